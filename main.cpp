@@ -2,6 +2,11 @@
 
 #include <thread>
 #include <chrono>
+#include <iostream>
+#include <fstream>
+#include <memory>
+
+#include <glad/glad.h>
 
 #include "marble/vendor/imgui/imgui.h"
 #include "marble/vendor/imgui/imgui_impl_glfw.h"
@@ -9,10 +14,18 @@
 
 #include "marble/abstraction/Window.h"
 #include "marble/abstraction/Inputs.h"
+#include "marble/abstraction/GLStateCache.h"
 
 #include "marble/Sandbox/Scene.h"
+#include "marble/Sandbox/Headless.h"
+#include "marble/Sandbox/Flythrough.h"
+#include "marble/Sandbox/FramePipeline.h"
 #include "marble/Utils/Debug.h"
+#include "marble/Utils/Profiler.h"
+#include "marble/Utils/FramePacing.h"
 #include "marble/World/Sky.h"
+#include "marble/World/Player.h"
+#include "marble/World/CameraPath.h"
 
 #include "marble/Sandbox/Tests.h"
 
@@ -22,13 +35,171 @@ inline long long nanoTime()
     return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
 }
 
-int main()
+static FramePacing::FixedTimestep       s_simulation;
+static FramePacing::FrameLimiter        s_frameLimiter;
+static FramePacing::FrameTimeStatistics s_frameTimes;
+static std::unique_ptr<FramePipeline::SimulationThread> s_simulationThread; // null if pipelined scenes run on the GL thread
+
+static void stepSimulation(unsigned int ticks, float tickDelta)
+{
+    MARBLE_PROFILE_SCOPE("Step");
+    for (unsigned int tick = 0; tick < ticks; tick++) {
+        // inputs are read per tick, the mouse motion of frames without ticks goes to the next tick
+        FramePacing::beginSimulationTick();
+        Inputs::updateInputs();
+        SceneManager::step(tickDelta);
+    }
+}
+
+/* Steps a pipelined scene and builds its next frame, may run on the simulation thread */
+static void simulateAndBuildFrame(unsigned int ticks, float tickDelta, float interpolation)
+{
+    stepSimulation(ticks, tickDelta);
+    MARBLE_PROFILE_SCOPE("Build frame");
+    FramePacing::setRenderInterpolation(interpolation);
+    Player::beginInterpolatedRender();
+    SceneManager::buildFrame();
+    Player::endInterpolatedRender();
+}
+
+/*
+* Runs ticks fixed steps of the simulation then renders the scene between its two
+* last states, interpolation is the fraction of a tick elapsed since the last one.
+* Pipelined scenes render the frame built during the previous call while the next
+* one is simulated, when the simulation thread exists.
+*/
+static void updateAndRenderFrame(unsigned int ticks, float tickDelta, float interpolation, float time, bool drawGui)
+{
+    Window::pollUserEvents();
+
+    ImGui_ImplGlfw_NewFrame();
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui::NewFrame();
+    
+    Renderer::setFrameTime(time);
+    if (SceneManager::isPipelined() && s_simulationThread) {
+        // events were polled and the gui is built after the wait, only the rendering overlaps the simulation
+        s_simulationThread->run([=] { simulateAndBuildFrame(ticks, tickDelta, interpolation); });
+        {
+            MARBLE_PROFILE_SCOPE("Render");
+            SceneManager::onRender();
+        }
+        {
+            MARBLE_PROFILE_SCOPE("Wait simulation");
+            s_simulationThread->wait();
+        }
+        SceneManager::swapFrames();
+    } else if (SceneManager::isPipelined()) {
+        simulateAndBuildFrame(ticks, tickDelta, interpolation);
+        SceneManager::swapFrames();
+        MARBLE_PROFILE_SCOPE("Render");
+        SceneManager::onRender();
+    } else {
+        stepSimulation(ticks, tickDelta);
+        MARBLE_PROFILE_SCOPE("Render");
+        FramePacing::setRenderInterpolation(interpolation);
+        Player::beginInterpolatedRender();
+        SceneManager::onRender();
+        Player::endInterpolatedRender();
+    }
+    SceneManager::onImGuiRender();
+    DebugWindow::onImGuiRender();
+    Profiler::onImGuiRender();
+    Flythrough::onImGuiRender();
+    FramePacing::onImGuiRender(s_frameLimiter, s_simulation, s_frameTimes);
+    Renderer::flushDebugDraw();
+
+    Renderer::Shader::unbind(); // unbind shaders before ImGui's new frame, so it won't try to restore a shader that has been deleted
+
+    ImGui::Render();
+    if (drawGui) {
+        MARBLE_PROFILE_SCOPE("ImGui");
+        MARBLE_PROFILE_GPU_SCOPE("ImGui");
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        Renderer::GLStateCache::invalidate(); // ImGui changes the GL state without going through the cache
+    }
+    Renderer::endFrame();
+    Profiler::endFrame();
+}
+
+/* Steps the scene with a fixed delta for a fixed number of frames, then prints the frame timings */
+static void runHeadless(const Headless::Options &options, size_t sceneIndex)
+{
+    Headless::FrameRecorder recorder;
+    recorder.reserve(options.frames);
+
+    for (unsigned int frame = 0; frame < options.frames; frame++) {
+        auto frameStart = nanoTime();
+        updateAndRenderFrame(1, options.timestep, 1.f, frame * options.timestep, false); // the gui is built but not drawn
+        glFinish();
+        recorder.addFrame(nanoTime() - frameStart);
+    }
+
+    recorder.printReport(std::cout, SceneManager::getSceneName(sceneIndex));
+}
+
+/* Replays a camera path with a fixed delta, writes the per-frame measures and prints their percentiles */
+static int runFlythrough(const Headless::Options &options, size_t sceneIndex)
 {
-	Window::createWindow(16*70, 9*70, "test");
+    World::CameraPath path;
+    try {
+        path = World::CameraPath::loadFromFile(options.flythroughPath);
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    unsigned int frames = (unsigned int)(path.getDuration() / options.timestep) + 1;
+    std::vector<Flythrough::FrameSample> samples;
+    samples.reserve(frames);
+    World::CameraPose pose;
+    Player::setPoseOverride(&pose);
+
+    {
+        Flythrough::FrameProbe probe;
+        for (unsigned int frame = 0; frame < frames; frame++) {
+            pose = path.sample(frame * options.timestep);
+            probe.beginFrame();
+            updateAndRenderFrame(1, options.timestep, 1.f, frame * options.timestep, false);
+            probe.endSubmission();
+            glFinish();
+            samples.push_back(probe.endFrame());
+        }
+    }
 
-    Window::setVisible(true);
-    Window::setPosition(400, 100);
-    Window::capFramerate();
+    Player::setPoseOverride(nullptr);
+
+    std::ofstream csv(options.flythroughOutput);
+    if (!csv) {
+        std::cerr << "Could not write " << options.flythroughOutput << std::endl;
+        return 1;
+    }
+    Flythrough::writeCsv(csv, samples, options.timestep);
+    Flythrough::printReport(std::cout, SceneManager::getSceneName(sceneIndex), samples);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Headless::Options options;
+    try {
+        options = Headless::parseCommandLine(argc, argv);
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (options.checks.enabled)
+        return Checks::run(options.checks); // cpu only, no window nor gl context
+
+    if (options.enabled) {
+        Window::createHeadlessWindow(options.width, options.height);
+    } else {
+        Window::createWindow(options.width, options.height, "test");
+        Window::setVisible(true);
+        Window::setPosition(400, 100);
+        Window::capFramerate(options.vsync);
+    }
     Inputs::observeInputs();
 
     ImGui::CreateContext();
@@ -39,6 +210,20 @@ int main()
     Renderer::SkyRenderer::init();
     Renderer::init();
     SceneManager::init();
+    if (options.enabled)
+        Headless::createOffscreenTarget(options.width, options.height);
+
+    if (options.benchmarks.enabled) {
+        int exitCode = Benchmarks::run(options.benchmarks);
+        SceneManager::shutdown();
+        Profiler::shutdown();
+        Headless::destroyOffscreenTarget();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
+        Window::destroyWindow();
+        return exitCode;
+    }
 
     
     SceneManager::registerScene<TestTerrainScene>("Terrain");
@@ -50,44 +235,73 @@ int main()
     SceneManager::registerScene<TestInstancedScene>("Instanced");
     SceneManager::registerScene<TestBloomScene>("Bloom");
     SceneManager::registerScene<TestWater>("Water");
+    SceneManager::registerScene<TestCullingScene>("Culling");
+    SceneManager::registerScene<TestOcclusionScene>("Occlusion");
+    SceneManager::registerScene<TestClusteredLightsScene>("Clustered lights");
     SceneManager::registerScene<POC1Scene>("POC 1");
     SceneManager::registerScene<POC2Scene>("POC 2");
     SceneManager::registerScene<POC3Scene>("POC 3");
     SceneManager::registerScene<POC4Scene>("POC 4");
     
 
-    SceneManager::switchToScene(2);
+    size_t sceneIndex = 2;
+    if (!options.scene.empty()) {
+        sceneIndex = SceneManager::findScene(options.scene);
+        if (sceneIndex == (size_t)-1) {
+            std::cerr << "Unknown scene \"" << options.scene << "\", available scenes:" << std::endl;
+            for (size_t i = 0; i < SceneManager::getSceneCount(); i++)
+                std::cerr << "  " << i << ": " << SceneManager::getSceneName(i) << std::endl;
+            return 1;
+        }
+    }
+
+    SceneManager::switchToScene(sceneIndex);
+
+    // flythroughs measure the frame of each pose, they are not pipelined
+    if (options.pipelining && options.flythroughPath.empty())
+        s_simulationThread = std::make_unique<FramePipeline::SimulationThread>();
 
     //===========================================================//
 
+    if (options.enabled) {
+        int exitCode = 0;
+        if (options.flythroughPath.empty())
+            runHeadless(options, sceneIndex);
+        else
+            exitCode = runFlythrough(options, sceneIndex);
+        s_simulationThread.reset();
+        SceneManager::shutdown();
+        Profiler::shutdown();
+        Headless::destroyOffscreenTarget();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
+        Window::destroyWindow();
+        return exitCode;
+    }
+
     unsigned int frames = 0;
+    float time = 0;
     auto firstTime = nanoTime();
     auto lastSec = firstTime;
+    s_simulation.setTickDelta(1.f / options.tickRate);
+    s_frameLimiter.setTargetFramerate(options.targetFramerate);
 
     while (!Window::shouldClose()) {
 
+        s_frameLimiter.wait();
+
         auto nextTime = nanoTime();
         auto delta = nextTime - firstTime;
         float realDelta = delta / 1E9f;
         firstTime = nextTime;
+        time += realDelta;
+        s_frameTimes.addFrame(delta);
 
-        Window::pollUserEvents();
-        Inputs::updateInputs();
         frames++;
 
-        ImGui_ImplGlfw_NewFrame();
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui::NewFrame();
-        
-        SceneManager::step(realDelta);
-        SceneManager::onRender();
-        SceneManager::onImGuiRender();
-        DebugWindow::onImGuiRender();
-
-        Renderer::Shader::unbind(); // unbind shaders before ImGui's new frame, so it won't try to restore a shader that has been deleted
-
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        unsigned int ticks = s_simulation.advance(realDelta);
+        updateAndRenderFrame(ticks, s_simulation.getTickDelta(), s_simulation.getInterpolation(), time, true);
         Window::sendFrame();
 
         if (lastSec + 1E9 < nextTime) {
@@ -99,7 +313,9 @@ int main()
         }
     }
 
+    s_simulationThread.reset();
     SceneManager::shutdown();
+    Profiler::shutdown();
 
     ImGui_ImplGlfw_Shutdown();
     ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,572 @@
+#include "Benchmarks.h"
+
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+
+#include "../abstraction/UnifiedRenderer.h"
+#include "../abstraction/RenderDevice.h"
+#include "../abstraction/Camera.h"
+#include "../abstraction/OcclusionBuffer.h"
+#include "../abstraction/animation/Animator.h"
+#include "../World/TerrainGeneration/Noise.h"
+#include "../World/TerrainGeneration/Terrain.h"
+#include "../World/Grass.h"
+#include "../World/Props/PropsManager.h"
+#include "../Utils/AABB.h"
+
+namespace Benchmarks {
+
+/*
+* A benchmark is created by its setup function which returns the timed function,
+* setups are only ran for the benchmarks that pass the filter.
+*/
+struct Benchmark {
+  std::string                           name;
+  std::function<std::function<void()>()> setup;
+};
+
+static constexpr unsigned int TERRAIN_SIZE = 256;
+static constexpr unsigned int BOX_COUNT = 100'000;
+static constexpr unsigned int GRASS_BLADES_PER_CHUNK = 20'000;
+static constexpr unsigned int SKELETON_BRANCHES = 8, SKELETON_BRANCH_LENGTH = 8;
+static constexpr unsigned int ANIMATION_KEYFRAMES = 30, ANIMATION_STEPS = 1000;
+static constexpr unsigned int PROPS_GRID_SIZE = 64;     // props in each direction
+static constexpr unsigned int SUBMISSION_FRAMES = 100;  // frames submitted by each run of the renderer benchmarks
+static constexpr int          OCCLUDER_STEP = 4;        // of the terrain occluder, as in the occlusion test scene
+
+// results are accumulated here so that the compiler cannot discard the benchmarked work
+static volatile float s_sink;
+
+static Noise::ConcreteHeightMap createBenchmarkHeightmap(unsigned int size)
+{
+  Noise::PerlinNoiseSettings settings; // default settings, fixed seed
+  return Noise::generateNoiseMap(size, size, settings);
+}
+
+static Renderer::Camera createBenchmarkCamera(const glm::vec3 &position, const glm::vec3 &target)
+{
+  Renderer::Camera camera;
+  camera.setProjection(Renderer::PerspectiveProjection{ Mathf::PI / 2.f, 16.f / 9.f });
+  camera.setPosition(position);
+  camera.lookAt(target);
+  camera.recalculateViewMatrix();
+  camera.recalculateViewProjectionMatrix();
+  return camera;
+}
+
+/* The occlusion buffer's default size, with a terrain occluder seen by a camera that stands on the terrain and looks across it */
+struct OcclusionScene {
+  std::shared_ptr<Noise::ConcreteHeightMap>           heightmap;
+  std::shared_ptr<Renderer::OcclusionBuffer::Occluder> occluder;
+  Renderer::Camera                                    camera;
+  std::shared_ptr<Renderer::OcclusionBuffer>          buffer;
+};
+
+static OcclusionScene createOcclusionScene()
+{
+  OcclusionScene scene;
+  scene.heightmap = std::make_shared<Noise::ConcreteHeightMap>(createBenchmarkHeightmap(TERRAIN_SIZE));
+  const Noise::ConcreteHeightMap &heightmap = *scene.heightmap;
+  scene.occluder = std::make_shared<Renderer::OcclusionBuffer::Occluder>(
+    Renderer::OcclusionBuffer::makeTerrainOccluder(heightmap, { 0, 0, TERRAIN_SIZE - 1.f, TERRAIN_SIZE - 1.f }, OCCLUDER_STEP));
+  float center = TERRAIN_SIZE * .5f;
+  scene.camera = createBenchmarkCamera({ 8, heightmap(8.f, 8.f) + 2.f, 8 }, { center, heightmap(center, center), center });
+  scene.buffer = std::make_shared<Renderer::OcclusionBuffer>();
+  scene.buffer->clear(scene.camera);
+  scene.buffer->addOccluder(*scene.occluder);
+  scene.buffer->rasterize();
+  return scene;
+}
+
+/*
+* Submits frames to the null device, nothing reaches the driver and the time is
+* the cpu cost of the renderer (culling, sorting, batching, state tracking).
+* Resources are still created with GL by the setups.
+*/
+static std::function<void()> submitToNullDevice(std::function<void()> renderFrame)
+{
+  return [renderFrame] {
+    static Renderer::NullRenderDevice nullDevice;
+    Renderer::setRenderDevice(&nullDevice);
+    for (unsigned int i = 0; i < SUBMISSION_FRAMES; i++) {
+      renderFrame();
+      Renderer::endFrame(); // releases the stream buffer allocations of the frame
+    }
+    Renderer::setRenderDevice(nullptr);
+  };
+}
+
+static std::vector<Benchmark> createBenchmarks()
+{
+  std::vector<Benchmark> benchmarks;
+
+  benchmarks.push_back({ "generateNoiseMap 512x512", [] {
+    return [] {
+      Noise::ConcreteHeightMap heightmap = Noise::generateNoiseMap(512, 512, Noise::PerlinNoiseSettings{});
+      s_sink = s_sink + heightmap.getHeight(256, 256);
+    };
+  } });
+
+  benchmarks.push_back({ "erode 256x256 50k droplets", [] {
+    auto heightmap = std::make_shared<Noise::ConcreteHeightMap>(createBenchmarkHeightmap(TERRAIN_SIZE));
+    return [heightmap] {
+      Noise::ConcreteHeightMap eroded = *heightmap;
+      Noise::ErosionSettings settings;
+      settings.dropletCount = 50'000;
+      std::srand(0); // erosion droplets are placed with rand()
+      Noise::erode(&eroded, settings);
+      s_sink = s_sink + eroded.getHeight(128, 128);
+    };
+  } });
+
+  benchmarks.push_back({ "TerrainMesh vertices 4x4 chunks", [] {
+    auto heightmap = std::make_shared<Noise::ConcreteHeightMap>(createBenchmarkHeightmap(TERRAIN_SIZE));
+    auto vertices = std::make_shared<std::vector<Renderer::BaseVertex>>(Renderer::TerrainMesh::CHUNK_VERTEX_COUNT);
+    return [heightmap, vertices] {
+      for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+          Renderer::TerrainMesh::generateChunkVertices(*heightmap, { x, y }, vertices->data());
+          s_sink = s_sink + vertices->back().position.y;
+        }
+      }
+    };
+  } });
+
+  benchmarks.push_back({ "Frustum::isOnFrustum 100k boxes", [] {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> positionDistribution(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> heightDistribution(-20.f, 60.f);
+    std::uniform_real_distribution<float> sizeDistribution(.5f, 8.f);
+    auto boxes = std::make_shared<std::vector<AABB>>();
+    boxes->reserve(BOX_COUNT);
+    for (unsigned int i = 0; i < BOX_COUNT; i++) {
+      glm::vec3 origin{ positionDistribution(rng), heightDistribution(rng), positionDistribution(rng) };
+      glm::vec3 size{ sizeDistribution(rng), sizeDistribution(rng), sizeDistribution(rng) };
+      boxes->push_back(AABB(origin, size));
+    }
+
+    Renderer::Camera camera;
+    camera.setProjection(Renderer::PerspectiveProjection{ Mathf::PI / 2.f, 16.f / 9.f });
+    camera.setPosition({ 0, 10, 0 });
+    camera.lookAt({ 100, 0, 100 });
+    camera.recalculateViewMatrix();
+    camera.recalculateViewProjectionMatrix();
+    Renderer::Frustum frustum = Renderer::Frustum::createFrustumFromCamera(camera);
+
+    return [boxes, frustum] {
+      unsigned int visible = 0;
+      for (const AABB &box : *boxes)
+        visible += frustum.isOnFrustum(box);
+      s_sink = s_sink + (float)visible;
+    };
+  } });
+
+  benchmarks.push_back({ "OcclusionBuffer::rasterize 256x144 terrain occluder", [] {
+    OcclusionScene scene = createOcclusionScene();
+    return [scene] {
+      scene.buffer->clear(scene.camera);
+      scene.buffer->addOccluder(*scene.occluder);
+      scene.buffer->rasterize();
+      s_sink = s_sink + scene.buffer->getDepthBuffer()[scene.buffer->getDepthBuffer().size() / 2];
+    };
+  } });
+
+  benchmarks.push_back({ "OcclusionBuffer::isVisible 100k boxes", [] {
+    OcclusionScene scene = createOcclusionScene();
+    const Noise::ConcreteHeightMap &heightmap = *scene.heightmap;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> positionDistribution(0.f, TERRAIN_SIZE - 1.f);
+    std::uniform_real_distribution<float> sizeDistribution(.5f, 4.f);
+    auto boxes = std::make_shared<std::vector<AABB>>();
+    boxes->reserve(BOX_COUNT);
+    for (unsigned int i = 0; i < BOX_COUNT; i++) {
+      glm::vec3 origin{ positionDistribution(rng), 0, positionDistribution(rng) };
+      origin.y = heightmap(origin.x, origin.z);
+      boxes->push_back(AABB(origin, { sizeDistribution(rng), sizeDistribution(rng), sizeDistribution(rng) }));
+    }
+
+    return [boxes, buffer = scene.buffer] {
+      unsigned int visible = 0;
+      for (const AABB &box : *boxes)
+        visible += buffer->isVisible(box);
+      s_sink = s_sink + (float)visible;
+    };
+  } });
+
+  // one benchmark per model, sorted so that the order does not depend on the file system
+  std::vector<std::filesystem::path> models;
+  if (std::filesystem::is_directory("res/meshes")) {
+    for (const auto &entry : std::filesystem::directory_iterator("res/meshes"))
+      if (entry.path().extension() == ".obj")
+        models.push_back(entry.path());
+  }
+  std::sort(models.begin(), models.end());
+  for (const std::filesystem::path &model : models) {
+    benchmarks.push_back({ "loadMeshFromFile " + model.filename().string(), [model] {
+      return [model] {
+        Renderer::Mesh mesh = Renderer::loadMeshFromFile(model);
+        s_sink = s_sink + mesh.getBoundingBox().getSize().x;
+      };
+    } });
+  }
+
+  benchmarks.push_back({ "TerrainGrassGenerator 3x3 chunks", [] {
+    auto heightmap = std::make_shared<Noise::ConcreteHeightMap>(createBenchmarkHeightmap(TERRAIN_SIZE));
+    auto generator = std::make_shared<World::TerrainGrassGenerator>(heightmap.get());
+    auto blades = std::make_shared<std::vector<World::GrassInstance>>(GRASS_BLADES_PER_CHUNK);
+    return [heightmap, generator, blades] {
+      for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) {
+          generator->regenerateChunk({ x, y }, Renderer::TerrainMesh::CHUNK_SIZE, blades->size(), blades->data());
+          s_sink = s_sink + blades->back().position.y;
+        }
+      }
+    };
+  } });
+
+  benchmarks.push_back({ "Animator::step 64 joints", [] {
+    // a root with branches of chained joints, each keyframe moves every joint
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<std::string> jointNames{ "root" };
+    auto root = std::make_shared<Joint>(0, "root", glm::mat4(1.f));
+    for (unsigned int b = 0; b < SKELETON_BRANCHES; b++) {
+      Joint branch;
+      for (int j = SKELETON_BRANCH_LENGTH - 1; j >= 0; j--) {
+        std::string name = "joint" + std::to_string(b) + "_" + std::to_string(j);
+        Joint joint((int)jointNames.size(), name, glm::mat4(1.f));
+        if (j != SKELETON_BRANCH_LENGTH - 1)
+          joint.addChild(branch);
+        branch = joint;
+        jointNames.push_back(name);
+      }
+      root->addChild(branch);
+    }
+
+    std::vector<KeyFrame> keyFrames;
+    for (unsigned int k = 0; k < ANIMATION_KEYFRAMES; k++) {
+      std::unordered_map<std::string, JointTransform> pose;
+      for (const std::string &name : jointNames) {
+        glm::vec3 position{ distribution(rng), distribution(rng), distribution(rng) };
+        glm::quat rotation = glm::normalize(glm::quat(distribution(rng), distribution(rng), distribution(rng), distribution(rng)));
+        pose.emplace(name, JointTransform(position, rotation));
+      }
+      keyFrames.emplace_back(k / 15.f, pose);
+    }
+    auto animation = std::make_shared<Animation>((ANIMATION_KEYFRAMES - 1) / 15.f, keyFrames);
+
+    return [root, animation] {
+      Animator animator;
+      animator.doAnimation(animation.get());
+      for (unsigned int i = 0; i < ANIMATION_STEPS; i++)
+        animator.step(1.f / 60.f, *root);
+      s_sink = s_sink + root->getChildren()[0].getAnimationTransform()[3][0];
+    };
+  } });
+
+  benchmarks.push_back({ "renderMeshTerrain 256x256 null device", [] {
+    Noise::ConcreteHeightMap heightmap = createBenchmarkHeightmap(TERRAIN_SIZE);
+    auto terrain = std::make_shared<Renderer::TerrainMesh>();
+    terrain->rebuildMesh(heightmap, { 0, 0, TERRAIN_SIZE, TERRAIN_SIZE });
+    auto material = std::make_shared<Renderer::Material>();
+    material->shader = Renderer::getStandardMeshShader();
+    terrain->setMaterial(material);
+    Renderer::Camera camera = createBenchmarkCamera({ 0, 40, 0 }, { TERRAIN_SIZE * .5f, 0, TERRAIN_SIZE * .5f });
+
+    return submitToNullDevice([terrain, camera] {
+      Renderer::renderMeshTerrain(camera, *terrain);
+    });
+  } });
+
+  benchmarks.push_back({ "PropsManager::render 64x64 props null device", [] {
+    auto props = std::make_shared<World::PropsManager>();
+    std::shared_ptr<Renderer::Model> cube = Renderer::createCubeModel();
+    auto material = std::make_shared<Renderer::Material>();
+    material->shader = Renderer::getStandardMeshShader();
+    for (unsigned int x = 0; x < PROPS_GRID_SIZE; x++) {
+      for (unsigned int z = 0; z < PROPS_GRID_SIZE; z++) {
+        auto prop = std::make_shared<Renderer::Mesh>(cube, material);
+        prop->getTransform().position = { x * 4.f, 0, z * 4.f };
+        props->feed(prop);
+      }
+    }
+    Renderer::Camera camera = createBenchmarkCamera({ 0, 20, 0 }, { PROPS_GRID_SIZE * 2.f, 0, PROPS_GRID_SIZE * 2.f });
+
+    return submitToNullDevice([props, camera] {
+      props->render(camera);
+    });
+  } });
+
+  benchmarks.push_back({ "TerrainGrass::render 3x3 chunks null device", [] {
+    auto heightmap = std::make_shared<Noise::ConcreteHeightMap>(createBenchmarkHeightmap(TERRAIN_SIZE));
+    std::vector<glm::ivec2> hdChunks, ldChunks;
+    for (int x = 0; x < 5; x++) {
+      for (int y = 0; y < 5; y++) {
+        bool hd = x >= 1 && x <= 3 && y >= 1 && y <= 3;
+        (hd ? hdChunks : ldChunks).push_back({ x, y });
+      }
+    }
+    auto grass = std::make_shared<World::TerrainGrass>(std::make_unique<World::FixedGrassChunks>(
+      std::make_unique<World::TerrainGrassGenerator>(heightmap.get()),
+      Renderer::TerrainMesh::CHUNK_SIZE, hdChunks, ldChunks));
+    float center = Renderer::TerrainMesh::CHUNK_SIZE * 2.5f;
+    Renderer::Camera camera = createBenchmarkCamera({ center, 20, 0 }, { center, 0, center });
+    grass->step(camera);
+
+    return submitToNullDevice([heightmap, grass, camera] {
+      grass->render(camera, 0.f);
+    });
+  } });
+
+  return benchmarks;
+}
+
+static Result runBenchmark(const std::string &name, const std::function<void()> &fn, unsigned int repetitions)
+{
+  using clock = std::chrono::high_resolution_clock;
+
+  fn(); // warmup, caches and allocators
+
+  std::vector<long long> times;
+  times.reserve(repetitions);
+  for (unsigned int i = 0; i < repetitions; i++) {
+    auto begin = clock::now();
+    fn();
+    times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin).count());
+  }
+  std::sort(times.begin(), times.end());
+
+  Result result;
+  result.name = name;
+  result.repetitions = repetitions;
+  result.minTime = times.front();
+  result.medianTime = times[times.size() / 2];
+  result.meanTime = std::accumulate(times.begin(), times.end(), 0ll) / (long long)times.size();
+  result.maxTime = times.back();
+  return result;
+}
+
+std::vector<Result> runAll(const std::string &filter, unsigned int repetitions)
+{
+  assert(repetitions > 0);
+
+  std::vector<Result> results;
+  for (const Benchmark &benchmark : createBenchmarks()) {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+      continue;
+    std::function<void()> fn = benchmark.setup();
+    results.push_back(runBenchmark(benchmark.name, fn, repetitions));
+  }
+  return results;
+}
+
+void printResults(std::ostream &out, const std::vector<Result> &results)
+{
+  for (const Result &result : results) {
+    out << "benchmark=\"" << result.name << "\""
+        << " repetitions=" << result.repetitions
+        << " min_ms=" << result.minTime * 1e-6
+        << " median_ms=" << result.medianTime * 1e-6
+        << " mean_ms=" << result.meanTime * 1e-6
+        << " max_ms=" << result.maxTime * 1e-6
+        << std::endl;
+  }
+}
+
+static void writeJsonString(std::ostream &out, const std::string &text)
+{
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      out << '\\';
+    out << c;
+  }
+  out << '"';
+}
+
+void writeJson(std::ostream &out, const std::vector<Result> &results)
+{
+  out << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    out << "    { \"name\": ";
+    writeJsonString(out, result.name);
+    out << ", \"repetitions\": " << result.repetitions
+        << ", \"min_ns\": " << result.minTime
+        << ", \"median_ns\": " << result.medianTime
+        << ", \"mean_ns\": " << result.meanTime
+        << ", \"max_ns\": " << result.maxTime
+        << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+}
+
+/* Reads the subset of json written by #writeJson, objects of strings and integers */
+class JsonReader {
+private:
+  std::string m_text;
+  size_t      m_cursor = 0;
+
+public:
+  explicit JsonReader(std::istream &in)
+    : m_text(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()) { }
+
+  char peek()
+  {
+    while (m_cursor < m_text.size() && std::isspace((unsigned char)m_text[m_cursor]))
+      m_cursor++;
+    return m_cursor < m_text.size() ? m_text[m_cursor] : '\0';
+  }
+
+  bool tryConsume(char c)
+  {
+    if (peek() != c)
+      return false;
+    m_cursor++;
+    return true;
+  }
+
+  void expect(char c)
+  {
+    if (!tryConsume(c))
+      throw std::runtime_error(std::string("Malformed benchmark file, expected '") + c + "' at offset " + std::to_string(m_cursor));
+  }
+
+  std::string readString()
+  {
+    expect('"');
+    std::string text;
+    while (m_cursor < m_text.size() && m_text[m_cursor] != '"') {
+      if (m_text[m_cursor] == '\\')
+        m_cursor++;
+      if (m_cursor < m_text.size())
+        text += m_text[m_cursor++];
+    }
+    expect('"');
+    return text;
+  }
+
+  long long readInteger()
+  {
+    peek();
+    const char *begin = m_text.c_str() + m_cursor;
+    char *end;
+    long long value = std::strtoll(begin, &end, 10);
+    if (end == begin)
+      throw std::runtime_error("Malformed benchmark file, expected a number at offset " + std::to_string(m_cursor));
+    m_cursor += end - begin;
+    return value;
+  }
+};
+
+std::vector<Result> readJson(std::istream &in)
+{
+  JsonReader reader(in);
+  std::vector<Result> results;
+
+  reader.expect('{');
+  if (reader.readString() != "benchmarks")
+    throw std::runtime_error("Malformed benchmark file, expected a \"benchmarks\" array");
+  reader.expect(':');
+  reader.expect('[');
+  while (!reader.tryConsume(']')) {
+    if (!results.empty())
+      reader.expect(',');
+    Result &result = results.emplace_back();
+    reader.expect('{');
+    while (!reader.tryConsume('}')) {
+      std::string key = reader.readString();
+      reader.expect(':');
+      if (key == "name")                result.name = reader.readString();
+      else if (key == "repetitions")    result.repetitions = (unsigned int)reader.readInteger();
+      else if (key == "min_ns")         result.minTime = reader.readInteger();
+      else if (key == "median_ns")      result.medianTime = reader.readInteger();
+      else if (key == "mean_ns")        result.meanTime = reader.readInteger();
+      else if (key == "max_ns")         result.maxTime = reader.readInteger();
+      else if (reader.peek() == '"')    reader.readString();
+      else                              reader.readInteger();
+      reader.tryConsume(',');
+    }
+  }
+  reader.expect('}');
+
+  return results;
+}
+
+std::vector<Comparison> compare(const std::vector<Result> &baseline, const std::vector<Result> &current, float regressionThreshold)
+{
+  std::vector<Comparison> comparisons;
+  for (const Result &result : current) {
+    auto reference = std::find_if(baseline.begin(), baseline.end(), [&](const Result &r) { return r.name == result.name; });
+    if (reference == baseline.end() || reference->medianTime <= 0)
+      continue;
+    float change = (float)(result.medianTime - reference->medianTime) / reference->medianTime * 100.f;
+    comparisons.push_back({ result.name, reference->medianTime, result.medianTime, change, change > regressionThreshold });
+  }
+  return comparisons;
+}
+
+size_t printComparison(std::ostream &out, const std::vector<Comparison> &comparisons, float regressionThreshold)
+{
+  size_t regressions = 0;
+  for (const Comparison &comparison : comparisons) {
+    out << (comparison.regressed ? "REGRESSION " : "ok         ")
+        << "benchmark=\"" << comparison.name << "\""
+        << " baseline_ms=" << comparison.baselineTime * 1e-6
+        << " current_ms=" << comparison.currentTime * 1e-6
+        << " change=" << std::showpos << std::fixed << std::setprecision(1) << comparison.change << "%"
+        << std::noshowpos << std::defaultfloat << std::setprecision(6)
+        << std::endl;
+    regressions += comparison.regressed;
+  }
+  out << regressions << " regression(s) over " << comparisons.size() << " compared benchmark(s), threshold " << regressionThreshold << "%" << std::endl;
+  return regressions;
+}
+
+int run(const Options &options)
+{
+  std::vector<Result> results = runAll(options.filter, options.repetitions);
+  printResults(std::cout, results);
+
+  if (!options.outputPath.empty()) {
+    std::ofstream file(options.outputPath);
+    if (!file) {
+      std::cerr << "Could not write " << options.outputPath << std::endl;
+      return 1;
+    }
+    writeJson(file, results);
+  }
+
+  if (!options.baselinePath.empty()) {
+    std::ifstream file(options.baselinePath);
+    if (!file) {
+      std::cerr << "Could not read " << options.baselinePath << std::endl;
+      return 1;
+    }
+    std::vector<Result> baseline;
+    try {
+      baseline = readJson(file);
+    } catch (const std::runtime_error &e) {
+      std::cerr << options.baselinePath << ": " << e.what() << std::endl;
+      return 1;
+    }
+    std::vector<Comparison> comparisons = compare(baseline, results, options.regressionThreshold);
+    if (printComparison(std::cout, comparisons, options.regressionThreshold) > 0)
+      return 1;
+  }
+
+  return 0;
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+/**
+* Microbenchmarks of the cpu hot paths of the engine (noise generation, erosion,
+* terrain vertices, frustum culling, occlusion culling, obj loading, grass
+* placement, animation)
+* and of the renderer's submission of terrain, props and grass. The submission
+* benchmarks draw to the null device (see RenderDevice.h), they measure the cpu
+* side of the renderer without the driver's cost.
+*
+* Every benchmark works on fixed sizes with fixed seeds so that two runs do the
+* same work, it is run once to warm up then timed over a number of repetitions.
+* Results can be written as json and compared against a previous run, a
+* benchmark regresses when its median time grew by more than the threshold.
+*
+* Some benchmarks (obj loading, submission) create gl resources, the suite is ran after the
+* renderer is initialized, in headless mode (see Headless.h).
+*
+* Command line:
+*   --benchmarks                  run the suite instead of a scene, implies --headless
+*   --benchmark-filter <text>     only run the benchmarks whose name contains text
+*   --benchmark-repetitions <n>   timed runs of each benchmark
+*   --benchmark-output <file>     write the results as json
+*   --benchmark-baseline <file>   compare the results against a previous output
+*   --benchmark-threshold <pct>   allowed slowdown before a benchmark is flagged
+*
+* Example usage:
+*   marble --benchmarks --benchmark-output baseline.json
+*   marble --benchmarks --benchmark-baseline baseline.json --benchmark-threshold 5
+*/
+namespace Benchmarks {
+
+struct Options {
+  bool         enabled = false;
+  std::string  filter;
+  unsigned int repetitions = 10;
+  std::string  outputPath;
+  std::string  baselinePath;
+  float        regressionThreshold = 10.f; // in percents
+};
+
+struct Result {
+  std::string  name;
+  unsigned int repetitions = 0;
+  long long    minTime = 0;    // in nanoseconds
+  long long    medianTime = 0; // in nanoseconds
+  long long    meanTime = 0;   // in nanoseconds
+  long long    maxTime = 0;    // in nanoseconds
+};
+
+struct Comparison {
+  std::string name;
+  long long   baselineTime; // median, in nanoseconds
+  long long   currentTime;  // median, in nanoseconds
+  float       change;       // in percents, positive if slower
+  bool        regressed;
+};
+
+/* Runs every benchmark whose name contains the filter (all of them if it is empty) */
+std::vector<Result> runAll(const std::string &filter, unsigned int repetitions);
+
+void printResults(std::ostream &out, const std::vector<Result> &results);
+void writeJson(std::ostream &out, const std::vector<Result> &results);
+/* Reads the output of #writeJson, throws std::runtime_error if it is malformed */
+std::vector<Result> readJson(std::istream &in);
+
+/* Benchmarks that are missing from the baseline are not compared */
+std::vector<Comparison> compare(const std::vector<Result> &baseline, const std::vector<Result> &current, float regressionThreshold);
+/* Returns the number of regressions */
+size_t printComparison(std::ostream &out, const std::vector<Comparison> &comparisons, float regressionThreshold);
+
+/* Runs the suite as described by the options, returns the process exit code (1 if a benchmark regressed) */
+int run(const Options &options);
+
+}
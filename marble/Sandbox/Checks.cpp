@@ -0,0 +1,371 @@
+#include "Checks.h"
+
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "../abstraction/Camera.h"
+#include "../abstraction/GBufferEncoding.h"
+#include "../abstraction/OcclusionBuffer.h"
+#include "../Utils/Mathf.h"
+#include "../Utils/AABB.h"
+#include "../World/CascadedShadowMaps.h"
+
+namespace Checks {
+
+/* A check appends its measures to the result, it may throw to fail */
+struct Check {
+  std::string                               name;
+  std::function<void(std::vector<Measure> &)> run;
+};
+
+static constexpr unsigned int GBUFFER_SAMPLES = 4096;
+static constexpr float MAX_NORMAL_ERROR = .05f;             // in degrees, a RG16 octahedral normal is good to ~.035
+static constexpr float MAX_POSITION_ERROR = 1.5f;           // in world units, at 1000 units from the camera
+static constexpr float MAX_RELATIVE_POSITION_ERROR = .002f; // position error divided by the distance to the camera
+
+static constexpr unsigned int CULLING_BOX_COUNT = 100'000;
+static constexpr float CULLING_WORLD_SIZE = 2000.f;
+static constexpr unsigned int CULLING_CAMERAS = 64;
+
+static constexpr unsigned int SHADOW_CACHE_FRAMES = 600;
+static constexpr float SHADOW_CACHE_SUN_SPEED = .1f;   // in degrees per frame, the sun of POC 4 moves a bit faster
+static constexpr float SHADOW_CACHE_THRESHOLD = .5f;   // in degrees, the default of CascadedShadowMaps
+
+// the camera looks down -z at two walls, 7.2 pixels per unit. Their edges are placed so that the
+// pixels on their silhouettes have their center covered, only the one pixel grow of boxes keeps
+// the ones that peek by less than a pixel visible
+static constexpr float OCCLUSION_WALL_DISTANCE = 10.f;
+static constexpr glm::vec2 OCCLUSION_WALL_EXTENT{ 6.05f, 4.1f }; // outer edges of the walls
+static constexpr float OCCLUSION_GAP = .4f;                      // between the walls, about 2.9 pixels
+
+static Renderer::Camera createCheckCamera(const glm::vec3 &position, const glm::vec3 &target)
+{
+  Renderer::Camera camera;
+  camera.setProjection(Renderer::PerspectiveProjection{ Mathf::PI / 2.f, 16.f / 9.f });
+  camera.setPosition(position);
+  camera.lookAt(target);
+  camera.recalculateViewMatrix();
+  camera.recalculateViewProjectionMatrix();
+  return camera;
+}
+
+static float normalRoundTripError(const glm::vec3 &normal)
+{
+  using namespace Renderer::GBufferEncoding;
+  float cosAngle = glm::clamp(glm::dot(normal, unpackNormal(packNormal(normal))), -1.f, 1.f);
+  return glm::degrees(std::acos(cosAngle));
+}
+
+static void checkGBufferEncoding(std::vector<Measure> &measures)
+{
+  // the axes and the edges of the octahedron, where the lower hemisphere is folded
+  float edgesError = 0;
+  for (int x = -1; x <= 1; x++) {
+    for (int y = -1; y <= 1; y++) {
+      for (int z = -1; z <= 1; z++) {
+        if (x != 0 || y != 0 || z != 0)
+          edgesError = std::max(edgesError, normalRoundTripError(glm::normalize(glm::vec3(x, y, z))));
+      }
+    }
+  }
+  measures.push_back({ "normal error on the octahedron edges (degrees)", edgesError, MAX_NORMAL_ERROR });
+
+  struct View { const char *name; glm::vec3 position, target; };
+  const View views[] = {
+    { "ground", { 0, 10, 0 },       { 100, 0, 100 } },
+    { "above",  { 500, 80, -300 },  { 100, 0, 100 } },
+  };
+  for (const View &view : views) {
+    Renderer::Camera camera = createCheckCamera(view.position, view.target);
+    Renderer::GBufferEncoding::Precision precision = Renderer::GBufferEncoding::measureGBufferPrecision(camera, GBUFFER_SAMPLES, 1000.f);
+    std::string suffix = std::string(" (") + view.name + " view)";
+    measures.push_back({ "normal error (degrees)" + suffix, precision.maxNormalError, MAX_NORMAL_ERROR });
+    measures.push_back({ "position error (world units)" + suffix, precision.maxPositionError, MAX_POSITION_ERROR });
+    measures.push_back({ "relative position error" + suffix, precision.maxRelativePositionError, MAX_RELATIVE_POSITION_ERROR });
+  }
+}
+
+static void checkCulling(std::vector<Measure> &measures)
+{
+  // the boxes of the culling test scene
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> positionDistribution(-CULLING_WORLD_SIZE*.5f, CULLING_WORLD_SIZE*.5f);
+  std::uniform_real_distribution<float> heightDistribution(-20.f, 60.f);
+  std::uniform_real_distribution<float> sizeDistribution(.5f, 8.f);
+  std::uniform_real_distribution<float> angleDistribution(-Mathf::PI, Mathf::PI);
+
+  std::vector<AABB> boxes;
+  Renderer::CullingSystem culling;
+  boxes.reserve(CULLING_BOX_COUNT);
+  culling.reserve(CULLING_BOX_COUNT);
+  for (unsigned int i = 0; i < CULLING_BOX_COUNT; i++) {
+    glm::vec3 origin{ positionDistribution(rng), heightDistribution(rng), positionDistribution(rng) };
+    glm::vec3 size{ sizeDistribution(rng), sizeDistribution(rng), sizeDistribution(rng) };
+    boxes.push_back(AABB(origin, size));
+    culling.addBox(boxes.back());
+  }
+
+  // random perspective cameras, and orthographic ones such as the shadow cameras
+  std::vector<Renderer::Frustum> frustums;
+  for (unsigned int i = 0; i < CULLING_CAMERAS; i++) {
+    Renderer::Camera camera;
+    if (i % 2 == 0) {
+      camera.setProjection(Renderer::PerspectiveProjection{ Mathf::PI / 2.f, 16.f / 9.f });
+    } else {
+      float halfSize = sizeDistribution(rng) * 20.f;
+      camera.setProjection(Renderer::OrthographicProjection{ -halfSize, halfSize, -halfSize, halfSize, -300.f, 300.f });
+    }
+    camera.setPosition({ positionDistribution(rng), heightDistribution(rng), positionDistribution(rng) });
+    camera.setYaw(angleDistribution(rng));
+    camera.setPitch(angleDistribution(rng) * .5f);
+    camera.recalculateViewMatrix();
+    camera.recalculateViewProjectionMatrix();
+    frustums.push_back(i % 2 == 0
+      ? Renderer::Frustum::createFrustumFromCamera(camera)
+      : Renderer::Frustum::createFrustumFromOrthographicCamera(camera));
+  }
+
+  std::vector<bool> referenceVisibility(boxes.size());
+  Renderer::CullingSystem::VisibilityBitset visibility;
+  std::vector<unsigned int> visibleIndices;
+  size_t mismatches = 0, viewsMismatches = 0, visibleCount = 0;
+
+  for (const Renderer::Frustum &frustum : frustums) {
+    for (size_t i = 0; i < boxes.size(); i++)
+      referenceVisibility[i] = frustum.isOnFrustum(boxes[i]);
+    culling.cull(frustum, visibility);
+    culling.cull(frustum, visibleIndices);
+    mismatches += countCullingMismatches(referenceVisibility, visibility, visibleIndices);
+    visibleCount += visibleIndices.size();
+  }
+
+  // the multi-view pass, over groups of MAX_VIEWS frustums
+  std::vector<Renderer::CullingSystem::VisibilityBitset> visibilities(Renderer::CullingSystem::MAX_VIEWS);
+  for (size_t first = 0; first < frustums.size(); first += Renderer::CullingSystem::MAX_VIEWS) {
+    size_t viewCount = std::min(frustums.size() - first, Renderer::CullingSystem::MAX_VIEWS);
+    culling.cullViews({ frustums.data() + first, viewCount }, { visibilities.data(), viewCount });
+    for (size_t view = 0; view < viewCount; view++) {
+      for (size_t i = 0; i < boxes.size(); i++)
+        referenceVisibility[i] = frustums[first + view].isOnFrustum(boxes[i]);
+      Renderer::CullingSystem::collectVisibleIndices(visibilities[view], visibleIndices);
+      viewsMismatches += countCullingMismatches(referenceVisibility, visibilities[view], visibleIndices);
+    }
+  }
+
+  // a check that passes because nothing is visible proves nothing
+  if (visibleCount == 0)
+    throw std::runtime_error("No box is visible from any of the cameras");
+
+  measures.push_back({ "mismatches with Frustum#isOnFrustum", (double)mismatches, 0 });
+  measures.push_back({ "mismatches of the multi-view culling", (double)viewsMismatches, 0 });
+}
+
+/* Number of static renders of each cascade while the sun turns by a fixed angle every frame */
+static std::vector<unsigned int> countStaticShadowRenders(float sunDegreesPerFrame)
+{
+  World::CascadedShadowCameras cameras(3, 2048, 200.f);
+  cameras.setSunDirectionThreshold(glm::radians(SHADOW_CACHE_THRESHOLD));
+
+  // a still camera above a terrain made of chunks
+  Renderer::Camera camera = createCheckCamera({ 0, 30, 0 }, { 100, 0, 60 });
+  std::vector<AABB> casters;
+  for (int x = -8; x < 8; x++) {
+    for (int z = -8; z < 8; z++)
+      casters.push_back(AABB({ x * 32.f, 0, z * 32.f }, { 32.f, 40.f, 32.f }));
+  }
+
+  std::vector<unsigned int> staticRenders(cameras.getCascadeCount());
+  for (unsigned int frame = 0; frame < SHADOW_CACHE_FRAMES; frame++) {
+    float elevation = glm::radians(20.f + frame * sunDegreesPerFrame);
+    cameras.setSunDirection({ glm::cos(elevation), glm::sin(elevation), 0 });
+    cameras.update(camera, casters);
+    for (unsigned int i = 0; i < cameras.getCascadeCount(); i++) {
+      if (cameras.needsStaticRender(i)) {
+        staticRenders[i]++;
+        cameras.setStaticRenderDone(i);
+      }
+    }
+  }
+  return staticRenders;
+}
+
+static void checkShadowCache(std::vector<Measure> &measures)
+{
+  // a still sun renders each cache once, a slow sun once per threshold crossing (and the first frame)
+  std::vector<unsigned int> stillRenders = countStaticShadowRenders(0);
+  std::vector<unsigned int> slowRenders = countStaticShadowRenders(SHADOW_CACHE_SUN_SPEED);
+  float slowBound = std::ceil(SHADOW_CACHE_FRAMES * SHADOW_CACHE_SUN_SPEED / SHADOW_CACHE_THRESHOLD) + 1;
+  for (size_t i = 0; i < slowRenders.size(); i++) {
+    std::string cascade = " (cascade " + std::to_string(i) + ", " + std::to_string(SHADOW_CACHE_FRAMES) + " frames)";
+    measures.push_back({ "static renders with a still sun" + cascade, (double)stillRenders[i], 1 });
+    measures.push_back({ "static renders with a slow sun" + cascade, (double)slowRenders[i], slowBound });
+  }
+
+  // a sun that turns faster than the threshold must not be cached, or the check proves nothing
+  std::vector<unsigned int> fastRenders = countStaticShadowRenders(SHADOW_CACHE_THRESHOLD * 2.f);
+  if (std::any_of(fastRenders.begin(), fastRenders.end(), [](unsigned int renders) { return renders != SHADOW_CACHE_FRAMES; }))
+    throw std::runtime_error("The static cache was kept while the sun turned by more than the threshold");
+}
+
+/* A box that starts at the given distance from the camera and whose front face projects on the rectangle of the walls' plane */
+static AABB makeBoxBehindWalls(const glm::vec2 &wallMin, const glm::vec2 &wallMax, float distance)
+{
+  float scale = distance / OCCLUSION_WALL_DISTANCE;
+  return AABB::make_aabb(glm::vec3(wallMin * scale, -distance), glm::vec3(wallMax * scale, -distance - 1.f));
+}
+
+static void checkOcclusion(std::vector<Measure> &measures)
+{
+  Renderer::Camera camera = createCheckCamera({ 0, 0, 0 }, { 0, 0, -1 });
+  float halfGap = OCCLUSION_GAP * .5f;
+  glm::vec2 extent = OCCLUSION_WALL_EXTENT;
+  Renderer::OcclusionBuffer::Occluder walls;
+  for (float side : { -1.f, 1.f }) {
+    unsigned int first = (unsigned int)walls.vertices.size();
+    for (glm::vec2 corner : { glm::vec2{ halfGap, -extent.y }, glm::vec2{ extent.x, -extent.y }, extent, glm::vec2{ halfGap, extent.y } })
+      walls.vertices.push_back({ corner.x * side, corner.y, -OCCLUSION_WALL_DISTANCE });
+    walls.indices.insert(walls.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+  }
+
+  // the rectangles are given in the walls' plane
+  std::vector<AABB> hiddenBoxes, visibleBoxes;
+  for (float distance : { 15.f, 40.f }) {
+    for (float x : { 1.f, 2.f, 3.5f, 5.f }) {
+      for (float y : { -3.f, -1.f, 1.f, 3.f }) {
+        for (float side : { -1.f, 1.f })
+          hiddenBoxes.push_back(makeBoxBehindWalls({ x * side - .25f, y - .25f }, { x * side + .25f, y + .25f }, distance));
+      }
+    }
+    // boxes that peek past the silhouettes by about 1.5 pixels, or by less than a pixel
+    for (float peek : { .2f, .05f }) {
+      for (float y : { -2.f, 0.f, 2.f }) {
+        visibleBoxes.push_back(makeBoxBehindWalls({ -extent.x - peek, y - .25f }, { -5.5f, y + .25f }, distance));
+        visibleBoxes.push_back(makeBoxBehindWalls({ 5.5f, y - .25f }, { extent.x + peek, y + .25f }, distance));
+        visibleBoxes.push_back(makeBoxBehindWalls({ -1.f, y - .25f }, { -halfGap + peek, y + .25f }, distance));
+        visibleBoxes.push_back(makeBoxBehindWalls({ halfGap - peek, y - .25f }, { 1.f, y + .25f }, distance));
+      }
+      for (float x : { -3.f, 3.f }) {
+        visibleBoxes.push_back(makeBoxBehindWalls({ x - .25f, extent.y - .5f }, { x + .25f, extent.y + peek }, distance));
+        visibleBoxes.push_back(makeBoxBehindWalls({ x - .25f, -extent.y - peek }, { x + .25f, -extent.y + .5f }, distance));
+      }
+    }
+    // boxes seen through the gap, across it or inside of it
+    for (float y : { -2.f, 0.f, 2.f }) {
+      visibleBoxes.push_back(makeBoxBehindWalls({ -1.f, y - .25f }, { 1.f, y + .25f }, distance));
+      visibleBoxes.push_back(makeBoxBehindWalls({ -.1f, y - .25f }, { .1f, y + .25f }, distance));
+    }
+  }
+  // a box in front of the walls is never occluded
+  visibleBoxes.push_back(makeBoxBehindWalls({ -3.f, -1.f }, { -2.f, 1.f }, OCCLUSION_WALL_DISTANCE * .5f));
+
+  Renderer::OcclusionBuffer occlusionBuffer;
+  occlusionBuffer.clear(camera);
+  occlusionBuffer.addOccluder(walls);
+  occlusionBuffer.rasterize();
+  size_t hiddenReportedVisible = std::count_if(hiddenBoxes.begin(), hiddenBoxes.end(), [&](const AABB &box) { return occlusionBuffer.isVisible(box); });
+  size_t visibleReportedOccluded = std::count_if(visibleBoxes.begin(), visibleBoxes.end(), [&](const AABB &box) { return !occlusionBuffer.isVisible(box); });
+
+  // the bands rasterized by the worker pool must give the same buffer as a single thread
+  Renderer::OcclusionBuffer singleThreadBuffer(occlusionBuffer.getWidth(), occlusionBuffer.getHeight(), 1);
+  singleThreadBuffer.clear(camera);
+  singleThreadBuffer.addOccluder(walls);
+  singleThreadBuffer.rasterize();
+  const std::vector<float> &depth = occlusionBuffer.getDepthBuffer();
+  const std::vector<float> &singleThreadDepth = singleThreadBuffer.getDepthBuffer();
+  size_t differentPixels = 0;
+  for (size_t i = 0; i < depth.size(); i++)
+    differentPixels += depth[i] != singleThreadDepth[i];
+
+  measures.push_back({ "boxes behind the walls reported visible", (double)hiddenReportedVisible, 0 });
+  measures.push_back({ "boxes peeking past the walls reported occluded", (double)visibleReportedOccluded, 0 });
+  measures.push_back({ "pixels that differ between the worker pool and one thread", (double)differentPixels, 0 });
+}
+
+static std::vector<Check> createChecks()
+{
+  std::vector<Check> checks;
+  checks.push_back({ "gbuffer encoding", checkGBufferEncoding });
+  checks.push_back({ "culling", checkCulling });
+  checks.push_back({ "shadow cache", checkShadowCache });
+  checks.push_back({ "occlusion", checkOcclusion });
+  return checks;
+}
+
+bool Result::passed() const
+{
+  return error.empty() && std::all_of(measures.begin(), measures.end(), [](const Measure &m) { return m.value <= m.bound; });
+}
+
+std::vector<Result> runAll(const std::string &filter)
+{
+  std::vector<Result> results;
+  for (const Check &check : createChecks()) {
+    if (!filter.empty() && check.name.find(filter) == std::string::npos)
+      continue;
+    Result &result = results.emplace_back();
+    result.name = check.name;
+    try {
+      check.run(result.measures);
+    } catch (const std::exception &e) {
+      result.error = e.what();
+    }
+  }
+  return results;
+}
+
+size_t printResults(std::ostream &out, const std::vector<Result> &results)
+{
+  size_t failures = 0;
+  for (const Result &result : results) {
+    bool passed = result.passed();
+    failures += !passed;
+    out << "check=\"" << result.name << "\" " << (passed ? "passed" : "FAILED") << std::endl;
+    for (const Measure &measure : result.measures) {
+      out << "  " << (measure.value <= measure.bound ? "ok  " : "FAIL")
+          << " " << measure.name << " = " << measure.value << " (bound " << measure.bound << ")" << std::endl;
+    }
+    if (!result.error.empty())
+      out << "  FAIL threw: " << result.error << std::endl;
+  }
+  out << results.size() - failures << "/" << results.size() << " checks passed" << std::endl;
+  return failures;
+}
+
+size_t countCullingMismatches(const std::vector<bool> &referenceVisibility,
+                              const Renderer::CullingSystem::VisibilityBitset &visibility,
+                              const std::vector<unsigned int> &visibleIndices)
+{
+  size_t mismatches = 0;
+  size_t nextVisibleIndex = 0;
+  for (size_t i = 0; i < referenceVisibility.size(); i++) {
+    bool expected = referenceVisibility[i];
+    if (expected != Renderer::CullingSystem::isVisible(visibility, i))
+      mismatches++;
+    bool listed = nextVisibleIndex < visibleIndices.size() && visibleIndices[nextVisibleIndex] == i;
+    if (listed)
+      nextVisibleIndex++;
+    if (expected != listed)
+      mismatches++;
+  }
+  // indices that are out of order or out of range
+  mismatches += visibleIndices.size() - nextVisibleIndex;
+  return mismatches;
+}
+
+int run(const Options &options)
+{
+  std::vector<Result> results = runAll(options.filter);
+  if (results.empty()) {
+    std::cerr << "No check matches \"" << options.filter << "\"" << std::endl;
+    return 1;
+  }
+  return printResults(std::cout, results) > 0 ? 1 : 0;
+}
+
+}
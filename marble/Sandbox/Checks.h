@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "../abstraction/CullingSystem.h"
+
+/**
+* Correctness checks of the cpu references of the engine, ran without a window
+* nor a gl context so that they can run on any machine (ci included).
+*
+* A check takes measures (an error, a count of mismatches...) and compares each
+* of them to an explicit bound, the check fails if any measure exceeds its bound.
+* The process exits with 1 if any check failed.
+*
+* Current checks:
+*  - g-buffer encoding: round-trip error of the octahedral normals and error of
+*    the positions reconstructed from a 24 bits depth buffer (see GBufferEncoding.h)
+*  - culling: the bitsets and index lists of CullingSystem against
+*    Frustum#isOnFrustum, for perspective and orthographic cameras, no mismatch allowed
+*  - shadow cache: static renders of the shadow cascades (see CascadedShadowCameras)
+*    under a still camera, once with a still sun and once with a sun that turns
+*    slower than the cache threshold
+*  - occlusion: boxes behind two walls must be reported occluded by the
+*    OcclusionBuffer, boxes peeking past their silhouettes or through the gap
+*    between them must be reported visible
+*
+* Command line:
+*   --checks               run the checks instead of a scene, no window is created
+*   --check-filter <text>  only run the checks whose name contains text
+*
+* Example usage:
+*   marble --checks
+*   marble --checks --check-filter culling
+*/
+namespace Checks {
+
+struct Options {
+  bool        enabled = false;
+  std::string filter;
+};
+
+struct Measure {
+  std::string name;
+  double      value;
+  double      bound; // the measure passes if value <= bound
+};
+
+struct Result {
+  std::string          name;
+  std::vector<Measure> measures;
+  std::string          error; // set if the check threw
+
+  bool passed() const;
+};
+
+/* Runs every check whose name contains the filter (all of them if it is empty) */
+std::vector<Result> runAll(const std::string &filter);
+
+/* Returns the number of failed checks */
+size_t printResults(std::ostream &out, const std::vector<Result> &results);
+
+/* Runs the checks as described by the options, returns the process exit code (1 if a check failed) */
+int run(const Options &options);
+
+/*
+* Compares the outputs of CullingSystem#cull with the reference visibility given
+* by Frustum#isOnFrustum for each box, returns the number of disagreements (a box
+* can be counted once for the bitset and once for the list).
+* Also used by the culling test scene.
+*/
+size_t countCullingMismatches(const std::vector<bool> &referenceVisibility,
+                              const Renderer::CullingSystem::VisibilityBitset &visibility,
+                              const std::vector<unsigned int> &visibleIndices);
+
+}
@@ -0,0 +1,215 @@
+#include "Flythrough.h"
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+#include "../vendor/imgui/imgui.h"
+#include "../abstraction/RenderDevice.h"
+#include "../World/CameraPath.h"
+#include "../World/Player.h"
+
+namespace Flythrough {
+
+static long long nanoTime()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+FrameProbe::FrameProbe()
+  : m_counter(&Renderer::getRenderDevice())
+{
+  m_counter.setStreamEnabled(false);
+  Renderer::setRenderDevice(&m_counter);
+
+  GLint counterBits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counterBits);
+  m_hasTimestamps = counterBits > 0;
+  if (m_hasTimestamps)
+    glGenQueries(2, m_timestampQueries);
+}
+
+FrameProbe::~FrameProbe()
+{
+  Renderer::setRenderDevice(nullptr);
+  if (m_hasTimestamps)
+    glDeleteQueries(2, m_timestampQueries);
+}
+
+void FrameProbe::beginFrame()
+{
+  m_counter.reset();
+  m_frameBegin = nanoTime();
+  if (m_hasTimestamps)
+    glQueryCounter(m_timestampQueries[0], GL_TIMESTAMP);
+}
+
+void FrameProbe::endSubmission()
+{
+  if (m_hasTimestamps)
+    glQueryCounter(m_timestampQueries[1], GL_TIMESTAMP);
+  m_submissionEnd = nanoTime();
+}
+
+FrameSample FrameProbe::endFrame()
+{
+  FrameSample sample;
+  sample.cpuTime = m_submissionEnd - m_frameBegin;
+  sample.frameTime = nanoTime() - m_frameBegin;
+  sample.gpuTime = -1;
+  sample.drawCalls = m_counter.getDrawCallCount();
+  sample.vertexCount = m_counter.getVertexCount();
+
+  if (m_hasTimestamps) {
+    // the frame was waited for, the results are available without stalling
+    GLuint64 begin, end;
+    glGetQueryObjectui64v(m_timestampQueries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(m_timestampQueries[1], GL_QUERY_RESULT, &end);
+    sample.gpuTime = (long long)(end - begin);
+  }
+
+  return sample;
+}
+
+void writeCsv(std::ostream &out, const std::vector<FrameSample> &samples, float timestep)
+{
+  out << "frame,time_s,cpu_ms,frame_ms,gpu_ms,draw_calls,vertices\n";
+  for (size_t i = 0; i < samples.size(); i++) {
+    const FrameSample &sample = samples[i];
+    out << i << ',' << i * timestep << ','
+        << sample.cpuTime * 1e-6 << ','
+        << sample.frameTime * 1e-6 << ',';
+    if (sample.gpuTime >= 0)
+      out << sample.gpuTime * 1e-6;
+    out << ',' << sample.drawCalls << ',' << sample.vertexCount << '\n';
+  }
+}
+
+/* Nearest-rank percentile of sorted values */
+static long long percentile(const std::vector<long long> &sorted, float p)
+{
+  size_t rank = (size_t)std::ceil(p / 100.f * sorted.size());
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static void printPercentiles(std::ostream &out, const char *name, std::vector<long long> times)
+{
+  std::sort(times.begin(), times.end());
+  out << " " << name << "_p50_ms=" << percentile(times, 50) * 1e-6
+      << " " << name << "_p95_ms=" << percentile(times, 95) * 1e-6
+      << " " << name << "_p99_ms=" << percentile(times, 99) * 1e-6
+      << " " << name << "_max_ms=" << times.back() * 1e-6;
+}
+
+void printReport(std::ostream &out, const std::string &sceneName, const std::vector<FrameSample> &samples)
+{
+  out << "scene=\"" << sceneName << "\" frames=" << samples.size();
+  if (samples.empty()) {
+    out << std::endl;
+    return;
+  }
+
+  std::vector<long long> frameTimes, cpuTimes, gpuTimes;
+  size_t drawCalls = 0, vertices = 0;
+  for (const FrameSample &sample : samples) {
+    frameTimes.push_back(sample.frameTime);
+    cpuTimes.push_back(sample.cpuTime);
+    if (sample.gpuTime >= 0)
+      gpuTimes.push_back(sample.gpuTime);
+    drawCalls += sample.drawCalls;
+    vertices += sample.vertexCount;
+  }
+
+  printPercentiles(out, "frame", frameTimes);
+  printPercentiles(out, "cpu", cpuTimes);
+  if (!gpuTimes.empty())
+    printPercentiles(out, "gpu", gpuTimes);
+
+  std::vector<long long> sortedFrameTimes = frameTimes;
+  std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+  long long median = percentile(sortedFrameTimes, 50);
+  size_t hitches = std::count_if(frameTimes.begin(), frameTimes.end(), [median](long long t) { return t > 2 * median; });
+
+  out << " hitches=" << hitches
+      << " avg_draw_calls=" << drawCalls / samples.size()
+      << " avg_vertices=" << vertices / samples.size()
+      << std::endl;
+}
+
+static World::CameraPath s_path;
+static World::CameraPose s_previewPose;
+static bool  s_recording = false;
+static bool  s_previewing = false;
+static float s_recordingTime = 0;
+static float s_recordingInterval = .5f; // in seconds, between two keyframes
+static float s_previewTime = 0;
+static char  s_pathFile[256] = "flythrough.path";
+static std::string s_status;
+
+void onImGuiRender()
+{
+  float delta = ImGui::GetIO().DeltaTime;
+
+  if (s_recording) {
+    s_recordingTime += delta;
+    if (s_path.isEmpty() || s_recordingTime - s_path.getDuration() >= s_recordingInterval)
+      s_path.addKeyframe(s_path.isEmpty() ? 0.f : s_recordingTime, Player::getLastSteppedPose());
+  }
+
+  if (s_previewing) {
+    s_previewTime = std::fmod(s_previewTime + delta, std::max(s_path.getDuration(), 1e-3f));
+    s_previewPose = s_path.sample(s_previewTime);
+  }
+
+  if (ImGui::Begin("Flythrough")) {
+    ImGui::InputText("Path file", s_pathFile, sizeof(s_pathFile));
+    ImGui::SliderFloat("Keyframe interval", &s_recordingInterval, .1f, 2.f, "%.1fs");
+
+    if (ImGui::Checkbox("Record", &s_recording) && s_recording) {
+      s_previewing = false;
+      Player::setPoseOverride(nullptr);
+      s_path.clear();
+      s_recordingTime = 0;
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(s_recording || s_path.isEmpty());
+    if (ImGui::Checkbox("Preview", &s_previewing)) {
+      s_previewTime = 0;
+      s_previewPose = s_path.sample(0);
+      Player::setPoseOverride(s_previewing ? &s_previewPose : nullptr);
+    }
+    ImGui::EndDisabled();
+
+    if (ImGui::Button("Save")) {
+      try {
+        s_path.saveToFile(s_pathFile);
+        s_status = "Saved " + std::string(s_pathFile);
+      } catch (const std::runtime_error &e) {
+        s_status = e.what();
+      }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+      try {
+        s_path = World::CameraPath::loadFromFile(s_pathFile);
+        s_status = "Loaded " + std::string(s_pathFile);
+      } catch (const std::runtime_error &e) {
+        s_status = e.what();
+      }
+      s_recording = false;
+      s_previewing = false;
+      Player::setPoseOverride(nullptr);
+    }
+
+    ImGui::Text("%zu keyframes, %.1fs", s_path.getKeyframes().size(), s_path.getDuration());
+    if (!s_status.empty())
+      ImGui::TextUnformatted(s_status.c_str());
+  }
+  ImGui::End();
+}
+
+}
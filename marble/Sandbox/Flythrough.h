@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "../abstraction/RecordingRenderDevice.h"
+
+/**
+* Flythroughs replay a camera path (see World::CameraPath) over a scene with a
+* fixed timestep and measure every frame, so that scenes can be compared across
+* builds on the exact same views.
+*
+* Every player follows the path during a replay (see Player#setPoseOverride),
+* which works with any scene that steps a Player. Each frame records its cpu
+* submission time, its total time (after a glFinish), its gpu time and the draw
+* calls and vertices that went through the render device. The gpu time is the
+* span between two timestamp queries placed around the frame, it is left empty
+* when the driver has no timestamp counter.
+*
+* Paths are recorded in the window from the live player camera with the
+* "Flythrough" panel, which can also preview a path.
+*
+* Command line (see Headless.h):
+*   --flythrough <path file>      replay the path headless instead of a fixed frame count
+*   --flythrough-output <csv>     per-frame measures, flythrough.csv by default
+*
+* Example usage:
+*   marble --flythrough paths/poc1.path --scene "POC 1" --resolution 1920x1080 --flythrough-output poc1.csv
+*/
+namespace Flythrough {
+
+struct FrameSample {
+  long long cpuTime;     // in nanoseconds, from the beginning of the frame to the end of its submission
+  long long frameTime;   // in nanoseconds, including the wait for the gpu
+  long long gpuTime;     // in nanoseconds, -1 if timestamp queries are not available
+  size_t    drawCalls;
+  size_t    vertexCount; // of direct draws only
+};
+
+/*
+* Measures the frames of a replay, while it exists the calls to the current
+* render device go through a counting device.
+*/
+class FrameProbe {
+private:
+  Renderer::RecordingRenderDevice m_counter;
+  unsigned int m_timestampQueries[2];
+  bool         m_hasTimestamps;
+  long long    m_frameBegin = 0;
+  long long    m_submissionEnd = 0;
+
+public:
+  FrameProbe();
+  ~FrameProbe();
+  FrameProbe(const FrameProbe &) = delete;
+  FrameProbe &operator=(const FrameProbe &) = delete;
+
+  bool hasGpuTimes() const { return m_hasTimestamps; }
+
+  void beginFrame();
+  /* To be called once every command of the frame was issued, before waiting for the gpu */
+  void endSubmission();
+  /* To be called after a glFinish */
+  FrameSample endFrame();
+};
+
+void writeCsv(std::ostream &out, const std::vector<FrameSample> &samples, float timestep);
+/* Prints the p50/p95/p99/max frame times and the number of hitches (frames longer than twice the median) */
+void printReport(std::ostream &out, const std::string &sceneName, const std::vector<FrameSample> &samples);
+
+/* Recording and preview of camera paths, in windowed mode */
+void onImGuiRender();
+
+}
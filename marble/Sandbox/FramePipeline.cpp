@@ -0,0 +1,71 @@
+#include "FramePipeline.h"
+
+#include <cassert>
+
+#include "../Utils/Profiler.h"
+
+namespace FramePipeline {
+
+SimulationThread::SimulationThread()
+  : m_thread(&SimulationThread::loop, this)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+void SimulationThread::run(std::function<void()> job)
+{
+  {
+    std::lock_guard lock(m_mutex);
+    assert(!m_busy);
+    m_job = std::move(job);
+    m_busy = true;
+  }
+  m_condition.notify_all();
+}
+
+void SimulationThread::wait()
+{
+  std::exception_ptr exception;
+  {
+    std::unique_lock lock(m_mutex);
+    m_condition.wait(lock, [this] { return !m_busy; });
+    std::swap(exception, m_exception);
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+void SimulationThread::loop()
+{
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    m_condition.wait(lock, [this] { return m_busy || m_stopping; });
+    if (m_stopping)
+      return;
+
+    std::function<void()> job = std::move(m_job);
+    lock.unlock();
+    try {
+      MARBLE_PROFILE_SCOPE("Simulation thread");
+      job();
+    } catch (...) {
+      lock.lock();
+      m_exception = std::current_exception();
+      lock.unlock();
+    }
+    lock.lock();
+    m_busy = false;
+    m_condition.notify_all();
+  }
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/**
+* The frame pipeline overlaps the simulation of a frame with the submission of
+* the previous one: while the GL thread renders frame N, a simulation thread
+* steps the scene and builds frame N+1 (cameras, transforms, visibility...).
+* The rendered frames lag one frame behind the simulation.
+*
+* Scenes opt in (see Scene#isPipelined) by splitting their rendering in two:
+*  - #Scene::buildFrame, on the simulation thread after the ticks of a frame,
+*    writes everything the rendering needs in the back packet of a FramePackets,
+*  - #Scene::onRender, on the GL thread, only reads the front packet and the
+*    resources that never change while the scene runs.
+* The packets are swapped between two frames, while the simulation thread is
+* idle. Events, the gui and scene switches also happen while it is idle, so
+* #Scene::step and #Scene::onImGuiRender do not need to be synchronized. The
+* simulation thread must not call GL, the context is current on the GL thread.
+*
+* Other scenes keep stepping and rendering on the GL thread.
+*
+* Example usage (each frame):
+*   simulationThread.run([&] { scene.step(delta); scene.buildFrame(); });
+*   scene.onRender();        // reads the front packet
+*   simulationThread.wait(); // rethrows what the job threw
+*   scene.swapFrames();
+*/
+namespace FramePipeline {
+
+/*
+* Double-buffered frame data, the back packet is written by the simulation and
+* the front packet is read by the rendering. A packet is not cleared when it
+* becomes the back packet again, containers can be reused without allocating.
+*/
+template<class T>
+class FramePackets {
+private:
+  T      m_packets[2]{};
+  size_t m_front = 0;
+
+public:
+  T &back() { return m_packets[1 - m_front]; }
+  const T &front() const { return m_packets[m_front]; }
+  void swap() { m_front = 1 - m_front; }
+};
+
+/* A thread that runs one job at a time, jobs are given by the GL thread */
+class SimulationThread {
+private:
+  std::mutex              m_mutex;
+  std::condition_variable m_condition;
+  std::function<void()>   m_job;
+  std::exception_ptr      m_exception;
+  bool                    m_busy = false;
+  bool                    m_stopping = false;
+  std::thread             m_thread; // last, the other members must exist when it starts
+
+public:
+  SimulationThread();
+  ~SimulationThread();
+  SimulationThread(const SimulationThread &) = delete;
+  SimulationThread &operator=(const SimulationThread &) = delete;
+
+  /* Starts the job on the thread, the previous job must have been waited for */
+  void run(std::function<void()> job);
+  /* Blocks until the current job is done, rethrows the exception it threw if any */
+  void wait();
+
+private:
+  void loop();
+};
+
+}
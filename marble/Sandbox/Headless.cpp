@@ -0,0 +1,159 @@
+#include "Headless.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+#include <glad/glad.h>
+
+#include "../abstraction/FrameBufferObject.h"
+#include "../abstraction/Texture.h"
+
+namespace Headless {
+
+struct OffscreenTarget {
+  Renderer::Texture           color;
+  Renderer::Texture           depth;
+  Renderer::FrameBufferObject fbo;
+};
+
+static OffscreenTarget *s_offscreenTarget = nullptr;
+
+static unsigned int parseUnsigned(const char *arg, const char *option)
+{
+  char *end;
+  unsigned long value = std::strtoul(arg, &end, 10);
+  if (end == arg || *end != '\0' || value == 0)
+    throw std::runtime_error(std::string("Invalid value for ") + option + ": " + arg);
+  return (unsigned int)value;
+}
+
+static float parseFloat(const char *arg, const char *option, bool allowZero)
+{
+  char *end;
+  float value = std::strtof(arg, &end);
+  if (end == arg || *end != '\0' || value < 0 || (value == 0 && !allowZero))
+    throw std::runtime_error(std::string("Invalid value for ") + option + ": " + arg);
+  return value;
+}
+
+Options parseCommandLine(int argc, const char *const *argv)
+{
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (std::strcmp(arg, "--headless") == 0) {
+      options.enabled = true;
+    } else if (std::strcmp(arg, "--scene") == 0 && hasValue) {
+      options.scene = argv[++i];
+    } else if (std::strcmp(arg, "--frames") == 0 && hasValue) {
+      options.frames = parseUnsigned(argv[++i], arg);
+    } else if (std::strcmp(arg, "--timestep") == 0 && hasValue) {
+      char *end;
+      const char *value = argv[++i];
+      options.timestep = std::strtof(value, &end);
+      if (end == value || *end != '\0' || options.timestep <= 0)
+        throw std::runtime_error(std::string("Invalid value for --timestep: ") + value);
+    } else if (std::strcmp(arg, "--resolution") == 0 && hasValue) {
+      std::string value = argv[++i];
+      size_t separator = value.find('x');
+      if (separator == std::string::npos)
+        throw std::runtime_error("Invalid value for --resolution: " + value + ", expected <width>x<height>");
+      options.width = parseUnsigned(value.substr(0, separator).c_str(), arg);
+      options.height = parseUnsigned(value.substr(separator + 1).c_str(), arg);
+    } else if (std::strcmp(arg, "--fps") == 0 && hasValue) {
+      options.targetFramerate = parseFloat(argv[++i], arg, true);
+    } else if (std::strcmp(arg, "--no-vsync") == 0) {
+      options.vsync = false;
+    } else if (std::strcmp(arg, "--tick-rate") == 0 && hasValue) {
+      options.tickRate = parseFloat(argv[++i], arg, false);
+    } else if (std::strcmp(arg, "--no-pipelining") == 0) {
+      options.pipelining = false;
+    } else if (std::strcmp(arg, "--flythrough") == 0 && hasValue) {
+      options.enabled = true;
+      options.flythroughPath = argv[++i];
+    } else if (std::strcmp(arg, "--flythrough-output") == 0 && hasValue) {
+      options.flythroughOutput = argv[++i];
+    } else if (std::strcmp(arg, "--benchmarks") == 0) {
+      options.enabled = true;
+      options.benchmarks.enabled = true;
+    } else if (std::strcmp(arg, "--benchmark-filter") == 0 && hasValue) {
+      options.benchmarks.filter = argv[++i];
+    } else if (std::strcmp(arg, "--benchmark-repetitions") == 0 && hasValue) {
+      options.benchmarks.repetitions = parseUnsigned(argv[++i], arg);
+    } else if (std::strcmp(arg, "--benchmark-output") == 0 && hasValue) {
+      options.benchmarks.outputPath = argv[++i];
+    } else if (std::strcmp(arg, "--benchmark-baseline") == 0 && hasValue) {
+      options.benchmarks.baselinePath = argv[++i];
+    } else if (std::strcmp(arg, "--benchmark-threshold") == 0 && hasValue) {
+      char *end;
+      const char *value = argv[++i];
+      options.benchmarks.regressionThreshold = std::strtof(value, &end);
+      if (end == value || *end != '\0' || options.benchmarks.regressionThreshold < 0)
+        throw std::runtime_error(std::string("Invalid value for --benchmark-threshold: ") + value);
+    } else if (std::strcmp(arg, "--checks") == 0) {
+      options.checks.enabled = true;
+    } else if (std::strcmp(arg, "--check-filter") == 0 && hasValue) {
+      options.checks.filter = argv[++i];
+    } else {
+      throw std::runtime_error(std::string("Unknown or incomplete argument: ") + arg);
+    }
+  }
+
+  return options;
+}
+
+void createOffscreenTarget(unsigned int width, unsigned int height)
+{
+  assert(s_offscreenTarget == nullptr);
+
+  s_offscreenTarget = new OffscreenTarget{
+    Renderer::Texture::createTargetTexture(width, height, GL_RGBA8),
+    Renderer::Texture::createDepthTexture(width, height),
+    Renderer::FrameBufferObject{},
+  };
+  s_offscreenTarget->fbo.setTargetTexture(s_offscreenTarget->color);
+  s_offscreenTarget->fbo.setDepthTexture(s_offscreenTarget->depth);
+
+  // never unbound, the stack rebinds it whenever the framebuffers above it are unbound
+  s_offscreenTarget->fbo.bind();
+  s_offscreenTarget->fbo.setViewportToTargetTexture();
+}
+
+void destroyOffscreenTarget()
+{
+  if (s_offscreenTarget == nullptr)
+    return;
+  Renderer::FrameBufferObject::unbind();
+  delete s_offscreenTarget;
+  s_offscreenTarget = nullptr;
+}
+
+void FrameRecorder::printReport(std::ostream &out, const std::string &sceneName) const
+{
+  if (m_frameTimes.empty()) {
+    out << "scene=\"" << sceneName << "\" frames=0" << std::endl;
+    return;
+  }
+
+  std::vector<long long> sorted = m_frameTimes;
+  std::sort(sorted.begin(), sorted.end());
+  long long total = std::accumulate(sorted.begin(), sorted.end(), 0ll);
+
+  out << "scene=\"" << sceneName << "\""
+      << " frames=" << sorted.size()
+      << " total_ms=" << total * 1e-6
+      << " avg_ms=" << total * 1e-6 / sorted.size()
+      << " min_ms=" << sorted.front() * 1e-6
+      << " median_ms=" << sorted[sorted.size() / 2] * 1e-6
+      << " max_ms=" << sorted.back() * 1e-6
+      << std::endl;
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "Benchmarks.h"
+#include "Checks.h"
+
+/**
+* Runs without a display, for benchmarks on machines that have no screen.
+*
+* In headless mode the window is hidden and backed by an offscreen context (see
+* Window#createHeadlessWindow), every frame is drawn to an offscreen framebuffer
+* of the requested resolution and the scene is stepped with a fixed timestep for
+* a fixed number of frames so that two runs do the same work.
+*
+* Command line:
+*   --headless                 run without a display
+*   --scene <name|index>       scene to start on, also works with a window
+*   --frames <n>               number of frames of a headless run
+*   --timestep <seconds>       fixed delta of a headless run
+*   --resolution <w>x<h>       size of the offscreen framebuffer
+*   --benchmarks ...           run the cpu benchmarks (see Benchmarks.h)
+*   --checks ...               run the correctness checks, without a window (see Checks.h)
+*   --fps <n>                  frame limiter target of windowed runs, 0 for no limit
+*   --no-vsync                 do not wait for the display in windowed runs
+*   --tick-rate <n>            simulation ticks per second of windowed runs
+*   --no-pipelining            step pipelined scenes on the GL thread (see FramePipeline.h)
+*   --flythrough <file>        replay a camera path instead of --frames (see Flythrough.h)
+*   --flythrough-output <csv>  per-frame measures of the replay
+*
+* Example usage:
+*   marble --headless --scene "Clustered lights" --frames 1000 --resolution 1920x1080
+*/
+namespace Headless {
+
+struct Options {
+  bool         enabled = false;
+  std::string  scene;              // empty to keep the default scene
+  unsigned int frames = 600;
+  float        timestep = 1.f / 60.f;
+  unsigned int width = 16 * 70;
+  unsigned int height = 9 * 70;
+  float        targetFramerate = 0;  // of the frame limiter, 0 to rely on vsync
+  bool         vsync = true;
+  float        tickRate = 60.f;      // headless runs tick once per frame instead
+  bool         pipelining = true;
+  Benchmarks::Options benchmarks;
+  Checks::Options checks;
+  std::string  flythroughPath;     // empty for a fixed frame count run
+  std::string  flythroughOutput = "flythrough.csv";
+};
+
+/* Throws std::runtime_error on unknown or malformed arguments */
+Options parseCommandLine(int argc, const char *const *argv);
+
+/*
+* Creates the framebuffer every frame is drawn to, it is kept at the bottom of the
+* framebuffer stack so that unbinding any other framebuffer falls back to it.
+* Must be called once the renderer is initialized.
+*/
+void createOffscreenTarget(unsigned int width, unsigned int height);
+void destroyOffscreenTarget();
+
+/* Per-frame timings of a run, frames are measured after a glFinish so they include the gpu work */
+class FrameRecorder {
+private:
+  std::vector<long long> m_frameTimes; // in nanoseconds
+
+public:
+  void reserve(size_t frames) { m_frameTimes.reserve(frames); }
+  void addFrame(long long nanoseconds) { m_frameTimes.push_back(nanoseconds); }
+
+  const std::vector<long long> &getFrameTimes() const { return m_frameTimes; }
+  void printReport(std::ostream &out, const std::string &sceneName) const;
+};
+
+}
@@ -1,6 +1,7 @@
 #include "Scene.h"
 
 #include <vector>
+#include <algorithm>
 
 #include "../vendor/imgui/imgui.h"
 
@@ -36,7 +37,7 @@ void switchToScene(size_t sceneIndex)
 {
   // restore the default mesh shader for scenes that do not overwrite it
   // this also has the effect of reseting uniforms
-  Renderer::rebuildStandardMeshShader(Renderer::ShaderFactory()
+  auto &standardMeshShader = Renderer::rebuildStandardMeshShader(Renderer::ShaderFactory()
     .prefix("res/shaders/")
     .addFileVertex("standard.vs")
     .prefix("mesh_parts/")
@@ -48,10 +49,12 @@ void switchToScene(size_t sceneIndex)
     .addFileFragment("normal_none.fs"));
 
   int samplers[8] = { 0,1,2,3,4,5,6,7 };
-  Renderer::getStandardMeshShader()->bind();
-  Renderer::getStandardMeshShader()->setUniform1iv("u_Textures2D", 8, samplers);
+  standardMeshShader->bind();
+  standardMeshShader->setUniform1iv("u_Textures2D", 8, samplers);
+  Renderer::setFogParameters(); // fog is not part of the shader uniforms, it is kept by the renderer
 
   delete s_activeScene;
+  Renderer::setUniformPointLights({}); // the light buffer is shared by all scenes
   auto &[name, provider] = s_availableScenes[sceneIndex];
   s_activeScene = provider();
   s_activeSceneIndex = sceneIndex;
@@ -67,6 +70,21 @@ void onRender()
   s_activeScene->onRender();
 }
 
+bool isPipelined()
+{
+  return s_activeScene->isPipelined();
+}
+
+void buildFrame()
+{
+  s_activeScene->buildFrame();
+}
+
+void swapFrames()
+{
+  s_activeScene->swapFrames();
+}
+
 void onImGuiRender()
 {
   s_activeScene->onImGuiRender();
@@ -89,4 +107,30 @@ void registerScene(const std::string &name, SceneProvider provider)
   s_availableScenes.push_back(std::make_pair(name, provider));
 }
 
+size_t getSceneCount()
+{
+  return s_availableScenes.size();
+}
+
+const std::string &getSceneName(size_t index)
+{
+  return s_availableScenes[index].first;
+}
+
+size_t findScene(const std::string &nameOrIndex)
+{
+  for (size_t i = 0; i < s_availableScenes.size(); i++) {
+    if (s_availableScenes[i].first == nameOrIndex)
+      return i;
+  }
+
+  if (!nameOrIndex.empty() && std::all_of(nameOrIndex.begin(), nameOrIndex.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+    size_t index = std::stoul(nameOrIndex);
+    if (index < s_availableScenes.size())
+      return index;
+  }
+
+  return -1;
+}
+
 }
\ No newline at end of file
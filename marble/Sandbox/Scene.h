@@ -33,6 +33,16 @@ public:
   virtual void onImGuiRender() = 0;
 
   virtual Renderer::Camera& getCamera() = 0;
+
+  /*
+  * Pipelined scenes are stepped and build their frames on the simulation thread
+  * while the previous frame is rendered (see FramePipeline.h), their #onRender
+  * only reads the packet swapped by #swapFrames. A pipelined scene must have a
+  * front packet ready once constructed.
+  */
+  virtual bool isPipelined() const { return false; }
+  virtual void buildFrame() {}
+  virtual void swapFrames() {}
 };
 
 typedef std::function<Scene *()> SceneProvider;
@@ -49,6 +59,10 @@ void shutdown();
 void step(float delta);
 void onRender();
 void onImGuiRender();
+// see Scene#isPipelined
+bool isPipelined();
+void buildFrame();
+void swapFrames();
 
 void registerScene(const std::string &name, SceneProvider provider);
 template<class T>
@@ -56,4 +70,9 @@ void registerScene(const std::string &name) { registerScene(name, []() { return
 
 void switchToScene(size_t index);
 
+size_t getSceneCount();
+const std::string &getSceneName(size_t index);
+// accepts the name of a registered scene or its index, returns -1 if there is no such scene
+size_t findScene(const std::string &nameOrIndex);
+
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "../../abstraction/UnifiedRenderer.h"
 #include "../../abstraction/FrameBufferObject.h"
 #include "../../abstraction/pipeline/VFXPipeline.h"
+#include "../../Utils/Profiler.h"
 
 /* ========  A mountainy scene with erosion, shadows and flares  ======== */
 
@@ -55,10 +56,9 @@ public:
     meshShader->bind();
     meshShader->setUniform1iv("u_Textures2D", 8, samplers);
     meshShader->setUniform1f("u_Strength", m_sun.strength);
-    meshShader->setUniform3f("u_fogDamping", .001f, .001f, .001f);
-    meshShader->setUniform3f("u_fogColor", 1.f, 1.f, 1.f);
     meshShader->setUniform2f("u_grassSteepness", .79f, 1.f);
     Renderer::Shader::unbind();
+    Renderer::setFogParameters({ .001f, .001f, .001f }, { 1.f, 1.f, 1.f });
 
     m_depthTexture = std::make_shared<Renderer::Texture>(Renderer::Texture::createDepthTexture(1600 * 16 / 9, 1600));
     m_depthFBO.setDepthTexture(*m_depthTexture);
@@ -158,18 +158,26 @@ public:
     meshShader->setUniform1i("u_shadowMap", 5);
     Renderer::Shader::unbind();
 
-    Renderer::beginDepthPass();
-    m_depthFBO.bind();
-    m_depthFBO.setViewportToTexture(*m_depthTexture);
-    renderSceneDepthPass();
+    {
+      MARBLE_PROFILE_SCOPE("Shadow map");
+      MARBLE_PROFILE_GPU_SCOPE("Shadow map");
+      Renderer::beginDepthPass();
+      m_depthFBO.bind();
+      m_depthFBO.setViewportToTexture(*m_depthTexture);
+      renderSceneDepthPass();
+    }
 
     Renderer::beginColorPass();
     Renderer::FrameBufferObject::unbind();
     Renderer::FrameBufferObject::setViewportToWindow();
 
-    m_pipeline.bind();
-    renderScene();
-    m_pipeline.unbind();
+    {
+      MARBLE_PROFILE_SCOPE("Color pass");
+      MARBLE_PROFILE_GPU_SCOPE("Color pass");
+      m_pipeline.bind();
+      renderScene();
+      m_pipeline.unbind();
+    }
 
     m_pipeline.renderPipeline();
   }
@@ -10,6 +10,7 @@
 #include "../../World/Light/LightManager.h"
 #include "../../abstraction/UnifiedRenderer.h"
 #include "../../abstraction/FrameBufferObject.h"
+#include "../../Utils/Profiler.h"
 
 #include <queue>
 
@@ -37,7 +38,7 @@ private:
   Renderer::InstancedMesh  m_smallTrees;
   Renderer::Mesh           m_lowPolyFatTreeMesh = Renderer::loadMeshFromFile("res/meshes/fattree.obj");
 
-  World::LightRenderer m_light; // holds 12 lights, todo : change this
+  World::LightRenderer m_light;
 
 public:
   POC2Scene()
@@ -162,6 +163,8 @@ public:
 
   void onRender() override
   {
+    MARBLE_PROFILE_SCOPE("Color pass");
+    MARBLE_PROFILE_GPU_SCOPE("Color pass");
     Renderer::clear();
 
     Renderer::Camera &camera = m_player.getCamera();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <random>
+
 #include "../Scene.h"
 #include "../../World/Sky.h"
 #include "../../World/Grass.h"
@@ -8,6 +10,8 @@
 #include "../../World/TerrainGeneration/Terrain.h"
 #include "../../World/TerrainGeneration/Noise.h"
 #include "../../abstraction/UnifiedRenderer.h"
+#include "../../abstraction/MaterialTable.h"
+#include "../../abstraction/MultiViewCulling.h"
 #include "../../abstraction/FrameBufferObject.h"
 #include "../../abstraction/pipeline/VFXPipeline.h"
 
@@ -15,6 +19,8 @@
 
 class POC3Scene : public Scene {
 private:
+  static constexpr unsigned int PROPS_TEXTURE_SIZE = 512;
+
   Player               m_player;
   float                m_realTime;
   glm::vec3            m_sun{ 1000,1000,1000 };
@@ -28,8 +34,12 @@ private:
   World::Sky           m_sky{World::Sky::SkyboxesType::SAND};
   World::LightRenderer m_light;
   World::PropsManager  m_props;
+  std::shared_ptr<Renderer::Shader> m_propsShader;
   World::Water         m_water;
 
+  Renderer::MultiViewCulling m_views;
+  std::vector<Renderer::CullingSystem::VisibilityBitset> m_chunksVisibility;
+
 public:
   POC3Scene()
   {
@@ -53,17 +63,9 @@ public:
       meshShader->setUniform1iv("u_NormalsTextureSlot", 8, normals_samplers);
       meshShader->setUniform1iv("u_Textures2D", 8, samplers);
       meshShader->setUniform1f("u_Strength", 1.25f);
-      meshShader->setUniform3f("u_fogDamping", .005f, .005f, .007f);
-      meshShader->setUniform3f("u_fogColor", 1.000f, 0.944f, 0.102f);
       meshShader->setUniform3f("u_SunPos", 1000,1000,1000);
       Renderer::Shader::unbind();
-    }
-
-    { // props
-      auto arch = std::make_shared<Renderer::Mesh>(Renderer::loadMeshFromFile("res/meshes/SmallArch_Obj.obj"));
-      arch->getTransform().position = { 65,26,40 };
-      arch->getTransform().scale = { .5f,.5f,.5f };
-      m_props.feed(arch);
+      Renderer::setFogParameters({ .005f, .005f, .007f }, { 1.000f, 0.944f, 0.102f });
     }
 
     { // VFX stuff
@@ -107,6 +109,73 @@ public:
       m_terrain.setMaterial(material);
     }
 
+    { // props, they all share one material and select their texture and tint in a material table
+      Renderer::TextureArrayManager textures;
+      auto materials = std::make_shared<Renderer::MaterialTable>(PROPS_TEXTURE_SIZE);
+      auto addMaterial = [&](const char *texturePath, const glm::vec4 &tint) {
+        return materials->addMaterial(textures.loadTexture(texturePath, PROPS_TEXTURE_SIZE), tint);
+      };
+      unsigned int sandstone = addMaterial("res/textures/sand1.jpg", { 1.f, .9f, .75f, 1.f });
+      unsigned int ruins = addMaterial("res/textures/wallpoly.jpg", { 1.f, .95f, .85f, 1.f });
+      unsigned int darkRuins = addMaterial("res/textures/wallpoly.jpg", { .7f, .62f, .55f, 1.f });
+      unsigned int rock = addMaterial("res/textures/Rock_9_Base_Color.jpg", { 1.f, 1.f, 1.f, 1.f });
+
+      m_propsShader = Renderer::ShaderFactory()
+        .prefix("res/shaders/")
+        .addFileVertex("standard.vs")
+        .prefix("mesh_parts/")
+        .addFileFragment("base.fs")
+        .addFileFragment("color_materials.fs")
+        .addFileFragment("lights_pointlights.fs")
+        .addFileFragment("final_fog.fs")
+        .addFileFragment("shadows_normal.fs")
+        .addFileFragment("normal_none.fs")
+        .build();
+      m_propsShader->bind();
+      m_propsShader->setUniform3f("u_SunPos", 1000, 1000, 1000);
+      Renderer::Shader::unbind();
+
+      auto material = std::make_shared<Renderer::Material>();
+      material->shader = m_propsShader;
+      material->textureArray = materials->getTextureArray();
+      material->materialTable = materials;
+
+      auto loadModel = [](const char *objPath, unsigned int materialIndex) {
+        Renderer::ObjFile obj = Renderer::readObjFile(objPath);
+        Renderer::MaterialTable::assignMaterial(obj.vertices, materialIndex);
+        return std::make_shared<Renderer::Model>(obj.vertices, obj.indices);
+      };
+      auto addProp = [&](const std::shared_ptr<Renderer::Model> &model, float x, float z, float scale, float yaw) {
+        auto prop = std::make_shared<Renderer::Mesh>(model, material);
+        prop->getTransform().position = { x, m_heightmap.isInBounds(x, z) ? m_heightmap(x, z) : 0.f, z };
+        prop->getTransform().scale = glm::vec3{ scale };
+        prop->getTransform().rotation = glm::angleAxis(yaw, glm::vec3{ 0, 1, 0 });
+        m_props.feed(prop);
+      };
+
+      auto arch = std::make_shared<Renderer::Mesh>(loadModel("res/meshes/SmallArch_Obj.obj", sandstone), material);
+      arch->getTransform().position = { 65,26,40 };
+      arch->getTransform().scale = { .5f,.5f,.5f };
+      m_props.feed(arch);
+
+      // the ruins of a colonnade, along a broken wall
+      auto pillar = loadModel("res/meshes/pillar.obj", ruins);
+      auto wall = loadModel("res/meshes/wall.obj", darkRuins);
+      for (int i = 0; i < 8; i++) {
+        addProp(pillar, 200.f + i * 12.f, 220.f, 2.f, 0);
+        if (i % 3 != 2)
+          addProp(wall, 206.f + i * 12.f, 232.f, 3.f, Mathf::PI * .5f);
+      }
+
+      auto boulder = loadModel("res/meshes/Rock_9.obj", rock);
+      std::mt19937 rng(0);
+      std::uniform_real_distribution<float> positionDistribution(20.f, 380.f);
+      std::uniform_real_distribution<float> scaleDistribution(.01f, .03f);
+      std::uniform_real_distribution<float> yawDistribution(0, 2 * Mathf::PI);
+      for (int i = 0; i < 24; i++)
+        addProp(boulder, positionDistribution(rng), positionDistribution(rng), scaleDistribution(rng), yawDistribution(rng));
+    }
+
     // Water stuff
     m_water.addSource({ 80,9.2f,80 }, { 160,160 });
   }
@@ -123,13 +192,12 @@ public:
     m_water.updateMoveFactor(realDelta);
   }
 
-  void renderScene() 
+  void renderScene(const Renderer::Camera &camera, Renderer::MultiViewCulling::ViewIndex view)
   {
-    Renderer::Camera& camera = m_player.getCamera();
     Renderer::clear();
     
-    Renderer::renderMeshTerrain(camera, m_terrain);
-    m_props.render(camera);
+    Renderer::renderMeshTerrain(camera, m_terrain, m_chunksVisibility[view]);
+    m_props.render(camera, view);
     m_sky.render(camera, m_realTime);
   }
 
@@ -140,7 +208,22 @@ public:
     m_pipeline.setContextParam<Renderer::Camera>("camera", getCamera());
     m_pipeline.bind();
 
-    m_water.onRender([this]() -> void { renderScene(); }, getCamera());
+    // cull terrain and props once for all water passes, refraction and final passes use the main camera
+    const Renderer::Camera &camera = getCamera();
+    m_views.clearViews();
+    Renderer::MultiViewCulling::ViewIndex mainView = m_views.addView(camera);
+    Renderer::MultiViewCulling::ViewIndex reflectionView = m_views.addView(m_water.getReflectionCamera(camera));
+    m_views.cull(m_terrain.getChunksCulling(), m_chunksVisibility);
+    m_props.cullViews(m_views);
+
+    m_water.onRender([&](const Renderer::Camera &passCamera, World::WaterPass pass) -> void {
+      // the water only sets the clipping plane of the standard mesh shader
+      float waterHeight = m_water.getSourceAt(0).position.y;
+      m_propsShader->bind();
+      m_propsShader->setUniform4f("u_plane", pass == World::WaterPass::REFLECTION ? glm::vec4(0, 1, 0, -waterHeight) : glm::vec4(0, -1, 0, waterHeight));
+      Renderer::Shader::unbind();
+      renderScene(passCamera, pass == World::WaterPass::REFLECTION ? reflectionView : mainView);
+    }, camera);
     m_pipeline.unbind();
     m_pipeline.renderPipeline();
   }
@@ -1,32 +1,48 @@
 #pragma once
 
+#include <glm/gtc/constants.hpp>
+
 #include "../Scene.h"
 #include "../../World/Sky.h"
 #include "../../World/Grass.h"
-#include "../../World/SunCameraHelper.h"
+#include "../../World/CascadedShadowMaps.h"
 #include "../../World/TerrainGeneration/Terrain.h"
 #include "../../World/TerrainGeneration/Noise.h"
 #include "../../abstraction/UnifiedRenderer.h"
-#include "../../abstraction/FrameBufferObject.h"
+#include "../../abstraction/MultiViewCulling.h"
+#include "../../Utils/FramePacing.h"
+#include "../../Utils/Profiler.h"
+#include "../FramePipeline.h"
 
 /* ========  A mesa scene with shadows and custom terrain shader (custom terrain showcase)  ======== */
 
-// FIX shadows in the mesa POC
-
+/* Pipelined, the player, the sun, the cubes and the chunks culling are done on the simulation thread */
 class POC4Scene : public Scene {
 private:
+  // everything the rendering reads of the simulation
+  struct Frame {
+    Renderer::Camera camera;
+    glm::vec3        sunDirection;
+    float            realTime;
+    Transform        dynamicCubeTransforms[3];
+    std::vector<Renderer::CullingSystem::VisibilityBitset> chunksVisibility; // of the player's view
+  };
+
   Player                m_player;
   Renderer::TerrainMesh m_terrain;
   World::Sky            m_sky;
-  float                 m_realTime;
+  float                 m_realTime = 0;
 
-  Renderer::FrameBufferObject m_depthFBO;
-  std::shared_ptr<Renderer::Texture> m_depthTexture;
+  static constexpr unsigned int SHADOW_MAPS_SLOT = 5;
+  World::CascadedShadowMaps m_shadows;
+  std::vector<AABB>         m_staticShadowCasters;
+  glm::vec3                 m_sunDirection{ 1.f, .5f, 0.f };
+  bool                      m_animateSun = true;
+  Renderer::Mesh            m_dynamicCubes[3];
+  FramePacing::Interpolated<Transform> m_dynamicCubeTransforms[3]; // simulated transforms, the meshes get the interpolated ones
 
-  struct Sun {
-    Renderer::Camera camera;
-    SunCameraHelper shadowCameraHelper;
-  } m_sun;
+  Renderer::MultiViewCulling m_views;
+  FramePipeline::FramePackets<Frame> m_frames;
 
 public:
   POC4Scene()
@@ -44,22 +60,27 @@ public:
       .addFileFragment("color_mesa.fs")
       .addFileFragment("lights_none.fs")
       .addFileFragment("final_fog.fs")
-      .addFileFragment("shadows_casted.fs")
+      .addFileFragment("shadows_cascaded.fs")
       .addFileFragment("normal_none.fs"));
     int samplers[8] = { 0,1,2,3,4,5,6,7 };
     meshShader->bind();
     meshShader->setUniform1iv("u_Textures2D", 8, samplers);
     meshShader->setUniform1f("u_Strength", 1.25f);
-    meshShader->setUniform3f("u_fogDamping", .005f, .005f, .007f);
-    meshShader->setUniform3f("u_fogColor", 1.000f, 0.944f, 0.102f);
     Renderer::Shader::unbind();
-    m_depthTexture = std::unique_ptr<Texture>(new Texture(Texture::createDepthTexture(1600 * 16 / 9, 1600)));
-    m_depthFBO.setDepthTexture(*m_depthTexture);
+    Renderer::setFogParameters({ .005f, .005f, .007f }, { 1.000f, 0.944f, 0.102f });
     auto terrainMaterial = std::make_shared<Renderer::Material>();
+    auto cubesMaterial = std::make_shared<Renderer::Material>();
     terrainMaterial->shader = meshShader;
     terrainMaterial->textures[0] = std::make_shared<Texture>("res/textures/sand.jpg");
-    terrainMaterial->textures[5] = m_depthTexture;
+    cubesMaterial->shader = meshShader;
+    for (unsigned int i = 0; i < m_shadows.getCascadeCount(); i++) {
+      terrainMaterial->textures[SHADOW_MAPS_SLOT + i] = m_shadows.getDepthTexture(i);
+      cubesMaterial->textures[SHADOW_MAPS_SLOT + i] = m_shadows.getDepthTexture(i);
+    }
     m_terrain.setMaterial(terrainMaterial);
+    std::shared_ptr<Renderer::Model> cubeModel = Renderer::createCubeModel();
+    for (Renderer::Mesh &cube : m_dynamicCubes)
+      cube = Renderer::Mesh(cubeModel, cubesMaterial);
 
     { // terrain
       constexpr float height = 10;
@@ -89,6 +110,13 @@ public:
       }
       m_terrain.rebuildMesh(heightmap, { 0,0, noiseMapSize,noiseMapSize });
     }
+
+    // the terrain never changes, its shadows are cached by the cascades
+    for (const auto &chunk : m_terrain.getChunks())
+      m_staticShadowCasters.push_back(chunk.worldBoundingBox);
+
+    buildFrame();
+    swapFrames();
   }
   
   void step(float realDelta) override
@@ -96,73 +124,94 @@ public:
     m_player.step(realDelta);
     m_player.updateCamera();
     m_realTime += realDelta;
-  }
 
-  void repositionSunCamera(const Renderer::Frustum &visibleFrustum)
-  {
-    m_sun.shadowCameraHelper.setSunDirection({ glm::cos(m_realTime/10.f), .5f, glm::sin(m_realTime/10.f) });
-    m_sun.shadowCameraHelper.prepareSunCameraMovement();
-    for (const auto &chunk : m_terrain.getChunks()) {
-      const AABB &chunkAABB = chunk.worldBoundingBox;
-      if (visibleFrustum.isOnFrustum(chunkAABB))
-        m_sun.shadowCameraHelper.ensureCanReceiveShadows(chunkAABB);
-    }
+    if (m_animateSun)
+      m_sunDirection = { glm::cos(m_realTime/10.f), .5f, glm::sin(m_realTime/10.f) };
 
-    m_sun.shadowCameraHelper.prepareSunCameraCasting();
-    for (const auto &chunk : m_terrain.getChunks()) {
-      const AABB &chunkAABB = chunk.worldBoundingBox;
-      m_sun.shadowCameraHelper.ensureCanCastShadows(chunkAABB);
+    // cubes flying around the player are dynamic shadow casters
+    for (size_t i = 0; i < std::size(m_dynamicCubes); i++) {
+      float angle = m_realTime + i * glm::two_pi<float>() / std::size(m_dynamicCubes);
+      Transform transform = m_dynamicCubeTransforms[i].get();
+      transform.position = m_player.getPosition() + glm::vec3{ glm::cos(angle) * 6.f, 4.f, glm::sin(angle) * 6.f };
+      m_dynamicCubeTransforms[i].set(transform);
     }
-
-    m_sun.shadowCameraHelper.finishSunCameraMovement();
-    m_sun.camera = m_sun.shadowCameraHelper.getCamera();
   }
 
-  void renderSceneDepthPass()
+  bool isPipelined() const override { return true; }
+
+  void buildFrame() override
   {
-    Renderer::Camera &camera = m_sun.camera;
-    Renderer::clear();
+    Frame &frame = m_frames.back();
+    frame.camera = m_player.getCamera(); // interpolated
+    frame.sunDirection = m_sunDirection;
+    frame.realTime = m_realTime;
+    for (size_t i = 0; i < std::size(m_dynamicCubes); i++)
+      frame.dynamicCubeTransforms[i] = m_dynamicCubeTransforms[i].getInterpolated();
+
+    // cascades are fitted to slices of the player's frustum and cull on their own
+    m_views.clearViews();
+    m_views.addView(frame.camera);
+    m_views.cull(m_terrain.getChunksCulling(), frame.chunksVisibility);
+  }
 
-    Renderer::renderMeshTerrain(camera, m_terrain);
+  void swapFrames() override
+  {
+    m_frames.swap();
   }
 
-  void renderScene()
+  void renderScene(const Frame &frame)
   {
-    Renderer::Camera &camera = m_player.getCamera();
+    MARBLE_PROFILE_SCOPE("Color pass");
+    MARBLE_PROFILE_GPU_SCOPE("Color pass");
+    const Renderer::Camera &camera = frame.camera;
     Renderer::clear();
 
-    Renderer::renderMeshTerrain(camera, m_terrain);
+    Renderer::renderMeshTerrain(camera, m_terrain, frame.chunksVisibility[0]);
+    for (const Renderer::Mesh &cube : m_dynamicCubes)
+      Renderer::renderMesh(camera, cube);
 
-    m_sky.render(camera, m_realTime);
+    m_sky.render(camera, frame.realTime);
   }
 
   void onRender() override
   {
-    Renderer::Camera &playerCamera = m_player.getCamera();
-    Renderer::Frustum cameraFrustum = Renderer::Frustum::createFrustumFromPerspectiveCamera(playerCamera);
-    repositionSunCamera(cameraFrustum);
+    const Frame &frame = m_frames.front();
+    for (size_t i = 0; i < std::size(m_dynamicCubes); i++)
+      m_dynamicCubes[i].getTransform() = frame.dynamicCubeTransforms[i];
+
+    m_shadows.setSunDirection(frame.sunDirection);
+    m_shadows.update(frame.camera, m_staticShadowCasters);
+
+    Renderer::beginDepthPass();
+    m_shadows.render(
+      [&](const Renderer::Camera &sunCamera) { Renderer::renderMeshTerrain(sunCamera, m_terrain); },
+      [&](const Renderer::Camera &sunCamera) {
+        for (const Renderer::Mesh &cube : m_dynamicCubes)
+          Renderer::renderMesh(sunCamera, cube);
+      });
 
     auto &meshShader = Renderer::getStandardMeshShader();
     meshShader->bind();
-    meshShader->setUniform3f("u_SunPos", m_sun.camera.getPosition());
-    meshShader->setUniformMat4x3f("u_shadowMapProj", m_sun.shadowCameraHelper.getWorldToShadowMapProjectionMatrix());
-    meshShader->setUniform2f("u_shadowMapOrthoZRange", m_sun.shadowCameraHelper.getZNear(), m_sun.shadowCameraHelper.getZFar());
-    meshShader->setUniform1i("u_shadowMap", 5);
+    meshShader->setUniform3f("u_SunPos", frame.sunDirection);
+    m_shadows.setShaderUniforms(*meshShader, SHADOW_MAPS_SLOT);
     Renderer::Shader::unbind();
 
-    Renderer::beginDepthPass();
-    m_depthFBO.bind();
-    m_depthFBO.setViewportToTexture(*m_depthTexture);
-    renderSceneDepthPass();
-
     Renderer::beginColorPass();
-    Renderer::FrameBufferObject::unbind();
     Renderer::FrameBufferObject::setViewportToWindow();
-    renderScene();
+    renderScene(frame);
   }
 
   void onImGuiRender() override
   {
+    if (ImGui::Begin("Shadows")) {
+      const World::CascadedShadowMaps::Statistics &stats = m_shadows.getStatistics();
+      ImGui::Checkbox("animate sun", &m_animateSun);
+      for (unsigned int i = 0; i < m_shadows.getCascadeCount(); i++)
+        ImGui::Text("cascade %u (up to %.0fm) : %u static renders in %u frames", i, m_shadows.getCascadeSplitFar(i), stats.staticRenders[i], stats.frames);
+      if (ImGui::Button("invalidate static shadows"))
+        m_shadows.invalidateStaticGeometry();
+    }
+    ImGui::End();
   }
 
   CAMERA_IS_PLAYER(m_player);
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Scene.h"
+#include "../../abstraction/Cubemap.h"
+#include "../../abstraction/UnifiedRenderer.h"
+#include "../../World/TerrainGeneration/HeightMap.h"
+#include "../../World/TerrainGeneration/Noise.h"
+#include "../../World/Light/Light.h"
+#include "../../World/Player.h"
+#include "../../Utils/Mathf.h"
+
+/* ========  Hundreds of moving point lights, shaded with the FORWARD_PLUS state  ======== */
+
+class TestClusteredLightsScene : public Scene {
+private:
+  static constexpr unsigned int WORLD_SIZE = 200;
+  static constexpr unsigned int MAX_LIGHT_COUNT = 2048;
+
+  struct MovingLight {
+    glm::vec2 center;
+    float     orbitRadius;
+    float     speed;
+    float     phase;
+  };
+
+  Renderer::Cubemap        m_skybox;
+  Player                   m_player;
+  Noise::ConcreteHeightMap m_heightmap;
+  Renderer::TerrainMesh    m_terrain;
+  std::vector<Renderer::Mesh> m_pillars;
+  std::vector<MovingLight> m_movingLights;
+  std::vector<Light>       m_lights;
+  int                      m_lightCount = 512;
+  float                    m_lightDistance = 13;
+  bool                     m_animateLights = true;
+  bool                     m_useClusters = true;
+  float                    m_time = 0;
+
+public:
+  TestClusteredLightsScene()
+    : m_skybox{
+      "res/skybox/skybox_front.bmp", "res/skybox/skybox_back.bmp",
+      "res/skybox/skybox_left.bmp",  "res/skybox/skybox_right.bmp",
+      "res/skybox/skybox_top.bmp",   "res/skybox/skybox_bottom.bmp" }
+  {
+    m_player.setPostion({ WORLD_SIZE * .5f, 30, -20 });
+    m_player.setRotation(3.14f, -.4f);
+    m_player.updateCamera();
+
+    // the standard shader of the FORWARD_PLUS state shades the lights per cluster
+    Renderer::setRenderingState(Renderer::FORWARD_PLUS);
+    const std::shared_ptr<Renderer::Shader> &meshShader = Renderer::getStandardMeshShader();
+
+    Noise::PerlinNoiseSettings perlinSettings;
+    perlinSettings.scale = 60;
+    perlinSettings.octaves = 3;
+    perlinSettings.terrainHeight = 10;
+    m_heightmap = Noise::generateNoiseMap(WORLD_SIZE, WORLD_SIZE, perlinSettings);
+    m_terrain.rebuildMesh(m_heightmap, { 0,0, WORLD_SIZE,WORLD_SIZE });
+
+    auto material = std::make_shared<Renderer::Material>();
+    material->shader = meshShader;
+    m_terrain.setMaterial(material);
+
+    std::shared_ptr<Renderer::Model> cube = Renderer::createCubeModel();
+    for (unsigned int x = 10; x < WORLD_SIZE; x += 20) {
+      for (unsigned int z = 10; z < WORLD_SIZE; z += 20) {
+        Renderer::Mesh &pillar = m_pillars.emplace_back(cube, material);
+        pillar.getTransform().position = { x, m_heightmap.getHeight(x, z), z };
+        pillar.getTransform().scale = { 2, 12, 2 };
+      }
+    }
+
+    m_movingLights.resize(MAX_LIGHT_COUNT);
+    for (unsigned int i = 0; i < MAX_LIGHT_COUNT; i++) {
+      MovingLight &light = m_movingLights[i];
+      light.center = { Mathf::rand(i + .1f) * WORLD_SIZE, Mathf::rand(i + .2f) * WORLD_SIZE };
+      light.orbitRadius = 2 + Mathf::rand(i + .3f) * 13;
+      light.speed = .2f + Mathf::rand(i + .4f) * .8f;
+      light.phase = Mathf::rand(i + .5f) * 6.28f;
+    }
+  }
+
+  ~TestClusteredLightsScene()
+  {
+    Renderer::setRenderingState(Renderer::FORWARD);
+  }
+
+  void updateLights()
+  {
+    m_lights.clear();
+    for (int i = 0; i < m_lightCount; i++) {
+      const MovingLight &moving = m_movingLights[i];
+      float angle = moving.phase + m_time * moving.speed;
+      glm::vec2 xz = moving.center + moving.orbitRadius * glm::vec2{ glm::cos(angle), glm::sin(angle) };
+      float height = m_heightmap.isInBounds(xz.x, xz.y) ? m_heightmap(xz.x, xz.y) : 0;
+      glm::vec3 color = glm::abs(glm::vec3{ glm::sin(moving.phase), glm::sin(moving.phase + 2.1f), glm::sin(moving.phase + 4.2f) });
+      Light::LightParam params{ color * .1f, color, color * .3f };
+      m_lights.emplace_back(glm::vec3{ xz.x, height + 2, xz.y }, params, m_lightDistance);
+    }
+    Renderer::setUniformPointLights(m_useClusters ? m_lights : std::vector<Light>{});
+  }
+
+  void step(float delta) override
+  {
+    if (m_animateLights)
+      m_time += delta;
+    m_player.step(delta);
+    updateLights();
+  }
+
+  void onRender() override
+  {
+    Renderer::clear();
+    Renderer::renderCubemap(m_player.getCamera(), m_skybox);
+    Renderer::renderMeshTerrain(m_player.getCamera(), m_terrain);
+    for (const Renderer::Mesh &pillar : m_pillars)
+      Renderer::renderMesh(m_player.getCamera(), pillar);
+  }
+
+  void onImGuiRender() override
+  {
+    if (ImGui::Begin("Clustered lights")) {
+      const Renderer::ClusteredLights::Statistics &stats = Renderer::getLightClusters().getStatistics();
+      ImGui::SliderInt("light count", &m_lightCount, 0, MAX_LIGHT_COUNT);
+      ImGui::SliderFloat("light distance", &m_lightDistance, 7, 50);
+      ImGui::Checkbox("animate lights", &m_animateLights);
+      ImGui::Checkbox("shade lights", &m_useClusters);
+      ImGui::Text("clusters            : %ux%ux%u", Renderer::ClusteredLights::TILE_COUNT_X, Renderer::ClusteredLights::TILE_COUNT_Y, Renderer::ClusteredLights::SLICE_COUNT);
+      ImGui::Text("lights              : %u", stats.lights);
+      ImGui::Text("assigned indices    : %u", stats.assignedIndices);
+      ImGui::Text("max per cluster     : %u", stats.maxLightsPerCluster);
+      ImGui::Text("overflowed clusters : %u", stats.overflowedClusters);
+      ImGui::Text("binning             : %.3fms (%u threads)", stats.binningTime * 1e-6, stats.threads);
+      const Renderer::LightBuffer::Statistics &bufferStats = Renderer::getLightBuffer().getStatistics();
+      ImGui::Text("light buffer        : %u uploads, %.1fKB", bufferStats.uploads, bufferStats.uploadedBytes / 1024.f);
+    }
+    ImGui::End();
+  }
+
+  CAMERA_IS_PLAYER(m_player);
+};
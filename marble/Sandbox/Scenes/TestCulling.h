@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "../Scene.h"
+#include "../Checks.h"
+#include "../../abstraction/UnifiedRenderer.h"
+#include "../../abstraction/CullingSystem.h"
+#include "../../World/Player.h"
+#include "../../Utils/AABB.h"
+
+/*
+* Checks the batched culling system against Frustum#isOnFrustum, both must
+* report exactly the same boxes. Also shows the time taken by each method.
+* The same comparison runs headlessly over random cameras with --checks (see Checks.h).
+*/
+class TestCullingScene : public Scene {
+private:
+  static constexpr int   BOX_COUNT = 100'000;
+  static constexpr float WORLD_SIZE = 2000.f;
+
+  Player                   m_player, m_roguePlayer;
+  bool                     m_useRoguePlayer = false;
+  bool                     m_drawVisibleBoxes = true;
+
+  std::vector<AABB>        m_boxes;
+  Renderer::CullingSystem  m_culling;
+
+  Renderer::CullingSystem::VisibilityBitset m_visibilityBitset;
+  std::vector<unsigned int> m_visibleIndices;
+  std::vector<bool>        m_referenceVisibility;
+
+  size_t m_mismatchCount = 0;
+  size_t m_visibleCount = 0;
+  long long m_referenceTime = 0, m_bitsetTime = 0, m_indicesTime = 0; // in nanoseconds
+
+public:
+  TestCullingScene()
+  {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> positionDistribution(-WORLD_SIZE*.5f, WORLD_SIZE*.5f);
+    std::uniform_real_distribution<float> heightDistribution(-20.f, 60.f);
+    std::uniform_real_distribution<float> sizeDistribution(.5f, 8.f);
+
+    m_boxes.reserve(BOX_COUNT);
+    m_culling.reserve(BOX_COUNT);
+    for (int i = 0; i < BOX_COUNT; i++) {
+      glm::vec3 origin{ positionDistribution(rng), heightDistribution(rng), positionDistribution(rng) };
+      glm::vec3 size{ sizeDistribution(rng), sizeDistribution(rng), sizeDistribution(rng) };
+      m_boxes.push_back(AABB(origin, size));
+      m_culling.addBox(m_boxes.back());
+    }
+
+    m_player.setPostion({ 0, 10, 0 });
+    m_player.updateCamera();
+  }
+
+  void step(float delta) override
+  {
+    (m_useRoguePlayer ? m_roguePlayer : m_player).step(delta);
+
+    Renderer::Frustum frustum = Renderer::Frustum::createFrustumFromCamera(m_player.getCamera());
+    using clock = std::chrono::high_resolution_clock;
+
+    auto t0 = clock::now();
+    m_referenceVisibility.resize(m_boxes.size());
+    for (size_t i = 0; i < m_boxes.size(); i++)
+      m_referenceVisibility[i] = frustum.isOnFrustum(m_boxes[i]);
+    auto t1 = clock::now();
+    m_culling.cull(frustum, m_visibilityBitset);
+    auto t2 = clock::now();
+    m_culling.cull(frustum, m_visibleIndices);
+    auto t3 = clock::now();
+
+    m_referenceTime = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    m_bitsetTime = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+    m_indicesTime = std::chrono::duration_cast<std::chrono::nanoseconds>(t3 - t2).count();
+
+    // compare the two outputs with the reference
+    m_mismatchCount = Checks::countCullingMismatches(m_referenceVisibility, m_visibilityBitset, m_visibleIndices);
+    m_visibleCount = std::count(m_referenceVisibility.begin(), m_referenceVisibility.end(), true);
+  }
+
+  void onRender() override
+  {
+    Renderer::clear();
+    const Renderer::Camera &renderCamera = (m_useRoguePlayer ? m_roguePlayer : m_player).getCamera();
+
+    if (m_useRoguePlayer)
+      Renderer::renderDebugCameraOutline(renderCamera, m_player.getCamera());
+
+    if (m_drawVisibleBoxes) {
+      for (unsigned int i : m_visibleIndices)
+        Renderer::renderAABBDebugOutline(renderCamera, m_boxes[i]);
+    }
+  }
+
+  void onImGuiRender() override
+  {
+    if (ImGui::Begin("Culling")) {
+      ImGui::Checkbox("rogue player", &m_useRoguePlayer);
+      ImGui::Checkbox("draw visible boxes", &m_drawVisibleBoxes);
+      ImGui::Text("boxes   : %d", BOX_COUNT);
+      ImGui::Text("visible : %zu", m_visibleCount);
+      ImGui::TextColored(m_mismatchCount ? ImVec4{ 1,0,0,1 } : ImVec4{ 0,1,0,1 }, "mismatches : %zu", m_mismatchCount);
+      ImGui::Text("Frustum#isOnFrustum : %8.3fms", m_referenceTime * 1e-6);
+      ImGui::Text("CullingSystem bitset: %8.3fms", m_bitsetTime * 1e-6);
+      ImGui::Text("CullingSystem list  : %8.3fms", m_indicesTime * 1e-6);
+    }
+    ImGui::End();
+  }
+
+  CAMERA_IS_PLAYER(m_player);
+};
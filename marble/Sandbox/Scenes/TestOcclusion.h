@@ -0,0 +1,124 @@
+#pragma once
+
+#include <random>
+#include <chrono>
+
+#include <glm/glm.hpp>
+
+#include "../Scene.h"
+#include "../../abstraction/Cubemap.h"
+#include "../../abstraction/UnifiedRenderer.h"
+#include "../../abstraction/OcclusionBuffer.h"
+#include "../../World/Player.h"
+#include "../../World/Props/PropsManager.h"
+#include "../../World/TerrainGeneration/Noise.h"
+#include "../../Utils/Debug.h"
+
+/*
+* Hilly terrain covered with props, the terrain is used as an occluder for
+* both its own chunks and the props. Toggle occlusion culling and compare
+* the vertex count in the debug window.
+*/
+class TestOcclusionScene : public Scene {
+private:
+  static constexpr unsigned int TERRAIN_SIZE = 500;
+  static constexpr int          PROP_COUNT = 3000;
+  static constexpr int          OCCLUDER_STEP = 4;
+
+  Renderer::Cubemap          m_skybox;
+  Player                     m_player;
+
+  Noise::ConcreteHeightMap   m_heightmap;
+  Renderer::TerrainMesh      m_terrain;
+  World::PropsManager        m_props;
+
+  Renderer::OcclusionBuffer            m_occlusionBuffer;
+  Renderer::OcclusionBuffer::Occluder  m_terrainOccluder;
+  bool                                 m_useOcclusionCulling = true;
+  bool                                 m_showDepthBuffer = false;
+  Renderer::Texture                    m_depthBufferTexture;
+  long long                            m_rasterizationTime = 0; // in nanoseconds
+
+public:
+  TestOcclusionScene()
+    : m_skybox{
+      "res/skybox/skybox_front.bmp", "res/skybox/skybox_back.bmp",
+      "res/skybox/skybox_left.bmp",  "res/skybox/skybox_right.bmp",
+      "res/skybox/skybox_top.bmp",   "res/skybox/skybox_bottom.bmp" }
+  {
+    Noise::PerlinNoiseSettings terrainSettings;
+    terrainSettings.scale = 120.f;
+    terrainSettings.terrainHeight = 60.f;
+    m_heightmap = Noise::generateNoiseMap(TERRAIN_SIZE, TERRAIN_SIZE, terrainSettings);
+    m_terrain.rebuildMesh(m_heightmap, { 0, 0, (float)TERRAIN_SIZE, (float)TERRAIN_SIZE });
+    m_terrainOccluder = Renderer::OcclusionBuffer::makeTerrainOccluder(m_heightmap, { 0, 0, TERRAIN_SIZE - 1.f, TERRAIN_SIZE - 1.f }, OCCLUDER_STEP);
+
+    auto material = std::make_shared<Renderer::Material>();
+    material->shader = Renderer::getStandardMeshShader();
+    m_terrain.setMaterial(material);
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> positionDistribution(2.f, TERRAIN_SIZE - 2.f);
+    std::shared_ptr<Renderer::Model> cubeModel = Renderer::createCubeModel();
+    for (int i = 0; i < PROP_COUNT; i++) {
+      auto prop = std::make_shared<Renderer::Mesh>(cubeModel, material);
+      glm::vec3 position{ positionDistribution(rng), 0, positionDistribution(rng) };
+      position.y = m_heightmap(position.x, position.z) + 1.f;
+      prop->getTransform().position = position;
+      prop->getTransform().scale = { 1.f, 2.f, 1.f };
+      m_props.feed(prop);
+    }
+
+    m_player.setPostion({ TERRAIN_SIZE * .5f, m_heightmap(TERRAIN_SIZE * .5f, TERRAIN_SIZE * .5f) + 5.f, TERRAIN_SIZE * .5f });
+    m_player.updateCamera();
+  }
+
+  void step(float delta) override
+  {
+    m_player.step(delta);
+  }
+
+  void onRender() override
+  {
+    const Renderer::Camera &camera = m_player.getCamera();
+    const Renderer::OcclusionBuffer *occlusion = nullptr;
+
+    if (m_useOcclusionCulling) {
+      auto begin = std::chrono::high_resolution_clock::now();
+      m_occlusionBuffer.clear(camera);
+      m_occlusionBuffer.addOccluder(m_terrainOccluder);
+      m_occlusionBuffer.rasterize();
+      m_rasterizationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - begin).count();
+      occlusion = &m_occlusionBuffer;
+    }
+
+    Renderer::clear();
+    Renderer::renderCubemap(camera, m_skybox);
+    Renderer::renderMeshTerrain(camera, m_terrain, occlusion);
+    m_props.render(camera, occlusion);
+
+    if (m_useOcclusionCulling && m_showDepthBuffer) {
+      std::vector<float> pixels(m_occlusionBuffer.getDepthBuffer().size());
+      for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = glm::clamp((1.f - m_occlusionBuffer.getDepthBuffer()[i]) * 20.f, 0.f, 1.f); // NDC depth is close to 1 for most pixels
+      m_depthBufferTexture = Renderer::Texture::createTextureFromData(pixels.data(), m_occlusionBuffer.getWidth(), m_occlusionBuffer.getHeight(), 1);
+      Renderer::renderDebugGUIQuadWithTexture(m_depthBufferTexture, { -.95f, -.95f }, { .6f, .6f });
+    }
+  }
+
+  void onImGuiRender() override
+  {
+    if (ImGui::Begin("Occlusion")) {
+      const Renderer::OcclusionBuffer::Statistics &stats = m_occlusionBuffer.getStatistics();
+      ImGui::Checkbox("occlusion culling", &m_useOcclusionCulling);
+      ImGui::Checkbox("show depth buffer", &m_showDepthBuffer);
+      ImGui::Text("occluder triangles : %u (%u rasterized)", stats.occluderTriangles, stats.rasterizedTriangles);
+      ImGui::Text("rasterization      : %.3fms", m_rasterizationTime * 1e-6);
+      ImGui::Text("occluded boxes     : %u/%u", stats.occludedBoxes, stats.testedBoxes);
+    }
+    ImGui::End();
+    m_props.onImGuiRender();
+  }
+
+  CAMERA_IS_PLAYER(m_player);
+};
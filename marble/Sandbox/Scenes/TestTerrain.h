@@ -37,7 +37,7 @@ private:
   
   bool                  m_renderChunks = 0;
 
-  Renderer::TestUniform m_fogDampingTestUniform;
+  glm::vec3             m_fogDamping{ 0, 0, .001f };
   Renderer::TestUniform m_grassSteepnessTestUniform;
 
   /* Other */
@@ -76,8 +76,7 @@ public:
 
     m_frustum = Renderer::Frustum::createFrustumFromPerspectiveCamera(m_player.getCamera());
 
-    m_fogDampingTestUniform = Renderer::TestUniform(Renderer::getStandardMeshShader().get(), "u_fogDamping", 3, .0001f);
-    m_fogDampingTestUniform.setValue(0, 0, .001f);
+    Renderer::setFogParameters(m_fogDamping);
     m_grassSteepnessTestUniform = Renderer::TestUniform(Renderer::getStandardMeshShader().get(), "u_grassSteepness", 2, .01f);
     m_grassSteepnessTestUniform.setValue(.79f, 1.f);
   }
@@ -100,6 +99,19 @@ public:
     m_terrain.rebuildMesh(m_heightmap, { 0,0, (float)m_terrainSize,(float)m_terrainSize });
   }
 
+  void digCrater(glm::vec2 center, float radius, float depth)
+  {
+    for (int y = (int)(center.y - radius); y <= (int)(center.y + radius); y++) {
+      for (int x = (int)(center.x - radius); x <= (int)(center.x + radius); x++) {
+        float d2 = glm::dot(glm::vec2(x, y) - center, glm::vec2(x, y) - center) / (radius * radius);
+        if (d2 < 1.f && m_heightmap.isInBounds(x, y))
+          m_heightmap.addHeightAt(x, y, -depth * (1.f - d2));
+      }
+    }
+    // only the chunks covering the crater are updated, no need to rebuild the whole mesh
+    m_terrain.notifyHeightsChanged(m_heightmap, { center.x - radius, center.y - radius, center.x + radius, center.y + radius });
+  }
+
   void step(float delta) override
   {
       realTime += delta;
@@ -196,6 +208,9 @@ public:
         regenerateTerrain();
     }
 
+    if (ImGui::Button("Dig crater under player"))
+      digCrater({ m_player.getPosition().x, m_player.getPosition().z }, 8.f, 5.f);
+
     ImGui::SliderFloat3("Sun position", &m_sun.position[0], -200, 200);
     ImGui::SliderFloat("Sun strength", &m_sun.strength, 0, 3);
     ImGui::Checkbox("Fly", &m_playerIsFlying);
@@ -207,7 +222,8 @@ public:
       m_player.updateCamera();
     }
 
-    m_fogDampingTestUniform.renderImGui();
+    if (ImGui::DragFloat3("u_fogDamping", &m_fogDamping.x, .0001f))
+      Renderer::setFogParameters(m_fogDamping);
     m_grassSteepnessTestUniform.renderImGui();
   }
 
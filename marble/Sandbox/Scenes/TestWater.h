@@ -7,6 +7,7 @@
 #include "../../abstraction/Cubemap.h"
 #include "../../abstraction/UnifiedRenderer.h"
 #include "../../abstraction/Mesh.h"
+#include "../../abstraction/MultiViewCulling.h"
 #include "../../World/Player.h"
 #include "../../World/TerrainGeneration/HeightMap.h"
 #include "../../World/TerrainGeneration/Noise.h"
@@ -34,6 +35,10 @@ private:
     World::Sky        m_sky;
     float             m_realTime = 0;
 
+    /* Culling, done once per frame for all water passes */
+    Renderer::MultiViewCulling m_views;
+    std::vector<Renderer::CullingSystem::VisibilityBitset> m_chunksVisibility;
+
 public:
     TestWater()
     {
@@ -60,19 +65,27 @@ public:
         m_water.updateMoveFactor(delta);
     }
 
-    void renderScene()
+    void renderScene(const Renderer::Camera &camera, Renderer::MultiViewCulling::ViewIndex view)
     {
-        Renderer::Camera& camera = m_player.getCamera();
         Renderer::clear();
 
-        Renderer::renderMeshTerrain(camera, m_terrain);
+        Renderer::renderMeshTerrain(camera, m_terrain, m_chunksVisibility[view]);
 
         m_sky.render(camera, m_realTime);
     }
 
     void onRender() override
     {
-        m_water.onRender([this]() { renderScene(); }, getCamera() );
+        // the refraction and final passes share the main camera, only 2 views are needed
+        const Renderer::Camera &camera = getCamera();
+        m_views.clearViews();
+        Renderer::MultiViewCulling::ViewIndex mainView = m_views.addView(camera);
+        Renderer::MultiViewCulling::ViewIndex reflectionView = m_views.addView(m_water.getReflectionCamera(camera));
+        m_views.cull(m_terrain.getChunksCulling(), m_chunksVisibility);
+
+        m_water.onRender([&](const Renderer::Camera &passCamera, World::WaterPass pass) {
+            renderScene(passCamera, pass == World::WaterPass::REFLECTION ? reflectionView : mainView);
+        }, camera);
     }
 
     void onImGuiRender() override
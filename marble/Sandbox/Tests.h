@@ -9,6 +9,9 @@
 #include "Scenes/TestInstanced.h"
 #include "Scenes/TestWater.h"
 #include "Scenes/TestBloom.h"
+#include "Scenes/TestCulling.h"
+#include "Scenes/TestOcclusion.h"
+#include "Scenes/TestClusteredLights.h"
 
 #include "Scenes/POC1.h"
 #include "Scenes/POC2.h"
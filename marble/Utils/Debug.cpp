@@ -8,12 +8,16 @@
 
 #include "../vendor/imgui/imgui.h"
 #include "../abstraction/UnifiedRenderer.h"
+#include "../abstraction/GLStateCache.h"
+#include "../abstraction/StreamBuffer.h"
+#include "../abstraction/RecordingRenderDevice.h"
 
 
 namespace DebugWindow {
 
 static bool s_wireframeDisplay = false;
 static bool s_renderAABBs = false;
+static Renderer::RecordingRenderDevice *s_deviceRecorder = nullptr; // records the calls of a frame and forwards them to GL
 
 void onImGuiRender()
 {
@@ -22,15 +26,43 @@ void onImGuiRender()
   if (ImGui::Begin("Debug")) {
       ImGui::Text("Number of drawn vertices : %d\n", debugData.vertexCount);
       ImGui::Text("Number of drawn meshes : %d\n", debugData.meshCount);
-      ImGui::Text("Number of debug lines : %d\n", debugData.debugLines);
+      ImGui::Text("Number of debug lines : %zu (%zu draw calls)\n", debugData.debugLines, debugData.debugDrawCalls);
+      const auto &glStatistics = Renderer::GLStateCache::getStatistics();
+      ImGui::Text("GL state calls : %zu issued, %zu elided\n", glStatistics.issuedCalls, glStatistics.elidedCalls);
+      if (const Renderer::StreamBuffer *stream = Renderer::getFrameStreamBuffer()) {
+        const auto &streamStatistics = stream->getLastFrameStatistics();
+        ImGui::Text("Streamed : %zu bytes, %u allocations, %u copies, %u stalls\n", streamStatistics.allocatedBytes, streamStatistics.allocations, streamStatistics.copies, streamStatistics.stalls);
+      }
       if (ImGui::Checkbox("Render as wireframe", &s_wireframeDisplay)) {
         glPolygonMode(GL_FRONT_AND_BACK, s_wireframeDisplay ? GL_LINE : GL_FILL);
       }
       ImGui::Checkbox("Render AABBS", &s_renderAABBs);
+      bool recordDeviceCalls = s_deviceRecorder != nullptr;
+      if (ImGui::Checkbox("Record device calls", &recordDeviceCalls)) {
+        if (recordDeviceCalls) {
+          s_deviceRecorder = new Renderer::RecordingRenderDevice(&Renderer::getRenderDevice());
+          Renderer::setRenderDevice(s_deviceRecorder);
+        } else {
+          Renderer::setRenderDevice(nullptr);
+          delete s_deviceRecorder;
+          s_deviceRecorder = nullptr;
+        }
+      }
+      if (s_deviceRecorder) {
+        ImGui::Text("%zu commands in %zu bytes\n", s_deviceRecorder->getCommandCount(), s_deviceRecorder->getStream().size() * sizeof(uint32_t));
+        for (size_t i = 0; i < Renderer::RecordingRenderDevice::CALL_COUNT; i++) {
+          auto call = (Renderer::RecordingRenderDevice::Call)i;
+          if (size_t count = s_deviceRecorder->getCallCount(call))
+            ImGui::Text("  %s : %zu\n", Renderer::RecordingRenderDevice::getCallName(call), count);
+        }
+      }
   }
 
   ImGui::End();
   Renderer::clearDebugData();
+  Renderer::GLStateCache::resetStatistics();
+  if (s_deviceRecorder)
+    s_deviceRecorder->reset();
 }
 
 bool renderAABB() {
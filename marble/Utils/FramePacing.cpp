@@ -0,0 +1,193 @@
+#include "FramePacing.h"
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cassert>
+
+#include "../vendor/imgui/imgui.h"
+#include "../abstraction/Window.h"
+
+namespace FramePacing {
+
+static unsigned long long s_simulationTick = 0;
+static float s_renderInterpolation = 0;
+
+static long long nanoTime()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FixedTimestep::FixedTimestep(float tickDelta, unsigned int maxTicksPerFrame)
+  : m_tickDelta(tickDelta), m_maxTicksPerFrame(maxTicksPerFrame)
+{
+  assert(tickDelta > 0);
+  assert(maxTicksPerFrame > 0);
+}
+
+unsigned int FixedTimestep::advance(float realDelta)
+{
+  m_accumulator += realDelta;
+  unsigned int ticks = (unsigned int)(m_accumulator / m_tickDelta);
+  if (ticks > m_maxTicksPerFrame) {
+    m_droppedTicks += ticks - m_maxTicksPerFrame;
+    ticks = m_maxTicksPerFrame;
+    m_accumulator = 0;
+  } else {
+    m_accumulator -= ticks * m_tickDelta;
+  }
+  m_accumulator = std::max(m_accumulator, 0.f); // float rounding
+  return ticks;
+}
+
+void FixedTimestep::setTickDelta(float tickDelta)
+{
+  assert(tickDelta > 0);
+  m_accumulator *= tickDelta / m_tickDelta; // keep the interpolation
+  m_tickDelta = tickDelta;
+}
+
+FrameLimiter::FrameLimiter(float targetFramerate)
+{
+  setTargetFramerate(targetFramerate);
+}
+
+void FrameLimiter::setTargetFramerate(float targetFramerate)
+{
+  assert(targetFramerate >= 0);
+  m_targetFrameTime = targetFramerate > 0 ? (long long)(1e9 / targetFramerate) : 0;
+  m_nextFrame = 0;
+}
+
+long long FrameLimiter::getSleepEstimate() const
+{
+  double variance = m_sleepCount > 1 ? m_sleepM2 / (m_sleepCount - 1) : 0;
+  return (long long)(m_sleepMean + std::sqrt(variance));
+}
+
+void FrameLimiter::sleepUntil(long long time)
+{
+  using namespace std::chrono_literals;
+
+  // sleep while the remaining time is larger than what a sleep usually takes
+  long long now = nanoTime();
+  while (time - now > getSleepEstimate()) {
+    std::this_thread::sleep_for(1ms);
+    long long after = nanoTime();
+    // running mean and variance of the sleep durations (Welford), the count is
+    // capped so that the estimate follows changes of the system timer
+    double duration = (double)(after - now);
+    m_sleepCount = std::min(m_sleepCount + 1, 1000ll);
+    double delta = duration - m_sleepMean;
+    m_sleepMean += delta / m_sleepCount;
+    m_sleepM2 += delta * (duration - m_sleepMean);
+    if (m_sleepCount == 1000)
+      m_sleepM2 *= 999. / 1000.;
+    now = after;
+  }
+
+  // spin for the rest, sleeps are not precise enough
+  long long spinBegin = now;
+  while (now < time) {
+    std::this_thread::yield();
+    now = nanoTime();
+  }
+  m_lastSpinTime = now - spinBegin;
+}
+
+void FrameLimiter::wait()
+{
+  if (m_targetFrameTime == 0)
+    return;
+
+  long long now = nanoTime();
+  if (m_nextFrame > now)
+    sleepUntil(m_nextFrame);
+  else if (now - m_nextFrame > m_targetFrameTime)
+    m_nextFrame = now; // more than a frame late (or the first frame), do not try to catch up
+  m_nextFrame += m_targetFrameTime;
+}
+
+void FrameTimeStatistics::addFrame(long long nanoseconds)
+{
+  m_frameTimes[m_frameCount % HISTORY_SIZE] = nanoseconds * 1e-6f;
+  m_frameCount++;
+}
+
+float FrameTimeStatistics::getMean() const
+{
+  size_t count = getFrameCount();
+  if (count == 0)
+    return 0;
+  float sum = 0;
+  for (size_t i = 0; i < count; i++)
+    sum += m_frameTimes[i];
+  return sum / count;
+}
+
+float FrameTimeStatistics::getJitter() const
+{
+  size_t count = getFrameCount();
+  if (count < 2)
+    return 0;
+  float mean = getMean();
+  float sum = 0;
+  for (size_t i = 0; i < count; i++)
+    sum += (m_frameTimes[i] - mean) * (m_frameTimes[i] - mean);
+  return std::sqrt(sum / (count - 1));
+}
+
+float FrameTimeStatistics::getMin() const
+{
+  size_t count = getFrameCount();
+  return count ? *std::min_element(m_frameTimes.begin(), m_frameTimes.begin() + count) : 0;
+}
+
+float FrameTimeStatistics::getMax() const
+{
+  size_t count = getFrameCount();
+  return count ? *std::max_element(m_frameTimes.begin(), m_frameTimes.begin() + count) : 0;
+}
+
+unsigned long long getSimulationTick()
+{
+  return s_simulationTick;
+}
+
+void beginSimulationTick()
+{
+  s_simulationTick++;
+}
+
+float getRenderInterpolation()
+{
+  return s_renderInterpolation;
+}
+
+void setRenderInterpolation(float interpolation)
+{
+  s_renderInterpolation = interpolation;
+}
+
+void onImGuiRender(FrameLimiter &limiter, FixedTimestep &simulation, const FrameTimeStatistics &frameTimes)
+{
+  if (ImGui::Begin("Frame pacing")) {
+    float targetFramerate = limiter.getTargetFramerate();
+    if (ImGui::DragFloat("Target framerate", &targetFramerate, 1.f, 0.f, 1000.f, targetFramerate > 0 ? "%.0f fps" : "unlimited"))
+      limiter.setTargetFramerate(std::max(targetFramerate, 0.f));
+    bool vsync = Window::isFramerateCapped();
+    if (ImGui::Checkbox("VSync", &vsync))
+      Window::capFramerate(vsync);
+    float tickRate = 1.f / simulation.getTickDelta();
+    if (ImGui::SliderFloat("Simulation rate", &tickRate, 10.f, 240.f, "%.0f ticks/s"))
+      simulation.setTickDelta(1.f / tickRate);
+
+    ImGui::PlotLines("Frame times", frameTimes.getFrameTimes(), (int)frameTimes.getFrameCount(), (int)frameTimes.getOffset(), nullptr, 0.f, frameTimes.getMax() * 1.2f, ImVec2(0, 60));
+    ImGui::Text("mean %.2fms, jitter %.3fms, min %.2fms, max %.2fms", frameTimes.getMean(), frameTimes.getJitter(), frameTimes.getMin(), frameTimes.getMax());
+    ImGui::Text("sleep estimate %.2fms, last spin %.3fms", limiter.getSleepEstimate() * 1e-6, limiter.getLastSpinTime() * 1e-6);
+    ImGui::Text("interpolation %.2f, dropped ticks %u", getRenderInterpolation(), simulation.getDroppedTicks());
+  }
+  ImGui::End();
+}
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "Transform.h"
+
+/**
+* Frame pacing decouples the simulation from the rendering.
+*
+* The simulation advances with fixed ticks (FixedTimestep), a frame runs as many
+* ticks as the elapsed real time allows and the remaining fraction of a tick is
+* used to render a state between the two last ticks, objects that move keep
+* their previous and current states (Interpolated, Player does it for cameras).
+* Because of this rendered states lag at most one tick behind the simulation.
+*
+* FrameLimiter paces the main loop to a target framerate without spinning the
+* cpu: it sleeps in small slices while the remaining time is larger than what a
+* sleep is expected to overshoot by, then spins for the rest. The overshoot is
+* measured while running, so coarse system timers only cost more spinning.
+*
+* Example usage:
+*   FramePacing::FixedTimestep simulation(1.f / 60.f);
+*   FramePacing::FrameLimiter limiter(144.f);
+*   while (running) {
+*     limiter.wait();
+*     unsigned int ticks = simulation.advance(realDelta);
+*     for (unsigned int i = 0; i < ticks; i++) {
+*       FramePacing::beginSimulationTick();
+*       step(simulation.getTickDelta());
+*     }
+*     FramePacing::setRenderInterpolation(simulation.getInterpolation());
+*     render(); // uses Interpolated#getInterpolated
+*   }
+*/
+namespace FramePacing {
+
+class FixedTimestep {
+private:
+  float        m_tickDelta;
+  float        m_accumulator = 0;
+  unsigned int m_maxTicksPerFrame;
+  unsigned int m_droppedTicks = 0;
+
+public:
+  /* Frames that would need more than maxTicksPerFrame ticks drop the extra time, the simulation slows down instead of falling further behind */
+  explicit FixedTimestep(float tickDelta = 1.f / 60.f, unsigned int maxTicksPerFrame = 8);
+
+  /* Adds the real time elapsed since the last frame, returns the number of ticks to run */
+  unsigned int advance(float realDelta);
+
+  float getTickDelta() const { return m_tickDelta; }
+  void setTickDelta(float tickDelta);
+  /* Fraction of a tick elapsed since the last tick, in [0,1[ */
+  float getInterpolation() const { return m_accumulator / m_tickDelta; }
+  /* Ticks dropped because frames were too long, since the creation of the timestep */
+  unsigned int getDroppedTicks() const { return m_droppedTicks; }
+};
+
+class FrameLimiter {
+private:
+  long long m_targetFrameTime = 0; // in nanoseconds, 0 if the limiter is disabled
+  long long m_nextFrame = 0;
+  // statistics of the durations of sleep_for(1ms), in nanoseconds
+  double    m_sleepMean = 2e6;
+  double    m_sleepM2 = 0;
+  long long m_sleepCount = 1;
+  long long m_lastSpinTime = 0;
+
+public:
+  /* A target of 0 disables the limiter */
+  explicit FrameLimiter(float targetFramerate = 0);
+
+  void setTargetFramerate(float targetFramerate);
+  float getTargetFramerate() const { return m_targetFrameTime ? 1e9f / m_targetFrameTime : 0.f; }
+  long long getTargetFrameTime() const { return m_targetFrameTime; }
+  /* Time spent spinning during the last wait, in nanoseconds */
+  long long getLastSpinTime() const { return m_lastSpinTime; }
+  /* Expected duration of a 1ms sleep, the wait spins when less than that remains */
+  long long getSleepEstimate() const;
+
+  /* Waits until the beginning of the next frame */
+  void wait();
+
+private:
+  void sleepUntil(long long time);
+};
+
+/* Statistics of the durations of the last frames, jitter is their standard deviation */
+class FrameTimeStatistics {
+public:
+  static constexpr size_t HISTORY_SIZE = 240;
+private:
+  std::array<float, HISTORY_SIZE> m_frameTimes{}; // in milliseconds, a ring buffer
+  size_t m_frameCount = 0;
+public:
+  void addFrame(long long nanoseconds);
+
+  size_t getFrameCount() const { return std::min(m_frameCount, HISTORY_SIZE); }
+  float getMean() const;
+  float getJitter() const;
+  float getMin() const;
+  float getMax() const;
+  /* Ring buffer of the frame times in milliseconds, getOffset is the index of the oldest one */
+  const float *getFrameTimes() const { return m_frameTimes.data(); }
+  size_t getOffset() const { return m_frameCount < HISTORY_SIZE ? 0 : m_frameCount % HISTORY_SIZE; }
+};
+
+/* Index of the current simulation tick, incremented by #beginSimulationTick */
+unsigned long long getSimulationTick();
+void beginSimulationTick();
+/* Fraction of a tick between the previous and current states to render */
+float getRenderInterpolation();
+void setRenderInterpolation(float interpolation);
+
+inline float interpolate(float a, float b, float t) { return a + (b - a) * t; }
+inline glm::vec3 interpolate(const glm::vec3 &a, const glm::vec3 &b, float t) { return glm::mix(a, b, t); }
+inline Transform interpolate(const Transform &a, const Transform &b, float t)
+{
+  return { glm::mix(a.position, b.position, t), glm::mix(a.scale, b.scale, t), glm::slerp(a.rotation, b.rotation, t) };
+}
+
+/*
+* A value that is written by the simulation and read by the rendering, the state
+* of the previous tick is kept when it is first written during a tick. Values
+* that were not written during the last tick are at rest and are not interpolated.
+*/
+template<class T>
+class Interpolated {
+private:
+  T m_previous{};
+  T m_current{};
+  unsigned long long m_tick = NEVER_WRITTEN;
+
+  static constexpr unsigned long long NEVER_WRITTEN = ~0ull;
+
+public:
+  Interpolated() = default;
+  explicit Interpolated(const T &value) : m_previous(value), m_current(value) {}
+
+  void set(const T &value)
+  {
+    unsigned long long tick = getSimulationTick();
+    if (m_tick == NEVER_WRITTEN)
+      m_previous = value;
+    else if (m_tick != tick)
+      m_previous = m_current;
+    m_current = value;
+    m_tick = tick;
+  }
+
+  /* Sets the value without interpolating from the previous one */
+  void teleport(const T &value) { m_previous = m_current = value; m_tick = getSimulationTick(); }
+
+  const T &get() const { return m_current; }
+
+  T getInterpolated() const
+  {
+    if (m_tick != getSimulationTick())
+      return m_current;
+    return interpolate(m_previous, m_current, getRenderInterpolation());
+  }
+};
+
+/* "Frame pacing" panel, edits the target framerate, the tick rate and vsync */
+void onImGuiRender(FrameLimiter &limiter, FixedTimestep &simulation, const FrameTimeStatistics &frameTimes);
+
+}
@@ -0,0 +1,420 @@
+#include "Profiler.h"
+
+#ifndef MARBLE_NO_PROFILER
+
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <cfloat>
+#include <iomanip>
+
+#include <glad/glad.h>
+
+#include "../vendor/imgui/imgui.h"
+
+namespace Profiler {
+
+struct CpuEvent {
+  const char  *name;
+  long long    begin, end; // in nanoseconds
+  unsigned int depth;
+  unsigned int thread;
+};
+
+struct GpuEvent {
+  const char *name;
+  long long   cpuBegin; // when the zone was opened, gpu timestamps are not correlated with cpu ones
+  long long   duration; // -1 until the query is read
+};
+
+struct Frame {
+  unsigned long long    number;
+  long long             begin, end;
+  std::vector<CpuEvent> cpuEvents; // sorted by thread then begin time
+  std::vector<GpuEvent> gpuEvents;
+};
+
+struct ThreadBuffer {
+  std::mutex            mutex;
+  std::vector<CpuEvent> events;
+  unsigned int          depth = 0;
+  unsigned int          index;
+  bool                  alive = true;
+};
+
+struct PendingQuery {
+  unsigned int       query;
+  unsigned long long frame;
+  size_t             eventIndex;
+};
+
+static long long nanoTime()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
+}
+
+static std::atomic<bool> s_paused = false;
+
+// threads register their buffer on their first zone, indices of threads that
+// exited are reused so that short-lived workers do not create new tracks each frame
+static std::mutex                                 s_threadsMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> s_threads;
+static std::vector<unsigned int>                  s_freeThreadIndices;
+static unsigned int                               s_nextThreadIndex = 0;
+
+// gpu zones and frames are only touched by the thread that owns the GL context
+static std::vector<GpuEvent>     s_currentGpuEvents;
+static std::vector<PendingQuery> s_pendingQueries;
+static std::vector<unsigned int> s_freeQueries;
+static bool                      s_gpuZoneOpen = false;
+
+static std::deque<Frame>  s_history;
+static unsigned long long s_frameNumber = 0;
+static long long          s_frameBegin = nanoTime();
+
+class ThreadBufferHandle {
+private:
+  std::shared_ptr<ThreadBuffer> m_buffer;
+public:
+  ThreadBufferHandle()
+  {
+    m_buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard lock(s_threadsMutex);
+    if (s_freeThreadIndices.empty()) {
+      m_buffer->index = s_nextThreadIndex++;
+    } else {
+      m_buffer->index = s_freeThreadIndices.back();
+      s_freeThreadIndices.pop_back();
+    }
+    s_threads.push_back(m_buffer);
+  }
+
+  ~ThreadBufferHandle()
+  {
+    std::lock_guard lock(m_buffer->mutex);
+    m_buffer->alive = false; // collected by the next #endFrame
+  }
+
+  ThreadBuffer &get() { return *m_buffer; }
+};
+
+static ThreadBuffer &getThreadBuffer()
+{
+  thread_local ThreadBufferHandle handle;
+  return handle.get();
+}
+
+CpuZone::CpuZone(const char *name)
+  : m_name(name), m_begin(-1)
+{
+  if (s_paused)
+    return;
+  getThreadBuffer().depth++;
+  m_begin = nanoTime();
+}
+
+CpuZone::~CpuZone()
+{
+  if (m_begin < 0)
+    return;
+  long long end = nanoTime();
+  ThreadBuffer &thread = getThreadBuffer();
+  thread.depth--;
+  std::lock_guard lock(thread.mutex);
+  thread.events.push_back({ m_name, m_begin, end, thread.depth, thread.index });
+}
+
+GpuZone::GpuZone(const char *name)
+  : m_queryIndex(-1)
+{
+  if (s_paused || s_gpuZoneOpen)
+    return;
+
+  unsigned int query;
+  if (s_freeQueries.empty()) {
+    glGenQueries(1, &query);
+  } else {
+    query = s_freeQueries.back();
+    s_freeQueries.pop_back();
+  }
+
+  glBeginQuery(GL_TIME_ELAPSED, query);
+  s_gpuZoneOpen = true;
+  m_queryIndex = (int)s_pendingQueries.size();
+  s_pendingQueries.push_back({ query, s_frameNumber, s_currentGpuEvents.size() });
+  s_currentGpuEvents.push_back({ name, nanoTime(), -1 });
+}
+
+GpuZone::~GpuZone()
+{
+  if (m_queryIndex < 0)
+    return;
+  glEndQuery(GL_TIME_ELAPSED);
+  s_gpuZoneOpen = false;
+}
+
+static Frame *findFrame(unsigned long long number)
+{
+  if (s_history.empty() || number < s_history.front().number || number > s_history.back().number)
+    return nullptr;
+  return &s_history[(size_t)(number - s_history.front().number)];
+}
+
+static void collectThreadEvents(std::vector<CpuEvent> &events)
+{
+  std::lock_guard lock(s_threadsMutex);
+  for (size_t i = 0; i < s_threads.size(); ) {
+    ThreadBuffer &thread = *s_threads[i];
+    bool exited;
+    {
+      std::lock_guard threadLock(thread.mutex);
+      events.insert(events.end(), thread.events.begin(), thread.events.end());
+      thread.events.clear();
+      exited = !thread.alive;
+    }
+    if (exited) {
+      s_freeThreadIndices.push_back(thread.index);
+      s_threads.erase(s_threads.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+static void readAvailableQueries()
+{
+  for (size_t i = 0; i < s_pendingQueries.size(); ) {
+    PendingQuery &pending = s_pendingQueries[i];
+    if (pending.frame + GPU_LATENCY > s_frameNumber) {
+      i++;
+      continue;
+    }
+    int available = 0;
+    glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      i++;
+      continue;
+    }
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+    if (Frame *frame = findFrame(pending.frame))
+      frame->gpuEvents[pending.eventIndex].duration = (long long)elapsed;
+    s_freeQueries.push_back(pending.query);
+    s_pendingQueries.erase(s_pendingQueries.begin() + i);
+  }
+}
+
+void endFrame()
+{
+  long long now = nanoTime();
+
+  Frame frame{ s_frameNumber, s_frameBegin, now, {}, {} };
+  collectThreadEvents(frame.cpuEvents);
+  frame.gpuEvents = std::move(s_currentGpuEvents);
+  s_currentGpuEvents.clear();
+
+  if (!s_paused) {
+    std::sort(frame.cpuEvents.begin(), frame.cpuEvents.end(), [](const CpuEvent &a, const CpuEvent &b) {
+      return a.thread != b.thread ? a.thread < b.thread : a.begin < b.begin;
+    });
+    s_history.push_back(std::move(frame));
+    if (s_history.size() > HISTORY_SIZE)
+      s_history.pop_front();
+  }
+
+  s_frameNumber++;
+  s_frameBegin = now;
+  readAvailableQueries();
+}
+
+void setPaused(bool paused)
+{
+  s_paused = paused;
+}
+
+bool isPaused()
+{
+  return s_paused;
+}
+
+void shutdown()
+{
+  for (const PendingQuery &pending : s_pendingQueries)
+    s_freeQueries.push_back(pending.query);
+  s_pendingQueries.clear();
+  if (!s_freeQueries.empty())
+    glDeleteQueries((GLsizei)s_freeQueries.size(), s_freeQueries.data());
+  s_freeQueries.clear();
+}
+
+static void writeJsonString(std::ostream &out, const char *str)
+{
+  out << '"';
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\')
+      out << '\\';
+    out << *str;
+  }
+  out << '"';
+}
+
+bool exportChromeTrace(const std::string &path)
+{
+  std::ofstream file{ path };
+  if (!file)
+    return false;
+
+  static constexpr unsigned int GPU_TRACK = 1000;
+  long long origin = s_history.empty() ? 0 : s_history.front().begin;
+  auto microseconds = [origin](long long ns) { return (ns - origin) * 1e-3; };
+  unsigned int threadCount = 0;
+  bool first = true;
+  auto separator = [&]() { if (!first) file << ",\n"; first = false; };
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[\n";
+  for (const Frame &frame : s_history) {
+    separator();
+    file << "{\"name\":\"Frame " << frame.number << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+         << ",\"ts\":" << microseconds(frame.begin) << ",\"dur\":" << (frame.end - frame.begin) * 1e-3 << "}";
+    for (const CpuEvent &event : frame.cpuEvents) {
+      separator();
+      file << "{\"name\":";
+      writeJsonString(file, event.name);
+      file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+           << ",\"ts\":" << microseconds(event.begin) << ",\"dur\":" << (event.end - event.begin) * 1e-3 << "}";
+      threadCount = std::max(threadCount, event.thread + 1);
+    }
+    for (const GpuEvent &event : frame.gpuEvents) {
+      if (event.duration < 0)
+        continue;
+      separator();
+      file << "{\"name\":";
+      writeJsonString(file, event.name);
+      file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << GPU_TRACK
+           << ",\"ts\":" << microseconds(event.cpuBegin) << ",\"dur\":" << event.duration * 1e-3 << "}";
+    }
+  }
+  for (unsigned int thread = 0; thread < std::max(threadCount, 1u); thread++) {
+    separator();
+    std::string name = thread == 0 ? "Main" : "Thread " + std::to_string(thread);
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":\"" << name << "\"}}";
+  }
+  separator();
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GPU_TRACK << ",\"args\":{\"name\":\"GPU (submission time)\"}}";
+  file << "\n]}\n";
+
+  return (bool)file;
+}
+
+static ImU32 getZoneColor(const char *name)
+{
+  // zones with the same name have the same color
+  unsigned int hash = 2166136261u;
+  for (; *name; name++)
+    hash = (hash ^ (unsigned char)*name) * 16777619u;
+  return ImColor::HSV((hash % 360) / 360.f, .5f, .8f);
+}
+
+static void renderTimeline(const Frame &frame)
+{
+  static constexpr float ROW_HEIGHT = 18.f;
+  const float width = ImGui::GetContentRegionAvail().x;
+  const double frameDuration = (double)std::max(1ll, frame.end - frame.begin);
+  ImDrawList *drawList = ImGui::GetWindowDrawList();
+
+  size_t i = 0;
+  while (i < frame.cpuEvents.size()) {
+    unsigned int thread = frame.cpuEvents[i].thread;
+    unsigned int maxDepth = 0;
+    for (size_t j = i; j < frame.cpuEvents.size() && frame.cpuEvents[j].thread == thread; j++)
+      maxDepth = std::max(maxDepth, frame.cpuEvents[j].depth);
+
+    if (thread == 0)
+      ImGui::Text("Main thread");
+    else
+      ImGui::Text("Thread %u", thread);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##timeline", { width, ROW_HEIGHT * (maxDepth + 1) });
+    ImGui::PushID((int)thread);
+    for (; i < frame.cpuEvents.size() && frame.cpuEvents[i].thread == thread; i++) {
+      const CpuEvent &event = frame.cpuEvents[i];
+      float x0 = origin.x + (float)((event.begin - frame.begin) / frameDuration) * width;
+      float x1 = origin.x + (float)((event.end - frame.begin) / frameDuration) * width;
+      x1 = std::max(x1, x0 + 1.f);
+      float y0 = origin.y + event.depth * ROW_HEIGHT;
+      ImVec2 min{ x0, y0 }, max{ x1, y0 + ROW_HEIGHT - 1 };
+      drawList->AddRectFilled(min, max, getZoneColor(event.name));
+      if (ImGui::CalcTextSize(event.name).x < x1 - x0 - 4) {
+        drawList->PushClipRect(min, max, true);
+        drawList->AddText({ x0 + 2, y0 + 2 }, IM_COL32(0, 0, 0, 255), event.name);
+        drawList->PopClipRect();
+      }
+      if (ImGui::IsMouseHoveringRect(min, max))
+        ImGui::SetTooltip("%s\n%.3fms", event.name, (event.end - event.begin) * 1e-6);
+    }
+    ImGui::PopID();
+  }
+}
+
+void onImGuiRender()
+{
+  if (!ImGui::Begin("Profiler")) {
+    ImGui::End();
+    return;
+  }
+
+  bool paused = s_paused;
+  if (ImGui::Checkbox("Pause", &paused))
+    setPaused(paused);
+  ImGui::SameLine();
+  static bool exportFailed = false;
+  if (ImGui::Button("Export chrome trace"))
+    exportFailed = !exportChromeTrace("profile_trace.json");
+  if (exportFailed) {
+    ImGui::SameLine();
+    ImGui::Text("could not write profile_trace.json");
+  }
+
+  if (s_history.empty()) {
+    ImGui::End();
+    return;
+  }
+
+  float frameTimes[HISTORY_SIZE];
+  size_t frameCount = s_history.size();
+  for (size_t i = 0; i < frameCount; i++)
+    frameTimes[i] = (s_history[i].end - s_history[i].begin) * 1e-6f;
+  ImGui::PlotLines("Frame times (ms)", frameTimes, (int)frameCount, 0, nullptr, 0.f, FLT_MAX, { 0, 60 });
+
+  // gpu results arrive GPU_LATENCY frames late, older frames are the complete ones
+  static int frameAge = GPU_LATENCY;
+  ImGui::SliderInt("Frame age", &frameAge, 0, (int)frameCount - 1);
+  frameAge = std::clamp(frameAge, 0, (int)frameCount - 1);
+  const Frame &frame = s_history[frameCount - 1 - frameAge];
+  ImGui::Text("Frame %llu : %.3fms", frame.number, (frame.end - frame.begin) * 1e-6);
+
+  if (ImGui::CollapsingHeader("GPU passes", ImGuiTreeNodeFlags_DefaultOpen)) {
+    for (const GpuEvent &event : frame.gpuEvents) {
+      if (event.duration < 0)
+        ImGui::Text("%s : pending", event.name);
+      else
+        ImGui::Text("%s : %.3fms", event.name, event.duration * 1e-6);
+    }
+  }
+
+  if (ImGui::CollapsingHeader("CPU timeline", ImGuiTreeNodeFlags_DefaultOpen))
+    renderTimeline(frame);
+
+  ImGui::End();
+}
+
+}
+
+#endif
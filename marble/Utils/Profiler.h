@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+
+/**
+* Frame profiler, cpu zones are timed per thread with nanosecond timestamps and
+* render passes are timed on the gpu with GL_TIME_ELAPSED queries.
+*
+* Zones are opened with the macros below and closed at the end of the scope.
+* Gpu queries are read a few frames later (see GPU_LATENCY) so that the cpu never
+* waits for them, their results are attached to the frame that issued them.
+* Gpu zones cannot be nested (GL only allows one GL_TIME_ELAPSED query at a time),
+* a gpu zone opened inside of another one is ignored, they should surround whole
+* passes (geometry, lighting, post effects...).
+*
+* The last HISTORY_SIZE frames are kept, #onImGuiRender shows the timeline of a
+* frame and #exportChromeTrace writes them in the trace_event format that can be
+* opened in chrome://tracing or https://ui.perfetto.dev.
+*
+* Defining MARBLE_NO_PROFILER removes the zones entirely, the macros expand to
+* nothing and the functions of this namespace become empty.
+*
+* Example usage:
+*   void renderTerrain()
+*   {
+*     MARBLE_PROFILE_SCOPE("Terrain");
+*     MARBLE_PROFILE_GPU_SCOPE("Terrain");
+*     ...
+*   }
+*   Profiler::endFrame(); // once per frame
+*/
+
+#define MARBLE_PROFILE_CONCAT_(a, b) a##b
+#define MARBLE_PROFILE_CONCAT(a, b) MARBLE_PROFILE_CONCAT_(a, b)
+
+#ifndef MARBLE_NO_PROFILER
+// name must be a string literal (or outlive the profiler)
+#define MARBLE_PROFILE_SCOPE(name) ::Profiler::CpuZone MARBLE_PROFILE_CONCAT(_marbleProfileZone, __LINE__){ name }
+#define MARBLE_PROFILE_GPU_SCOPE(name) ::Profiler::GpuZone MARBLE_PROFILE_CONCAT(_marbleProfileGpuZone, __LINE__){ name }
+#else
+#define MARBLE_PROFILE_SCOPE(name)
+#define MARBLE_PROFILE_GPU_SCOPE(name)
+#endif
+
+namespace Profiler {
+
+static constexpr unsigned int HISTORY_SIZE = 240;
+static constexpr unsigned int GPU_LATENCY = 4; // frames before gpu queries are read
+
+#ifndef MARBLE_NO_PROFILER
+
+class CpuZone {
+private:
+  const char *m_name;
+  long long   m_begin;
+public:
+  explicit CpuZone(const char *name);
+  ~CpuZone();
+  CpuZone(const CpuZone &) = delete;
+  CpuZone &operator=(const CpuZone &) = delete;
+};
+
+class GpuZone {
+private:
+  int m_queryIndex; // -1 if the zone is ignored
+public:
+  explicit GpuZone(const char *name);
+  ~GpuZone();
+  GpuZone(const GpuZone &) = delete;
+  GpuZone &operator=(const GpuZone &) = delete;
+};
+
+/* Closes the current frame and reads the gpu queries that are available, to be called once per frame */
+void endFrame();
+/* While paused no frame is recorded, the history can be inspected */
+void setPaused(bool paused);
+bool isPaused();
+/* Releases the gpu queries, to be called before the GL context is destroyed */
+void shutdown();
+
+/* Writes every frame of the history, returns false if the file cannot be written */
+bool exportChromeTrace(const std::string &path);
+
+void onImGuiRender();
+
+#else
+
+inline void endFrame() {}
+inline void setPaused(bool paused) {}
+inline bool isPaused() { return false; }
+inline void shutdown() {}
+inline bool exportChromeTrace(const std::string &path) { return false; }
+inline void onImGuiRender() {}
+
+#endif
+
+}
@@ -0,0 +1,92 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int workerCount)
+{
+  m_workers.reserve(workerCount);
+  for (unsigned int i = 0; i < workerCount; i++)
+    m_workers.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobAvailable.notify_all();
+  for (std::thread &worker : m_workers)
+    worker.join();
+}
+
+WorkerPool &WorkerPool::getShared()
+{
+  static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+
+void WorkerPool::run(JobGroup &group, std::function<void()> job)
+{
+  {
+    std::lock_guard lock(m_mutex);
+    group.m_pendingJobs++;
+    m_jobs.push_back({ std::move(job), &group });
+  }
+  m_jobAvailable.notify_one();
+}
+
+void WorkerPool::wait(JobGroup &group)
+{
+  std::unique_lock lock(m_mutex);
+  while (group.m_pendingJobs > 0) {
+    if (m_jobs.empty()) {
+      m_jobDone.wait(lock);
+      continue;
+    }
+    Job job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+    lock.unlock();
+    execute(job);
+    lock.lock();
+  }
+
+  std::exception_ptr exception;
+  std::swap(exception, group.m_exception);
+  lock.unlock();
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+void WorkerPool::workerLoop()
+{
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    m_jobAvailable.wait(lock, [this] { return !m_jobs.empty() || m_stopping; });
+    if (m_stopping)
+      return;
+    Job job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+    lock.unlock();
+    execute(job);
+    lock.lock();
+  }
+}
+
+void WorkerPool::execute(Job &job)
+{
+  std::exception_ptr exception;
+  try {
+    job.function();
+  } catch (...) {
+    exception = std::current_exception();
+  }
+
+  {
+    std::lock_guard lock(m_mutex);
+    if (exception && !job.group->m_exception)
+      job.group->m_exception = exception;
+    job.group->m_pendingJobs--;
+  }
+  m_jobDone.notify_all();
+}
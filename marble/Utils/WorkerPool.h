@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/**
+* A fixed set of threads that run jobs, created once instead of for every
+* parallel section: starting a thread costs tens of microseconds, which is the
+* whole budget of per-frame work such as light binning or occlusion rasterization.
+*
+* Jobs are grouped, #wait returns once every job of a group ran. The waiting
+* thread runs queued jobs itself instead of sleeping, so a section split in N
+* parts uses the caller and N-1 workers. Groups are independent, several
+* threads can run and wait for their own groups on the same pool.
+*
+* The shared pool has one worker less than there are hardware threads, the
+* thread that waits is the last one.
+*
+* Example usage:
+*   WorkerPool &pool = WorkerPool::getShared();
+*   WorkerPool::JobGroup group;
+*   for (unsigned int part = 1; part < partCount; part++)
+*     pool.run(group, [&, part] { process(part); });
+*   process(0);
+*   pool.wait(group); // rethrows the first exception a job threw
+*/
+class WorkerPool {
+public:
+  class JobGroup {
+  private:
+    friend class WorkerPool;
+    unsigned int       m_pendingJobs = 0;
+    std::exception_ptr m_exception;
+  public:
+    JobGroup() = default;
+    JobGroup(const JobGroup &) = delete;
+    JobGroup &operator=(const JobGroup &) = delete;
+  };
+
+private:
+  struct Job {
+    std::function<void()> function;
+    JobGroup             *group;
+  };
+
+  std::mutex               m_mutex;
+  std::condition_variable  m_jobAvailable;
+  std::condition_variable  m_jobDone;
+  std::deque<Job>          m_jobs;
+  bool                     m_stopping = false;
+  std::vector<std::thread> m_workers; // last, the other members must exist when they start
+
+public:
+  explicit WorkerPool(unsigned int workerCount);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  /* The pool used by the renderer, created on first use */
+  static WorkerPool &getShared();
+
+  /* Workers and the waiting thread */
+  unsigned int getThreadCount() const { return (unsigned int)m_workers.size() + 1; }
+
+  void run(JobGroup &group, std::function<void()> job);
+  /* Runs queued jobs until every job of the group is done */
+  void wait(JobGroup &group);
+
+private:
+  void workerLoop();
+  /* Called without the lock, takes it to mark the job as done */
+  void execute(Job &job);
+};
@@ -0,0 +1,102 @@
+#include "CameraPath.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cassert>
+
+#include "../Utils/Mathf.h"
+
+namespace World {
+
+template<class T>
+static T catmullRom(const T &p0, const T &p1, const T &p2, const T &p3, float t)
+{
+  float t2 = t * t;
+  float t3 = t2 * t;
+  return .5f * ((2.f * p1) + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+}
+
+void CameraPath::addKeyframe(float time, const CameraPose &pose)
+{
+  assert(m_keyframes.empty() || time > m_keyframes.back().time);
+
+  Keyframe keyframe{ time, pose };
+  if (!m_keyframes.empty()) {
+    // take the shortest turn from the previous yaw
+    float previousYaw = m_keyframes.back().pose.yaw;
+    float turn = std::remainder(pose.yaw - previousYaw, 2 * Mathf::PI);
+    keyframe.pose.yaw = previousYaw + turn;
+  }
+  m_keyframes.push_back(keyframe);
+}
+
+CameraPose CameraPath::sample(float time) const
+{
+  assert(!m_keyframes.empty());
+
+  if (time <= m_keyframes.front().time)
+    return m_keyframes.front().pose;
+  if (time >= m_keyframes.back().time)
+    return m_keyframes.back().pose;
+
+  auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time, [](float t, const Keyframe &k) { return t < k.time; });
+  size_t i2 = next - m_keyframes.begin();
+  size_t i1 = i2 - 1;
+  size_t i0 = i1 == 0 ? 0 : i1 - 1;
+  size_t i3 = std::min(i2 + 1, m_keyframes.size() - 1);
+
+  const CameraPose &p0 = m_keyframes[i0].pose, &p1 = m_keyframes[i1].pose, &p2 = m_keyframes[i2].pose, &p3 = m_keyframes[i3].pose;
+  float t = (time - m_keyframes[i1].time) / (m_keyframes[i2].time - m_keyframes[i1].time);
+
+  CameraPose pose;
+  pose.position = catmullRom(p0.position, p1.position, p2.position, p3.position, t);
+  pose.yaw = catmullRom(p0.yaw, p1.yaw, p2.yaw, p3.yaw, t);
+  pose.pitch = std::clamp(catmullRom(p0.pitch, p1.pitch, p2.pitch, p3.pitch, t), -Mathf::PI * .499f, +Mathf::PI * .499f);
+  return pose;
+}
+
+void CameraPath::saveToFile(const std::string &path) const
+{
+  std::ofstream file(path);
+  if (!file)
+    throw std::runtime_error("Could not write camera path " + path);
+
+  file << "# time x y z yaw pitch\n";
+  for (const Keyframe &keyframe : m_keyframes) {
+    const CameraPose &pose = keyframe.pose;
+    file << keyframe.time << ' '
+         << pose.position.x << ' ' << pose.position.y << ' ' << pose.position.z << ' '
+         << pose.yaw << ' ' << pose.pitch << '\n';
+  }
+}
+
+CameraPath CameraPath::loadFromFile(const std::string &path)
+{
+  std::ifstream file(path);
+  if (!file)
+    throw std::runtime_error("Could not read camera path " + path);
+
+  CameraPath cameraPath;
+  std::string line;
+  for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream ss(line);
+    float time;
+    CameraPose pose;
+    if (!(ss >> time >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch))
+      throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected <time> <x> <y> <z> <yaw> <pitch>");
+    if (!cameraPath.isEmpty() && time <= cameraPath.getDuration())
+      throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": keyframe times must be increasing");
+    cameraPath.addKeyframe(time, pose);
+  }
+
+  if (cameraPath.isEmpty())
+    throw std::runtime_error("Camera path " + path + " has no keyframe");
+  return cameraPath;
+}
+
+}
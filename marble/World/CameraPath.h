@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <glm/glm.hpp>
+
+namespace World {
+
+struct CameraPose {
+  glm::vec3 position{ 0.f };
+  float     yaw = 0.f;   // in radians
+  float     pitch = 0.f; // in radians
+};
+
+/**
+* A camera path is a list of timed poses, it is sampled with a Catmull-Rom spline
+* so that the camera moves smoothly through each keyframe. Keyframes must be added
+* in increasing time order.
+*
+* Yaws are unwrapped when keyframes are added, a camera turning past PI keeps
+* turning the same way instead of spinning back.
+*
+* Paths are saved as text, one keyframe per line:
+*   <time> <x> <y> <z> <yaw> <pitch>
+* empty lines and lines starting with # are ignored.
+*
+* Example usage:
+*   World::CameraPath path = World::CameraPath::loadFromFile("paths/poc1.path");
+*   World::CameraPose pose = path.sample(time);
+*/
+class CameraPath {
+public:
+  struct Keyframe {
+    float      time; // in seconds
+    CameraPose pose;
+  };
+
+private:
+  std::vector<Keyframe> m_keyframes;
+
+public:
+  void addKeyframe(float time, const CameraPose &pose);
+  void clear() { m_keyframes.clear(); }
+
+  const std::vector<Keyframe> &getKeyframes() const { return m_keyframes; }
+  bool isEmpty() const { return m_keyframes.empty(); }
+  /* Time of the last keyframe */
+  float getDuration() const { return m_keyframes.empty() ? 0.f : m_keyframes.back().time; }
+
+  /* Times outside of the path are clamped, the path must not be empty */
+  CameraPose sample(float time) const;
+
+  /* Throws std::runtime_error if the file cannot be written */
+  void saveToFile(const std::string &path) const;
+  /* Throws std::runtime_error if the file cannot be read or is malformed */
+  static CameraPath loadFromFile(const std::string &path);
+};
+
+}
@@ -0,0 +1,189 @@
+#include "CascadedShadowMaps.h"
+
+#include <string>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+#include "../abstraction/UnifiedRenderer.h"
+#include "../abstraction/GLStateCache.h"
+#include "../Utils/Profiler.h"
+
+namespace World {
+
+CascadedShadowCameras::CascadedShadowCameras(unsigned int cascadeCount, unsigned int resolution, float shadowDistance)
+  : m_cascadeCount(cascadeCount),
+  m_resolution(resolution),
+  m_shadowDistance(shadowDistance),
+  m_splitLambda(.75f),
+  m_sunDirectionThreshold(glm::radians(.5f)),
+  m_depthRangeMargin(.25f),
+  m_sunDirection(1, 0, 0)
+{
+  if (cascadeCount == 0 || cascadeCount > MAX_CASCADES)
+    throw std::runtime_error("Invalid shadow cascade count");
+}
+
+void CascadedShadowCameras::setSunDirection(const glm::vec3 &direction)
+{
+  m_sunDirection = glm::normalize(direction);
+}
+
+void CascadedShadowCameras::invalidateStaticGeometry()
+{
+  for (Cascade &cascade : m_cascades)
+    cascade.isCacheValid = false;
+}
+
+BoundingSphere CascadedShadowCameras::computeSliceBoundingSphere(const Renderer::Camera &camera, float sliceNear, float sliceFar) const
+{
+  const Renderer::PerspectiveProjection &projection = camera.getProjection<Renderer::PerspectiveProjection>();
+  float tanHalfFovy = glm::tan(projection.fovy * .5f);
+  float tanHalfFovx = tanHalfFovy * projection.aspect;
+  glm::vec3 forward = camera.getForward();
+  glm::vec3 right = camera.getRight();
+  glm::vec3 up = camera.getUp();
+
+  glm::vec3 corners[8];
+  glm::vec3 center{ 0 };
+  for (int i = 0; i < 8; i++) {
+    float distance = i < 4 ? sliceNear : sliceFar;
+    float sx = (i & 1) ? 1.f : -1.f;
+    float sy = (i & 2) ? 1.f : -1.f;
+    corners[i] = camera.getPosition() + distance * (forward + sx * tanHalfFovx * right + sy * tanHalfFovy * up);
+    center += corners[i] * .125f;
+  }
+  float radius = 0;
+  for (const glm::vec3 &corner : corners)
+    radius = glm::max(radius, glm::distance(center, corner));
+  // the radius only depends on the projection but floating point errors would still make it
+  // change a little when the camera rotates, which is enough to make shadows shimmer
+  radius = glm::ceil(radius * 16.f) / 16.f;
+  return BoundingSphere(center, radius);
+}
+
+void CascadedShadowCameras::update(const Renderer::Camera &camera, std::span<const AABB> staticCasters)
+{
+  const Renderer::PerspectiveProjection &projection = camera.getProjection<Renderer::PerspectiveProjection>();
+  float zNear = projection.zNear;
+  float zFar = glm::min(projection.zFar, m_shadowDistance);
+
+  for (unsigned int i = 0; i < m_cascadeCount; i++) {
+    Cascade &cascade = m_cascades[i];
+    // practical split scheme, a blend of logarithmic and uniform splits
+    float splitRatio = (i + 1) / (float)m_cascadeCount;
+    float logarithmicSplit = zNear * glm::pow(zFar / zNear, splitRatio);
+    float uniformSplit = zNear + (zFar - zNear) * splitRatio;
+    cascade.splitNear = i == 0 ? zNear : m_cascades[i - 1].splitFar;
+    cascade.splitFar = glm::mix(uniformSplit, logarithmicSplit, m_splitLambda);
+
+    // while the sun rotated by less than the threshold the cascade is fitted with the direction of
+    // its cache, fitting with the current one would move the snapped origin on any rotation
+    glm::vec3 sunDirection = m_sunDirection;
+    if (cascade.isCacheValid && glm::dot(cascade.cached.getSunDirection(), m_sunDirection) >= glm::cos(m_sunDirectionThreshold))
+      sunDirection = cascade.cached.getSunDirection();
+
+    BoundingSphere sphere = computeSliceBoundingSphere(camera, cascade.splitNear, cascade.splitFar);
+    fitSunCamera(cascade.fitted, sunDirection, sphere, staticCasters, 0);
+    if (canReuseStaticCache(cascade))
+      continue;
+
+    // the cached camera gets a larger depth range so that the cache survives small camera moves
+    fitSunCamera(cascade.cached, m_sunDirection, sphere, staticCasters, sphere.getRadius() * m_depthRangeMargin);
+    cascade.isCacheValid = true;
+    cascade.needsStaticRender = true;
+  }
+}
+
+void CascadedShadowCameras::fitSunCamera(SunCameraHelper &helper, const glm::vec3 &sunDirection, const BoundingSphere &receivers, std::span<const AABB> casters, float depthMargin) const
+{
+  helper.setSunDirection(sunDirection);
+  helper.prepareSunCameraMovement();
+  helper.ensureCanReceiveShadows(receivers);
+  helper.prepareSunCameraCasting();
+  helper.snapToTexelGrid(m_resolution, m_resolution);
+  for (const AABB &caster : casters)
+    helper.ensureCanCastShadows(caster);
+  helper.extendDepthRange(depthMargin);
+  helper.finishSunCameraMovement();
+}
+
+bool CascadedShadowCameras::canReuseStaticCache(const Cascade &cascade) const
+{
+  if (!cascade.isCacheValid)
+    return false;
+  if (glm::dot(cascade.cached.getSunDirection(), cascade.fitted.getSunDirection()) < glm::cos(m_sunDirectionThreshold))
+    return false;
+  // snapped origins are multiples of the texel size, they are equal as long as the cascade did not move by a texel
+  if (cascade.cached.getSunSpaceOrigin() != cascade.fitted.getSunSpaceOrigin())
+    return false;
+  return cascade.cached.doesDepthRangeContain(cascade.fitted);
+}
+
+CascadedShadowMaps::CascadedShadowMaps(unsigned int cascadeCount, unsigned int resolution, float shadowDistance)
+  : m_cameras(cascadeCount, resolution, shadowDistance),
+  m_statistics{}
+{
+  for (unsigned int i = 0; i < cascadeCount; i++) {
+    CascadeMaps &maps = m_maps[i];
+    maps.staticDepth = std::make_shared<Renderer::Texture>(Renderer::Texture::createDepthTexture(resolution, resolution));
+    maps.depth = std::make_shared<Renderer::Texture>(Renderer::Texture::createDepthTexture(resolution, resolution));
+    maps.staticFBO.setDepthTexture(*maps.staticDepth);
+    maps.fbo.setDepthTexture(*maps.depth);
+  }
+}
+
+void CascadedShadowMaps::render(
+  const std::function<void(const Renderer::Camera &)> &renderStaticGeometry,
+  const std::function<void(const Renderer::Camera &)> &renderDynamicGeometry)
+{
+  MARBLE_PROFILE_SCOPE("Shadow cascades");
+  MARBLE_PROFILE_GPU_SCOPE("Shadow cascades");
+  m_statistics.frames++;
+  for (unsigned int i = 0; i < m_cameras.getCascadeCount(); i++) {
+    CascadeMaps &maps = m_maps[i];
+    const Renderer::Camera &sunCamera = m_cameras.getCascadeCamera(i);
+
+    if (m_cameras.needsStaticRender(i)) {
+      maps.staticFBO.bind();
+      Renderer::FrameBufferObject::setViewportToTexture(*maps.staticDepth);
+      Renderer::clear();
+      renderStaticGeometry(sunCamera);
+      Renderer::FrameBufferObject::unbind();
+      m_cameras.setStaticRenderDone(i);
+      m_statistics.staticRenders[i]++;
+    }
+
+    Renderer::Texture::copyTextureContent(*maps.staticDepth, *maps.depth);
+
+    // dynamic casters may be closer to the sun than the cached near plane, depth clamping
+    // flattens them on the near plane instead of clipping them, they still cast shadows
+    maps.fbo.bind();
+    Renderer::FrameBufferObject::setViewportToTexture(*maps.depth);
+    Renderer::GLStateCache::setCapability(GL_DEPTH_CLAMP, true);
+    renderDynamicGeometry(sunCamera);
+    Renderer::GLStateCache::setCapability(GL_DEPTH_CLAMP, false);
+    Renderer::FrameBufferObject::unbind();
+  }
+}
+
+void CascadedShadowMaps::setShaderUniforms(Renderer::Shader &shader, unsigned int firstTextureSlot) const
+{
+  using Renderer::operator""_uniform;
+  static constexpr Renderer::UniformID shadowMaps[MAX_CASCADES] = {
+    "u_shadowMaps[0]"_uniform, "u_shadowMaps[1]"_uniform, "u_shadowMaps[2]"_uniform, "u_shadowMaps[3]"_uniform };
+  static constexpr Renderer::UniformID shadowMapProjs[MAX_CASCADES] = {
+    "u_shadowMapProjs[0]"_uniform, "u_shadowMapProjs[1]"_uniform, "u_shadowMapProjs[2]"_uniform, "u_shadowMapProjs[3]"_uniform };
+  static constexpr Renderer::UniformID shadowMapOrthoZRanges[MAX_CASCADES] = {
+    "u_shadowMapOrthoZRanges[0]"_uniform, "u_shadowMapOrthoZRanges[1]"_uniform, "u_shadowMapOrthoZRanges[2]"_uniform, "u_shadowMapOrthoZRanges[3]"_uniform };
+
+  shader.setUniform1i("u_shadowCascadeCount"_uniform, (int)m_cameras.getCascadeCount());
+  for (unsigned int i = 0; i < m_cameras.getCascadeCount(); i++) {
+    const SunCameraHelper &helper = m_cameras.getCascadeSunCamera(i);
+    shader.setUniform1i(shadowMaps[i], (int)(firstTextureSlot + i));
+    shader.setUniformMat4x3f(shadowMapProjs[i], helper.getWorldToShadowMapProjectionMatrix());
+    shader.setUniform2f(shadowMapOrthoZRanges[i], helper.getZNear(), helper.getZFar());
+  }
+}
+
+}
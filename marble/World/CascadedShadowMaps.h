@@ -0,0 +1,169 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "SunCameraHelper.h"
+#include "../abstraction/Camera.h"
+#include "../abstraction/Shader.h"
+#include "../abstraction/Texture.h"
+#include "../abstraction/FrameBufferObject.h"
+#include "../Utils/AABB.h"
+
+namespace World {
+
+/**
+* The cpu half of CascadedShadowMaps: splits the main camera frustum, fits the
+* sun camera of every cascade and decides when their static caches must be
+* rendered again. It owns no gl resource, so it can run without a gl context
+* (see the "shadow cache" check).
+*
+* The static cache of a cascade is kept while the sun rotated by less than the
+* threshold since the cache was fitted. Meanwhile the cascade is fitted with the
+* sun direction of its cache, so that its snapped origin and depth range only
+* change when the main camera moves.
+*
+* Example usage:
+*   cameras.setSunDirection(sunDirection);
+*   cameras.update(camera, staticCastersBoxes);
+*   for (unsigned int i = 0; i < cameras.getCascadeCount(); i++) {
+*     if (cameras.needsStaticRender(i)) {
+*       renderStaticGeometry(cameras.getCascadeCamera(i));
+*       cameras.setStaticRenderDone(i);
+*     }
+*   }
+*/
+class CascadedShadowCameras {
+public:
+  static constexpr unsigned int MAX_CASCADES = 4;
+
+private:
+  struct Cascade {
+    float           splitNear, splitFar;  // distances to the main camera covered by the cascade
+    SunCameraHelper fitted;               // fitted this frame
+    SunCameraHelper cached;               // used to render the static cache, also used for dynamic objects
+    bool            isCacheValid = false; // false until the cached camera is fitted, or once static geometry changed
+    bool            needsStaticRender = false;
+  };
+
+  unsigned int m_cascadeCount;
+  unsigned int m_resolution;
+  float        m_shadowDistance;
+  float        m_splitLambda;            // 0 for uniform splits, 1 for logarithmic splits
+  float        m_sunDirectionThreshold;  // in radians
+  float        m_depthRangeMargin;       // as a fraction of the cascade radius
+  glm::vec3    m_sunDirection;
+  Cascade      m_cascades[MAX_CASCADES];
+
+public:
+  CascadedShadowCameras(unsigned int cascadeCount, unsigned int resolution, float shadowDistance);
+
+  void setSunDirection(const glm::vec3 &direction);
+  void setSunDirectionThreshold(float radians) { m_sunDirectionThreshold = radians; }
+  void setSplitLambda(float lambda) { m_splitLambda = lambda; }
+  void invalidateStaticGeometry();
+
+  /* See CascadedShadowMaps#update */
+  void update(const Renderer::Camera &camera, std::span<const AABB> staticCasters);
+  /* True once update refitted the cached camera of the cascade, until #setStaticRenderDone is called */
+  bool needsStaticRender(unsigned int cascade) const { return m_cascades[cascade].needsStaticRender; }
+  void setStaticRenderDone(unsigned int cascade) { m_cascades[cascade].needsStaticRender = false; }
+
+  unsigned int getCascadeCount() const { return m_cascadeCount; }
+  const SunCameraHelper &getCascadeSunCamera(unsigned int cascade) const { return m_cascades[cascade].cached; }
+  const Renderer::Camera &getCascadeCamera(unsigned int cascade) const { return m_cascades[cascade].cached.getCamera(); }
+  float getCascadeSplitFar(unsigned int cascade) const { return m_cascades[cascade].splitFar; }
+
+private:
+  BoundingSphere computeSliceBoundingSphere(const Renderer::Camera &camera, float sliceNear, float sliceFar) const;
+  void fitSunCamera(SunCameraHelper &helper, const glm::vec3 &sunDirection, const BoundingSphere &receivers, std::span<const AABB> casters, float depthMargin) const;
+  bool canReuseStaticCache(const Cascade &cascade) const;
+};
+
+/**
+* Cascaded shadow maps split the main camera frustum in slices, each slice
+* gets its own sun camera (a SunCameraHelper) and depth map. Near slices are
+* small and get very detailed shadows, far slices cover a lot of ground with
+* the same texture size.
+*
+* Cascades are fitted to the bounding sphere of their slice, so that their
+* size does not change when the main camera rotates, and their origin is
+* snapped to the shadow map texel grid so that shadows do not shimmer when
+* the main camera moves.
+*
+* Static geometry (terrain...) is rendered once in a per-cascade cache. It is
+* rendered again only when the sun direction changed by more than a threshold,
+* when the snapped origin of the cascade moved or when its receivers left the
+* cached depth range (see CascadedShadowCameras). Every frame the cache is
+* copied to the depth map that is sampled by shaders and dynamic objects are
+* drawn on top of it.
+*
+* Shaders sample the cascades with the "shadows_cascaded.fs" mesh part.
+*
+* Example usage:
+*   shadows.setSunDirection(sunDirection);
+*   shadows.update(camera, staticCastersBoxes);
+*   Renderer::beginDepthPass();
+*   shadows.render(renderTerrain, renderProps);
+*   Renderer::beginColorPass();
+*   shadows.setShaderUniforms(*meshShader, 5);
+*/
+class CascadedShadowMaps {
+public:
+  static constexpr unsigned int MAX_CASCADES = CascadedShadowCameras::MAX_CASCADES;
+
+  struct Statistics {
+    unsigned int staticRenders[MAX_CASCADES]; // number of times the static cache of each cascade was rebuilt
+    unsigned int frames;
+  };
+
+private:
+  struct CascadeMaps {
+    std::shared_ptr<Renderer::Texture> staticDepth;
+    std::shared_ptr<Renderer::Texture> depth;
+    Renderer::FrameBufferObject        staticFBO;
+    Renderer::FrameBufferObject        fbo;
+  };
+
+  CascadedShadowCameras m_cameras;
+  CascadeMaps           m_maps[MAX_CASCADES];
+  Statistics            m_statistics;
+
+public:
+  CascadedShadowMaps(unsigned int cascadeCount = 3, unsigned int resolution = 2048, float shadowDistance = 200.f);
+  CascadedShadowMaps(const CascadedShadowMaps &) = delete;
+  CascadedShadowMaps &operator=(const CascadedShadowMaps &) = delete;
+
+  void setSunDirection(const glm::vec3 &direction) { m_cameras.setSunDirection(direction); }
+  void setSunDirectionThreshold(float radians) { m_cameras.setSunDirectionThreshold(radians); }
+  void setSplitLambda(float lambda) { m_cameras.setSplitLambda(lambda); }
+  // must be called when static geometry changed (terrain edition...)
+  void invalidateStaticGeometry() { m_cameras.invalidateStaticGeometry(); }
+
+  /*
+  * Fits every cascade to its slice of the camera frustum, static casters are used to
+  * push back the sun near planes. The camera must use a perspective projection.
+  */
+  void update(const Renderer::Camera &camera, std::span<const AABB> staticCasters) { m_cameras.update(camera, staticCasters); }
+  /*
+  * Renders the static geometry of the cascades whose cache is out of date, then composites
+  * dynamic objects in every cascade. Must be called during a depth pass.
+  * Both functions are called with the sun camera of a cascade.
+  */
+  void render(const std::function<void(const Renderer::Camera &)> &renderStaticGeometry,
+              const std::function<void(const Renderer::Camera &)> &renderDynamicGeometry);
+
+  /* Sets the uniforms read by the "shadows_cascaded.fs" mesh part, cascades depth maps must be bound to firstTextureSlot+i */
+  void setShaderUniforms(Renderer::Shader &shader, unsigned int firstTextureSlot) const;
+
+  unsigned int getCascadeCount() const { return m_cameras.getCascadeCount(); }
+  const std::shared_ptr<Renderer::Texture> &getDepthTexture(unsigned int cascade) const { return m_maps[cascade].depth; }
+  const Renderer::Camera &getCascadeCamera(unsigned int cascade) const { return m_cameras.getCascadeCamera(cascade); }
+  float getCascadeSplitFar(unsigned int cascade) const { return m_cameras.getCascadeSplitFar(cascade); }
+  const Statistics &getStatistics() const { return m_statistics; }
+};
+
+}
@@ -1,6 +1,7 @@
 #include "Grass.h"
 
 #include <fstream>
+#include <stdexcept>
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -10,6 +11,10 @@
 #include "../abstraction/Shader.h"
 #include "../abstraction/SpecializedRender.h"
 #include "../abstraction/UnifiedRenderer.h"
+#include "../abstraction/GLStateCache.h"
+#include "../abstraction/RenderDevice.h"
+#include "../Utils/Profiler.h"
+#include "../abstraction/StreamBuffer.h"
 
 namespace World {
 
@@ -41,6 +46,8 @@ private:
   Renderer::VertexBufferObject m_instanceBuffer;
   Renderer::VertexBufferHolder<GrassModelVertex, 2> m_grassModels;
   unsigned int m_voteComputeShader;
+  int          m_voteVPLocation;     // locations of the vote shader uniforms, queried once
+  int          m_voteCountLocation;
   unsigned int m_scan1ComputeShader;
   unsigned int m_scan2ComputeShader;
   unsigned int m_scan3ComputeShader;
@@ -97,6 +104,22 @@ WorldGrass::~WorldGrass()
   glDeleteBuffers(1, &m_ldInstanceBuffer);
 }
 
+/*
+ * Generates the blades of a chunk directly in the renderer's stream buffer and copies them
+ * to the slot of the instance buffer, mapping the instance buffer would wait for the grass
+ * draw calls of the previous frames to complete.
+ */
+static void regenerateChunkSlot(GrassGenerator &generator, const glm::ivec2 &chunkPosition, unsigned int chunkSize, size_t instanceCount, unsigned int instanceBuffer, size_t slotIndex)
+{
+  size_t slotSize = instanceCount * sizeof(GrassInstance);
+  Renderer::StreamBuffer *stream = Renderer::getFrameStreamBuffer();
+  if (stream == nullptr || slotSize > stream->getRegionSize())
+    throw std::runtime_error("Grass chunks cannot be regenerated without the renderer's stream buffer");
+  Renderer::StreamBuffer::Allocation staging = stream->allocate(slotSize, alignof(GrassInstance));
+  generator.regenerateChunk(chunkPosition, chunkSize, instanceCount, (GrassInstance *)staging.data);
+  Renderer::getRenderDevice().copyBufferSubData(staging.buffer, instanceBuffer, staging.offset, slotSize * slotIndex, slotSize);
+}
+
 TerrainGrass::TerrainGrass(std::unique_ptr<WorldGrass> &&world)
 //: m_world(std::move(world)), m_renderer(std::make_unique<GrassRenderer>())
 : m_world(std::move(world)), m_renderer(new GrassRenderer())
@@ -145,26 +168,17 @@ void TerrainGrassGenerator::regenerateChunk(const glm::ivec2 &chunkPosition, uns
 void InfiniteGrassWorld::regenerate()
 {
   size_t i;
-  GrassInstance *instanceBuffer;
-  unsigned int bufferHDChunkSlotSize = m_bladesPerHDChunk * sizeof(GrassInstance);
-  unsigned int bufferLDChunkSlotSize = m_bladesPerLDChunk * sizeof(GrassInstance);
 
   i = 0;
-  glBindBuffer(GL_ARRAY_BUFFER, m_hdInstanceBuffer);
   for (glm::ivec2 offset : HD_CHUNKS) {
-    instanceBuffer = (GrassInstance *)glMapBufferRange(GL_ARRAY_BUFFER, bufferHDChunkSlotSize * i, bufferHDChunkSlotSize, GL_MAP_WRITE_BIT);
-    m_generator->regenerateChunk(m_currentCameraChunk + offset, m_chunkSize, m_bladesPerHDChunk, instanceBuffer);
+    regenerateChunkSlot(*m_generator, m_currentCameraChunk + offset, m_chunkSize, m_bladesPerHDChunk, m_hdInstanceBuffer, i);
     m_hdGrassChunks[i++] = m_currentCameraChunk + offset;
-    glUnmapBuffer(GL_ARRAY_BUFFER);
   }
 
   i = 0;
-  glBindBuffer(GL_ARRAY_BUFFER, m_ldInstanceBuffer);
   for (glm::ivec2 offset : LD_CHUNKS) {
-    instanceBuffer = (GrassInstance *)glMapBufferRange(GL_ARRAY_BUFFER, bufferLDChunkSlotSize * i, bufferLDChunkSlotSize, GL_MAP_WRITE_BIT);
-    m_generator->regenerateChunk(m_currentCameraChunk + offset, m_chunkSize, m_bladesPerLDChunk, instanceBuffer);
+    regenerateChunkSlot(*m_generator, m_currentCameraChunk + offset, m_chunkSize, m_bladesPerLDChunk, m_ldInstanceBuffer, i);
     m_ldGrassChunks[i++] = m_currentCameraChunk + offset;
-    glUnmapBuffer(GL_ARRAY_BUFFER);
   }
 }
 
@@ -200,45 +214,26 @@ inline void InfiniteGrassWorld::repopulateGrassChunks(std::array<glm::ivec2, CC>
     }
   }
 
-  size_t bufferSlotSize = instanceCountPerBufferSlot * sizeof(GrassInstance);
-
   // actually regenerate the gpu grass buffer
-  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
   for (i = 0; i < CC; i++) {
-    if (newChunkIndices[i] != -1) {
-      GrassInstance *instanceBufferMemory = (GrassInstance *)glMapBufferRange(GL_ARRAY_BUFFER, bufferSlotSize * newChunkIndices[i], bufferSlotSize, GL_MAP_WRITE_BIT);
-      m_generator->regenerateChunk(newChunks[i], m_chunkSize, instanceCountPerBufferSlot, instanceBufferMemory);
-      glUnmapBuffer(GL_ARRAY_BUFFER);
-    }
+    if (newChunkIndices[i] != -1)
+      regenerateChunkSlot(*m_generator, newChunks[i], m_chunkSize, instanceCountPerBufferSlot, instanceBuffer, newChunkIndices[i]);
   }
 }
 
 void FixedGrassChunks::regenerate()
 {
   size_t i;
-  GrassInstance *instanceBuffer;
   unsigned int bladesPerHDChunk = GrassRenderSettings::MAX_BLADE_COUNT_PER_DRAWCALL / (unsigned int)m_hdChunks.size();
   unsigned int bladesPerLDChunk = GrassRenderSettings::MAX_BLADE_COUNT_PER_DRAWCALL / (unsigned int)m_ldChunks.size();
-  unsigned int bufferHDChunkSlotSize = bladesPerHDChunk * sizeof(GrassInstance);
-  unsigned int bufferLDChunkSlotSize = bladesPerLDChunk * sizeof(GrassInstance);
 
   i = 0;
-  glBindBuffer(GL_ARRAY_BUFFER, m_hdInstanceBuffer);
-  for (glm::ivec2 position : m_hdChunks) {
-    instanceBuffer = (GrassInstance *)glMapBufferRange(GL_ARRAY_BUFFER, bufferHDChunkSlotSize * i, bufferHDChunkSlotSize, GL_MAP_WRITE_BIT);
-    m_generator->regenerateChunk(position, m_chunkSize, bladesPerHDChunk, instanceBuffer);
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    i++;
-  }
+  for (glm::ivec2 position : m_hdChunks)
+    regenerateChunkSlot(*m_generator, position, m_chunkSize, bladesPerHDChunk, m_hdInstanceBuffer, i++);
 
   i = 0;
-  glBindBuffer(GL_ARRAY_BUFFER, m_ldInstanceBuffer);
-  for (glm::ivec2 position : m_ldChunks) {
-    instanceBuffer = (GrassInstance *)glMapBufferRange(GL_ARRAY_BUFFER, bufferLDChunkSlotSize * i, bufferLDChunkSlotSize, GL_MAP_WRITE_BIT);
-    m_generator->regenerateChunk(position, m_chunkSize, bladesPerLDChunk, instanceBuffer);
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    i++;
-  }
+  for (glm::ivec2 position : m_ldChunks)
+    regenerateChunkSlot(*m_generator, position, m_chunkSize, bladesPerLDChunk, m_ldInstanceBuffer, i++);
 }
 
 GrassRenderer::GrassRenderer()
@@ -254,6 +249,8 @@ GrassRenderer::GrassRenderer()
   m_scan2ComputeShader = loadComputeShader("res/shaders/grass/scan_groups.comp");
   m_scan3ComputeShader = loadComputeShader("res/shaders/grass/scan_accumulate.comp");
   m_compactComputeShader = loadComputeShader("res/shaders/grass/compact.comp");
+  m_voteVPLocation = glGetUniformLocation(m_voteComputeShader, "u_VP");
+  m_voteCountLocation = glGetUniformLocation(m_voteComputeShader, "N");
 
   Renderer::IndirectDrawCommand filledDrawCommand{};
   filledDrawCommand.count = -1; // to be set before each draw call (depending on the lod)
@@ -271,16 +268,16 @@ GrassRenderer::GrassRenderer()
 
 GrassRenderer::~GrassRenderer()
 {
-  glDeleteProgram(m_voteComputeShader);
-  glDeleteProgram(m_scan1ComputeShader);
-  glDeleteProgram(m_scan2ComputeShader);
-  glDeleteProgram(m_scan3ComputeShader);
-  glDeleteProgram(m_compactComputeShader);
+  for (unsigned int program : { m_voteComputeShader, m_scan1ComputeShader, m_scan2ComputeShader, m_scan3ComputeShader, m_compactComputeShader }) {
+    Renderer::GLStateCache::notifyProgramDeleted(program);
+    glDeleteProgram(program);
+  }
   glDeleteBuffers(1, &m_bigBuffer);
 }
 
 void GrassRenderer::render(const Renderer::Camera &camera, const Renderer::Camera &frustumCamera, float time, const WorldGrass &grass)
 {
+  MARBLE_PROFILE_SCOPE("Grass");
   renderSingleLOD(camera, frustumCamera, time, grass.getHDInstanceBuffer(), grass.getHDInstanceCount(), 0);
   renderSingleLOD(camera, frustumCamera, time, grass.getLDInstanceBuffer(), grass.getLDInstanceCount(), 1);
 }
@@ -351,41 +348,43 @@ void GrassRenderer::renderSingleLOD(const Renderer::Camera &camera, const Render
   glm::mat4 V = frustumCamera.getViewMatrix();
   V = glm::translate(V, frustumCamera.getForward() * 1.f); // move the clip camera back a bit to be sure blades that are very close to the actual camera do not get clipped
   glm::mat4 VP = frustumCamera.getProjectionMatrix() * V;
-  glUseProgram(m_voteComputeShader);
-  glUniformMatrix4fv(glGetUniformLocation(m_voteComputeShader, "u_VP"), 1, GL_FALSE, glm::value_ptr(VP));
-  glUniform1ui(glGetUniformLocation(m_voteComputeShader, "N"), (unsigned int)instanceCount);
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
-  glDispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
+  Renderer::RenderDevice &device = Renderer::getRenderDevice();
+  Renderer::GLStateCache::useProgram(m_voteComputeShader);
+  unsigned int bladeCount = (unsigned int)instanceCount;
+  device.setUniform(m_voteVPLocation, Renderer::RenderDevice::UniformType::MAT4, 1, glm::value_ptr(VP));
+  device.setUniform(m_voteCountLocation, Renderer::RenderDevice::UniformType::UINT, 1, &bladeCount);
+  device.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
+  device.dispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
   //glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
   // II/ scan
-  glUseProgram(m_scan1ComputeShader);
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer) + sizeof(BigBuffer::scanTempBuffer));
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer));
-  glDispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
+  Renderer::GLStateCache::useProgram(m_scan1ComputeShader);
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer) + sizeof(BigBuffer::scanTempBuffer));
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer));
+  device.dispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
   //glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
-  glUseProgram(m_scan2ComputeShader);
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer) + sizeof(BigBuffer::totalsTempBuffer));
-  glDispatchCompute(1, 1, 1);
+  Renderer::GLStateCache::useProgram(m_scan2ComputeShader);
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer) + sizeof(BigBuffer::totalsTempBuffer));
+  device.dispatchCompute(1, 1, 1);
   //glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
-  glUseProgram(m_scan3ComputeShader);
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer));
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer));
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, drawCommand), sizeof(BigBuffer::drawCommand));
-  glDispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
+  Renderer::GLStateCache::useProgram(m_scan3ComputeShader);
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer));
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, totalsBuffer), sizeof(BigBuffer::totalsBuffer));
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, drawCommand), sizeof(BigBuffer::drawCommand));
+  device.dispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
   //glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
   // III/ compact
-  glUseProgram(m_compactComputeShader);
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
-  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer));
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_instanceBuffer.getId());
-  glDispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
+  Renderer::GLStateCache::useProgram(m_compactComputeShader);
+  device.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_bigBuffer, offsetof(BigBuffer, voteBuffer), sizeof(BigBuffer::voteBuffer));
+  device.bindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_bigBuffer, offsetof(BigBuffer, scanBuffer), sizeof(BigBuffer::scanBuffer));
+  device.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_instanceBuffer.getId());
+  device.dispatchCompute(GrassRenderSettings::GROUP_COUNT, 1, 1);
   //glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
   float theta = 3.14f - camera.getYaw();
@@ -400,9 +399,8 @@ void GrassRenderer::renderSingleLOD(const Renderer::Camera &camera, const Render
   m_grassModels.bindBuffer(lod, m_vao);
   m_vao.bind();
   int verticesCount = (int)m_grassModels.getIndexBuffer(lod).getCount();
-  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_bigBuffer);
-  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(BigBuffer, drawCommand) + offsetof(Renderer::IndirectDrawCommand, count), sizeof(int), &verticesCount);
-  glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+  device.bufferSubData(m_bigBuffer, offsetof(BigBuffer, drawCommand) + offsetof(Renderer::IndirectDrawCommand, count), sizeof(int), &verticesCount);
+  device.drawElementsIndirect(GL_TRIANGLES, m_bigBuffer, offsetof(BigBuffer, drawCommand));
   Renderer::VertexArray::unbind();
 }
 
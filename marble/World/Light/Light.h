@@ -6,7 +6,7 @@
 #include "../../abstraction/UnifiedRenderer.h"
 
 // This file has to change.
-// Change distance to fall-off, don't stick to such a small sample of fall-offs, add an intensity parameter for HDR, support more than 12 lights...
+// Change distance to fall-off, don't stick to such a small sample of fall-offs, add an intensity parameter for HDR...
 
 static std::unordered_map<float, glm::vec3> s_mapDistValues =
 {
@@ -3,22 +3,56 @@
 #include "../abstraction/Inputs.h"
 #include "../abstraction/Camera.h"
 #include "../Utils/Mathf.h"
+#include "../Utils/FramePacing.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cassert>
 
 static constexpr glm::vec3 UP{ 0, 1, 0 };
 
+static const World::CameraPose *s_poseOverride = nullptr;
+static World::CameraPose s_lastSteppedPose;
+static std::vector<Player *> s_players; // every existing player, for interpolated renders
+static bool s_interpolatedRender = false;
+
 Player::Player()
   : m_camera()
 {
   m_camera.setProjection(Renderer::PerspectiveProjection{ Mathf::PI / 3.f, 16.f / 9.f });
 
   updateCamera();
+  s_players.push_back(this);
+}
+
+Player::Player(const Player &other)
+  : m_speed(other.m_speed), m_camera(other.m_camera),
+    m_previousPose(other.m_previousPose), m_steppedTick(other.m_steppedTick)
+{
+  s_players.push_back(this);
+}
+
+Player::~Player()
+{
+  s_players.erase(std::find(s_players.begin(), s_players.end(), this));
 }
 
 void Player::step(float delta)
 {
+  m_previousPose = getPose();
+  m_steppedTick = FramePacing::getSimulationTick();
+
+  if (s_poseOverride) {
+    m_camera.setPosition(s_poseOverride->position);
+    m_camera.setYaw(s_poseOverride->yaw);
+    m_camera.setPitch(s_poseOverride->pitch);
+    updateCamera();
+    s_lastSteppedPose = *s_poseOverride;
+    return;
+  }
+
   glm::vec3 motion{ 0 };
   if (Inputs::isKeyPressed('A'))
     motion -= getRight();
@@ -50,6 +84,8 @@ void Player::step(float delta)
 
   if(motion != glm::vec3(0) || rotationMotion != glm::vec2(0))
     updateCamera();
+
+  s_lastSteppedPose = getPose();
 }
 
 void Player::updateCamera()
@@ -57,3 +93,53 @@ void Player::updateCamera()
   m_camera.recalculateViewMatrix();
   m_camera.recalculateViewProjectionMatrix();
 }
+
+void Player::setPoseOverride(const World::CameraPose *pose)
+{
+  s_poseOverride = pose;
+}
+
+bool Player::hasPoseOverride()
+{
+  return s_poseOverride != nullptr;
+}
+
+const World::CameraPose &Player::getLastSteppedPose()
+{
+  return s_lastSteppedPose;
+}
+
+void Player::beginInterpolatedRender()
+{
+  assert(!s_interpolatedRender);
+  s_interpolatedRender = true;
+
+  float interpolation = FramePacing::getRenderInterpolation();
+  for (Player *player : s_players) {
+    if (player->m_steppedTick != FramePacing::getSimulationTick())
+      continue;
+    const World::CameraPose &previous = player->m_previousPose;
+    World::CameraPose current = player->getPose();
+    player->m_simulatedPose = current;
+    player->m_camera.setPosition(FramePacing::interpolate(previous.position, current.position, interpolation));
+    player->m_camera.setYaw(FramePacing::interpolate(previous.yaw, current.yaw, interpolation));
+    player->m_camera.setPitch(FramePacing::interpolate(previous.pitch, current.pitch, interpolation));
+    player->updateCamera();
+  }
+}
+
+void Player::endInterpolatedRender()
+{
+  assert(s_interpolatedRender);
+  s_interpolatedRender = false;
+
+  for (Player *player : s_players) {
+    if (player->m_steppedTick != FramePacing::getSimulationTick())
+      continue;
+    const World::CameraPose &simulated = player->m_simulatedPose;
+    player->m_camera.setPosition(simulated.position);
+    player->m_camera.setYaw(simulated.yaw);
+    player->m_camera.setPitch(simulated.pitch);
+    player->updateCamera();
+  }
+}
@@ -3,6 +3,7 @@
 #include <glm/vec3.hpp>
 
 #include "../abstraction/Camera.h"
+#include "CameraPath.h"
 
 /*
 * The player class is basically a fancy wrapper arround a camera, it also
@@ -13,6 +14,15 @@
 * matrix calculations, when moving the player or its rotation the camera
 * projection and view matrices are not updated, do call #updateCamera after
 * applying your changes.
+* 
+* While a pose override is set (camera path replays, see CameraPath) every
+* player follows it instead of the inputs. The pose of the last stepped player
+* is kept so that paths can be recorded from the live camera.
+* 
+* The simulation runs with fixed ticks (see FramePacing), between
+* #beginInterpolatedRender and #endInterpolatedRender the cameras of the players
+* that were stepped during the last tick are moved between their pose at the
+* beginning of that tick and their current pose.
 */
 class Player {
 private: 
@@ -21,6 +31,9 @@ private:
 
 public:
   Player();
+  Player(const Player &other);
+  Player &operator=(const Player &other) = default;
+  virtual ~Player();
 
   virtual void step(float delta);
 
@@ -40,6 +53,23 @@ public:
 
   virtual void updateCamera();
 
+  World::CameraPose getPose() const { return { m_camera.getPosition(), m_camera.getYaw(), m_camera.getPitch() }; }
+
+  /* The pose is not copied, it must outlive the override, pass nullptr to give the control back to the inputs */
+  static void setPoseOverride(const World::CameraPose *pose);
+  static bool hasPoseOverride();
+  /* Pose of the last player that was stepped */
+  static const World::CameraPose &getLastSteppedPose();
+
+  /* Moves every player stepped during the last tick to its interpolated pose, until #endInterpolatedRender */
+  static void beginInterpolatedRender();
+  static void endInterpolatedRender();
+
 protected:
   Renderer::Camera m_camera;
+
+private:
+  World::CameraPose  m_previousPose;  // at the beginning of the last step
+  World::CameraPose  m_simulatedPose; // saved during interpolated renders
+  unsigned long long m_steppedTick = ~0ull;
 };
\ No newline at end of file
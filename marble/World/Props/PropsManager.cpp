@@ -5,38 +5,110 @@
 #include "../../abstraction/UnifiedRenderer.h"
 #include "../../vendor/imgui/imgui.h"
 #include "../../Utils/Debug.h"
+#include "../../Utils/Profiler.h"
 
 namespace World {
 
-void PropsManager::feed(const std::shared_ptr<Renderer::Mesh>& mesh)
+size_t PropsManager::feed(const std::shared_ptr<Renderer::Mesh>& mesh)
 {
   m_props.emplace_back(mesh);
+  m_hierarchyNeedsRebuild = true;
+  return m_props.size() - 1;
 }
 
-void PropsManager::render(const Renderer::Camera& camera)
+void PropsManager::notifyPropMoved(size_t propIndex)
 {
+  // if the hierarchy is going to be rebuilt anyway there is no need to refit it
+  if (!m_hierarchyNeedsRebuild)
+    m_propsHierarchy.setBox((unsigned int)propIndex, m_props[propIndex]->getBoundingBox());
+}
+
+void PropsManager::ensureHierarchyIsBuilt()
+{
+  if (!m_hierarchyNeedsRebuild)
+    return;
+  std::vector<AABB> boxes;
+  boxes.reserve(m_props.size());
+  for (const std::shared_ptr<Renderer::Mesh> &prop : m_props)
+    boxes.push_back(prop->getBoundingBox());
+  m_propsHierarchy.build(boxes);
+  m_hierarchyNeedsRebuild = false;
+}
+
+void PropsManager::render(const Renderer::Camera& camera, const Renderer::OcclusionBuffer *occlusion)
+{
+  ensureHierarchyIsBuilt();
   Renderer::Frustum frustum = Renderer::Frustum::createFrustumFromCamera(camera);
+  m_propsHierarchy.cull(frustum, m_visibleProps);
+  renderVisibleProps(camera, occlusion, 0);
+}
 
-  for(const std::shared_ptr<Renderer::Mesh> &prop : m_props) {
-	AABB boundingBox = prop->getBoundingBox();
-	if (frustum.isOnFrustum(boundingBox)) {
-	  Renderer::renderMesh(camera, *prop);
-	}
-	if (DebugWindow::renderAABB()) {
-	  Renderer::renderAABBDebugOutline(camera, boundingBox);
-	}
+void PropsManager::cullViews(const Renderer::MultiViewCulling &views)
+{
+  ensureHierarchyIsBuilt();
+  views.cull(m_propsHierarchy, m_viewsVisibility);
+}
+
+void PropsManager::render(const Renderer::Camera &camera, Renderer::MultiViewCulling::ViewIndex view, const Renderer::OcclusionBuffer *occlusion)
+{
+  assert(view < m_viewsVisibility.size()); // cullViews was not called
+  Renderer::CullingSystem::collectVisibleIndices(m_viewsVisibility[view], m_visibleProps);
+  renderVisibleProps(camera, occlusion, view);
+}
+
+void PropsManager::renderVisibleProps(const Renderer::Camera &camera, const Renderer::OcclusionBuffer *occlusion, size_t batcherIndex)
+{
+  MARBLE_PROFILE_SCOPE("Props");
+  if (occlusion) {
+    std::erase_if(m_visibleProps, [&](unsigned int propIndex) { return !occlusion->isVisible(m_props[propIndex]->getBoundingBox()); });
+  }
+
+  if (m_useInstancing) {
+    if (batcherIndex >= m_batchers.size())
+      m_batchers.resize(batcherIndex + 1);
+    Renderer::InstanceBatcher &batcher = m_batchers[batcherIndex];
+    for (unsigned int propIndex : m_visibleProps)
+      batcher.submitMesh(*m_props[propIndex]);
+    batcher.render(camera);
+  } else {
+    for (unsigned int propIndex : m_visibleProps)
+      m_renderQueue.submitMesh(camera, *m_props[propIndex]);
+    Renderer::renderQueue(m_renderQueue);
+  }
+
+  if (DebugWindow::renderAABB()) {
+    for (const std::shared_ptr<Renderer::Mesh> &prop : m_props)
+      Renderer::renderAABBDebugOutline(camera, prop->getBoundingBox());
   }
 }
 
 void PropsManager::onImGuiRender()
 {
   if (ImGui::Begin("Scene props")) {
+    const Renderer::BoundingVolumeHierarchy::Statistics &stats = m_propsHierarchy.getLastCullStatistics();
+    ImGui::Text("%zu/%zu visible props", m_visibleProps.size(), m_props.size());
+    ImGui::Text("culling: %u nodes visited, %u props tested, %u plan tests", stats.visitedNodes, stats.testedItems, stats.planTests);
+    if (ImGui::Checkbox("Instancing", &m_useInstancing) && !m_useInstancing)
+      m_batchers.clear();
+    if (m_useInstancing) {
+      for (size_t view = 0; view < m_batchers.size(); view++) {
+        const Renderer::InstanceBatcher::Statistics &batchStats = m_batchers[view].getLastStatistics();
+        ImGui::Text("view %zu: %u draw calls for %u props in %u batches, %u instances uploaded in %u calls",
+          view, batchStats.drawCalls, batchStats.instances, batchStats.batches, batchStats.uploadedInstances, batchStats.uploads);
+      }
+    } else {
+      const Renderer::RenderQueue::Statistics &queueStats = m_renderQueue.getLastStatistics();
+      ImGui::Text("drawing: %u draw calls, %u shader binds, %u material binds, %u texture binds", queueStats.drawCalls, queueStats.shaderBinds, queueStats.materialBinds, queueStats.textureBinds);
+    }
 	for (unsigned int i = 0; i < m_props.size(); i ++) {
 	  Renderer::Mesh& p = *m_props[i];
 	  ImGui::PushID(i);
 	  if (ImGui::CollapsingHeader(("Prop " + std::to_string(i)).c_str())) {
-		ImGui::DragFloat3("Position", glm::value_ptr(p.getTransform().position), 1.F);
-		ImGui::DragFloat3("Size", glm::value_ptr(p.getTransform().scale), 0.25F);
+		bool moved = false;
+		moved |= ImGui::DragFloat3("Position", glm::value_ptr(p.getTransform().position), 1.F);
+		moved |= ImGui::DragFloat3("Size", glm::value_ptr(p.getTransform().scale), 0.25F);
+		if (moved)
+		  notifyPropMoved(i);
 	  }
 	  ImGui::PopID();
 	}
@@ -47,6 +119,11 @@ void PropsManager::onImGuiRender()
 void PropsManager::clear()
 {
   m_props.clear();
+  m_propsHierarchy.clear();
+  m_visibleProps.clear();
+  m_viewsVisibility.clear();
+  m_batchers.clear();
+  m_hierarchyNeedsRebuild = false;
 }
 
 } // !namespace World
\ No newline at end of file
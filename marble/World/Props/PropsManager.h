@@ -5,17 +5,54 @@
 
 #include "../../abstraction/Mesh.h"
 #include "../../abstraction/Camera.h"
+#include "../../abstraction/BoundingVolumeHierarchy.h"
+#include "../../abstraction/OcclusionBuffer.h"
+#include "../../abstraction/MultiViewCulling.h"
+#include "../../abstraction/RenderQueue.h"
+#include "../../abstraction/InstanceBatcher.h"
 
 namespace World {
 
+/*
+* Props are static meshes scattered around the world (rocks, trees...).
+* They are culled through a bounding volume hierarchy, when the transform
+* of a prop is changed #notifyPropMoved must be called for the hierarchy
+* to be refitted.
+*
+* When the scene is rendered from several cameras #cullViews can be called
+* once per frame and #render given the index of the view to draw.
+*
+* Visible props sharing a model and a material are drawn with a single instanced
+* draw call, each view has its own instance batcher so that instances uploaded
+* for a view stay valid the next frame. Instancing can be disabled, props are then
+* drawn through a render queue, props sharing a material one after the other.
+*/
 class PropsManager {
 private:
 	std::vector<std::shared_ptr<Renderer::Mesh>> m_props;
+  Renderer::BoundingVolumeHierarchy m_propsHierarchy;
+  bool                              m_hierarchyNeedsRebuild = false;
+  std::vector<unsigned int>         m_visibleProps; // kept between frames to avoid reallocations
+  std::vector<Renderer::CullingSystem::VisibilityBitset> m_viewsVisibility; // filled by cullViews
+  Renderer::RenderQueue             m_renderQueue;
+  std::vector<Renderer::InstanceBatcher> m_batchers; // one per view, the first one is also used by #render without view
+  bool                              m_useInstancing = true;
 public:
   void clear();
-  void feed(const std::shared_ptr<Renderer::Mesh> &mesh);
-  void render(const Renderer::Camera &camera);
+  /* Adds a prop and returns its index, the hierarchy is rebuilt before the next render */
+  size_t feed(const std::shared_ptr<Renderer::Mesh> &mesh);
+  void notifyPropMoved(size_t propIndex);
+  /* Props hidden by the occluders of the occlusion buffer are not drawn, it must be rasterized from the same camera */
+  void render(const Renderer::Camera &camera, const Renderer::OcclusionBuffer *occlusion = nullptr);
+  /* Culls the props against all views at once, must be called before rendering views with #render */
+  void cullViews(const Renderer::MultiViewCulling &views);
+  /* Draws the props visible from a view culled by the last #cullViews call, the camera must be the view's */
+  void render(const Renderer::Camera &camera, Renderer::MultiViewCulling::ViewIndex view, const Renderer::OcclusionBuffer *occlusion = nullptr);
   void onImGuiRender();
+
+private:
+  void ensureHierarchyIsBuilt();
+  void renderVisibleProps(const Renderer::Camera &camera, const Renderer::OcclusionBuffer *occlusion, size_t batcherIndex);
 };
 
 }
\ No newline at end of file
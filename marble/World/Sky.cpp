@@ -9,6 +9,7 @@
 #include "../abstraction/IndexBufferObject.h"
 #include "../abstraction/Shader.h"
 #include "../abstraction/Cubemap.h"
+#include "../abstraction/GLStateCache.h"
 #include "../World/Player.h"
 #include "../Utils/Mathf.h"
 #include "../abstraction/UnifiedRenderer.h"
@@ -69,8 +70,8 @@ void init()
 
 void drawSkyClouds(const Camera &camera, float time)
 {
-  glDepthMask(false); // do not write to depth buffer
-  glDepthFunc(GL_LEQUAL);
+  GLStateCache::setDepthMask(false); // do not write to depth buffer
+  GLStateCache::setDepthFunc(GL_LEQUAL);
   glm::mat4 M(1.f);
   // beware! if vertices go too far outside the clip range after the vertex shader
   // transformation, some may flicker, making triangles break and the whole plane
@@ -84,8 +85,8 @@ void drawSkyClouds(const Camera &camera, float time)
   //keepAliveResources->cloudsShader.setUniform2f("u_worldOffset", { camera.getPosition().x, camera.getPosition().z });
   //keepAliveResources->cloudsShader.setUniform1f("u_time", time);
   //keepAliveResources->planeMesh.draw();
-  glDepthFunc(GL_LESS);
-  glDepthMask(true);
+  GLStateCache::setDepthFunc(GL_LESS);
+  GLStateCache::setDepthMask(true);
 }
 
 }
\ No newline at end of file
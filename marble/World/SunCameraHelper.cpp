@@ -51,6 +51,16 @@ void SunCameraHelper::ensureCanReceiveShadows(const AABB &box)
   }
 }
 
+void SunCameraHelper::ensureCanReceiveShadows(const BoundingSphere &sphere)
+{
+  ensureState<HelperState::RECEIVING_BOXES>();
+
+  // the sphere is invariant to rotation, only its center needs to be projected
+  glm::vec3 centerInSunSpace = m_worldToSunProjection * sphere.getCenter();
+  m_minReceivingPoint = glm::min(centerInSunSpace - sphere.getRadius(), m_minReceivingPoint);
+  m_maxReceivingPoint = glm::max(centerInSunSpace + sphere.getRadius(), m_maxReceivingPoint);
+}
+
 void SunCameraHelper::prepareSunCameraCasting()
 {
   ensureState<HelperState::RECEIVING_BOXES>();
@@ -70,6 +80,27 @@ void SunCameraHelper::prepareSunCameraCasting()
   m_state = HelperState::CASTING_BOXES;
 }
 
+void SunCameraHelper::snapToTexelGrid(unsigned int shadowMapWidth, unsigned int shadowMapHeight)
+{
+  ensureState<HelperState::CASTING_BOXES>();
+  assert(shadowMapWidth > 2 && shadowMapHeight > 2);
+
+  // grow the camera by exactly one texel on each side, snapping moves it by at most half a texel
+  m_cameraHalfWidth *= shadowMapWidth / (shadowMapWidth - 2.f);
+  m_cameraHalfHeight *= shadowMapHeight / (shadowMapHeight - 2.f);
+  float texelWidth = 2.f * m_cameraHalfWidth / shadowMapWidth;
+  float texelHeight = 2.f * m_cameraHalfHeight / shadowMapHeight;
+  m_sunI = glm::round(m_sunI / texelWidth) * texelWidth;
+  m_sunJ = glm::round(m_sunJ / texelHeight) * texelHeight;
+}
+
+void SunCameraHelper::extendDepthRange(float margin)
+{
+  ensureState<HelperState::CASTING_BOXES>();
+  m_sunFarK -= margin;
+  m_sunNearK += margin;
+}
+
 void SunCameraHelper::ensureCanCastShadows(const AABB &box)
 {
   ensureState<HelperState::CASTING_BOXES>();
@@ -69,8 +69,16 @@ public:
   void prepareSunCameraMovement();
   // in RECEIVING_BOXES state
   void ensureCanReceiveShadows(const AABB &box);
+  // the sun camera size only depends on the sphere radius, not on the sun orientation (used by shadow cascades)
+  void ensureCanReceiveShadows(const BoundingSphere &sphere);
   void prepareSunCameraCasting();
   // in CASTING_BOXES state
+  // moves the sun camera by less than a texel so that it only ever moves by whole texels, the camera is grown
+  // by one texel on each side to keep receivers covered. Static geometry then projects to the same texels
+  // from frame to frame and shadows do not shimmer when the main camera moves
+  void snapToTexelGrid(unsigned int shadowMapWidth, unsigned int shadowMapHeight);
+  // pushes the sun camera near and far planes away, so that the depth map remains valid while receivers move a bit
+  void extendDepthRange(float margin);
   void ensureCanCastShadows(const AABB &box);
   void finishSunCameraMovement();
 
@@ -79,6 +87,11 @@ public:
   const glm::mat4x3 &getWorldToShadowMapProjectionMatrix() const { ensureState<HelperState::READY>(); return m_shadowMapProj; }
   float getZNear()                                         const { ensureState<HelperState::READY>(); return SUN_CAM_ZNEAR; }
   float getZFar()                                          const { ensureState<HelperState::READY>(); return m_sunNearK - m_sunFarK + SUN_CAM_ZNEAR; }
+  const glm::vec3 &getSunDirection()                       const { return m_sunDir; }
+  // position of the sun camera in sun space, after texel snapping if any
+  glm::vec2 getSunSpaceOrigin()                            const { ensureState<HelperState::READY>(); return { m_sunI, m_sunJ }; }
+  // returns true iff the depth range of the sun camera contains the depth range of the other
+  bool doesDepthRangeContain(const SunCameraHelper &other) const { return m_sunFarK <= other.m_sunFarK && m_sunNearK >= other.m_sunNearK; }
   // returns true iff the box overlaps the sun's view frustum, that is, it must be drawn during the depth pass
   bool isBoxVisibleBySun(const AABB &box) const;
 
@@ -44,4 +44,12 @@ bool TerrainMesh::hasChunk(glm::ivec2 chunkPosition)
                       [chunkPosition](auto &chunk) { return chunk.position == chunkPosition; }) != m_chunks.end();
 }
 
+void TerrainMesh::rebuildChunksCulling()
+{
+  m_chunksCulling.clear();
+  m_chunksCulling.reserve(m_chunks.size());
+  for (const Chunk &chunk : m_chunks)
+    m_chunksCulling.addBox(chunk.worldBoundingBox);
+}
+
 } // !namespace World
\ No newline at end of file
@@ -9,38 +9,49 @@
 namespace Renderer {
 
 template<Heightmap Heightmap>
-TerrainMesh::Chunk TerrainMesh::generateChunk(const Heightmap &heightmap, glm::ivec2 chunkPosition)
+BaseVertex TerrainMesh::generateVertex(const Heightmap &heightmap, glm::ivec2 chunkPosition, int x, int y)
 {
-  constexpr int vertexCount = (CHUNK_SIZE + 1) * (CHUNK_SIZE + 1);
-  std::array<BaseVertex, vertexCount> vertices;
+  float wx = (float)chunkPosition.x * CHUNK_SIZE + x + 1;
+  float wy = (float)chunkPosition.y * CHUNK_SIZE + y + 1;
+  BaseVertex vertex;
+  vertex.position = { wx, heightmap(wx, wy), wy };
+
+  vertex.uv = { x, y };
+  vertex.uv /= 10.f;
+
+  vertex.normal = glm::normalize(glm::cross(
+    glm::vec3{ 0.f, (heightmap(wx, wy + 1) - heightmap(wx, wy - 1)), 2.f },
+    glm::vec3{ 2.f, (heightmap(wx + 1, wy) - heightmap(wx - 1, wy)), 0.f }
+  ));
+
+  vertex.color = {
+    Mathf::rand(chunkPosition.x * 64.542f),
+    Mathf::rand(chunkPosition.y * 12.523f),
+    Mathf::rand(chunkPosition.x * 25.642f + chunkPosition.y * 53.2f),
+  };
+
+  vertex.texId = 0;
+  return vertex;
+}
 
+template<Heightmap Heightmap>
+void TerrainMesh::generateChunkVertices(const Heightmap &heightmap, glm::ivec2 chunkPosition, BaseVertex *vertices)
+{
   size_t i = 0;
   for (int y = 0; y <= (int)CHUNK_SIZE; y++) {
     for (int x = 0; x <= (int)CHUNK_SIZE; x++) {
-      float wx = (float)chunkPosition.x * CHUNK_SIZE + x + 1;
-      float wy = (float)chunkPosition.y * CHUNK_SIZE + y + 1;
-      BaseVertex &vertex = vertices[i++];
-      vertex.position = { wx, heightmap(wx, wy), wy };
-
-      vertex.uv = { x, y };
-      vertex.uv /= 10.f;
-
-      vertex.normal = glm::normalize(glm::cross(
-        glm::vec3{ 0.f, (heightmap(wx, wy + 1) - heightmap(wx, wy - 1)), 2.f },
-        glm::vec3{ 2.f, (heightmap(wx + 1, wy) - heightmap(wx - 1, wy)), 0.f }
-      ));
-
-      vertex.color = {
-        Mathf::rand(chunkPosition.x * 64.542f),
-        Mathf::rand(chunkPosition.y * 12.523f),
-        Mathf::rand(chunkPosition.x * 25.642f + chunkPosition.y * 53.2f),
-      };
-
-      vertex.texId = 0;
+      vertices[i++] = generateVertex(heightmap, chunkPosition, x, y);
     }
   }
 
-  assert(i == vertexCount);
+  assert(i == CHUNK_VERTEX_COUNT);
+}
+
+template<Heightmap Heightmap>
+TerrainMesh::Chunk TerrainMesh::generateChunk(const Heightmap &heightmap, glm::ivec2 chunkPosition)
+{
+  std::array<BaseVertex, CHUNK_VERTEX_COUNT> vertices;
+  generateChunkVertices(heightmap, chunkPosition, vertices.data());
 
   glm::vec3 minAABB(std::numeric_limits<float>::max()), maxAABB(std::numeric_limits<float>::min());
   for (const auto &vertex : vertices) {
@@ -51,6 +62,7 @@ TerrainMesh::Chunk TerrainMesh::generateChunk(const Heightmap &heightmap, glm::i
   VertexBufferObject vbo{ vertices.data(), vertices.size()*sizeof(BaseVertex) };
   VertexArray vao;
   vao.addBuffer(vbo, BaseVertex::getVertexBufferLayout(), m_ibo);
+  addIdentityInstance(vao);
 
   return Chunk{
     std::move(vao),
@@ -78,6 +90,63 @@ void TerrainMesh::rebuildMesh(const Heightmap &heightmap, TerrainRegion region)
       m_chunks.push_back(generateChunk(heightmap, chunkPosition));
     }
   }
+  rebuildChunksCulling();
+}
+
+template<Heightmap Heightmap>
+void TerrainMesh::notifyHeightsChanged(const Heightmap &heightmap, TerrainRegion dirty)
+{
+  // normals are computed from neighbouring heights, vertices next to the region must be updated too
+  int minX = (int)glm::floor(dirty.minX) - 1;
+  int minY = (int)glm::floor(dirty.minY) - 1;
+  int maxX = (int)glm::ceil(dirty.maxX) + 1;
+  int maxY = (int)glm::ceil(dirty.maxY) + 1;
+
+  std::vector<BaseVertex> updatedVertices;
+
+  for (size_t chunkIndex = 0; chunkIndex < m_chunks.size(); chunkIndex++) {
+    Chunk &chunk = m_chunks[chunkIndex];
+    // world position of the chunk's first vertex, see #generateVertex
+    int chunkOriginX = chunk.position.x * CHUNK_SIZE + 1;
+    int chunkOriginY = chunk.position.y * CHUNK_SIZE + 1;
+    int x0 = glm::max(minX - chunkOriginX, 0);
+    int y0 = glm::max(minY - chunkOriginY, 0);
+    int x1 = glm::min(maxX - chunkOriginX, (int)CHUNK_SIZE);
+    int y1 = glm::min(maxY - chunkOriginY, (int)CHUNK_SIZE);
+    if (x0 > x1 || y0 > y1)
+      continue;
+
+    // rows are contiguous in the vbo, if complete rows changed they can be sent in a single call
+    bool fullRows = x0 == 0 && x1 == CHUNK_SIZE;
+
+    chunk.vbo.bind();
+    updatedVertices.clear();
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++)
+        updatedVertices.push_back(generateVertex(heightmap, chunk.position, x, y));
+      if (!fullRows || y == y1) {
+        size_t firstVertex = (size_t)(fullRows ? y0 : y) * (CHUNK_SIZE + 1) + x0;
+        chunk.vbo.updateData(updatedVertices.data(), updatedVertices.size() * sizeof(BaseVertex), firstVertex * sizeof(BaseVertex));
+        updatedVertices.clear();
+      }
+    }
+    chunk.vbo.unbind();
+
+    // the previous extremums may have been inside of the region, the whole chunk must be sampled again
+    float minHeight = std::numeric_limits<float>::max();
+    float maxHeight = std::numeric_limits<float>::lowest();
+    for (int y = 0; y <= (int)CHUNK_SIZE; y++) {
+      for (int x = 0; x <= (int)CHUNK_SIZE; x++) {
+        float h = heightmap((float)(chunkOriginX + x), (float)(chunkOriginY + y));
+        minHeight = glm::min(minHeight, h);
+        maxHeight = glm::max(maxHeight, h);
+      }
+    }
+    chunk.worldBoundingBox = AABB::make_aabb(
+      { chunkOriginX, minHeight, chunkOriginY },
+      { chunkOriginX + CHUNK_SIZE, maxHeight, chunkOriginY + CHUNK_SIZE });
+    m_chunksCulling.setBox(chunkIndex, chunk.worldBoundingBox);
+  }
 }
 
 }
\ No newline at end of file
@@ -1,7 +1,23 @@
 #include "Water.h"
 #include <glad/glad.h>
 
-void World::Water::onRender(const std::function<void()> &renderFn, Renderer::Camera &camera)
+#include "../../abstraction/GLStateCache.h"
+#include "../../Utils/Profiler.h"
+
+Renderer::Camera World::Water::getReflectionCamera(const Renderer::Camera &camera) const
+{
+  const WaterSource &m_source = m_sources.at(0);
+
+  float distance = (camera.getPosition().y - m_source.position.y) * 2;
+  Renderer::Camera reflectionCamera = camera;
+  reflectionCamera.moveCamera({ 0, -distance, 0 });
+  reflectionCamera.inversePitch();
+  reflectionCamera.recalculateViewMatrix();
+  reflectionCamera.recalculateViewProjectionMatrix();
+  return reflectionCamera;
+}
+
+void World::Water::onRender(const std::function<void(const Renderer::Camera &camera, WaterPass pass)> &renderFn, const Renderer::Camera &camera)
 {
   const WaterSource &m_source = m_sources.at(0);
 
@@ -12,28 +28,20 @@ void World::Water::onRender(const std::function<void()> &renderFn, Renderer::Cam
   Renderer::Shader::unbind();
 
   // place camera
-  float distance = (camera.getPosition().y - m_source.position.y) * 2;
-
-  camera.moveCamera({ 0, -distance, 0 });
-  camera.inversePitch();
-  camera.recalculateViewMatrix();
-  camera.recalculateViewProjectionMatrix();
+  Renderer::Camera reflectionCamera = getReflectionCamera(camera);
 
   // Take photo
 
-  glEnable(GL_CLIP_DISTANCE0);
-
-  m_renderer.bindReflectionBuffer();
-  Renderer::clear();
-  renderFn();
-  m_renderer.unbind();
-
-  // undo camera setup
+  Renderer::GLStateCache::setCapability(GL_CLIP_DISTANCE0, true);
 
-  camera.inversePitch();
-  camera.moveCamera({ 0, distance, 0 });
-  camera.recalculateViewMatrix();
-  camera.recalculateViewProjectionMatrix();
+  {
+    MARBLE_PROFILE_SCOPE("Water reflection");
+    MARBLE_PROFILE_GPU_SCOPE("Water reflection");
+    m_renderer.bindReflectionBuffer();
+    Renderer::clear();
+    renderFn(reflectionCamera, WaterPass::REFLECTION);
+    m_renderer.unbind();
+  }
 
   // ~~~~~~~~~~~~ REFRACTION ~~~~~~~~~~~~ //
 
@@ -41,13 +49,25 @@ void World::Water::onRender(const std::function<void()> &renderFn, Renderer::Cam
   Renderer::getStandardMeshShader()->setUniform4f("u_plane", glm::vec4(0, -1, 0, m_source.position.y));
   Renderer::Shader::unbind();
 
-  m_renderer.bindRefractionBuffer();
-  Renderer::clear();
-  renderFn();
-  m_renderer.unbind();
+  {
+    MARBLE_PROFILE_SCOPE("Water refraction");
+    MARBLE_PROFILE_GPU_SCOPE("Water refraction");
+    m_renderer.bindRefractionBuffer();
+    Renderer::clear();
+    renderFn(camera, WaterPass::REFRACTION);
+    m_renderer.unbind();
+  }
 
-  glDisable(GL_CLIP_DISTANCE0);
+  Renderer::GLStateCache::setCapability(GL_CLIP_DISTANCE0, false);
   
-  renderFn();
-  m_renderer.onRenderWater(m_sources, camera);
+  {
+    MARBLE_PROFILE_SCOPE("Color pass");
+    MARBLE_PROFILE_GPU_SCOPE("Color pass");
+    renderFn(camera, WaterPass::FINAL);
+  }
+  {
+    MARBLE_PROFILE_SCOPE("Water surface");
+    MARBLE_PROFILE_GPU_SCOPE("Water surface");
+    m_renderer.onRenderWater(m_sources, camera);
+  }
 }
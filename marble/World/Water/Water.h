@@ -11,6 +11,13 @@
 
 namespace World {
 
+/* The passes of Water#onRender, in the order they are rendered */
+enum class WaterPass {
+  REFLECTION, // rendered with the camera returned by Water#getReflectionCamera, below the water plane
+  REFRACTION, // rendered with the main camera, only what is under the water
+  FINAL,      // rendered with the main camera, the water is drawn on top
+};
+
 class Water {
 private:
   WaterRenderer m_renderer;
@@ -27,7 +34,14 @@ public:
 
   void updateMoveFactor(float deltaTime) { m_renderer.updateMoveFactor(deltaTime); }
 
-  void onRender(const std::function<void()> &renderFn, Renderer::Camera &camera);
+  /*
+   * Renders the scene through renderFn once per WaterPass, renderFn must draw
+   * with the given camera. Passes other than REFLECTION use the main camera,
+   * scenes may cull their objects once for both cameras beforehand.
+   */
+  void onRender(const std::function<void(const Renderer::Camera &camera, WaterPass pass)> &renderFn, const Renderer::Camera &camera);
+  /* Returns the camera mirrored by the water plane, used by the reflection pass */
+  Renderer::Camera getReflectionCamera(const Renderer::Camera &camera) const;
 
   void onImguiRender() {}
 };
@@ -0,0 +1,249 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cassert>
+
+namespace Renderer {
+
+void BoundingVolumeHierarchy::build(const std::vector<AABB> &boxes)
+{
+  clear();
+  if (boxes.empty())
+    return;
+
+  unsigned int itemCount = (unsigned int)boxes.size();
+  m_itemBoxes = boxes;
+  m_itemLeaves.resize(itemCount);
+  m_itemLastRejectingPlans.assign(itemCount, 0);
+  m_itemIndices.resize(itemCount);
+  std::iota(m_itemIndices.begin(), m_itemIndices.end(), 0);
+
+  // a binary tree with non-empty leaves cannot have more than 2n-1 nodes
+  m_nodes.reserve(2 * (size_t)itemCount - 1);
+  m_nodes.emplace_back();
+  buildNode(0, NO_NODE, 0, itemCount, 0);
+}
+
+void BoundingVolumeHierarchy::buildNode(unsigned int nodeIndex, unsigned int parent, unsigned int firstItem, unsigned int itemCount, unsigned int depth)
+{
+  m_nodes[nodeIndex].parent = parent;
+
+  if (itemCount <= MAX_ITEMS_PER_LEAF || depth + 1 >= MAX_DEPTH) {
+    m_nodes[nodeIndex].firstChildOrItem = firstItem;
+    m_nodes[nodeIndex].itemCount = itemCount;
+    for (unsigned int i = firstItem; i < firstItem + itemCount; i++)
+      m_itemLeaves[m_itemIndices[i]] = nodeIndex;
+    computeNodeBounds(m_nodes[nodeIndex]);
+    return;
+  }
+
+  // split at the median of the item centers, along the axis where they are the most spread
+  // (centers are not divided by 2, only their order matters)
+  auto getDoubleCenter = [this](unsigned int item) { return 2.f * m_itemBoxes[item].getOrigin() + m_itemBoxes[item].getSize(); };
+  glm::vec3 centersMin{ std::numeric_limits<float>::max() };
+  glm::vec3 centersMax{ std::numeric_limits<float>::lowest() };
+  for (unsigned int i = firstItem; i < firstItem + itemCount; i++) {
+    glm::vec3 center = getDoubleCenter(m_itemIndices[i]);
+    centersMin = glm::min(centersMin, center);
+    centersMax = glm::max(centersMax, center);
+  }
+  glm::vec3 spread = centersMax - centersMin;
+  int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+  unsigned int half = itemCount / 2;
+  auto first = m_itemIndices.begin() + firstItem;
+  std::nth_element(first, first + half, first + itemCount, [&](unsigned int a, unsigned int b) {
+    return getDoubleCenter(a)[axis] < getDoubleCenter(b)[axis];
+  });
+
+  unsigned int firstChild = (unsigned int)m_nodes.size();
+  m_nodes[nodeIndex].firstChildOrItem = firstChild;
+  m_nodes[nodeIndex].itemCount = 0;
+  m_nodes.emplace_back();
+  m_nodes.emplace_back();
+  buildNode(firstChild,     nodeIndex, firstItem,        half,             depth + 1);
+  buildNode(firstChild + 1, nodeIndex, firstItem + half, itemCount - half, depth + 1);
+  computeNodeBounds(m_nodes[nodeIndex]);
+}
+
+void BoundingVolumeHierarchy::computeNodeBounds(Node &node) const
+{
+  node.min = glm::vec3{ std::numeric_limits<float>::max() };
+  node.max = glm::vec3{ std::numeric_limits<float>::lowest() };
+  if (node.isLeaf()) {
+    for (unsigned int i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; i++) {
+      const AABB &box = m_itemBoxes[m_itemIndices[i]];
+      node.min = glm::min(node.min, box.getOrigin());
+      node.max = glm::max(node.max, box.getOrigin() + box.getSize());
+    }
+  } else {
+    for (unsigned int c = node.firstChildOrItem; c < node.firstChildOrItem + 2; c++) {
+      node.min = glm::min(node.min, m_nodes[c].min);
+      node.max = glm::max(node.max, m_nodes[c].max);
+    }
+  }
+}
+
+void BoundingVolumeHierarchy::setBox(unsigned int itemIndex, const AABB &box)
+{
+  assert(itemIndex < m_itemBoxes.size());
+  m_itemBoxes[itemIndex] = box;
+
+  // refit up to the root, stop early when a node did not change, its parents won't either
+  for (unsigned int nodeIndex = m_itemLeaves[itemIndex]; nodeIndex != NO_NODE; nodeIndex = m_nodes[nodeIndex].parent) {
+    Node &node = m_nodes[nodeIndex];
+    glm::vec3 previousMin = node.min, previousMax = node.max;
+    computeNodeBounds(node);
+    if (node.min == previousMin && node.max == previousMax)
+      break;
+  }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+  m_nodes.clear();
+  m_itemIndices.clear();
+  m_itemLeaves.clear();
+  m_itemBoxes.clear();
+  m_itemLastRejectingPlans.clear();
+}
+
+bool BoundingVolumeHierarchy::testBox(const CullingSystem::CullingFrustum &frustum, const glm::vec3 &center, const glm::vec3 &extent, uint8_t &plansMask, uint8_t &lastRejectingPlan) const
+{
+  // same computation as Frustum#isOnOrForwardPlan, the last rejecting plan is tested first
+  for (uint8_t i = 0; i < 6; i++) {
+    uint8_t plan = i == 0 ? lastRejectingPlan : (i == lastRejectingPlan ? 0 : i);
+    if (!(plansMask & (1 << plan)))
+      continue;
+    const CullingSystem::CullingPlan &p = frustum[plan];
+    float sd = p.nx * center.x + p.ny * center.y + p.nz * center.z - p.distanceToOrigin;
+    float r = extent.x * p.anx + extent.y * p.any + extent.z * p.anz;
+    m_statistics.planTests++;
+    if (!(-r <= sd)) {
+      lastRejectingPlan = plan;
+      return false;
+    }
+    if (r <= sd)
+      plansMask &= ~(1 << plan); // fully inside, children do not need to test this plan
+  }
+  return true;
+}
+
+void BoundingVolumeHierarchy::cull(const Frustum &frustum, std::vector<unsigned int> &visibleItems) const
+{
+  visibleItems.clear();
+  m_statistics = {};
+  if (m_nodes.empty())
+    return;
+
+  CullingSystem::CullingFrustum cullingFrustum = CullingSystem::makeCullingFrustum(frustum);
+
+  struct StackEntry { unsigned int node; uint8_t plansMask; };
+  StackEntry stack[MAX_DEPTH + 1];
+  unsigned int stackSize = 0;
+  stack[stackSize++] = { 0, ALL_PLANS_MASK };
+
+  while (stackSize > 0) {
+    StackEntry entry = stack[--stackSize];
+    const Node &node = m_nodes[entry.node];
+    m_statistics.visitedNodes++;
+
+    uint8_t plansMask = entry.plansMask;
+    if (plansMask) {
+      glm::vec3 center = (node.min + node.max) * .5f;
+      glm::vec3 extent = node.max - center;
+      if (!testBox(cullingFrustum, center, extent, plansMask, node.lastRejectingPlan))
+        continue;
+    }
+
+    if (!node.isLeaf()) {
+      assert(stackSize + 2 <= MAX_DEPTH + 1);
+      stack[stackSize++] = { node.firstChildOrItem + 1, plansMask };
+      stack[stackSize++] = { node.firstChildOrItem,     plansMask };
+      continue;
+    }
+
+    for (unsigned int i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; i++) {
+      unsigned int item = m_itemIndices[i];
+      uint8_t itemPlansMask = plansMask;
+      if (itemPlansMask) {
+        m_statistics.testedItems++;
+        const AABB &box = m_itemBoxes[item];
+        glm::vec3 center = box.getOrigin() + box.getSize() / glm::vec3(2);
+        glm::vec3 extent = (box.getOrigin() + box.getSize()) - center;
+        if (!testBox(cullingFrustum, center, extent, itemPlansMask, m_itemLastRejectingPlans[item]))
+          continue;
+      }
+      visibleItems.push_back(item);
+    }
+  }
+}
+
+void BoundingVolumeHierarchy::cullViews(std::span<const Frustum> frustums, std::span<CullingSystem::VisibilityBitset> visibilities) const
+{
+  assert(frustums.size() == visibilities.size());
+  assert(frustums.size() <= CullingSystem::MAX_VIEWS);
+  m_statistics = {};
+  const size_t viewCount = frustums.size();
+  CullingSystem::CullingFrustum cullingFrustums[CullingSystem::MAX_VIEWS];
+  for (size_t view = 0; view < viewCount; view++) {
+    cullingFrustums[view] = CullingSystem::makeCullingFrustum(frustums[view]);
+    visibilities[view].assign((getItemCount() + 63) / 64, 0);
+  }
+  if (m_nodes.empty() || viewCount == 0)
+    return;
+
+  struct StackEntry { unsigned int node; uint8_t viewsMask; uint8_t plansMasks[CullingSystem::MAX_VIEWS]; };
+  StackEntry stack[MAX_DEPTH + 1];
+  unsigned int stackSize = 0;
+  stack[stackSize] = { 0, (uint8_t)((1u << viewCount) - 1), {} };
+  std::fill_n(stack[stackSize].plansMasks, viewCount, ALL_PLANS_MASK);
+  stackSize++;
+
+  while (stackSize > 0) {
+    StackEntry entry = stack[--stackSize];
+    const Node &node = m_nodes[entry.node];
+    m_statistics.visitedNodes++;
+
+    glm::vec3 center = (node.min + node.max) * .5f;
+    glm::vec3 extent = node.max - center;
+    for (size_t view = 0; view < viewCount; view++) {
+      uint8_t ignoredRejectingPlan = 0;
+      if ((entry.viewsMask & (1 << view)) && entry.plansMasks[view] &&
+          !testBox(cullingFrustums[view], center, extent, entry.plansMasks[view], ignoredRejectingPlan))
+        entry.viewsMask &= ~(1 << view);
+    }
+    if (!entry.viewsMask)
+      continue;
+
+    if (!node.isLeaf()) {
+      assert(stackSize + 2 <= MAX_DEPTH + 1);
+      stack[stackSize] = entry;
+      stack[stackSize++].node = node.firstChildOrItem + 1;
+      stack[stackSize] = entry;
+      stack[stackSize++].node = node.firstChildOrItem;
+      continue;
+    }
+
+    for (unsigned int i = node.firstChildOrItem; i < node.firstChildOrItem + node.itemCount; i++) {
+      unsigned int item = m_itemIndices[i];
+      const AABB &box = m_itemBoxes[item];
+      glm::vec3 itemCenter = box.getOrigin() + box.getSize() / glm::vec3(2);
+      glm::vec3 itemExtent = (box.getOrigin() + box.getSize()) - itemCenter;
+      m_statistics.testedItems++;
+      for (size_t view = 0; view < viewCount; view++) {
+        if (!(entry.viewsMask & (1 << view)))
+          continue;
+        uint8_t itemPlansMask = entry.plansMasks[view];
+        uint8_t ignoredRejectingPlan = 0;
+        if (itemPlansMask && !testBox(cullingFrustums[view], itemCenter, itemExtent, itemPlansMask, ignoredRejectingPlan))
+          continue;
+        visibilities[view][item / 64] |= 1ull << (item % 64);
+      }
+    }
+  }
+}
+
+}
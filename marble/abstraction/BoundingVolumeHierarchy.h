@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "CullingSystem.h"
+#include "../Utils/AABB.h"
+
+namespace Renderer {
+
+/**
+* A bounding volume hierarchy is a binary tree of boxes, each node contains
+* the boxes of its children and leaves contain a few items. It is used to
+* frustum cull many objects without testing all of them: when a node is not
+* visible none of its items are.
+*
+* Items are identified by their index in the list given to #build, boxes can
+* be moved with #setBox which refits the nodes containing the item. Refitting
+* does not change the tree structure so after many large moves the tree
+* becomes less efficient and should be rebuilt.
+*
+* Culling uses two classic tricks:
+* - plan masking, when a node is fully inside one of the frustum plans its
+*   children do not need to be tested against that plan
+* - temporal coherency, each node remembers the plan that rejected it last
+*   time and tests it first, when the camera moves smoothly it is likely to
+*   reject the node again
+*
+* Example usage:
+*   BoundingVolumeHierarchy bvh;
+*   bvh.build(boxes);
+*   std::vector<unsigned int> visible;
+*   bvh.cull(Frustum::createFrustumFromCamera(camera), visible);
+*/
+class BoundingVolumeHierarchy {
+public:
+  static constexpr unsigned int MAX_ITEMS_PER_LEAF = 4;
+  static constexpr unsigned int MAX_DEPTH = 64;
+
+  struct Statistics {
+    unsigned int visitedNodes;
+    unsigned int testedItems;
+    unsigned int planTests;
+  };
+
+private:
+  static constexpr unsigned int NO_NODE = (unsigned int)-1;
+  static constexpr uint8_t      ALL_PLANS_MASK = 0b111111;
+
+  struct Node {
+    glm::vec3    min, max;
+    // internal nodes have 2 children at firstChildOrItem and firstChildOrItem+1,
+    // leaves have itemCount items in m_itemIndices starting at firstChildOrItem
+    unsigned int firstChildOrItem;
+    unsigned int itemCount;
+    unsigned int parent;
+    mutable uint8_t lastRejectingPlan = 0;
+
+    bool isLeaf() const { return itemCount != 0; }
+  };
+
+  std::vector<Node>         m_nodes;
+  std::vector<unsigned int> m_itemIndices;      // items sorted by leaf
+  std::vector<unsigned int> m_itemLeaves;       // item index -> leaf node index
+  std::vector<AABB>         m_itemBoxes;
+  mutable std::vector<uint8_t> m_itemLastRejectingPlans;
+  mutable Statistics        m_statistics{};
+
+public:
+  BoundingVolumeHierarchy() = default;
+
+  /* Rebuilds the whole tree, previous items are discarded */
+  void build(const std::vector<AABB> &boxes);
+  /* Moves an item and refits the nodes containing it */
+  void setBox(unsigned int itemIndex, const AABB &box);
+  void clear();
+
+  size_t getItemCount() const { return m_itemLeaves.size(); }
+  size_t getNodeCount() const { return m_nodes.size(); }
+  const Statistics &getLastCullStatistics() const { return m_statistics; }
+
+  /* Fills the indices of visible items, the list is cleared first, indices are not sorted */
+  void cull(const Frustum &frustum, std::vector<unsigned int> &visibleItems) const;
+  /*
+   * Fills one bitset per frustum, the tree is traversed once for all views and
+   * a node is skipped as soon as no view sees it. Plan masking is done per
+   * view, temporal coherency is not used.
+   */
+  void cullViews(std::span<const Frustum> frustums, std::span<CullingSystem::VisibilityBitset> visibilities) const;
+
+private:
+  void buildNode(unsigned int nodeIndex, unsigned int parent, unsigned int firstItem, unsigned int itemCount, unsigned int depth);
+  void computeNodeBounds(Node &node) const;
+  // returns false if the box is outside of the frustum, otherwise clears from plansMask the plans the box is fully inside of
+  bool testBox(const CullingSystem::CullingFrustum &frustum, const glm::vec3 &center, const glm::vec3 &extent, uint8_t &plansMask, uint8_t &lastRejectingPlan) const;
+};
+
+}
@@ -133,6 +133,18 @@ bool Frustum::isOnFrustum(const AABB &boudingBox) const
   );
 }
 
+bool Frustum::isOnFrustum(const glm::vec3 &sphereCenter, float sphereRadius) const
+{
+  return (
+    leftFace.getSDToPlan(sphereCenter)   >= -sphereRadius &&
+    rightFace.getSDToPlan(sphereCenter)  >= -sphereRadius &&
+    topFace.getSDToPlan(sphereCenter)    >= -sphereRadius &&
+    bottomFace.getSDToPlan(sphereCenter) >= -sphereRadius &&
+    nearFace.getSDToPlan(sphereCenter)   >= -sphereRadius &&
+    farFace.getSDToPlan(sphereCenter)    >= -sphereRadius
+  );
+}
+
 bool Frustum::isOnOrForwardPlan(const Plan &plan, const AABB &boundingBox)
 {
   // Compute the projection interval radius of b onto L(t) = b.c + t * p.n
@@ -139,6 +139,7 @@ struct Frustum {
     Plan nearFace;
 
     bool isOnFrustum(const AABB &boudingBox) const;
+    bool isOnFrustum(const glm::vec3 &sphereCenter, float sphereRadius) const;
     
     static Frustum createFrustumFromCamera(const Camera &cam);
     static Frustum createFrustumFromOrthographicCamera(const Camera &cam);
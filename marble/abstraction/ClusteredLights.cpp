@@ -0,0 +1,230 @@
+#include "ClusteredLights.h"
+
+#include "../Utils/Profiler.h"
+#include "../Utils/WorkerPool.h"
+
+#include <cmath>
+#include <bit>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#define MARBLE_CLUSTERS_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MARBLE_CLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Renderer {
+
+ClusteredLights::ClusteredLights(unsigned int threadCount)
+  : m_threadCount(threadCount ? threadCount : WorkerPool::getShared().getThreadCount()),
+    m_sliceBounds(SLICE_COUNT),
+    m_clusterLightCounts(CLUSTER_COUNT),
+    m_clusterLightSlots((size_t)CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER),
+    m_sliceOverflows(SLICE_COUNT),
+    m_clusters(CLUSTER_COUNT),
+    m_clustersBuffer(sizeof(glm::uvec2) * CLUSTER_COUNT),
+    m_indicesBuffer(sizeof(uint32_t) * CLUSTER_COUNT),
+    m_clusterBlockBuffer(sizeof(ClusterBlock))
+{
+}
+
+void ClusteredLights::setLights(std::span<const PackedPointLight> lights)
+{
+  m_lightSpheres.resize(lights.size());
+  for (size_t i = 0; i < lights.size(); i++)
+    m_lightSpheres[i] = glm::vec4(glm::vec3(lights[i].positionRange), lights[i].isOn() ? lights[i].positionRange.w : 0.f);
+  m_lightsChanged = true;
+}
+
+void ClusteredLights::bind() const
+{
+  m_clustersBuffer.bindBase(LIGHT_CLUSTERS_STORAGE_BINDING);
+  m_indicesBuffer.bindBase(LIGHT_CLUSTER_INDICES_STORAGE_BINDING);
+  m_clusterBlockBuffer.bindBase(CLUSTER_BLOCK_BINDING);
+}
+
+void ClusteredLights::computeSliceBounds(const glm::mat4 &projection)
+{
+  // view space x of a point at distance d in front of the camera, for any perspective projection (off-center included)
+  auto viewX = [&](float ndc, float d) { return (ndc + projection[2][0]) * d / projection[0][0]; };
+  auto viewY = [&](float ndc, float d) { return (ndc + projection[2][1]) * d / projection[1][1]; };
+
+  for (unsigned int slice = 0; slice < SLICE_COUNT; slice++) {
+    SliceBounds &bounds = m_sliceBounds[slice];
+    float sliceNear = m_zNear * std::pow(m_zFar / m_zNear, (float)slice / SLICE_COUNT);
+    float sliceFar = m_zNear * std::pow(m_zFar / m_zNear, (float)(slice + 1) / SLICE_COUNT);
+    bounds.minZ = -sliceFar;
+    bounds.maxZ = -sliceNear;
+    for (unsigned int ty = 0; ty < TILE_COUNT_Y; ty++) {
+      float ndcY0 = -1.f + 2.f * ty / TILE_COUNT_Y;
+      float ndcY1 = -1.f + 2.f * (ty + 1) / TILE_COUNT_Y;
+      for (unsigned int tx = 0; tx < TILE_COUNT_X; tx++) {
+        float ndcX0 = -1.f + 2.f * tx / TILE_COUNT_X;
+        float ndcX1 = -1.f + 2.f * (tx + 1) / TILE_COUNT_X;
+        unsigned int tile = ty * TILE_COUNT_X + tx;
+        float xs[4] = { viewX(ndcX0, sliceNear), viewX(ndcX1, sliceNear), viewX(ndcX0, sliceFar), viewX(ndcX1, sliceFar) };
+        float ys[4] = { viewY(ndcY0, sliceNear), viewY(ndcY1, sliceNear), viewY(ndcY0, sliceFar), viewY(ndcY1, sliceFar) };
+        bounds.minX[tile] = *std::min_element(xs, xs + 4);
+        bounds.maxX[tile] = *std::max_element(xs, xs + 4);
+        bounds.minY[tile] = *std::min_element(ys, ys + 4);
+        bounds.maxY[tile] = *std::max_element(ys, ys + 4);
+      }
+    }
+  }
+}
+
+void ClusteredLights::update(const Camera &camera)
+{
+  MARBLE_PROFILE_SCOPE("Light clusters");
+  if (camera.getProjectionType() != CameraProjection::PERSPECTIVE)
+    return;
+  if (!m_lightsChanged && camera.getViewProjectionMatrix() == m_clusteredViewProjection)
+    return;
+
+  auto begin = std::chrono::high_resolution_clock::now();
+
+  if (camera.getProjectionMatrix() != m_clusteredProjection) {
+    const PerspectiveProjection &projection = camera.getProjection<PerspectiveProjection>();
+    m_zNear = projection.zNear;
+    m_zFar = projection.zFar;
+    m_clusteredProjection = camera.getProjectionMatrix();
+    computeSliceBounds(m_clusteredProjection);
+  }
+
+  // lights in view space and the range of slices they cover
+  const glm::mat4 &view = camera.getViewMatrix();
+  float sliceScale = SLICE_COUNT / std::log(m_zFar / m_zNear);
+  m_viewLights.resize(m_lightSpheres.size());
+  for (size_t i = 0; i < m_lightSpheres.size(); i++) {
+    const glm::vec4 &sphere = m_lightSpheres[i];
+    ViewLight &light = m_viewLights[i];
+    light.center = glm::vec3(view * glm::vec4(glm::vec3(sphere), 1.f));
+    light.radius = sphere.w;
+    float nearest = -light.center.z - light.radius;
+    float farthest = -light.center.z + light.radius;
+    if (light.radius <= 0 || farthest < m_zNear || nearest > m_zFar) {
+      light.firstSlice = 1;
+      light.lastSlice = 0;
+      continue;
+    }
+    light.firstSlice = nearest <= m_zNear ? 0 : std::min(SLICE_COUNT - 1, (unsigned int)(std::log(nearest / m_zNear) * sliceScale));
+    light.lastSlice = farthest >= m_zFar ? SLICE_COUNT - 1 : std::min(SLICE_COUNT - 1, (unsigned int)(std::log(farthest / m_zNear) * sliceScale));
+  }
+
+  // each thread bins whole slices, clusters are never written by two threads
+  unsigned int threadCount = m_lightSpheres.size() < PARALLEL_LIGHT_COUNT ? 1 : std::min(m_threadCount, SLICE_COUNT);
+  WorkerPool &pool = WorkerPool::getShared();
+  WorkerPool::JobGroup binning;
+  for (unsigned int thread = 1; thread < threadCount; thread++)
+    pool.run(binning, [this, thread, threadCount] { binSlices(SLICE_COUNT * thread / threadCount, SLICE_COUNT * (thread + 1) / threadCount); });
+  binSlices(0, SLICE_COUNT / threadCount);
+  pool.wait(binning);
+
+  compactAndUpload();
+
+  m_clusteredViewProjection = camera.getViewProjectionMatrix();
+  m_lightsChanged = false;
+  m_statistics.lights = (unsigned int)m_lightSpheres.size();
+  m_statistics.threads = threadCount;
+  m_statistics.binningTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+void ClusteredLights::binSlices(unsigned int firstSlice, unsigned int lastSlice)
+{
+  MARBLE_PROFILE_SCOPE("Light cluster slices");
+  for (unsigned int slice = firstSlice; slice < lastSlice; slice++) {
+    const SliceBounds &bounds = m_sliceBounds[slice];
+    uint32_t *counts = &m_clusterLightCounts[(size_t)slice * TILE_COUNT];
+    uint32_t *slots = &m_clusterLightSlots[(size_t)slice * TILE_COUNT * MAX_LIGHTS_PER_CLUSTER];
+    uint32_t overflows = 0;
+    std::fill_n(counts, TILE_COUNT, 0);
+
+    // counts keep growing past the maximum for statistics, only the first lights are stored
+    auto assign = [&](unsigned int tile, uint32_t lightIndex) {
+      uint32_t count = counts[tile]++;
+      if (count < MAX_LIGHTS_PER_CLUSTER)
+        slots[(size_t)tile * MAX_LIGHTS_PER_CLUSTER + count] = lightIndex;
+      else if (count == MAX_LIGHTS_PER_CLUSTER)
+        overflows++;
+    };
+
+    for (uint32_t l = 0; l < (uint32_t)m_viewLights.size(); l++) {
+      const ViewLight &light = m_viewLights[l];
+      if (slice < light.firstSlice || slice > light.lastSlice)
+        continue;
+      // sphere-box test, the z distance is the same for every tile of the slice
+      float dz = std::max(0.f, std::max(bounds.minZ - light.center.z, light.center.z - bounds.maxZ));
+      float remainingRadius2 = light.radius * light.radius - dz * dz;
+      if (remainingRadius2 < 0)
+        continue;
+
+#if defined(MARBLE_CLUSTERS_AVX2)
+      const __m256 cx = _mm256_set1_ps(light.center.x);
+      const __m256 cy = _mm256_set1_ps(light.center.y);
+      const __m256 r2 = _mm256_set1_ps(remainingRadius2);
+      const __m256 zero = _mm256_setzero_ps();
+      for (unsigned int tile = 0; tile < TILE_COUNT; tile += 8) {
+        __m256 dx = _mm256_max_ps(zero, _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds.minX + tile), cx), _mm256_sub_ps(cx, _mm256_loadu_ps(bounds.maxX + tile))));
+        __m256 dy = _mm256_max_ps(zero, _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds.minY + tile), cy), _mm256_sub_ps(cy, _mm256_loadu_ps(bounds.maxY + tile))));
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        unsigned int hits = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ));
+        for (; hits; hits &= hits - 1)
+          assign(tile + std::countr_zero(hits), l);
+      }
+#elif defined(MARBLE_CLUSTERS_SSE)
+      const __m128 cx = _mm_set1_ps(light.center.x);
+      const __m128 cy = _mm_set1_ps(light.center.y);
+      const __m128 r2 = _mm_set1_ps(remainingRadius2);
+      const __m128 zero = _mm_setzero_ps();
+      for (unsigned int tile = 0; tile < TILE_COUNT; tile += 4) {
+        __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bounds.minX + tile), cx), _mm_sub_ps(cx, _mm_loadu_ps(bounds.maxX + tile))));
+        __m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(bounds.minY + tile), cy), _mm_sub_ps(cy, _mm_loadu_ps(bounds.maxY + tile))));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        unsigned int hits = (unsigned int)_mm_movemask_ps(_mm_cmple_ps(d2, r2));
+        for (; hits; hits &= hits - 1)
+          assign(tile + std::countr_zero(hits), l);
+      }
+#else
+      for (unsigned int tile = 0; tile < TILE_COUNT; tile++) {
+        float dx = std::max(0.f, std::max(bounds.minX[tile] - light.center.x, light.center.x - bounds.maxX[tile]));
+        float dy = std::max(0.f, std::max(bounds.minY[tile] - light.center.y, light.center.y - bounds.maxY[tile]));
+        if (dx * dx + dy * dy <= remainingRadius2)
+          assign(tile, l);
+      }
+#endif
+    }
+    m_sliceOverflows[slice] = overflows;
+  }
+}
+
+void ClusteredLights::compactAndUpload()
+{
+  m_clusterLightIndices.clear();
+  m_statistics.maxLightsPerCluster = 0;
+  m_statistics.overflowedClusters = 0;
+  for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+    uint32_t count = std::min(m_clusterLightCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+    const uint32_t *slots = &m_clusterLightSlots[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER];
+    m_clusters[cluster] = { (uint32_t)m_clusterLightIndices.size(), count };
+    m_clusterLightIndices.insert(m_clusterLightIndices.end(), slots, slots + count);
+    m_statistics.maxLightsPerCluster = std::max(m_statistics.maxLightsPerCluster, m_clusterLightCounts[cluster]);
+  }
+  for (uint32_t overflows : m_sliceOverflows)
+    m_statistics.overflowedClusters += overflows;
+  m_statistics.assignedIndices = (unsigned int)m_clusterLightIndices.size();
+
+  m_clustersBuffer.setData(m_clusters.data(), m_clusters.size() * sizeof(glm::uvec2));
+  m_indicesBuffer.setData(m_clusterLightIndices.data(), m_clusterLightIndices.size() * sizeof(uint32_t));
+
+  float logRatio = std::log(m_zFar / m_zNear);
+  ClusterBlock block;
+  block.clusterCount = { TILE_COUNT_X, TILE_COUNT_Y, SLICE_COUNT, 0 };
+  block.depthScale = SLICE_COUNT / logRatio;
+  block.depthBias = -(float)SLICE_COUNT * std::log(m_zNear) / logRatio;
+  m_clusterBlockBuffer.updateData(&block, sizeof(block));
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "UniformBlocks.h"
+#include "UniformBufferObject.h"
+#include "ShaderStorageBufferObject.h"
+#include "LightBuffer.h"
+
+namespace Renderer {
+
+/**
+* Clustered light assignment for the FORWARD_PLUS rendering state.
+*
+* The view frustum of the camera is split in TILE_COUNT_X*TILE_COUNT_Y*SLICE_COUNT
+* froxels ("clusters"), slices are distributed exponentially between the near
+* and far plans. Each light is tested against the view space bounding box of
+* the clusters in the slices its sphere of influence covers, the tests are done
+* 8 (AVX2) or 4 (SSE) tiles at a time and slices are split between the threads
+* of the shared WorkerPool when there are many lights.
+*
+* The result is uploaded to two storage buffers:
+*   - one (first index, count) pair per cluster
+*   - the indices of the lights of all clusters, in the light buffer (see LightBuffer)
+* and to the cluster block (see UniformBlocks.h), the "lights_clustered.fs"
+* mesh part reads them to only shade the lights of the fragment's cluster.
+* Lights that are off are not assigned.
+* Lights beyond a cluster's MAX_LIGHTS_PER_CLUSTER are dropped.
+*
+* Only perspective cameras can be clustered.
+*
+* Example usage:
+*   clusters.setLights(lightBuffer.getLights());
+*   clusters.update(camera); // does nothing if neither the lights nor the camera changed
+*   clusters.bind();
+*   ... draw meshes with lights_clustered.fs
+*/
+class ClusteredLights {
+public:
+  static constexpr unsigned int TILE_COUNT_X = 16;
+  static constexpr unsigned int TILE_COUNT_Y = 9;
+  static constexpr unsigned int TILE_COUNT = TILE_COUNT_X * TILE_COUNT_Y;
+  static constexpr unsigned int SLICE_COUNT = 24;
+  static constexpr unsigned int CLUSTER_COUNT = TILE_COUNT * SLICE_COUNT;
+  static constexpr unsigned int MAX_LIGHTS_PER_CLUSTER = 128;
+  // below this number of lights binning is done on the calling thread
+  static constexpr unsigned int PARALLEL_LIGHT_COUNT = 64;
+
+  static_assert(TILE_COUNT % 8 == 0, "tiles are tested by batches of 8");
+
+  struct Statistics {
+    unsigned int lights;
+    unsigned int assignedIndices;      // sum of the light counts of all clusters
+    unsigned int maxLightsPerCluster;
+    unsigned int overflowedClusters;   // clusters that had more than MAX_LIGHTS_PER_CLUSTER lights
+    unsigned int threads;
+    long long    binningTime;          // in nanoseconds
+  };
+
+private:
+  // view space bounding boxes of the clusters of each slice, structure-of-arrays by tile
+  struct SliceBounds {
+    float minX[TILE_COUNT], minY[TILE_COUNT];
+    float maxX[TILE_COUNT], maxY[TILE_COUNT];
+    float minZ, maxZ;
+  };
+
+  // a light in view space and the slices it covers
+  struct ViewLight {
+    glm::vec3    center;
+    float        radius;
+    unsigned int firstSlice, lastSlice; // inclusive, firstSlice > lastSlice if the light is not visible
+  };
+
+  unsigned int m_threadCount;
+  std::vector<glm::vec4> m_lightSpheres; // xyz position, w range, 0 for lights that are off
+  bool         m_lightsChanged = true;
+  glm::mat4    m_clusteredViewProjection{ 0.f };
+  glm::mat4    m_clusteredProjection{ 0.f };
+  float        m_zNear = 0, m_zFar = 0;
+
+  std::vector<SliceBounds>  m_sliceBounds;
+  std::vector<ViewLight>    m_viewLights;
+  std::vector<uint32_t>     m_clusterLightCounts;   // CLUSTER_COUNT
+  std::vector<uint32_t>     m_clusterLightSlots;    // CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER
+  std::vector<uint32_t>     m_sliceOverflows;       // SLICE_COUNT, overflowed clusters of each slice
+  std::vector<glm::uvec2>   m_clusters;             // uploaded, (first index, count)
+  std::vector<uint32_t>     m_clusterLightIndices;  // uploaded
+
+  ShaderStorageBufferObject m_clustersBuffer;
+  ShaderStorageBufferObject m_indicesBuffer;
+  UniformBufferObject       m_clusterBlockBuffer;
+
+  Statistics m_statistics{};
+
+public:
+  /* threadCount is the number of parts slices are split in, 0 uses every thread of the shared WorkerPool */
+  explicit ClusteredLights(unsigned int threadCount = 0);
+
+  /* The indices of the given lights must be the ones of the light buffer */
+  void setLights(std::span<const PackedPointLight> lights);
+  /* Re-assigns the lights to the clusters of the camera if it or the lights changed since the last call */
+  void update(const Camera &camera);
+  /* Binds the storage buffers and the cluster block to their binding points, the light buffer is bound separately */
+  void bind() const;
+
+  size_t getLightCount() const { return m_lightSpheres.size(); }
+  const Statistics &getStatistics() const { return m_statistics; }
+
+private:
+  void computeSliceBounds(const glm::mat4 &projection);
+  void binSlices(unsigned int firstSlice, unsigned int lastSlice);
+  void compactAndUpload();
+};
+
+}
@@ -7,6 +7,9 @@
 
 #include <glad/glad.h>
 
+#include "GLStateCache.h"
+#include "RenderDevice.h"
+
 namespace Renderer {
 
 ComputeShader::ComputeShader(const char *path, glm::uvec2 workSize)
@@ -48,8 +51,7 @@ ComputeShader::ComputeShader(const char *path, glm::uvec2 workSize)
 
   // create input/output textures
   glGenTextures(1, &m_outTexture);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, m_outTexture);
+  GLStateCache::bindTexture2D(0, m_outTexture);
 
   // turns out we need this. huh.
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -62,20 +64,20 @@ ComputeShader::ComputeShader(const char *path, glm::uvec2 workSize)
 
 ComputeShader::~ComputeShader()
 {
+  GLStateCache::notifyProgramDeleted(m_shaderID);
   glDeleteProgram(m_shaderID);
 }
 
 void ComputeShader::use() const
 {
-  glUseProgram(m_shaderID);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, m_outTexture);
+  GLStateCache::useProgram(m_shaderID);
+  GLStateCache::bindTexture2D(0, m_outTexture);
 }
 
 void ComputeShader::dispatch() const
 {
   // just keep it simple, 2d work group
-  glDispatchCompute(m_workSize.x, m_workSize.y, 1);
+  getRenderDevice().dispatchCompute(m_workSize.x, m_workSize.y, 1);
 }
 
 void ComputeShader::wait() const
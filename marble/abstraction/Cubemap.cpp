@@ -10,6 +10,7 @@
 #include "Shader.h"
 #include "VertexArray.h"
 #include "IndexBufferObject.h"
+#include "GLStateCache.h"
 #include "UnifiedRenderer.h"
 
 namespace Renderer {
@@ -46,13 +47,13 @@ Cubemap::~Cubemap()
 
 void Cubemap::bind() const
 {
-  glActiveTexture(GL_TEXTURE0);
+  GLStateCache::activeTexture(0);
   glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
 }
 
 void Cubemap::unbind()
 {
-  glActiveTexture(GL_TEXTURE0);
+  GLStateCache::activeTexture(0);
   glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
@@ -0,0 +1,217 @@
+#include "CullingSystem.h"
+
+#include <cmath>
+#include <bit>
+
+#if defined(__AVX2__)
+#define MARBLE_CULLING_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MARBLE_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Renderer {
+
+static constexpr size_t BATCH_SIZE = CullingSystem::BATCH_SIZE;
+
+static size_t paddedSize(size_t boxCount)
+{
+  return (boxCount + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+}
+
+size_t CullingSystem::addBox(const AABB &box)
+{
+  size_t index = m_boxCount++;
+  if (m_boxCount > m_centerX.size()) {
+    size_t newSize = paddedSize(m_boxCount);
+    m_centerX.resize(newSize); m_centerY.resize(newSize); m_centerZ.resize(newSize);
+    m_extentX.resize(newSize); m_extentY.resize(newSize); m_extentZ.resize(newSize);
+  }
+  setBox(index, box);
+  return index;
+}
+
+void CullingSystem::setBox(size_t index, const AABB &box)
+{
+  assert(index < m_boxCount);
+  // computed exactly like Frustum#isOnOrForwardPlan does for the results to be identical
+  glm::vec3 center = box.getOrigin() + box.getSize() / glm::vec3(2);
+  glm::vec3 extent = (box.getOrigin() + box.getSize()) - center;
+  m_centerX[index] = center.x;
+  m_centerY[index] = center.y;
+  m_centerZ[index] = center.z;
+  m_extentX[index] = extent.x;
+  m_extentY[index] = extent.y;
+  m_extentZ[index] = extent.z;
+}
+
+void CullingSystem::reserve(size_t boxCount)
+{
+  size_t size = paddedSize(boxCount);
+  m_centerX.reserve(size); m_centerY.reserve(size); m_centerZ.reserve(size);
+  m_extentX.reserve(size); m_extentY.reserve(size); m_extentZ.reserve(size);
+}
+
+void CullingSystem::clear()
+{
+  m_centerX.clear(); m_centerY.clear(); m_centerZ.clear();
+  m_extentX.clear(); m_extentY.clear(); m_extentZ.clear();
+  m_boxCount = 0;
+}
+
+CullingSystem::CullingFrustum CullingSystem::makeCullingFrustum(const Frustum &frustum)
+{
+  // same order as Frustum#isOnFrustum, side plans reject more boxes than the near&far ones
+  const Plan *plans[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+  CullingFrustum cullingFrustum;
+  for (size_t i = 0; i < 6; i++) {
+    const Plan &p = *plans[i];
+    cullingFrustum[i] = {
+      p.normal.x, p.normal.y, p.normal.z,
+      std::abs(p.normal.x), std::abs(p.normal.y), std::abs(p.normal.z),
+      p.distanceToOrigin
+    };
+  }
+  return cullingFrustum;
+}
+
+uint32_t CullingSystem::cullBatch(const CullingFrustum &frustum, size_t firstBox) const
+{
+  // the operations order must match Frustum#isOnOrForwardPlan exactly, do not use fma here
+#if defined(MARBLE_CULLING_AVX2)
+  const __m256 cx = _mm256_loadu_ps(&m_centerX[firstBox]);
+  const __m256 cy = _mm256_loadu_ps(&m_centerY[firstBox]);
+  const __m256 cz = _mm256_loadu_ps(&m_centerZ[firstBox]);
+  const __m256 ex = _mm256_loadu_ps(&m_extentX[firstBox]);
+  const __m256 ey = _mm256_loadu_ps(&m_extentY[firstBox]);
+  const __m256 ez = _mm256_loadu_ps(&m_extentZ[firstBox]);
+  const __m256 signBit = _mm256_set1_ps(-0.f);
+  __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+  for (const CullingPlan &p : frustum) {
+    __m256 sd = _mm256_add_ps(_mm256_add_ps(
+      _mm256_mul_ps(_mm256_set1_ps(p.nx), cx),
+      _mm256_mul_ps(_mm256_set1_ps(p.ny), cy)),
+      _mm256_mul_ps(_mm256_set1_ps(p.nz), cz));
+    sd = _mm256_sub_ps(sd, _mm256_set1_ps(p.distanceToOrigin));
+    __m256 r = _mm256_add_ps(_mm256_add_ps(
+      _mm256_mul_ps(ex, _mm256_set1_ps(p.anx)),
+      _mm256_mul_ps(ey, _mm256_set1_ps(p.any))),
+      _mm256_mul_ps(ez, _mm256_set1_ps(p.anz)));
+    visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_xor_ps(r, signBit), sd, _CMP_LE_OQ));
+    if (_mm256_testz_ps(visible, visible))
+      return 0;
+  }
+  return (uint32_t)_mm256_movemask_ps(visible);
+
+#elif defined(MARBLE_CULLING_SSE)
+  uint32_t mask = 0;
+  const __m128 signBit = _mm_set1_ps(-0.f);
+  for (size_t half = 0; half < BATCH_SIZE; half += 4) {
+    const size_t b = firstBox + half;
+    const __m128 cx = _mm_loadu_ps(&m_centerX[b]);
+    const __m128 cy = _mm_loadu_ps(&m_centerY[b]);
+    const __m128 cz = _mm_loadu_ps(&m_centerZ[b]);
+    const __m128 ex = _mm_loadu_ps(&m_extentX[b]);
+    const __m128 ey = _mm_loadu_ps(&m_extentY[b]);
+    const __m128 ez = _mm_loadu_ps(&m_extentZ[b]);
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (const CullingPlan &p : frustum) {
+      __m128 sd = _mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(_mm_set1_ps(p.nx), cx),
+        _mm_mul_ps(_mm_set1_ps(p.ny), cy)),
+        _mm_mul_ps(_mm_set1_ps(p.nz), cz));
+      sd = _mm_sub_ps(sd, _mm_set1_ps(p.distanceToOrigin));
+      __m128 r = _mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(ex, _mm_set1_ps(p.anx)),
+        _mm_mul_ps(ey, _mm_set1_ps(p.any))),
+        _mm_mul_ps(ez, _mm_set1_ps(p.anz)));
+      visible = _mm_and_ps(visible, _mm_cmple_ps(_mm_xor_ps(r, signBit), sd));
+      if (_mm_movemask_ps(visible) == 0)
+        break;
+    }
+    mask |= (uint32_t)_mm_movemask_ps(visible) << half;
+  }
+  return mask;
+
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < BATCH_SIZE; i++) {
+    const size_t b = firstBox + i;
+    bool visible = true;
+    for (const CullingPlan &p : frustum) {
+      float sd = p.nx * m_centerX[b] + p.ny * m_centerY[b] + p.nz * m_centerZ[b] - p.distanceToOrigin;
+      float r = m_extentX[b] * p.anx + m_extentY[b] * p.any + m_extentZ[b] * p.anz;
+      if (!(-r <= sd)) {
+        visible = false;
+        break;
+      }
+    }
+    mask |= (uint32_t)visible << i;
+  }
+  return mask;
+#endif
+}
+
+void CullingSystem::cull(const Frustum &frustum, VisibilityBitset &visibility) const
+{
+  static_assert(64 % BATCH_SIZE == 0);
+  CullingFrustum cullingFrustum = makeCullingFrustum(frustum);
+  visibility.assign((m_boxCount + 63) / 64, 0);
+
+  for (size_t firstBox = 0; firstBox < m_boxCount; firstBox += BATCH_SIZE) {
+    uint64_t mask = cullBatch(cullingFrustum, firstBox);
+    if (m_boxCount - firstBox < BATCH_SIZE)
+      mask &= (1ull << (m_boxCount - firstBox)) - 1; // ignore padding boxes
+    visibility[firstBox / 64] |= mask << (firstBox % 64);
+  }
+}
+
+void CullingSystem::cull(const Frustum &frustum, std::vector<unsigned int> &visibleIndices) const
+{
+  CullingFrustum cullingFrustum = makeCullingFrustum(frustum);
+  visibleIndices.clear();
+
+  for (size_t firstBox = 0; firstBox < m_boxCount; firstBox += BATCH_SIZE) {
+    uint32_t mask = cullBatch(cullingFrustum, firstBox);
+    if (m_boxCount - firstBox < BATCH_SIZE)
+      mask &= (1u << (m_boxCount - firstBox)) - 1;
+    for (unsigned int i = (unsigned int)firstBox; mask; mask >>= 1, i++) {
+      if (mask & 1)
+        visibleIndices.push_back(i);
+    }
+  }
+}
+
+void CullingSystem::cullViews(std::span<const Frustum> frustums, std::span<VisibilityBitset> visibilities) const
+{
+  assert(frustums.size() == visibilities.size());
+  assert(frustums.size() <= MAX_VIEWS);
+  CullingFrustum cullingFrustums[MAX_VIEWS];
+  for (size_t view = 0; view < frustums.size(); view++) {
+    cullingFrustums[view] = makeCullingFrustum(frustums[view]);
+    visibilities[view].assign((m_boxCount + 63) / 64, 0);
+  }
+
+  // the batch stays in cache while it is tested against every view
+  for (size_t firstBox = 0; firstBox < m_boxCount; firstBox += BATCH_SIZE) {
+    uint64_t paddingMask = m_boxCount - firstBox < BATCH_SIZE ? (1ull << (m_boxCount - firstBox)) - 1 : ~0ull;
+    for (size_t view = 0; view < frustums.size(); view++) {
+      uint64_t mask = cullBatch(cullingFrustums[view], firstBox) & paddingMask;
+      visibilities[view][firstBox / 64] |= mask << (firstBox % 64);
+    }
+  }
+}
+
+void CullingSystem::collectVisibleIndices(const VisibilityBitset &visibility, std::vector<unsigned int> &visibleIndices)
+{
+  visibleIndices.clear();
+  for (size_t word = 0; word < visibility.size(); word++) {
+    for (uint64_t bits = visibility[word]; bits; bits &= bits - 1)
+      visibleIndices.push_back((unsigned int)(word * 64 + std::countr_zero(bits)));
+  }
+}
+
+}
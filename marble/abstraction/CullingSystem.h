@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <span>
+#include <stdint.h>
+
+#include "Camera.h"
+#include "../Utils/AABB.h"
+
+namespace Renderer {
+
+/**
+* A culling system holds many bounding boxes and checks all of them against
+* a frustum at once, it is the batched equivalent of Frustum#isOnFrustum.
+*
+* Boxes are stored as structure-of-arrays (one array per center/extent
+* component) so that 8 boxes can be tested per iteration with AVX2, or 4
+* with SSE when AVX2 is not available. Results are bit-for-bit identical
+* to Frustum#isOnFrustum.
+*
+* Boxes are identified by the index returned by #addBox, results can be
+* retrieved as a bitset (bit i is set iff box i is visible) or as a compact
+* list of the indices of visible boxes. When the same boxes are seen by
+* several cameras (water reflections, shadow maps...) #cullViews tests them
+* against all frustums in a single pass, see MultiViewCulling.
+*
+* Example usage:
+*   CullingSystem culling;
+*   for (const Mesh &mesh : meshes)
+*     culling.addBox(mesh.getBoundingBox());
+*   std::vector<unsigned int> visible;
+*   culling.cull(Frustum::createFrustumFromCamera(camera), visible);
+*/
+class CullingSystem {
+public:
+  static constexpr size_t BATCH_SIZE = 8;
+  static constexpr size_t MAX_VIEWS = 8;
+
+  typedef std::vector<uint64_t> VisibilityBitset;
+
+  /* A frustum plan in a form that is directly usable by the culling loops */
+  struct CullingPlan {
+    float nx, ny, nz;          // plan normal
+    float anx, any, anz;       // absolute plan normal, used to compute the projected box radius
+    float distanceToOrigin;
+  };
+  typedef std::array<CullingPlan, 6> CullingFrustum;
+
+private:
+  // padded to a multiple of BATCH_SIZE, padding boxes are never reported as visible
+  std::vector<float> m_centerX, m_centerY, m_centerZ;
+  std::vector<float> m_extentX, m_extentY, m_extentZ;
+  size_t             m_boxCount = 0;
+
+public:
+  CullingSystem() = default;
+
+  /* Adds a box to the system and returns its index */
+  size_t addBox(const AABB &box);
+  void setBox(size_t index, const AABB &box);
+  void reserve(size_t boxCount);
+  void clear();
+
+  size_t getBoxCount() const { return m_boxCount; }
+
+  /* Fills the bitset, it is resized to hold #getBoxCount bits */
+  void cull(const Frustum &frustum, VisibilityBitset &visibility) const;
+  /* Fills the indices of visible boxes in increasing order, the list is cleared first */
+  void cull(const Frustum &frustum, std::vector<unsigned int> &visibleIndices) const;
+  /* Fills one bitset per frustum, boxes are only read once for all views */
+  void cullViews(std::span<const Frustum> frustums, std::span<VisibilityBitset> visibilities) const;
+
+  static bool isVisible(const VisibilityBitset &visibility, size_t index) { return (visibility[index / 64] >> (index % 64)) & 1; }
+  static CullingFrustum makeCullingFrustum(const Frustum &frustum);
+  /* Fills the indices of the bits set in the bitset in increasing order, the list is cleared first */
+  static void collectVisibleIndices(const VisibilityBitset &visibility, std::vector<unsigned int> &visibleIndices);
+
+private:
+  // tests boxes [firstBox, firstBox+BATCH_SIZE[ and returns one bit per box
+  uint32_t cullBatch(const CullingFrustum &frustum, size_t firstBox) const;
+};
+
+}
@@ -6,22 +6,31 @@
 #include "FrameBufferObject.h"
 #include "../World/Light/LightManager.h"
 #include "UnifiedRenderer.h"
+#include "LightVolumes.h"
+#include "GBufferEncoding.h"
+#include "../Utils/Profiler.h"
 #include "pipeline/VFXPipeline.h"
 
 #include <vector>
 
+/*
+ * Packed layout, 12 bytes per pixel with the depth (see GBufferEncoding.h) :
+ * - albedo, RGBA8
+ * - normal, RG16 octahedral encoding
+ * - positions are reconstructed from the depth and the inverse view-projection
+ */
 struct gBufferLayout {
 
-	Renderer::Texture albedo{ Window::getWinWidth(), Window::getWinHeight() };
-	Renderer::Texture normal{ Window::getWinWidth(), Window::getWinHeight() };
-	Renderer::Texture position{ Window::getWinWidth(), Window::getWinHeight() };
+	Renderer::Texture albedo = Renderer::Texture::createTargetTexture(Window::getWinWidth(), Window::getWinHeight(), GL_RGBA8);
+	Renderer::Texture normal = Renderer::Texture::createTargetTexture(Window::getWinWidth(), Window::getWinHeight(), GL_RG16);
 
 	Renderer::Texture depth = Renderer::Texture::createDepthTexture(Window::getWinWidth(), Window::getWinHeight());
 public:
 
+	/* In the order of the shaders' u_gBufferTextures, the depth is bound after them */
 	std::vector<Renderer::Texture*> getTextures() {
 		return {
-			&albedo, &normal,&position
+			&albedo, &normal, &depth
 		};
 	}
 
@@ -42,11 +51,10 @@ struct gBuffer {
 
 		fbo.setTargetTexture(textures.albedo,0);
 		fbo.setTargetTexture(textures.normal,1);
-		fbo.setTargetTexture(textures.position,2);
 
 		fbo.bind();
-		unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-		glDrawBuffers(3, attachments);
+		unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glDrawBuffers(2, attachments);
 		fbo.unbind();
 
 
@@ -65,6 +73,14 @@ private:
 
 	Renderer::FrameBufferObject m_final;
 	Renderer::Texture m_target{Window::getWinWidth(), Window::getWinHeight()};
+	Renderer::Texture m_finalDepth = Renderer::Texture::createDepthTexture(Window::getWinWidth(), Window::getWinHeight());
+
+	Renderer::LightVolumes m_lightVolumes;
+	bool m_useLightVolumes = true;
+
+	Renderer::Camera m_lastCamera;
+	Renderer::GBufferEncoding::Precision m_precision{};
+	bool m_precisionMeasured = false;
 
 	Renderer::BlitPass m_deferredPass;
 	Renderer::BlitPass last;
@@ -85,6 +101,7 @@ public:
 
 		// Set up the FBO correctly (depth map, and 3 textures attachments)
 		m_final.setTargetTexture(m_target);
+		m_final.setDepthTexture(m_finalDepth);
 
 		//Set up deferred pass
 		m_deferredPass.setShader("res/shaders/deferredPass.fs");
@@ -119,6 +136,7 @@ public:
 
 	void render(const std::function<void()>& renderFn, Renderer::Camera& camera) 
 	{
+		m_lastCamera = camera;
 		computeGeometryPass(renderFn);
 		combineAndApplyLights(camera);
 
@@ -152,10 +170,22 @@ public:
 						auto* t = textures[i];
 						ImGui::Image(t->getId(), size, { 0,1 }, { 1,0 });
 					}
-						ImGui::Image(m_gBuffer.textures.depth.getId(), size, { 0,1 }, { 1,0 });
 				
 		}
 
+		if (ImGui::CollapsingHeader("gBuffer precision")) {
+			// encodes and decodes on the cpu exactly as the shaders do, with the current camera
+			if (ImGui::Button("Measure"))
+			{
+				m_precision = Renderer::GBufferEncoding::measureGBufferPrecision(m_lastCamera, 4096, 1000.f);
+				m_precisionMeasured = true;
+			}
+			if (m_precisionMeasured) {
+				ImGui::Text("Max normal error : %.4f deg", m_precision.maxNormalError);
+				ImGui::Text("Max position error : %.5f (%.4f%% of the distance)", m_precision.maxPositionError, m_precision.maxRelativePositionError * 100.f);
+			}
+		}
+
 		ImGui::Checkbox("Turn on SSAO", &m_renderSSAO);
 
 		if (m_renderSSAO && ImGui::CollapsingHeader("SSAO preview")) {
@@ -164,6 +194,12 @@ public:
 		}
 		
 		
+		ImGui::Checkbox("Light volumes", &m_useLightVolumes);
+		if (m_useLightVolumes) {
+			const Renderer::LightVolumes::Statistics &stats = m_lightVolumes.getStatistics();
+			ImGui::Text("Visible lights : %u/%u (culled in %.3fms)", stats.visibleLights, stats.lights, stats.cullingTime * 1e-6);
+		}
+
 		ImGui::Checkbox("Apply Pipeline", &m_renderPipeline);
 		if (m_renderPipeline) m_vfx.onImGuiRender();
 		m_lightEngine.onImguiRender();
@@ -181,6 +217,8 @@ private:
 		if (Renderer::getCurrentRenderingState() != Renderer::RenderingState::DEFERRED) {
 			Renderer::setRenderingState(Renderer::RenderingState::DEFERRED);
 		}
+		MARBLE_PROFILE_SCOPE("Geometry pass");
+		MARBLE_PROFILE_GPU_SCOPE("Geometry pass");
 		m_gBuffer.fbo.bind();
 		renderFn();
 		m_gBuffer.fbo.unbind();
@@ -193,10 +231,12 @@ private:
 
 		// SSAO stuff
 		if (m_renderSSAO) {
+		MARBLE_PROFILE_SCOPE("SSAO");
+		MARBLE_PROFILE_GPU_SCOPE("SSAO");
 
 		Renderer::Texture* ssaoTexture =
 			m_ssaoRenderer.computeSSAOTexture(
-				&m_gBuffer.textures.position,
+				&m_gBuffer.textures.depth,
 				&m_gBuffer.textures.normal,
 				camera
 			);
@@ -214,23 +254,52 @@ private:
 			t->bind(i);
 		}
 
-		// Upload lights
+		// Lights are read from the renderer's light buffer
 		
 		m_deferredPass.getShader().bind();
 		m_deferredPass.getShader().setUniform3f("u_cameraPos", camera.getPosition());
+		m_deferredPass.getShader().setUniformMat4f("u_inverseVP", glm::inverse(camera.getViewProjectionMatrix()));
+		m_deferredPass.getShader().setUniform1i("u_shadePointLights", !m_useLightVolumes);
 		m_deferredPass.getShader().unbind();
-		m_lightEngine.uploadLightsToShader(m_deferredPass.getShader());
 
 		// Deferred pass, blit into target
 		
-		if (!m_renderPipeline) {
+		if (m_useLightVolumes) {
+			{
+				MARBLE_PROFILE_SCOPE("Lighting");
+				MARBLE_PROFILE_GPU_SCOPE("Lighting");
+				m_final.bind();
+				m_deferredPass.doBlit();
+				// light volumes are depth and stencil tested against the g-buffer depth
+				glCopyImageSubData(
+					m_gBuffer.textures.depth.getId(), GL_TEXTURE_2D, 0, 0, 0, 0,
+					m_finalDepth.getId(), GL_TEXTURE_2D, 0, 0, 0, 0,
+					m_finalDepth.getWidth(), m_finalDepth.getHeight(), 1);
+				m_lightVolumes.render(camera, Renderer::getLightBuffer().getLights(), { m_target.getWidth(), m_target.getHeight() });
+				m_final.unbind();
+			}
+
+			if (m_renderPipeline) {
+				applyPostEffects(camera);
+			}
+			else {
+				m_target.bind(0);
+				last.doBlit();
+			}
+		}
+		else if (!m_renderPipeline) {
+			MARBLE_PROFILE_SCOPE("Lighting");
+			MARBLE_PROFILE_GPU_SCOPE("Lighting");
 			m_deferredPass.doBlit();
 		}
 		else {
-
-			m_final.bind();
-			m_deferredPass.doBlit();
-			m_final.unbind();
+			{
+				MARBLE_PROFILE_SCOPE("Lighting");
+				MARBLE_PROFILE_GPU_SCOPE("Lighting");
+				m_final.bind();
+				m_deferredPass.doBlit();
+				m_final.unbind();
+			}
 			applyPostEffects(camera);
 		}
 
@@ -241,6 +310,8 @@ private:
 	// todo : this works, but it can be better !!
 	void applyPostEffects(Renderer::Camera& camera) 
 	{
+		MARBLE_PROFILE_SCOPE("Post effects");
+		MARBLE_PROFILE_GPU_SCOPE("Post effects");
 
 		m_vfx.setContextParam("camera", camera);
 		m_vfx.bind();
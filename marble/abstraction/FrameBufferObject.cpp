@@ -4,6 +4,8 @@
 #include <assert.h>
 
 #include "Window.h"
+#include "GLStateCache.h"
+#include "UnifiedRenderer.h"
 
 namespace Renderer {
 
@@ -34,38 +36,43 @@ FrameBufferObject::FrameBufferObject(FrameBufferObject &&moved) noexcept
 
 void FrameBufferObject::bind() const
 {
-  glBindFramebuffer(GL_FRAMEBUFFER, m_renderID);
+  flushDebugDraw(); // debug lines are drawn in the framebuffer they were submitted in
+  GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, m_renderID);
   FBOStack::getInstance().pushFBO(this);
 }
 
 void FrameBufferObject::bindAsWrite() const
 {
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_renderID);
+	flushDebugDraw();
+	GLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, m_renderID);
 	FBOStack::getInstance().pushFBO(this);
 }
 
 
 void FrameBufferObject::bindAsRead() const
 {
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_renderID);
+	GLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, m_renderID);
 	FBOStack::getInstance().pushFBO(this);
 }
 
 
 void FrameBufferObject::bindCached() const
 {
-  glBindFramebuffer(GL_FRAMEBUFFER, m_renderID);
+  flushDebugDraw();
+  GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, m_renderID);
 }
 
 void FrameBufferObject::unbind()
 {
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  flushDebugDraw();
+  GLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
   FBOStack::getInstance().popFBO();
   
 }
 
 void FrameBufferObject::destroy()
 {
+  GLStateCache::notifyFramebufferDeleted(m_renderID);
   glDeleteFramebuffers(1, &m_renderID);
   m_renderID = 0;
 }
@@ -102,22 +109,22 @@ void FrameBufferObject::assertIsValid() const
 
 void FrameBufferObject::setViewport(unsigned int width, unsigned int height)
 {
-  glViewport(0, 0, width, height);
+  GLStateCache::setViewport(0, 0, width, height);
 }
 
 void FrameBufferObject::setViewportToTexture(const Texture &texture)
 {
-  glViewport(0, 0, texture.getWidth(), texture.getHeight());
+  GLStateCache::setViewport(0, 0, texture.getWidth(), texture.getHeight());
 }
 
 void FrameBufferObject::setViewportToTargetTexture()
 {
-  glViewport(0, 0, m_viewPort.width, m_viewPort.height);
+  GLStateCache::setViewport(0, 0, m_viewPort.width, m_viewPort.height);
 }
 
 void FrameBufferObject::setViewportToWindow()
 {
-  glViewport(0, 0, Window::getWinWidth(), Window::getWinHeight());
+  GLStateCache::setViewport(0, 0, Window::getWinWidth(), Window::getWinHeight());
 }
 
 
@@ -0,0 +1,47 @@
+#include "GBufferEncoding.h"
+
+#include <algorithm>
+
+#include "../Utils/Mathf.h"
+
+namespace Renderer::GBufferEncoding {
+
+Precision measureGBufferPrecision(const Camera &camera, unsigned int sampleCount, float maxDistance)
+{
+  Precision precision{};
+  const float goldenAngle = Mathf::PI * (3.f - std::sqrt(5.f));
+
+  // normals on a fibonacci sphere
+  for (unsigned int i = 0; i < sampleCount; i++) {
+    float z = 1.f - 2.f * (i + .5f) / sampleCount;
+    float r = std::sqrt(1.f - z * z);
+    glm::vec3 normal{ r * std::cos(goldenAngle * i), r * std::sin(goldenAngle * i), z };
+    float cosAngle = glm::clamp(glm::dot(normal, unpackNormal(packNormal(normal))), -1.f, 1.f);
+    precision.maxNormalError = std::max(precision.maxNormalError, glm::degrees(std::acos(cosAngle)));
+  }
+
+  // positions spread on the screen, at exponentially increasing distances
+  const glm::mat4 &VP = camera.getViewProjectionMatrix();
+  glm::mat4 inverseVP = glm::inverse(VP);
+  for (unsigned int i = 0; i < sampleCount; i++) {
+    glm::vec2 uv{ Mathf::fract(i * .7548776662f), Mathf::fract(i * .5698402910f) }; // R2 sequence
+    float distance = std::pow(maxDistance, (i + .5f) / sampleCount);
+    glm::vec3 direction = glm::normalize(reconstructPosition(uv, 1.f, inverseVP) - camera.getPosition());
+    glm::vec3 position = camera.getPosition() + direction * distance;
+
+    uint32_t depth = quantizeDepth(position, VP);
+    if (depth == 0 || depth == 16777215)
+      continue; // clipped by the near or far plan
+    glm::vec4 clip = VP * glm::vec4(position, 1.f);
+    glm::vec2 projectedUV = glm::vec2(clip) / clip.w * .5f + .5f;
+    glm::vec3 reconstructed = reconstructPosition(projectedUV, depth / 16777215.f, inverseVP);
+
+    float error = glm::length(reconstructed - position);
+    precision.maxPositionError = std::max(precision.maxPositionError, error);
+    precision.maxRelativePositionError = std::max(precision.maxRelativePositionError, error / distance);
+  }
+
+  return precision;
+}
+
+}
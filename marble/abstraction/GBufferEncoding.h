@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+namespace Renderer {
+
+/**
+* Cpu reference of the encodings used by the packed g-buffer (see DeferredRenderer.h),
+* the shaders that write and read the g-buffer (gBuffer.fs, deferredPass.fs,
+* deferred_lightvolume.fs and SSAO.fs) implement the same functions in glsl.
+*
+* - normals are stored in a RG16 (unorm) target with an octahedral encoding,
+*   the unit sphere is projected on an octahedron which is unfolded on a square
+* - positions are not stored, they are reconstructed from the depth buffer and
+*   the inverse of the view-projection matrix
+*
+* #measureGBufferPrecision can be used to check the error of both encodings
+* without a gpu, the results are shown by the deferred renderer's debug window
+* and checked against bounds by the headless checks (see Checks.h).
+*/
+namespace GBufferEncoding {
+
+/* Maps a unit vector to [-1,1]^2 */
+inline glm::vec2 encodeOctahedral(glm::vec3 n)
+{
+  n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+  if (n.z < 0) {
+    glm::vec2 signs{ n.x >= 0 ? 1.f : -1.f, n.y >= 0 ? 1.f : -1.f };
+    return (1.f - glm::abs(glm::vec2{ n.y, n.x })) * signs;
+  }
+  return { n.x, n.y };
+}
+
+inline glm::vec3 decodeOctahedral(glm::vec2 e)
+{
+  glm::vec3 n{ e.x, e.y, 1.f - glm::abs(e.x) - glm::abs(e.y) };
+  float t = glm::clamp(-n.z, 0.f, 1.f);
+  n.x += n.x >= 0 ? -t : t;
+  n.y += n.y >= 0 ? -t : t;
+  return glm::normalize(n);
+}
+
+/* The value written in the RG16 target, as stored by the gpu */
+inline glm::u16vec2 packNormal(const glm::vec3 &n)
+{
+  glm::vec2 unorm = glm::clamp(encodeOctahedral(n) * .5f + .5f, 0.f, 1.f);
+  return glm::u16vec2(glm::round(unorm * 65535.f));
+}
+
+inline glm::vec3 unpackNormal(const glm::u16vec2 &packed)
+{
+  return decodeOctahedral(glm::vec2(packed) / 65535.f * 2.f - 1.f);
+}
+
+/* uv in 0..1, depth is the value of the depth buffer in 0..1 */
+inline glm::vec3 reconstructPosition(const glm::vec2 &uv, float depth, const glm::mat4 &inverseVP)
+{
+  glm::vec4 p = inverseVP * glm::vec4(glm::vec3(uv, depth) * 2.f - 1.f, 1.f);
+  return glm::vec3(p) / p.w;
+}
+
+/* The value written in a 24 bits depth buffer for a world position, inverse of #reconstructPosition */
+inline uint32_t quantizeDepth(const glm::vec3 &position, const glm::mat4 &VP)
+{
+  glm::vec4 clip = VP * glm::vec4(position, 1.f);
+  float depth = glm::clamp(clip.z / clip.w * .5f + .5f, 0.f, 1.f);
+  return (uint32_t)std::round(depth * 16777215.f);
+}
+
+struct Precision {
+  float maxNormalError;           // in degrees
+  float maxPositionError;         // in world units
+  float maxRelativePositionError; // position error divided by the distance to the camera
+};
+
+/*
+ * Encodes and decodes sampleCount normals spread on the sphere, and positions
+ * seen by the camera at increasing distances up to maxDistance, positions beyond its
+ * far plan are skipped.
+ */
+Precision measureGBufferPrecision(const Camera &camera, unsigned int sampleCount, float maxDistance);
+
+}
+
+}
@@ -0,0 +1,253 @@
+#include "GLStateCache.h"
+
+#include <array>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+namespace Renderer::GLStateCache {
+
+// GL object names are never this value, it marks an unknown binding
+static constexpr unsigned int UNKNOWN = 0xffffffff;
+static constexpr unsigned int TEXTURE_UNIT_COUNT = 32;
+static constexpr GLenum SHADOWED_CAPABILITIES[] = {
+  GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_MULTISAMPLE, GL_DEPTH_CLAMP, GL_CLIP_DISTANCE0, GL_STENCIL_TEST,
+};
+static constexpr size_t SHADOWED_CAPABILITY_COUNT = std::size(SHADOWED_CAPABILITIES);
+
+enum class TriState : unsigned char { UNKNOWN, DISABLED, ENABLED };
+
+struct State {
+  unsigned int program;
+  unsigned int vao;
+  unsigned int activeUnit;
+  std::array<unsigned int, TEXTURE_UNIT_COUNT> textures;
+  std::array<unsigned int, TEXTURE_UNIT_COUNT> arrayTextures;
+  unsigned int drawFramebuffer;
+  unsigned int readFramebuffer;
+  int viewport[4];
+  std::array<TriState, SHADOWED_CAPABILITY_COUNT> capabilities;
+  TriState depthMask;
+  unsigned int depthFunc;
+  unsigned int blendSource, blendDestination;
+};
+
+static State makeUnknownState()
+{
+  State state;
+  state.program = UNKNOWN;
+  state.vao = UNKNOWN;
+  state.activeUnit = UNKNOWN;
+  state.textures.fill(UNKNOWN);
+  state.arrayTextures.fill(UNKNOWN);
+  state.drawFramebuffer = UNKNOWN;
+  state.readFramebuffer = UNKNOWN;
+  std::fill_n(state.viewport, 4, -1); // no viewport has a negative size
+  state.capabilities.fill(TriState::UNKNOWN);
+  state.depthMask = TriState::UNKNOWN;
+  state.depthFunc = UNKNOWN;
+  state.blendSource = state.blendDestination = UNKNOWN;
+  return state;
+}
+
+static State s_state = makeUnknownState();
+static Statistics s_statistics;
+
+// returns true if the call must be issued
+static inline bool track(bool changed)
+{
+  if (changed)
+    s_statistics.issuedCalls++;
+  else
+    s_statistics.elidedCalls++;
+  return changed;
+}
+
+void invalidate()
+{
+  s_state = makeUnknownState();
+}
+
+void useProgram(unsigned int program)
+{
+  if (track(s_state.program != program)) {
+    getRenderDevice().useProgram(program);
+    s_state.program = program;
+  }
+}
+
+void bindVertexArray(unsigned int vao)
+{
+  if (track(s_state.vao != vao)) {
+    getRenderDevice().bindVertexArray(vao);
+    s_state.vao = vao;
+  }
+}
+
+void activeTexture(unsigned int unit)
+{
+  if (track(s_state.activeUnit != unit)) {
+    getRenderDevice().activeTexture(unit);
+    s_state.activeUnit = unit;
+  }
+}
+
+void bindTexture2D(unsigned int unit, unsigned int texture)
+{
+  if (unit < TEXTURE_UNIT_COUNT && s_state.textures[unit] == texture) {
+    s_statistics.elidedCalls++;
+    return;
+  }
+  activeTexture(unit);
+  bindTexture2D(texture);
+}
+
+void bindTexture2D(unsigned int texture)
+{
+  unsigned int unit = s_state.activeUnit;
+  bool isShadowed = unit < TEXTURE_UNIT_COUNT;
+  if (track(!isShadowed || s_state.textures[unit] != texture)) {
+    getRenderDevice().bindTexture(GL_TEXTURE_2D, texture);
+    if (isShadowed)
+      s_state.textures[unit] = texture;
+  }
+}
+
+void bindTexture2DArray(unsigned int unit, unsigned int texture)
+{
+  if (unit < TEXTURE_UNIT_COUNT && s_state.arrayTextures[unit] == texture) {
+    s_statistics.elidedCalls++;
+    return;
+  }
+  activeTexture(unit);
+  s_statistics.issuedCalls++;
+  getRenderDevice().bindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  if (unit < TEXTURE_UNIT_COUNT)
+    s_state.arrayTextures[unit] = texture;
+}
+
+void bindFramebuffer(unsigned int target, unsigned int framebuffer)
+{
+  bool bindsDraw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+  bool bindsRead = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+  bool changed = (bindsDraw && s_state.drawFramebuffer != framebuffer) || (bindsRead && s_state.readFramebuffer != framebuffer);
+  if (track(changed)) {
+    getRenderDevice().bindFramebuffer(target, framebuffer);
+    if (bindsDraw) s_state.drawFramebuffer = framebuffer;
+    if (bindsRead) s_state.readFramebuffer = framebuffer;
+  }
+}
+
+void setViewport(int x, int y, int width, int height)
+{
+  int *viewport = s_state.viewport;
+  if (track(viewport[0] != x || viewport[1] != y || viewport[2] != width || viewport[3] != height)) {
+    getRenderDevice().setViewport(x, y, width, height);
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+  }
+}
+
+void setCapability(unsigned int cap, bool enabled)
+{
+  TriState wanted = enabled ? TriState::ENABLED : TriState::DISABLED;
+  TriState *shadowed = nullptr;
+  for (size_t i = 0; i < SHADOWED_CAPABILITY_COUNT; i++) {
+    if (SHADOWED_CAPABILITIES[i] == cap)
+      shadowed = &s_state.capabilities[i];
+  }
+  if (track(!shadowed || *shadowed != wanted)) {
+    getRenderDevice().setCapability(cap, enabled);
+    if (shadowed)
+      *shadowed = wanted;
+  }
+}
+
+bool isCapabilityEnabled(unsigned int cap)
+{
+  for (size_t i = 0; i < SHADOWED_CAPABILITY_COUNT; i++) {
+    if (SHADOWED_CAPABILITIES[i] != cap)
+      continue;
+    TriState &shadowed = s_state.capabilities[i];
+    if (shadowed == TriState::UNKNOWN)
+      shadowed = getRenderDevice().isCapabilityEnabled(cap) ? TriState::ENABLED : TriState::DISABLED;
+    return shadowed == TriState::ENABLED;
+  }
+  return getRenderDevice().isCapabilityEnabled(cap);
+}
+
+void setDepthMask(bool enabled)
+{
+  TriState wanted = enabled ? TriState::ENABLED : TriState::DISABLED;
+  if (track(s_state.depthMask != wanted)) {
+    getRenderDevice().setDepthMask(enabled);
+    s_state.depthMask = wanted;
+  }
+}
+
+void setDepthFunc(unsigned int func)
+{
+  if (track(s_state.depthFunc != func)) {
+    getRenderDevice().setDepthFunc(func);
+    s_state.depthFunc = func;
+  }
+}
+
+void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor)
+{
+  if (track(s_state.blendSource != sourceFactor || s_state.blendDestination != destinationFactor)) {
+    getRenderDevice().setBlendFunc(sourceFactor, destinationFactor);
+    s_state.blendSource = sourceFactor;
+    s_state.blendDestination = destinationFactor;
+  }
+}
+
+// GL unbinds deleted objects (programs stay in use until another one is, but their name is not reused until then)
+
+void notifyProgramDeleted(unsigned int program)
+{
+  if (s_state.program == program)
+    s_state.program = UNKNOWN;
+}
+
+void notifyVertexArrayDeleted(unsigned int vao)
+{
+  if (s_state.vao == vao)
+    s_state.vao = 0;
+}
+
+void notifyTextureDeleted(unsigned int texture)
+{
+  for (unsigned int &boundTexture : s_state.textures) {
+    if (boundTexture == texture)
+      boundTexture = 0;
+  }
+  for (unsigned int &boundTexture : s_state.arrayTextures) {
+    if (boundTexture == texture)
+      boundTexture = 0;
+  }
+}
+
+void notifyFramebufferDeleted(unsigned int framebuffer)
+{
+  if (s_state.drawFramebuffer == framebuffer)
+    s_state.drawFramebuffer = 0;
+  if (s_state.readFramebuffer == framebuffer)
+    s_state.readFramebuffer = 0;
+}
+
+const Statistics &getStatistics()
+{
+  return s_statistics;
+}
+
+void resetStatistics()
+{
+  s_statistics = {};
+}
+
+}
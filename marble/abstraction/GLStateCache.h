@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Renderer {
+
+/**
+* Shadow copy of the GL state that the engine changes often. Renderer wrappers
+* (Shader#bind, VertexArray#bind, Texture#bind, FrameBufferObject#bind...) go
+* through these functions instead of calling GL directly, calls that would not
+* change the GL state are dropped, the others are issued to the current
+* RenderDevice.
+*
+* The shadowed state is: the program in use, the bound VAO, the active texture
+* unit and the 2D texture and 2D texture array bound to each unit, the draw and read framebuffers,
+* the viewport, a few capabilities (depth test, blend, cull face...), the depth
+* mask, the depth function and the blend function.
+*
+* Any code that changes this state with raw GL calls must either go through
+* these functions or call #invalidate after. GL objects that are deleted must
+* be reported so that a new object reusing the same name is bound correctly.
+*
+* Counters of issued and elided calls are kept until #resetStatistics.
+*/
+namespace GLStateCache {
+
+struct Statistics {
+  size_t issuedCalls;
+  size_t elidedCalls;
+};
+
+/* Forgets the shadowed state, every next call will be issued */
+void invalidate();
+
+void useProgram(unsigned int program);
+void bindVertexArray(unsigned int vao);
+void activeTexture(unsigned int unit);
+/* Binds a 2D texture to the given unit, the unit becomes the active one */
+void bindTexture2D(unsigned int unit, unsigned int texture);
+/* Binds a 2D texture to the active unit, used when creating textures */
+void bindTexture2D(unsigned int texture);
+/* Binds a 2D texture array to the given unit, the unit becomes the active one */
+void bindTexture2DArray(unsigned int unit, unsigned int texture);
+/* target can be GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER */
+void bindFramebuffer(unsigned int target, unsigned int framebuffer);
+void setViewport(int x, int y, int width, int height);
+/* cap is a GL capability (GL_DEPTH_TEST, GL_BLEND...), capabilities that are not shadowed are always issued */
+void setCapability(unsigned int cap, bool enabled);
+/* Reads the shadowed value when it is known, queries GL otherwise */
+bool isCapabilityEnabled(unsigned int cap);
+void setDepthMask(bool enabled);
+void setDepthFunc(unsigned int func);
+void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor);
+
+void notifyProgramDeleted(unsigned int program);
+void notifyVertexArrayDeleted(unsigned int vao);
+void notifyTextureDeleted(unsigned int texture);
+void notifyFramebufferDeleted(unsigned int framebuffer);
+
+const Statistics &getStatistics();
+void resetStatistics();
+
+}
+
+}
@@ -4,12 +4,16 @@
 
 #include <glad/glad.h>
 
+#include "GLStateCache.h"
+
 namespace Renderer {
 
 IndexBufferObject::IndexBufferObject(const unsigned int* indices, size_t count)
   : m_count(count)
 {
   glGenBuffers(1, &m_renderID);
+  // the element buffer binding is part of the VAO state, renderers leave their last VAO bound
+  GLStateCache::bindVertexArray(0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_renderID);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 }
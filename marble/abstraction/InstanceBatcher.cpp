@@ -0,0 +1,117 @@
+#include "InstanceBatcher.h"
+
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#include "UnifiedRenderer.h"
+#include "../Utils/Profiler.h"
+
+namespace Renderer {
+
+size_t InstanceBatcher::BatchKeyHash::operator()(const BatchKey &key) const
+{
+  std::hash<const void *> hash;
+  return hash(key.model) ^ (hash(key.material) * 31);
+}
+
+void InstanceBatcher::submitMesh(const Mesh &mesh)
+{
+  const std::shared_ptr<Material> &material = mesh.getMaterial();
+  if (!material->shader->readsAttribute(BaseInstance::FIRST_ATTRIBUTE_LOCATION)) {
+    m_unbatchedMeshes.push_back(&mesh);
+    return;
+  }
+
+  auto [it, inserted] = m_batches.try_emplace(BatchKey{ mesh.getModel().get(), material.get() });
+  Batch &batch = it->second;
+  if (inserted)
+    batch.mesh = InstancedMesh(mesh.getModel(), material, 0);
+  batch.instances.push_back(BaseInstance::fromTransform(mesh.getTransform()));
+}
+
+static inline bool isSameInstance(const BaseInstance &a, const BaseInstance &b)
+{
+  return std::memcmp(&a, &b, sizeof(BaseInstance)) == 0;
+}
+
+void InstanceBatcher::uploadChangedInstances(Batch &batch, Statistics &stats)
+{
+  const std::vector<BaseInstance> &instances = batch.instances;
+  std::vector<BaseInstance> &uploaded = batch.uploadedInstances;
+  size_t count = instances.size();
+
+  if (count > batch.mesh.getInstanceCount()) {
+    // the buffer grows geometrically, it is reallocated and filled entirely
+    size_t capacity = std::max(count, batch.mesh.getInstanceCount() * 2);
+    uploaded.assign(instances.begin(), instances.end());
+    uploaded.resize(capacity);
+    batch.mesh.replaceInstances(uploaded.data(), capacity);
+    stats.uploads++;
+    stats.uploadedInstances += (unsigned int)count;
+    return;
+  }
+
+  size_t i = 0;
+  while (i < count) {
+    if (isSameInstance(instances[i], uploaded[i])) {
+      i++;
+      continue;
+    }
+    size_t rangeBegin = i;
+    size_t rangeEnd = i + 1;
+    for (size_t j = rangeEnd; j < count && j - rangeEnd < UPLOAD_MERGE_DISTANCE; j++) {
+      if (!isSameInstance(instances[j], uploaded[j]))
+        rangeEnd = j + 1;
+    }
+    std::copy(instances.begin() + rangeBegin, instances.begin() + rangeEnd, uploaded.begin() + rangeBegin);
+    batch.mesh.updateInstances(instances.data() + rangeBegin, rangeBegin, rangeEnd);
+    stats.uploads++;
+    stats.uploadedInstances += (unsigned int)(rangeEnd - rangeBegin);
+    i = rangeEnd;
+  }
+}
+
+void InstanceBatcher::render(const Camera &camera)
+{
+  MARBLE_PROFILE_SCOPE("Instance batches");
+  Statistics stats{};
+
+  for (auto it = m_batches.begin(); it != m_batches.end(); ) {
+    Batch &batch = it->second;
+    if (batch.instances.empty()) {
+      // the batch is likely to be drawn again soon, its buffer is kept for a while
+      if (++batch.idleRenders > MAX_IDLE_RENDERS)
+        it = m_batches.erase(it);
+      else
+        ++it;
+      continue;
+    }
+
+    batch.idleRenders = 0;
+    uploadChangedInstances(batch, stats);
+    renderMeshInstanced(camera, batch.mesh, batch.instances.size());
+    stats.batches++;
+    stats.drawCalls++;
+    stats.instances += (unsigned int)batch.instances.size();
+    batch.instances.clear();
+    ++it;
+  }
+
+  for (const Mesh *mesh : m_unbatchedMeshes) {
+    renderMesh(camera, *mesh);
+    stats.drawCalls++;
+    stats.instances++;
+  }
+  m_unbatchedMeshes.clear();
+
+  m_lastStatistics = stats;
+}
+
+void InstanceBatcher::clear()
+{
+  m_batches.clear();
+  m_unbatchedMeshes.clear();
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "Mesh.h"
+#include "Camera.h"
+
+namespace Renderer {
+
+/**
+* The instance batcher draws the meshes that share a model and a material with
+* a single instanced draw call. Meshes are submitted each frame and their
+* transforms become the instances of the batch of their (model, material) pair.
+*
+* Batches keep their instance buffer between frames, when a batch is drawn only
+* the ranges of instances that changed since it was last drawn are uploaded.
+* Submitting meshes in the same order each frame keeps these ranges small, a
+* batcher should therefore be used for a single view. Batches that are not
+* drawn for MAX_IDLE_RENDERS renders are released.
+*
+* The material shader must read the BaseInstance attributes (see standard.vs),
+* meshes whose shader does not are drawn one by one with Renderer#renderMesh.
+* These meshes are referenced, they must be kept alive until #render is called.
+*
+* Example usage:
+*   for (const Mesh &mesh : visibleMeshes)
+*     batcher.submitMesh(mesh);
+*   batcher.render(camera); // also clears the submitted meshes
+*/
+class InstanceBatcher {
+public:
+  static constexpr unsigned int MAX_IDLE_RENDERS = 120;
+  // changed instances separated by less unchanged instances than this are uploaded together
+  static constexpr size_t UPLOAD_MERGE_DISTANCE = 16;
+
+  struct Statistics {
+    unsigned int batches;
+    unsigned int drawCalls;
+    unsigned int instances;
+    unsigned int uploads;
+    unsigned int uploadedInstances;
+  };
+
+private:
+  struct BatchKey {
+    const Model    *model;
+    const Material *material;
+    bool operator==(const BatchKey &) const = default;
+  };
+
+  struct BatchKeyHash {
+    size_t operator()(const BatchKey &key) const;
+  };
+
+  struct Batch {
+    InstancedMesh             mesh;              // keeps the model and material alive, its instance count is the batch capacity
+    std::vector<BaseInstance> instances;         // submitted since the last render
+    std::vector<BaseInstance> uploadedInstances; // copy of the instance buffer, of the same size
+    unsigned int              idleRenders = 0;
+  };
+
+  std::unordered_map<BatchKey, Batch, BatchKeyHash> m_batches;
+  std::vector<const Mesh *> m_unbatchedMeshes;
+  Statistics m_lastStatistics{};
+
+public:
+  void submitMesh(const Mesh &mesh);
+  /* Draws the batches that received instances since the last call and clears them */
+  void render(const Camera &camera);
+  /* Releases all batches and their instance buffers */
+  void clear();
+
+  size_t getBatchCount() const { return m_batches.size(); }
+  const Statistics &getLastStatistics() const { return m_lastStatistics; }
+
+private:
+  static void uploadChangedInstances(Batch &batch, Statistics &stats);
+};
+
+}
@@ -0,0 +1,73 @@
+#include "LightBuffer.h"
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "UniformBlocks.h"
+
+namespace Renderer {
+
+LightBuffer::LightBuffer(size_t initialCapacity)
+  : m_buffer(HEADER_SIZE + initialCapacity * sizeof(PackedPointLight))
+{
+  uint32_t header[4]{};
+  m_buffer.updateData(header, sizeof(header));
+}
+
+void LightBuffer::bind() const
+{
+  m_buffer.bindBase(POINT_LIGHTS_STORAGE_BINDING);
+}
+
+void LightBuffer::setLights(std::span<const PackedPointLight> lights)
+{
+  size_t requiredSize = HEADER_SIZE + lights.size() * sizeof(PackedPointLight);
+  bool countChanged = lights.size() != m_lights.size();
+
+  if (requiredSize > m_buffer.getCapacity()) {
+    // the content is lost when the buffer grows, everything is uploaded again
+    std::vector<char> content(requiredSize);
+    uint32_t count = (uint32_t)lights.size();
+    std::memcpy(content.data(), &count, sizeof(count));
+    std::memcpy(content.data() + HEADER_SIZE, lights.data(), lights.size_bytes());
+    m_buffer.setData(content.data(), content.size());
+    m_lights.assign(lights.begin(), lights.end());
+    m_statistics.uploads++;
+    m_statistics.uploadedBytes += requiredSize;
+    m_statistics.reallocations++;
+    return;
+  }
+
+  if (countChanged) {
+    uint32_t count = (uint32_t)lights.size();
+    m_buffer.updateData(&count, sizeof(count));
+    m_statistics.uploads++;
+    m_statistics.uploadedBytes += sizeof(count);
+  }
+
+  // lights that were not in the buffer are always dirty
+  size_t comparedCount = std::min(lights.size(), m_lights.size());
+  size_t dirtyBegin = lights.size(), dirtyEnd = 0;
+  for (size_t i = 0; i < comparedCount; i++) {
+    if (std::memcmp(&lights[i], &m_lights[i], sizeof(PackedPointLight)) != 0) {
+      dirtyBegin = std::min(dirtyBegin, i);
+      dirtyEnd = i + 1;
+    }
+  }
+  if (lights.size() > comparedCount) {
+    dirtyBegin = std::min(dirtyBegin, comparedCount);
+    dirtyEnd = lights.size();
+  }
+
+  m_lights.assign(lights.begin(), lights.end());
+  if (dirtyBegin >= dirtyEnd)
+    return;
+
+  size_t dirtySize = (dirtyEnd - dirtyBegin) * sizeof(PackedPointLight);
+  m_buffer.updateData(&lights[dirtyBegin], dirtySize, HEADER_SIZE + dirtyBegin * sizeof(PackedPointLight));
+  m_statistics.uploads++;
+  m_statistics.uploadedBytes += dirtySize;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "ShaderStorageBufferObject.h"
+
+namespace Renderer {
+
+/**
+* Point light as stored in the light buffer, std430 layout.
+*
+* GLSL declaration (the binding is POINT_LIGHTS_STORAGE_BINDING, see UniformBlocks.h):
+*   struct PointLight {
+*     vec4 positionRange; // xyz position, w range
+*     vec4 ambient;
+*     vec4 diffuse;
+*     vec4 specular;
+*     vec4 attenuation;   // constant, linear, quadratic, on (0 or 1)
+*   };
+*   layout(std430, binding = 4) readonly buffer PointLights {
+*     uint       u_pointLightCount;
+*     PointLight u_pointLights[];
+*   };
+*/
+struct PackedPointLight {
+  glm::vec4 positionRange;
+  glm::vec4 ambient;
+  glm::vec4 diffuse;
+  glm::vec4 specular;
+  glm::vec4 attenuation;
+
+  bool isOn() const { return attenuation.w != 0; }
+};
+
+static_assert(sizeof(PackedPointLight) == 5 * 16);
+
+/**
+* The point lights of the scene, kept in a single storage buffer that is bound
+* once and read by every shader that does lighting (forward, clustered and
+* deferred).
+*
+* The buffer starts with the light count (padded to 16 bytes) followed by the
+* lights. Setting the lights compares them with the previous ones and only the
+* range that changed is uploaded, moving one light out of a thousand uploads a
+* single light. Lights that are off stay in the buffer so that toggling a light
+* does not shift the others.
+*
+* Example usage:
+*   lights.bind(); // once
+*   lights.setLights(packedLights); // whenever the lights change
+*/
+class LightBuffer {
+public:
+  struct Statistics {
+    unsigned int uploads;         // since the creation of the buffer
+    size_t       uploadedBytes;
+    unsigned int reallocations;
+  };
+
+private:
+  static constexpr size_t HEADER_SIZE = 16;
+
+  std::vector<PackedPointLight> m_lights; // last uploaded content
+  ShaderStorageBufferObject     m_buffer;
+  Statistics                    m_statistics{};
+
+public:
+  LightBuffer() = default; // does not create the buffer on the gpu
+  explicit LightBuffer(size_t initialCapacity);
+
+  void setLights(std::span<const PackedPointLight> lights);
+
+  void bind() const;
+
+  std::span<const PackedPointLight> getLights() const { return m_lights; }
+  const Statistics &getStatistics() const { return m_statistics; }
+};
+
+}
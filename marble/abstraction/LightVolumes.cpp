@@ -0,0 +1,113 @@
+#include "LightVolumes.h"
+
+#include <chrono>
+#include <numeric>
+
+#include <glad/glad.h>
+
+#include "UnifiedRenderer.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+#include "RenderDevice.h"
+#include "../Utils/Mathf.h"
+
+namespace Renderer {
+
+LightVolumes::LightVolumes()
+  : m_sphere(createSphereModel(SPHERE_RESOLUTION)),
+    m_stencilShader(loadShaderFromFiles("res/shaders/deferred_lightvolume.vs", "res/shaders/depth_pass.fs")),
+    m_lightingShader(loadShaderFromFiles("res/shaders/deferred_lightvolume.vs", "res/shaders/deferred_lightvolume.fs")),
+    m_visibleLightsBuffer(sizeof(uint32_t) * 64)
+{
+  m_sphereVAO.addBuffer(m_sphere->getVBO(), BaseVertex::getVertexBufferLayout(), m_sphere->getIBO());
+  VertexArray::unbind();
+
+  // the sphere model is inscribed in the unit sphere, the center of its faces is the
+  // closest point to the origin, at cos(half sector angle)*cos(half stack angle)
+  m_volumeScale = 1.f / (std::cos(Mathf::PI / SPHERE_RESOLUTION) * std::cos(Mathf::PI / (2 * SPHERE_RESOLUTION)));
+
+  int samplers[16];
+  std::iota(samplers, samplers + 16, 0);
+  m_lightingShader->bind();
+  m_lightingShader->setUniform1iv("u_gBufferTextures", 16, samplers);
+  m_lightingShader->setUniform1f("u_volumeScale", m_volumeScale);
+  m_stencilShader->bind();
+  m_stencilShader->setUniform1f("u_volumeScale", m_volumeScale);
+  Shader::unbind();
+}
+
+void LightVolumes::cullLights(const Camera &camera, std::span<const PackedPointLight> lights)
+{
+  auto begin = std::chrono::high_resolution_clock::now();
+
+  Frustum frustum = Frustum::createFrustumFromCamera(camera);
+  m_visibleLights.clear();
+  m_statistics.lights = 0;
+  for (uint32_t i = 0; i < (uint32_t)lights.size(); i++) {
+    const PackedPointLight &light = lights[i];
+    if (!light.isOn())
+      continue;
+    m_statistics.lights++;
+    if (frustum.isOnFrustum(glm::vec3(light.positionRange), light.positionRange.w * m_volumeScale))
+      m_visibleLights.push_back(i);
+  }
+  m_statistics.visibleLights = (unsigned int)m_visibleLights.size();
+
+  m_statistics.cullingTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+void LightVolumes::render(const Camera &camera, std::span<const PackedPointLight> lights, const glm::vec2 &screenSize)
+{
+  cullLights(camera, lights);
+  if (m_visibleLights.empty())
+    return;
+
+  m_visibleLightsBuffer.setData(m_visibleLights.data(), m_visibleLights.size() * sizeof(uint32_t));
+  m_visibleLightsBuffer.bindBase(VISIBLE_LIGHTS_STORAGE_BINDING);
+
+  RenderDevice &device = getRenderDevice();
+  int indexCount = (int)m_sphere->getIBO().getCount();
+  int instanceCount = (int)m_visibleLights.size();
+  m_sphereVAO.bind();
+
+  // stencil pass, z-fail counting of the faces behind the surface
+  // the device has no stencil state, stencil functions and masks are set directly
+  GLStateCache::setCapability(GL_STENCIL_TEST, true);
+  glStencilMask(0xff);
+  device.clear(GL_STENCIL_BUFFER_BIT);
+  device.setColorMask(false);
+  GLStateCache::setDepthMask(false);
+  GLStateCache::setCapability(GL_DEPTH_TEST, true);
+  GLStateCache::setDepthFunc(GL_LESS);
+  GLStateCache::setCapability(GL_CULL_FACE, false);
+  glStencilFunc(GL_ALWAYS, 0, 0);
+  glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+  glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+  m_stencilShader->bind();
+  device.drawElementsInstanced(GL_TRIANGLES, indexCount, instanceCount);
+
+  // lighting pass, back faces are drawn so that volumes containing the camera are not clipped
+  device.setColorMask(true);
+  GLStateCache::setCapability(GL_DEPTH_TEST, false);
+  GLStateCache::setCapability(GL_CULL_FACE, true);
+  glCullFace(GL_FRONT);
+  GLStateCache::setCapability(GL_BLEND, true);
+  GLStateCache::setBlendFunc(GL_ONE, GL_ONE);
+  glStencilFunc(GL_NOTEQUAL, 0, 0xff);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  m_lightingShader->bind();
+  m_lightingShader->setUniform2f("u_screenSize"_uniform, screenSize);
+  m_lightingShader->setUniformMat4f("u_inverseVP"_uniform, glm::inverse(camera.getViewProjectionMatrix()));
+  device.drawElementsInstanced(GL_TRIANGLES, indexCount, instanceCount);
+
+  // restore the default state (see Window#createWindow)
+  glCullFace(GL_BACK);
+  GLStateCache::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GLStateCache::setCapability(GL_DEPTH_TEST, true);
+  GLStateCache::setDepthMask(true);
+  GLStateCache::setCapability(GL_STENCIL_TEST, false);
+  Shader::unbind();
+  VertexArray::unbind();
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstdint>
+
+#include "Camera.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "VertexArray.h"
+#include "LightBuffer.h"
+#include "ShaderStorageBufferObject.h"
+
+namespace Renderer {
+
+/**
+* Light-volume shading of point lights for the deferred renderer, each light
+* only shades the pixels its sphere of influence covers instead of every light
+* being evaluated for every pixel.
+*
+* Lights of the light buffer are first culled against the camera frustum on the
+* cpu, the indices of the visible ones are uploaded to a storage buffer read by
+* instance. Their spheres are then drawn twice, instanced:
+*   - a stencil pass, without color, counts the faces that are behind the
+*     g-buffer depth (back faces increment, front faces decrement), pixels whose
+*     surface is inside of a volume end up with a non zero stencil value, this
+*     also works when the camera is inside of a volume;
+*   - a lighting pass draws the back faces with additive blending where the
+*     stencil is not zero, the fragment shader also discards the pixels that are
+*     out of the range of its own light.
+*
+* The bound framebuffer must have a depth-stencil attachment that contains the
+* depth of the g-buffer, the g-buffer textures must be bound to their slots (see
+* DeferredRenderer).
+*
+* Example usage:
+*   volumes.render(camera, Renderer::getLightBuffer().getLights(), screenSize);
+*/
+class LightVolumes {
+public:
+  static constexpr int SPHERE_RESOLUTION = 12;
+
+  struct Statistics {
+    unsigned int lights;        // lights that are on
+    unsigned int visibleLights; // drawn lights
+    long long    cullingTime;   // in nanoseconds
+  };
+
+private:
+  std::shared_ptr<Model>    m_sphere;
+  VertexArray               m_sphereVAO;
+  std::shared_ptr<Shader>   m_stencilShader;
+  std::shared_ptr<Shader>   m_lightingShader;
+  ShaderStorageBufferObject m_visibleLightsBuffer;
+  std::vector<uint32_t>     m_visibleLights;
+  float                     m_volumeScale;
+  Statistics                m_statistics{};
+
+public:
+  LightVolumes();
+  LightVolumes(const LightVolumes &) = delete;
+  LightVolumes &operator=(const LightVolumes &) = delete;
+
+  /* Adds the contribution of the visible lights to the color of the bound framebuffer */
+  void render(const Camera &camera, std::span<const PackedPointLight> lights, const glm::vec2 &screenSize);
+
+  const Statistics &getStatistics() const { return m_statistics; }
+
+private:
+  void cullLights(const Camera &camera, std::span<const PackedPointLight> lights);
+};
+
+}
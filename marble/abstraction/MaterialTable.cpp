@@ -0,0 +1,51 @@
+#include "MaterialTable.h"
+
+#include <stdexcept>
+
+#include "UniformBlocks.h"
+
+namespace Renderer {
+
+MaterialTable::MaterialTable(unsigned int textureSize)
+  : m_textureSize(textureSize), m_buffer(INITIAL_CAPACITY * sizeof(PackedMaterial))
+{
+}
+
+unsigned int MaterialTable::addMaterial(const TextureHandle &texture, const glm::vec4 &tint)
+{
+  if (m_textureArray == nullptr)
+    m_textureArray = texture.array;
+  if (texture.array != m_textureArray || texture.array->getSize() != m_textureSize)
+    throw std::runtime_error("The textures of a material table must be in the same texture array");
+
+  PackedMaterial &material = m_materials.emplace_back();
+  material.tint = tint;
+  material.layer = texture.layer;
+
+  // the whole table is uploaded again when the buffer grows, otherwise only the new material
+  size_t index = m_materials.size() - 1;
+  if ((index + 1) * sizeof(PackedMaterial) > m_buffer.getCapacity())
+    m_buffer.setData(m_materials.data(), m_materials.size() * sizeof(PackedMaterial));
+  else
+    m_buffer.updateData(&material, sizeof(PackedMaterial), index * sizeof(PackedMaterial));
+  return (unsigned int)index;
+}
+
+void MaterialTable::setTint(unsigned int material, const glm::vec4 &tint)
+{
+  m_materials[material].tint = tint;
+  m_buffer.updateData(&m_materials[material], sizeof(PackedMaterial), material * sizeof(PackedMaterial));
+}
+
+void MaterialTable::bind() const
+{
+  m_buffer.bindBase(MATERIALS_STORAGE_BINDING);
+}
+
+void MaterialTable::assignMaterial(std::vector<BaseVertex> &vertices, unsigned int material)
+{
+  for (BaseVertex &vertex : vertices)
+    vertex.texId = (float)material;
+}
+
+}
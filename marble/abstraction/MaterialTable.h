@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "ShaderStorageBufferObject.h"
+#include "TextureArrayManager.h"
+#include "Mesh.h"
+
+namespace Renderer {
+
+/**
+* Material as stored in the material table, std430 layout.
+*
+* GLSL declaration (the binding is MATERIALS_STORAGE_BINDING, see UniformBlocks.h):
+*   struct PackedMaterial {
+*     vec4 tint;  // multiplies the texture color
+*     uint layer; // in u_TextureArray
+*   };
+*   layout(std430, binding = 8) readonly buffer Materials {
+*     PackedMaterial u_materials[];
+*   };
+*/
+struct PackedMaterial {
+  glm::vec4 tint{ 1.f };
+  uint32_t  layer = 0;
+  uint32_t  padding[3]{};
+};
+
+static_assert(sizeof(PackedMaterial) == 2 * 16);
+
+/**
+* The materials of a set of meshes that share a single Material, kept in a
+* storage buffer and indexed by the texId vertex attribute. Meshes with
+* different textures and tints can then be drawn with the same shader, texture
+* array and storage buffer, without any binding in between (and be sorted and
+* batched together by the render queue).
+*
+* Every texture of a table is in the same TextureArray, textures are loaded by
+* a TextureArrayManager at the layer size of the table. The shared material must
+* reference the table and its array, its shader samples them with the
+* "color_materials.fs" mesh part.
+*
+* Example usage:
+*   auto table = std::make_shared<MaterialTable>(512);
+*   unsigned int rock = table->addMaterial(textures.loadTexture("res/textures/rock.jpg", table->getTextureSize()));
+*   MaterialTable::assignMaterial(rockVertices, rock);
+*   sharedMaterial->materialTable = table;
+*   sharedMaterial->textureArray = table->getTextureArray();
+*/
+class MaterialTable {
+public:
+  static constexpr size_t INITIAL_CAPACITY = 16; // in materials
+
+private:
+  unsigned int                  m_textureSize;
+  std::shared_ptr<TextureArray> m_textureArray; // set by the first material
+  std::vector<PackedMaterial>   m_materials;
+  ShaderStorageBufferObject     m_buffer;
+
+public:
+  /* Creates the storage buffer, textures must be textureSize*textureSize layers (see TextureArrayManager#loadTexture) */
+  explicit MaterialTable(unsigned int textureSize);
+
+  /* Returns the index of the new material, throws std::runtime_error if the texture is not in the table's array */
+  unsigned int addMaterial(const TextureHandle &texture, const glm::vec4 &tint = glm::vec4{ 1.f });
+  void setTint(unsigned int material, const glm::vec4 &tint);
+
+  void bind() const;
+
+  unsigned int getTextureSize() const { return m_textureSize; }
+  const std::shared_ptr<TextureArray> &getTextureArray() const { return m_textureArray; }
+  size_t getMaterialCount() const { return m_materials.size(); }
+  unsigned int getId() const { return m_buffer.getId(); } // unsafe
+
+  /* Sets the texId attribute of the vertices to the index of the material */
+  static void assignMaterial(std::vector<BaseVertex> &vertices, unsigned int material);
+};
+
+}
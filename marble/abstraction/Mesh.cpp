@@ -6,6 +6,7 @@
 
 #include <glad/glad.h>
 
+#include "RenderDevice.h"
 #include "../Utils/BoundingSphere.h"
 #include "../Utils/Mathf.h"
 
@@ -47,6 +48,7 @@ Mesh::Mesh(const std::shared_ptr<Model> &model, const std::shared_ptr<Material>
   : m_model(model), m_material(material), m_transform(), m_VAO()
 {
   m_VAO.addBuffer(model->getVBO(), BaseVertex::getVertexBufferLayout(), model->getIBO());
+  addIdentityInstance(m_VAO);
   m_VAO.unbind();
 }
 
@@ -140,6 +142,7 @@ NormalsMesh::NormalsMesh(const std::vector<BaseVertex> &vertices)
   m_VBO = VertexBufferObject(newVertices.data(), sizeof(BaseVertex) * newVertices.size());
   m_IBO = IndexBufferObject(newIndices.data(), newIndices.size());
   m_VAO.addBuffer(m_VBO, BaseVertex::getVertexBufferLayout(), m_IBO);
+  addIdentityInstance(m_VAO);
   m_verticesCount = (unsigned int)newVertices.size();
   VertexArray::unbind();
 }
@@ -167,7 +170,7 @@ NormalsMesh &NormalsMesh::operator=(NormalsMesh &&moved) noexcept
 void NormalsMesh::draw() const
 {
   m_VAO.bind();
-  glDrawElements(GL_LINES, m_verticesCount, GL_UNSIGNED_INT, nullptr);
+  getRenderDevice().drawElements(GL_LINES, m_verticesCount);
   VertexArray::unbind();
 }
 
@@ -7,12 +7,16 @@
 
 #include "VertexArray.h"
 #include "Texture.h"
+#include "TextureArray.h"
 #include "Shader.h"
+#include "CullingSystem.h"
 #include "../Utils/AABB.h"
 #include "../Utils/Transform.h"
 
 namespace Renderer {
 
+class MaterialTable;
+
 struct BaseVertex {
   glm::vec3 position{ 0,0,0 };
   glm::vec2 uv{ 0,0 };
@@ -35,10 +39,14 @@ struct BaseVertex {
   }
 };
 
+/*
+ * Per instance data of instanced meshes, applied in the same order as a mesh Transform.
+ * Instance attributes follow the BaseVertex ones, shaders read them at locations 5 to 7.
+ */
 struct BaseInstance {
   glm::vec3 position{0,0,0};
   glm::vec3 scale{1};
-  // TODO add rotation to BaseInstance
+  glm::quat rotation{1,0,0,0}; // glm stores quaternions as xyzw, shaders read a vec4 in the same order
 
   static const VertexBufferLayout &getVertexBufferLayout()
   {
@@ -46,12 +54,27 @@ struct BaseInstance {
       VertexBufferLayout l;
       l.push<float>(3); // position
       l.push<float>(3); // scale
+      l.push<float>(4); // rotation
       return l;
     }();
     return layout;
   }
+
+  static constexpr unsigned int FIRST_ATTRIBUTE_LOCATION = 5; // after the BaseVertex attributes
+
+  static BaseInstance fromTransform(const Transform &transform) { return { transform.position, transform.scale, transform.rotation }; }
 };
 
+static_assert(sizeof(BaseInstance) == 10 * sizeof(float), "BaseInstance is uploaded as is to instance buffers");
+
+/*
+* Gives a VAO that has no instance buffer a single identity instance, so that
+* shaders reading the instance attributes (standard.vs) draw its vertices as is.
+* The instance buffer is owned by the renderer, it is created by the first call
+* (a gl context must exist) and destroyed by Renderer#shutdown.
+*/
+void addIdentityInstance(VertexArray &vao);
+
 /**
 * A mesh contains references to a VAO and its components, textures and a bounding box.
 * 
@@ -87,9 +110,12 @@ public:
 struct Material
 {
   static constexpr unsigned int TEXTURE_SLOT_COUNT = 8;
+  static constexpr unsigned int TEXTURE_ARRAY_SLOT = TEXTURE_SLOT_COUNT; // shaders sample it as u_TextureArray
 
   std::shared_ptr<Shader> shader;
   std::array<std::shared_ptr<Texture>, TEXTURE_SLOT_COUNT> textures;
+  std::shared_ptr<TextureArray> textureArray; // optional, see TextureArrayManager
+  std::shared_ptr<MaterialTable> materialTable; // optional, bound to MATERIALS_STORAGE_BINDING, see MaterialTable
 };
 
 class Mesh {
@@ -167,6 +193,7 @@ concept Heightmap = requires(const T heightmap, float x, float y)
 class TerrainMesh {
 public:
   static constexpr int CHUNK_SIZE = 50;
+  static constexpr int CHUNK_VERTEX_COUNT = (CHUNK_SIZE + 1) * (CHUNK_SIZE + 1);
   struct Chunk {
     VertexArray        vao;
     VertexBufferObject vbo;
@@ -179,6 +206,7 @@ private:
   std::shared_ptr<Material> m_material;
   Transform                 m_transform;
   IndexBufferObject         m_ibo; // a single ibo is enough for all chunks
+  CullingSystem             m_chunksCulling; // chunks bounding boxes, in the same order as m_chunks
 
 public:
   TerrainMesh() : TerrainMesh(nullptr) {}
@@ -198,10 +226,23 @@ public:
    * margin, samples outside are used to compute terrain normals.
    * 
    * If called multiple times, this method assumes that the heightmap
-   * did not change, otherwise call clearMesh() before.
+   * did not change, otherwise call clearMesh() before or notifyHeightsChanged()
+   * with the modified region.
    */
   template<Heightmap Heightmap>
   void rebuildMesh(const Heightmap &heightmap, TerrainRegion region);
+  /*
+   * Updates the existing chunks after the heightmap changed inside of the
+   * given region (erosion step, crater, editor brush...).
+   *
+   * Only the vertices covered by the region are regenerated, plus the ones
+   * one unit around it because their normals depend on their neighbours,
+   * even if they belong to another chunk. Modified vertices are uploaded to
+   * the GPU row by row and the bounding boxes of the affected chunks are
+   * recomputed. Chunks that do not exist are not created.
+   */
+  template<Heightmap Heightmap>
+  void notifyHeightsChanged(const Heightmap &heightmap, TerrainRegion dirty);
   /*
    * Returns whether the chunk at the given position exists (ie. it
    * was built by rebuildMesh and not cleared since).
@@ -214,20 +255,31 @@ public:
    * 
    * TODO make clearMesh take a TerrainRegion parameter
    */
-  void clearMesh() { m_chunks.clear(); }
+  void clearMesh() { m_chunks.clear(); m_chunksCulling.clear(); }
 
   Transform &getTransform() { return m_transform; }
   const Transform &getTransform() const { return m_transform; }
   void setTransform(const Transform &transform) { m_transform = transform; }
   const std::vector<Chunk> &getChunks() const { return m_chunks; }
   const IndexBufferObject &getIBO() const { return m_ibo; }
+  const CullingSystem &getChunksCulling() const { return m_chunksCulling; }
   const std::shared_ptr<Material> &getMaterial() const { return m_material; }
   std::shared_ptr<Material> &getMaterial() { return m_material; }
   void setMaterial(const std::shared_ptr<Material> &material) { assert(material != nullptr); m_material = material; }
 
+  /*
+   * Fills the CHUNK_VERTEX_COUNT vertices of a chunk, this is the cpu part of
+   * #rebuildMesh, the chunk's vbo is created from these vertices.
+   */
+  template<Heightmap Heightmap>
+  static void generateChunkVertices(const Heightmap &heightmap, glm::ivec2 chunkPosition, BaseVertex *vertices);
+
 private:
   template<Heightmap Heightmap>
   Chunk generateChunk(const Heightmap &heightmap, glm::ivec2 chunkPosition);
+  void rebuildChunksCulling();
+  template<Heightmap Heightmap>
+  static BaseVertex generateVertex(const Heightmap &heightmap, glm::ivec2 chunkPosition, int x, int y);
 };
 
 class NormalsMesh {
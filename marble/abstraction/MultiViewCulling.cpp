@@ -0,0 +1,27 @@
+#include "MultiViewCulling.h"
+
+#include <stdexcept>
+
+namespace Renderer {
+
+MultiViewCulling::ViewIndex MultiViewCulling::addView(const Camera &camera)
+{
+  if (m_frustums.size() >= MAX_VIEWS)
+    throw std::runtime_error("Too many culling views");
+  m_frustums.push_back(Frustum::createFrustumFromCamera(camera));
+  return (ViewIndex)(m_frustums.size() - 1);
+}
+
+void MultiViewCulling::cull(const CullingSystem &boxes, std::vector<CullingSystem::VisibilityBitset> &visibilities) const
+{
+  visibilities.resize(m_frustums.size());
+  boxes.cullViews(m_frustums, visibilities);
+}
+
+void MultiViewCulling::cull(const BoundingVolumeHierarchy &hierarchy, std::vector<CullingSystem::VisibilityBitset> &visibilities) const
+{
+  visibilities.resize(m_frustums.size());
+  hierarchy.cullViews(m_frustums, visibilities);
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "Camera.h"
+#include "CullingSystem.h"
+#include "BoundingVolumeHierarchy.h"
+
+namespace Renderer {
+
+/**
+* Holds the frustums of every camera that will render the scene during a
+* frame (main camera, water reflection, sun...) so that objects can be
+* culled once for all of them.
+*
+* Each frame the views are registered before anything is rendered, then
+* culling structures (terrain chunks, props...) are tested against all
+* views at once and produce one visibility bitset per view. Renderers read
+* the bitset of the view they are drawing instead of building a frustum
+* and testing every object again.
+*
+* Example usage:
+*   views.clearViews();
+*   ViewIndex mainView = views.addView(camera);
+*   ViewIndex sunView = views.addView(sunCamera);
+*   views.cull(terrain.getChunksCulling(), chunksVisibility);
+*   renderMeshTerrain(sunCamera, terrain, chunksVisibility[sunView]);
+*   renderMeshTerrain(camera, terrain, chunksVisibility[mainView]);
+*/
+class MultiViewCulling {
+public:
+  typedef unsigned int ViewIndex;
+  static constexpr size_t MAX_VIEWS = CullingSystem::MAX_VIEWS;
+
+private:
+  std::vector<Frustum> m_frustums;
+
+public:
+  void clearViews() { m_frustums.clear(); }
+  /* Registers a view and returns its index in the visibility lists */
+  ViewIndex addView(const Camera &camera);
+
+  size_t getViewCount() const { return m_frustums.size(); }
+  const Frustum &getViewFrustum(ViewIndex view) const { return m_frustums[view]; }
+
+  /* Fills one bitset per view, the list is resized to #getViewCount */
+  void cull(const CullingSystem &boxes, std::vector<CullingSystem::VisibilityBitset> &visibilities) const;
+  void cull(const BoundingVolumeHierarchy &hierarchy, std::vector<CullingSystem::VisibilityBitset> &visibilities) const;
+};
+
+}
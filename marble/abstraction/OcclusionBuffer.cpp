@@ -0,0 +1,232 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../Utils/Profiler.h"
+#include "../Utils/WorkerPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MARBLE_OCCLUSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Renderer {
+
+// vertices closer than that to the camera plan are considered to be behind it
+static constexpr float MIN_CLIP_W = 1e-3f;
+static constexpr float INFINITE_DEPTH = std::numeric_limits<float>::infinity();
+
+static unsigned int roundUpToBlock(unsigned int x)
+{
+  return (x + OcclusionBuffer::BLOCK_SIZE - 1) / OcclusionBuffer::BLOCK_SIZE * OcclusionBuffer::BLOCK_SIZE;
+}
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height, unsigned int threadCount)
+  : m_width(roundUpToBlock(width)),
+    m_height(roundUpToBlock(height)),
+    m_threadCount(threadCount ? threadCount : WorkerPool::getShared().getThreadCount()),
+    m_viewProjection(1.f),
+    m_depth((size_t)m_width * m_height, INFINITE_DEPTH),
+    m_blocksMaxDepth((size_t)(m_width / BLOCK_SIZE) * (m_height / BLOCK_SIZE), INFINITE_DEPTH)
+{
+}
+
+void OcclusionBuffer::clear(const Camera &camera)
+{
+  m_viewProjection = camera.getViewProjectionMatrix();
+  m_triangles.clear();
+  m_statistics = {};
+  std::fill(m_depth.begin(), m_depth.end(), INFINITE_DEPTH);
+  std::fill(m_blocksMaxDepth.begin(), m_blocksMaxDepth.end(), INFINITE_DEPTH);
+}
+
+void OcclusionBuffer::addOccluder(const Occluder &occluder)
+{
+  std::vector<glm::vec4> clipVertices;
+  clipVertices.reserve(occluder.vertices.size());
+  for (const glm::vec3 &v : occluder.vertices)
+    clipVertices.push_back(m_viewProjection * glm::vec4(v, 1.f));
+
+  glm::vec2 screenSize{ m_width, m_height };
+  for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+    m_statistics.occluderTriangles++;
+    const glm::vec4 &ca = clipVertices[occluder.indices[i + 0]];
+    const glm::vec4 &cb = clipVertices[occluder.indices[i + 1]];
+    const glm::vec4 &cc = clipVertices[occluder.indices[i + 2]];
+    // no clipping, triangles crossing the camera plan are simply not used as occluders
+    if (ca.w < MIN_CLIP_W || cb.w < MIN_CLIP_W || cc.w < MIN_CLIP_W)
+      continue;
+
+    ScreenTriangle triangle;
+    triangle.a = (glm::vec2(ca) / ca.w * .5f + .5f) * screenSize;
+    triangle.b = (glm::vec2(cb) / cb.w * .5f + .5f) * screenSize;
+    triangle.c = (glm::vec2(cc) / cc.w * .5f + .5f) * screenSize;
+    triangle.depth = glm::max(ca.z / ca.w, glm::max(cb.z / cb.w, cc.z / cc.w));
+
+    glm::vec2 ab = triangle.b - triangle.a, ac = triangle.c - triangle.a;
+    float area = ab.x * ac.y - ab.y * ac.x;
+    if (area == 0)
+      continue;
+    if (area < 0)
+      std::swap(triangle.b, triangle.c); // both faces are occluders
+
+    // pixel i has its center at i+.5, only pixels with their center inside the triangle's bounding box can be covered
+    glm::vec2 min = glm::min(triangle.a, glm::min(triangle.b, triangle.c));
+    glm::vec2 max = glm::max(triangle.a, glm::max(triangle.b, triangle.c));
+    triangle.minX = std::max(0, (int)glm::ceil(min.x - .5f));
+    triangle.minY = std::max(0, (int)glm::ceil(min.y - .5f));
+    triangle.maxX = std::min((int)m_width - 1, (int)glm::floor(max.x - .5f));
+    triangle.maxY = std::min((int)m_height - 1, (int)glm::floor(max.y - .5f));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+      continue;
+
+    m_triangles.push_back(triangle);
+    m_statistics.rasterizedTriangles++;
+  }
+}
+
+void OcclusionBuffer::rasterize()
+{
+  MARBLE_PROFILE_SCOPE("Occlusion rasterization");
+  // split the screen in bands of whole blocks, so that each thread can compute its blocks max depth
+  unsigned int blockRows = m_height / BLOCK_SIZE;
+  unsigned int bandCount = std::min(m_threadCount, blockRows);
+  WorkerPool &pool = WorkerPool::getShared();
+  WorkerPool::JobGroup bands;
+  for (unsigned int band = 1; band < bandCount; band++) {
+    unsigned int firstRow = blockRows * band / bandCount * BLOCK_SIZE;
+    unsigned int lastRow = blockRows * (band + 1) / bandCount * BLOCK_SIZE;
+    pool.run(bands, [this, firstRow, lastRow] { rasterizeBand(firstRow, lastRow); });
+  }
+  rasterizeBand(0, blockRows / bandCount * BLOCK_SIZE);
+  pool.wait(bands);
+}
+
+void OcclusionBuffer::rasterizeBand(unsigned int firstRow, unsigned int lastRow)
+{
+  MARBLE_PROFILE_SCOPE("Occlusion band");
+  for (const ScreenTriangle &triangle : m_triangles) {
+    int minY = std::max(triangle.minY, (int)firstRow);
+    int maxY = std::min(triangle.maxY, (int)lastRow - 1);
+    if (minY > maxY)
+      continue;
+
+    // edge functions E(p) = A*p.x + B*p.y + C, positive inside of the triangle,
+    // pixels on shared edges are written twice, which is harmless
+    float A[3], B[3], C[3];
+    const glm::vec2 *vertices[3] = { &triangle.a, &triangle.b, &triangle.c };
+    for (int e = 0; e < 3; e++) {
+      const glm::vec2 &from = *vertices[e], &to = *vertices[(e + 1) % 3];
+      A[e] = from.y - to.y;
+      B[e] = to.x - from.x;
+      C[e] = -A[e] * from.x - B[e] * from.y;
+    }
+
+    // rows are processed 4 pixels at a time, the buffer width is a multiple of 4
+    int minX = triangle.minX & ~3;
+    int maxX = triangle.maxX;
+    for (int y = minY; y <= maxY; y++) {
+      float *row = &m_depth[(size_t)y * m_width];
+      float py = (float)y + .5f;
+#if defined(MARBLE_OCCLUSION_SSE)
+      const __m128 depth = _mm_set1_ps(triangle.depth);
+      const __m128 laneOffsets = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+      const __m128 zero = _mm_setzero_ps();
+      __m128 rowEdges[3], stepEdges[3];
+      for (int e = 0; e < 3; e++) {
+        rowEdges[e] = _mm_add_ps(
+          _mm_mul_ps(_mm_set1_ps(A[e]), _mm_add_ps(_mm_set1_ps((float)minX), laneOffsets)),
+          _mm_set1_ps(B[e] * py + C[e]));
+        stepEdges[e] = _mm_set1_ps(A[e] * 4.f);
+      }
+      for (int x = minX; x <= maxX; x += 4) {
+        __m128 covered = _mm_and_ps(_mm_and_ps(
+          _mm_cmpge_ps(rowEdges[0], zero),
+          _mm_cmpge_ps(rowEdges[1], zero)),
+          _mm_cmpge_ps(rowEdges[2], zero));
+        if (_mm_movemask_ps(covered)) {
+          __m128 current = _mm_loadu_ps(row + x);
+          __m128 written = _mm_min_ps(current, depth);
+          _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, written), _mm_andnot_ps(covered, current)));
+        }
+        for (int e = 0; e < 3; e++)
+          rowEdges[e] = _mm_add_ps(rowEdges[e], stepEdges[e]);
+      }
+#else
+      for (int x = minX; x <= maxX; x++) {
+        float px = (float)x + .5f;
+        bool covered = true;
+        for (int e = 0; e < 3; e++)
+          covered &= A[e] * px + B[e] * py + C[e] >= 0;
+        if (covered)
+          row[x] = std::min(row[x], triangle.depth);
+      }
+#endif
+    }
+  }
+
+  // update the max depth of the blocks of the band
+  unsigned int blocksPerRow = m_width / BLOCK_SIZE;
+  for (unsigned int blockY = firstRow / BLOCK_SIZE; blockY < lastRow / BLOCK_SIZE; blockY++) {
+    for (unsigned int blockX = 0; blockX < blocksPerRow; blockX++) {
+      float maxDepth = -INFINITE_DEPTH;
+      for (unsigned int y = blockY * BLOCK_SIZE; y < (blockY + 1) * BLOCK_SIZE; y++)
+        for (unsigned int x = blockX * BLOCK_SIZE; x < (blockX + 1) * BLOCK_SIZE; x++)
+          maxDepth = std::max(maxDepth, m_depth[(size_t)y * m_width + x]);
+      m_blocksMaxDepth[blockY * blocksPerRow + blockX] = maxDepth;
+    }
+  }
+}
+
+bool OcclusionBuffer::isVisible(const AABB &box) const
+{
+  m_statistics.testedBoxes++;
+
+  glm::vec2 min{ std::numeric_limits<float>::max() };
+  glm::vec2 max{ std::numeric_limits<float>::lowest() };
+  float nearestDepth = std::numeric_limits<float>::max();
+  for (glm::vec3 corner : box) {
+    glm::vec4 clip = m_viewProjection * glm::vec4(corner, 1.f);
+    if (clip.w < MIN_CLIP_W)
+      return true; // the box crosses the camera plan
+    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    min = glm::min(min, glm::vec2(ndc));
+    max = glm::max(max, glm::vec2(ndc));
+    nearestDepth = std::min(nearestDepth, ndc.z);
+  }
+
+  glm::vec2 screenSize{ m_width, m_height };
+  min = (min * .5f + .5f) * screenSize;
+  max = (max * .5f + .5f) * screenSize;
+  // pixels touched by the box's screen rectangle, plus one pixel around
+  int minX = std::max(0, (int)glm::floor(min.x) - 1);
+  int minY = std::max(0, (int)glm::floor(min.y) - 1);
+  int maxX = std::min((int)m_width - 1, (int)glm::ceil(max.x));
+  int maxY = std::min((int)m_height - 1, (int)glm::ceil(max.y));
+  if (minX > maxX || minY > maxY)
+    return true; // off screen, that's the frustum culling's job
+
+  // first check whole blocks, most occluded boxes are rejected here
+  unsigned int blocksPerRow = m_width / BLOCK_SIZE;
+  bool mayBeVisible = false;
+  for (int blockY = minY / (int)BLOCK_SIZE; blockY <= maxY / (int)BLOCK_SIZE && !mayBeVisible; blockY++)
+    for (int blockX = minX / (int)BLOCK_SIZE; blockX <= maxX / (int)BLOCK_SIZE && !mayBeVisible; blockX++)
+      mayBeVisible = m_blocksMaxDepth[blockY * blocksPerRow + blockX] >= nearestDepth;
+  if (!mayBeVisible) {
+    m_statistics.occludedBoxes++;
+    return false;
+  }
+
+  for (int y = minY; y <= maxY; y++) {
+    const float *row = &m_depth[(size_t)y * m_width];
+    for (int x = minX; x <= maxX; x++) {
+      if (row[x] >= nearestDepth)
+        return true;
+    }
+  }
+  m_statistics.occludedBoxes++;
+  return false;
+}
+
+}
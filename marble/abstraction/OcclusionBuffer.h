@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "Mesh.h"
+#include "../Utils/AABB.h"
+
+namespace Renderer {
+
+/**
+* The occlusion buffer is a small depth buffer rasterized on the CPU, it is
+* used to discard objects that are inside of the view frustum but hidden
+* behind large occluders (typically terrain ridges) before they are sent to
+* the GPU.
+*
+* The buffer is conservative in depth: an object that is in front of an
+* occluder is never reported as occluded. To ensure that,
+* - triangles are written with the depth of their farthest vertex
+* - occluder triangles crossing the camera plan are skipped
+* - boxes are tested with the depth of their nearest corner over their
+*   screen rectangle, grown by one pixel so that pixels on the occluders'
+*   silhouettes (whose center is covered but not their whole area) cannot
+*   hide a box alone
+* It is not conservative in coverage: like the GPU, a pixel is covered when
+* its center is, so gaps between occluders narrower than about a pixel of the
+* buffer are closed and the objects seen only through them are culled. Gaps
+* of two pixels or more always keep the boxes behind them visible (see the
+* "occlusion" check). Covering only the pixels whose whole area is inside of a
+* triangle would fix that, but it would also open seams along every edge of
+* an occluder mesh and little would be culled.
+* Occluders should be coarse meshes that are fully inside of the objects
+* they represent, #makeTerrainOccluder builds such a mesh for terrains.
+*
+* Triangles are rasterized 4 pixels at a time with SSE when available and
+* the screen is split in horizontal bands rasterized by the threads of the
+* shared WorkerPool.
+* Nothing here touches OpenGL, the buffer can be used without a window.
+*
+* Example usage (each frame):
+*   occlusionBuffer.clear(camera);
+*   occlusionBuffer.addOccluder(terrainOccluder);
+*   occlusionBuffer.rasterize();
+*   if (occlusionBuffer.isVisible(box)) ...
+*/
+class OcclusionBuffer {
+public:
+  struct Occluder {
+    std::vector<glm::vec3>    vertices;
+    std::vector<unsigned int> indices;
+  };
+
+  struct Statistics {
+    unsigned int occluderTriangles;   // triangles given to #addOccluder
+    unsigned int rasterizedTriangles; // triangles that were not skipped
+    unsigned int testedBoxes;
+    unsigned int occludedBoxes;
+  };
+
+  static constexpr unsigned int BLOCK_SIZE = 8; // size of the areas used to quickly reject boxes, in pixels
+
+private:
+  struct ScreenTriangle {
+    glm::vec2 a, b, c;   // in pixels, counter-clockwise
+    float     depth;     // farthest depth
+    int       minX, minY, maxX, maxY; // pixels that may be covered, inclusive
+  };
+
+  unsigned int m_width, m_height;
+  unsigned int m_threadCount;
+  glm::mat4    m_viewProjection;
+
+  std::vector<float> m_depth;          // NDC depth, cleared to +inf
+  std::vector<float> m_blocksMaxDepth; // max depth of each BLOCK_SIZE*BLOCK_SIZE area
+  std::vector<ScreenTriangle> m_triangles;
+  mutable Statistics m_statistics{};
+
+public:
+  /*
+   * The width and height are rounded up to multiples of BLOCK_SIZE, a thread
+   * count of 0 uses every thread of the shared WorkerPool.
+   */
+  OcclusionBuffer(unsigned int width = 256, unsigned int height = 144, unsigned int threadCount = 0);
+
+  /* Starts a new frame, all previous occluders are discarded */
+  void clear(const Camera &camera);
+  /* Queues the triangles of an occluder, it is not rasterized until #rasterize is called */
+  void addOccluder(const Occluder &occluder);
+  /* Rasterizes all queued occluders, must be called before testing boxes */
+  void rasterize();
+
+  /* Returns false iff the box is fully hidden by the occluders */
+  bool isVisible(const AABB &box) const;
+
+  unsigned int getWidth() const { return m_width; }
+  unsigned int getHeight() const { return m_height; }
+  const std::vector<float> &getDepthBuffer() const { return m_depth; }
+  const Statistics &getStatistics() const { return m_statistics; }
+
+  /*
+   * Builds a coarse occluder from a heightmap, with one vertex every 'step'
+   * world units in the given region.
+   *
+   * Each vertex takes the lowest height of the integer samples within 'step'
+   * units of it, so the occluder is always below the real terrain (assuming
+   * it is lerped between integer samples, like TerrainMesh does). Seen from
+   * above the terrain it can only hide objects that the terrain hides too.
+   */
+  template<Heightmap Heightmap>
+  static Occluder makeTerrainOccluder(const Heightmap &heightmap, TerrainRegion region, int step);
+
+private:
+  void rasterizeBand(unsigned int firstRow, unsigned int lastRow);
+};
+
+template<Heightmap Heightmap>
+OcclusionBuffer::Occluder OcclusionBuffer::makeTerrainOccluder(const Heightmap &heightmap, TerrainRegion region, int step)
+{
+  assert(step > 0);
+  int minX = (int)glm::ceil(region.minX), minY = (int)glm::ceil(region.minY);
+  int maxX = (int)glm::floor(region.maxX), maxY = (int)glm::floor(region.maxY);
+  int countX = (maxX - minX) / step + 1;
+  int countY = (maxY - minY) / step + 1;
+
+  Occluder occluder;
+  occluder.vertices.reserve((size_t)countX * countY);
+  for (int j = 0; j < countY; j++) {
+    for (int i = 0; i < countX; i++) {
+      int x = minX + i * step, y = minY + j * step;
+      float height = std::numeric_limits<float>::max();
+      for (int sy = glm::max(y - step, minY); sy <= glm::min(y + step, maxY); sy++)
+        for (int sx = glm::max(x - step, minX); sx <= glm::min(x + step, maxX); sx++)
+          height = glm::min(height, (float)heightmap((float)sx, (float)sy));
+      occluder.vertices.push_back({ x, height, y });
+    }
+  }
+
+  occluder.indices.reserve((size_t)(countX - 1) * (countY - 1) * 6);
+  for (int j = 0; j < countY - 1; j++) {
+    for (int i = 0; i < countX - 1; i++) {
+      unsigned int v = j * countX + i;
+      occluder.indices.insert(occluder.indices.end(), { v, v + countX, v + 1, v + 1, v + countX, v + countX + 1 });
+    }
+  }
+  return occluder;
+}
+
+}
@@ -0,0 +1,264 @@
+#include "RecordingRenderDevice.h"
+
+#include <cstring>
+#include <numeric>
+
+namespace Renderer {
+
+static size_t getUniformTypeSize(RenderDevice::UniformType type)
+{
+  switch (type) {
+  case RenderDevice::UniformType::INT:    return sizeof(int32_t);
+  case RenderDevice::UniformType::UINT:   return sizeof(uint32_t);
+  case RenderDevice::UniformType::FLOAT:  return sizeof(float);
+  case RenderDevice::UniformType::VEC2:   return sizeof(float) * 2;
+  case RenderDevice::UniformType::VEC3:   return sizeof(float) * 3;
+  case RenderDevice::UniformType::VEC4:   return sizeof(float) * 4;
+  case RenderDevice::UniformType::MAT2:   return sizeof(float) * 4;
+  case RenderDevice::UniformType::MAT4:   return sizeof(float) * 16;
+  case RenderDevice::UniformType::MAT4X3: return sizeof(float) * 12;
+  default:                                return 0;
+  }
+}
+
+void RecordingRenderDevice::reset()
+{
+  m_stream.clear();
+  m_callCounts.fill(0);
+  m_commandCount = 0;
+  m_vertexCount = 0;
+}
+
+size_t RecordingRenderDevice::getWorkCallCount() const
+{
+  return getDrawCallCount() + getCallCount(Call::DISPATCH_COMPUTE);
+}
+
+size_t RecordingRenderDevice::getDrawCallCount() const
+{
+  return getCallCount(Call::DRAW_ARRAYS) + getCallCount(Call::DRAW_ELEMENTS) + getCallCount(Call::DRAW_ELEMENTS_INSTANCED)
+    + getCallCount(Call::DRAW_ELEMENTS_INDIRECT);
+}
+
+const char *RecordingRenderDevice::getCallName(Call call)
+{
+  static constexpr const char *names[CALL_COUNT] = {
+    "useProgram", "bindVertexArray", "activeTexture", "bindTexture", "bindFramebuffer",
+    "bindBufferBase", "bindBufferRange", "setViewport", "setCapability", "isCapabilityEnabled",
+    "setDepthMask", "setDepthFunc", "setBlendFunc", "setColorMask", "setUniform",
+    "bufferSubData", "copyBufferSubData", "clear", "drawArrays", "drawElements",
+    "drawElementsInstanced", "drawElementsIndirect", "dispatchCompute",
+  };
+  return (size_t)call < CALL_COUNT ? names[(size_t)call] : "?";
+}
+
+void RecordingRenderDevice::beginCommand(Call call, uint32_t argWords)
+{
+  m_callCounts[(size_t)call]++;
+  m_commandCount++;
+  push((uint32_t)call | (argWords << 8));
+}
+
+void RecordingRenderDevice::useProgram(unsigned int program)
+{
+  beginCommand(Call::USE_PROGRAM, 1);
+  push(program);
+  if (m_next) m_next->useProgram(program);
+}
+
+void RecordingRenderDevice::bindVertexArray(unsigned int vao)
+{
+  beginCommand(Call::BIND_VERTEX_ARRAY, 1);
+  push(vao);
+  if (m_next) m_next->bindVertexArray(vao);
+}
+
+void RecordingRenderDevice::activeTexture(unsigned int unit)
+{
+  beginCommand(Call::ACTIVE_TEXTURE, 1);
+  push(unit);
+  if (m_next) m_next->activeTexture(unit);
+}
+
+void RecordingRenderDevice::bindTexture(unsigned int target, unsigned int texture)
+{
+  beginCommand(Call::BIND_TEXTURE, 2);
+  push(target);
+  push(texture);
+  if (m_next) m_next->bindTexture(target, texture);
+}
+
+void RecordingRenderDevice::bindFramebuffer(unsigned int target, unsigned int framebuffer)
+{
+  beginCommand(Call::BIND_FRAMEBUFFER, 2);
+  push(target);
+  push(framebuffer);
+  if (m_next) m_next->bindFramebuffer(target, framebuffer);
+}
+
+void RecordingRenderDevice::bindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer)
+{
+  beginCommand(Call::BIND_BUFFER_BASE, 3);
+  push(target);
+  push(binding);
+  push(buffer);
+  if (m_next) m_next->bindBufferBase(target, binding, buffer);
+}
+
+void RecordingRenderDevice::bindBufferRange(unsigned int target, unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+  beginCommand(Call::BIND_BUFFER_RANGE, 7);
+  push(target);
+  push(binding);
+  push(buffer);
+  push64(offset);
+  push64(size);
+  if (m_next) m_next->bindBufferRange(target, binding, buffer, offset, size);
+}
+
+void RecordingRenderDevice::setViewport(int x, int y, int width, int height)
+{
+  beginCommand(Call::SET_VIEWPORT, 4);
+  push((uint32_t)x);
+  push((uint32_t)y);
+  push((uint32_t)width);
+  push((uint32_t)height);
+  if (m_next) m_next->setViewport(x, y, width, height);
+}
+
+void RecordingRenderDevice::setCapability(unsigned int cap, bool enabled)
+{
+  beginCommand(Call::SET_CAPABILITY, 2);
+  push(cap);
+  push(enabled);
+  if (m_next) m_next->setCapability(cap, enabled);
+}
+
+bool RecordingRenderDevice::isCapabilityEnabled(unsigned int cap)
+{
+  // queries are counted but not part of the stream
+  m_callCounts[(size_t)Call::IS_CAPABILITY_ENABLED]++;
+  return m_next ? m_next->isCapabilityEnabled(cap) : false;
+}
+
+void RecordingRenderDevice::setDepthMask(bool enabled)
+{
+  beginCommand(Call::SET_DEPTH_MASK, 1);
+  push(enabled);
+  if (m_next) m_next->setDepthMask(enabled);
+}
+
+void RecordingRenderDevice::setDepthFunc(unsigned int func)
+{
+  beginCommand(Call::SET_DEPTH_FUNC, 1);
+  push(func);
+  if (m_next) m_next->setDepthFunc(func);
+}
+
+void RecordingRenderDevice::setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor)
+{
+  beginCommand(Call::SET_BLEND_FUNC, 2);
+  push(sourceFactor);
+  push(destinationFactor);
+  if (m_next) m_next->setBlendFunc(sourceFactor, destinationFactor);
+}
+
+void RecordingRenderDevice::setColorMask(bool enabled)
+{
+  beginCommand(Call::SET_COLOR_MASK, 1);
+  push(enabled);
+  if (m_next) m_next->setColorMask(enabled);
+}
+
+void RecordingRenderDevice::setUniform(int location, UniformType type, unsigned int count, const void *data)
+{
+  size_t dataSize = getUniformTypeSize(type) * count; // always a multiple of 4
+  uint32_t dataWords = (uint32_t)(dataSize / sizeof(uint32_t));
+  beginCommand(Call::SET_UNIFORM, 3 + dataWords);
+  push((uint32_t)location);
+  push((uint32_t)type);
+  push(count);
+  if (m_streamEnabled) {
+    size_t dataStart = m_stream.size();
+    m_stream.resize(dataStart + dataWords);
+    std::memcpy(m_stream.data() + dataStart, data, dataSize);
+  }
+  if (m_next) m_next->setUniform(location, type, count, data);
+}
+
+void RecordingRenderDevice::bufferSubData(unsigned int buffer, size_t offset, size_t size, const void *data)
+{
+  beginCommand(Call::BUFFER_SUB_DATA, 5);
+  push(buffer);
+  push64(offset);
+  push64(size);
+  if (m_next) m_next->bufferSubData(buffer, offset, size, data);
+}
+
+void RecordingRenderDevice::copyBufferSubData(unsigned int srcBuffer, unsigned int dstBuffer, size_t srcOffset, size_t dstOffset, size_t size)
+{
+  beginCommand(Call::COPY_BUFFER_SUB_DATA, 8);
+  push(srcBuffer);
+  push(dstBuffer);
+  push64(srcOffset);
+  push64(dstOffset);
+  push64(size);
+  if (m_next) m_next->copyBufferSubData(srcBuffer, dstBuffer, srcOffset, dstOffset, size);
+}
+
+void RecordingRenderDevice::clear(unsigned int mask)
+{
+  beginCommand(Call::CLEAR, 1);
+  push(mask);
+  if (m_next) m_next->clear(mask);
+}
+
+void RecordingRenderDevice::drawArrays(unsigned int mode, int first, int count)
+{
+  beginCommand(Call::DRAW_ARRAYS, 3);
+  m_vertexCount += count;
+  push(mode);
+  push((uint32_t)first);
+  push((uint32_t)count);
+  if (m_next) m_next->drawArrays(mode, first, count);
+}
+
+void RecordingRenderDevice::drawElements(unsigned int mode, int count, int baseVertex)
+{
+  beginCommand(Call::DRAW_ELEMENTS, 3);
+  m_vertexCount += count;
+  push(mode);
+  push((uint32_t)count);
+  push((uint32_t)baseVertex);
+  if (m_next) m_next->drawElements(mode, count, baseVertex);
+}
+
+void RecordingRenderDevice::drawElementsInstanced(unsigned int mode, int count, int instanceCount)
+{
+  beginCommand(Call::DRAW_ELEMENTS_INSTANCED, 3);
+  m_vertexCount += (size_t)count * instanceCount;
+  push(mode);
+  push((uint32_t)count);
+  push((uint32_t)instanceCount);
+  if (m_next) m_next->drawElementsInstanced(mode, count, instanceCount);
+}
+
+void RecordingRenderDevice::drawElementsIndirect(unsigned int mode, unsigned int indirectBuffer, size_t offset)
+{
+  beginCommand(Call::DRAW_ELEMENTS_INDIRECT, 4);
+  push(mode);
+  push(indirectBuffer);
+  push64(offset);
+  if (m_next) m_next->drawElementsIndirect(mode, indirectBuffer, offset);
+}
+
+void RecordingRenderDevice::dispatchCompute(unsigned int x, unsigned int y, unsigned int z)
+{
+  beginCommand(Call::DISPATCH_COMPUTE, 3);
+  push(x);
+  push(y);
+  push(z);
+  if (m_next) m_next->dispatchCompute(x, y, z);
+}
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "RenderDevice.h"
+
+namespace Renderer {
+
+/**
+* Device that records the calls it receives in a compact stream and counts
+* them, then forwards them to another device (or to none, like the null device).
+*
+* Each command is a header word, the call in the low byte and the number of
+* argument words above it, followed by its arguments. Sizes and offsets take two
+* words, uniform values are copied in the stream, buffer contents are not (only
+* their offset and size are). The stream can be disabled to only keep the
+* counters, for example to count the draw calls of every frame of a benchmark.
+*
+* Example usage:
+*   Renderer::RecordingRenderDevice recorder; // or recorder(&Renderer::getRenderDevice()) to still draw
+*   Renderer::setRenderDevice(&recorder);
+*   scene.onRender();
+*   Renderer::setRenderDevice(nullptr);
+*   size_t draws = recorder.getCallCount(Renderer::RecordingRenderDevice::Call::DRAW_ELEMENTS);
+*   recorder.forEachCommand([](auto call, auto args) { ... });
+*/
+class RecordingRenderDevice : public RenderDevice {
+public:
+  enum class Call : unsigned char {
+    USE_PROGRAM, BIND_VERTEX_ARRAY, ACTIVE_TEXTURE, BIND_TEXTURE, BIND_FRAMEBUFFER,
+    BIND_BUFFER_BASE, BIND_BUFFER_RANGE, SET_VIEWPORT, SET_CAPABILITY, IS_CAPABILITY_ENABLED,
+    SET_DEPTH_MASK, SET_DEPTH_FUNC, SET_BLEND_FUNC, SET_COLOR_MASK, SET_UNIFORM,
+    BUFFER_SUB_DATA, COPY_BUFFER_SUB_DATA, CLEAR, DRAW_ARRAYS, DRAW_ELEMENTS,
+    DRAW_ELEMENTS_INSTANCED, DRAW_ELEMENTS_INDIRECT, DISPATCH_COMPUTE,
+    _COUNT
+  };
+  static constexpr size_t CALL_COUNT = (size_t)Call::_COUNT;
+
+private:
+  RenderDevice                     *m_next;
+  std::vector<uint32_t>             m_stream;
+  std::array<size_t, CALL_COUNT>    m_callCounts{};
+  size_t                            m_commandCount = 0;
+  size_t                            m_vertexCount = 0;
+  bool                              m_streamEnabled = true;
+
+public:
+  /* next may be null, in which case the calls are only recorded */
+  explicit RecordingRenderDevice(RenderDevice *next = nullptr) : m_next(next) {}
+
+  /* Empties the stream and resets the counters */
+  void reset();
+  /* While disabled calls are counted but not written to the stream */
+  void setStreamEnabled(bool enabled) { m_streamEnabled = enabled; }
+
+  const std::vector<uint32_t> &getStream() const { return m_stream; }
+  size_t getCommandCount() const { return m_commandCount; }
+  size_t getCallCount(Call call) const { return m_callCounts[(size_t)call]; }
+  /* Sum of the draw and dispatch calls */
+  size_t getWorkCallCount() const;
+  /* Sum of the draw calls, direct and indirect */
+  size_t getDrawCallCount() const;
+  /* Vertices submitted by direct draws, indirect draws are not counted (their counts live on the gpu) */
+  size_t getVertexCount() const { return m_vertexCount; }
+  static const char *getCallName(Call call);
+
+  /* fn is called with (Call, std::span<const uint32_t> arguments) for each recorded command */
+  template<class F>
+  void forEachCommand(F &&fn) const
+  {
+    for (size_t i = 0; i < m_stream.size(); ) {
+      uint32_t header = m_stream[i];
+      uint32_t argCount = header >> 8;
+      fn((Call)(header & 0xff), std::span<const uint32_t>(m_stream.data() + i + 1, argCount));
+      i += 1 + argCount;
+    }
+  }
+
+  void useProgram(unsigned int program) override;
+  void bindVertexArray(unsigned int vao) override;
+  void activeTexture(unsigned int unit) override;
+  void bindTexture(unsigned int target, unsigned int texture) override;
+  void bindFramebuffer(unsigned int target, unsigned int framebuffer) override;
+  void bindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer) override;
+  void bindBufferRange(unsigned int target, unsigned int binding, unsigned int buffer, size_t offset, size_t size) override;
+  void setViewport(int x, int y, int width, int height) override;
+  void setCapability(unsigned int cap, bool enabled) override;
+  bool isCapabilityEnabled(unsigned int cap) override;
+  void setDepthMask(bool enabled) override;
+  void setDepthFunc(unsigned int func) override;
+  void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor) override;
+  void setColorMask(bool enabled) override;
+  void setUniform(int location, UniformType type, unsigned int count, const void *data) override;
+  void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void *data) override;
+  void copyBufferSubData(unsigned int srcBuffer, unsigned int dstBuffer, size_t srcOffset, size_t dstOffset, size_t size) override;
+  void clear(unsigned int mask) override;
+  void drawArrays(unsigned int mode, int first, int count) override;
+  void drawElements(unsigned int mode, int count, int baseVertex = 0) override;
+  void drawElementsInstanced(unsigned int mode, int count, int instanceCount) override;
+  void drawElementsIndirect(unsigned int mode, unsigned int indirectBuffer, size_t offset) override;
+  void dispatchCompute(unsigned int x, unsigned int y, unsigned int z) override;
+
+private:
+  /* Writes the header of a command, its argWords arguments must be pushed right after */
+  void beginCommand(Call call, uint32_t argWords);
+  void push(uint32_t word) { if (m_streamEnabled) m_stream.push_back(word); }
+  void push64(uint64_t value) { push((uint32_t)value); push((uint32_t)(value >> 32)); }
+};
+
+}
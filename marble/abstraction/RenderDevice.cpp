@@ -0,0 +1,156 @@
+#include "RenderDevice.h"
+
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+
+namespace Renderer {
+
+static GLRenderDevice s_glDevice;
+static RenderDevice *s_currentDevice = &s_glDevice;
+
+RenderDevice &getRenderDevice()
+{
+  return *s_currentDevice;
+}
+
+void setRenderDevice(RenderDevice *device)
+{
+  s_currentDevice = device ? device : &s_glDevice;
+  GLStateCache::invalidate();
+}
+
+void GLRenderDevice::useProgram(unsigned int program)
+{
+  glUseProgram(program);
+}
+
+void GLRenderDevice::bindVertexArray(unsigned int vao)
+{
+  glBindVertexArray(vao);
+}
+
+void GLRenderDevice::activeTexture(unsigned int unit)
+{
+  glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLRenderDevice::bindTexture(unsigned int target, unsigned int texture)
+{
+  glBindTexture(target, texture);
+}
+
+void GLRenderDevice::bindFramebuffer(unsigned int target, unsigned int framebuffer)
+{
+  glBindFramebuffer(target, framebuffer);
+}
+
+void GLRenderDevice::bindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer)
+{
+  glBindBufferBase(target, binding, buffer);
+}
+
+void GLRenderDevice::bindBufferRange(unsigned int target, unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+  glBindBufferRange(target, binding, buffer, (GLintptr)offset, (GLsizeiptr)size);
+}
+
+void GLRenderDevice::setViewport(int x, int y, int width, int height)
+{
+  glViewport(x, y, width, height);
+}
+
+void GLRenderDevice::setCapability(unsigned int cap, bool enabled)
+{
+  if (enabled)
+    glEnable(cap);
+  else
+    glDisable(cap);
+}
+
+bool GLRenderDevice::isCapabilityEnabled(unsigned int cap)
+{
+  return glIsEnabled(cap) == GL_TRUE;
+}
+
+void GLRenderDevice::setDepthMask(bool enabled)
+{
+  glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLRenderDevice::setDepthFunc(unsigned int func)
+{
+  glDepthFunc(func);
+}
+
+void GLRenderDevice::setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor)
+{
+  glBlendFunc(sourceFactor, destinationFactor);
+}
+
+void GLRenderDevice::setColorMask(bool enabled)
+{
+  GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+  glColorMask(mask, mask, mask, mask);
+}
+
+void GLRenderDevice::setUniform(int location, UniformType type, unsigned int count, const void *data)
+{
+  switch (type) {
+  case UniformType::INT:    glUniform1iv(location, count, (const GLint *)data);                    break;
+  case UniformType::UINT:   glUniform1uiv(location, count, (const GLuint *)data);                  break;
+  case UniformType::FLOAT:  glUniform1fv(location, count, (const GLfloat *)data);                  break;
+  case UniformType::VEC2:   glUniform2fv(location, count, (const GLfloat *)data);                  break;
+  case UniformType::VEC3:   glUniform3fv(location, count, (const GLfloat *)data);                  break;
+  case UniformType::VEC4:   glUniform4fv(location, count, (const GLfloat *)data);                  break;
+  case UniformType::MAT2:   glUniformMatrix2fv(location, count, GL_FALSE, (const GLfloat *)data);   break;
+  case UniformType::MAT4:   glUniformMatrix4fv(location, count, GL_FALSE, (const GLfloat *)data);   break;
+  case UniformType::MAT4X3: glUniformMatrix4x3fv(location, count, GL_FALSE, (const GLfloat *)data); break;
+  }
+}
+
+void GLRenderDevice::bufferSubData(unsigned int buffer, size_t offset, size_t size, const void *data)
+{
+  glNamedBufferSubData(buffer, (GLintptr)offset, (GLsizeiptr)size, data);
+}
+
+void GLRenderDevice::copyBufferSubData(unsigned int srcBuffer, unsigned int dstBuffer, size_t srcOffset, size_t dstOffset, size_t size)
+{
+  glCopyNamedBufferSubData(srcBuffer, dstBuffer, (GLintptr)srcOffset, (GLintptr)dstOffset, (GLsizeiptr)size);
+}
+
+void GLRenderDevice::clear(unsigned int mask)
+{
+  glClear(mask);
+}
+
+void GLRenderDevice::drawArrays(unsigned int mode, int first, int count)
+{
+  glDrawArrays(mode, first, count);
+}
+
+void GLRenderDevice::drawElements(unsigned int mode, int count, int baseVertex)
+{
+  if (baseVertex == 0)
+    glDrawElements(mode, count, GL_UNSIGNED_INT, nullptr);
+  else
+    glDrawElementsBaseVertex(mode, count, GL_UNSIGNED_INT, nullptr, baseVertex);
+}
+
+void GLRenderDevice::drawElementsInstanced(unsigned int mode, int count, int instanceCount)
+{
+  glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, nullptr, instanceCount);
+}
+
+void GLRenderDevice::drawElementsIndirect(unsigned int mode, unsigned int indirectBuffer, size_t offset)
+{
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+  glDrawElementsIndirect(mode, GL_UNSIGNED_INT, (const void *)offset);
+}
+
+void GLRenderDevice::dispatchCompute(unsigned int x, unsigned int y, unsigned int z)
+{
+  glDispatchCompute(x, y, z);
+}
+
+}
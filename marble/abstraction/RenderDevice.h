@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Renderer {
+
+/**
+* The calls the renderer issues every frame to submit work to the gpu: state
+* changes, bindings, uniforms, buffer updates, dispatches and draws. The
+* GLStateCache, shaders, buffers and the Renderer:: draw functions go through
+* the current device instead of calling GL directly.
+*
+* Three devices exist:
+*  - the GL device, used by default, forwards every call to GL;
+*  - the null device accepts and discards every call, queries return defaults;
+*  - the recording device (see RecordingRenderDevice.h) keeps a compact stream of
+*    the calls and per-call counts, and can forward them to another device.
+*
+* With the null device the cpu side of the renderer (culling, sorting, uniform
+* setup, state tracking) can be measured without the driver's cost or the gpu's.
+* Resources (shaders, textures, meshes) are still created with GL, so a context
+* must exist when they are loaded, a headless one is enough (see
+* Window#createHeadlessWindow). Creation and destruction of resources are not part
+* of the device.
+*
+* Values are the GL enums, the devices do not translate them.
+*
+* Example usage:
+*   Renderer::NullRenderDevice nullDevice;
+*   Renderer::setRenderDevice(&nullDevice);
+*   Renderer::renderMeshTerrain(camera, terrain); // nothing reaches GL
+*   Renderer::setRenderDevice(nullptr);           // back to the GL device
+*/
+class RenderDevice {
+public:
+  enum class UniformType : unsigned char {
+    INT, UINT, FLOAT, VEC2, VEC3, VEC4, MAT2, MAT4, MAT4X3,
+  };
+
+  virtual ~RenderDevice() = default;
+
+  // state
+  virtual void useProgram(unsigned int program) = 0;
+  virtual void bindVertexArray(unsigned int vao) = 0;
+  virtual void activeTexture(unsigned int unit) = 0;
+  virtual void bindTexture(unsigned int target, unsigned int texture) = 0;
+  virtual void bindFramebuffer(unsigned int target, unsigned int framebuffer) = 0;
+  virtual void bindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer) = 0;
+  virtual void bindBufferRange(unsigned int target, unsigned int binding, unsigned int buffer, size_t offset, size_t size) = 0;
+  virtual void setViewport(int x, int y, int width, int height) = 0;
+  virtual void setCapability(unsigned int cap, bool enabled) = 0;
+  virtual bool isCapabilityEnabled(unsigned int cap) = 0;
+  virtual void setDepthMask(bool enabled) = 0;
+  virtual void setDepthFunc(unsigned int func) = 0;
+  virtual void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor) = 0;
+  virtual void setColorMask(bool enabled) = 0;
+
+  /* Sets count values of the uniform at location of the program in use, data is tightly packed */
+  virtual void setUniform(int location, UniformType type, unsigned int count, const void *data) = 0;
+
+  // buffers
+  virtual void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void *data) = 0;
+  virtual void copyBufferSubData(unsigned int srcBuffer, unsigned int dstBuffer, size_t srcOffset, size_t dstOffset, size_t size) = 0;
+
+  // work, indices are always unsigned ints
+  virtual void clear(unsigned int mask) = 0;
+  virtual void drawArrays(unsigned int mode, int first, int count) = 0;
+  virtual void drawElements(unsigned int mode, int count, int baseVertex = 0) = 0;
+  virtual void drawElementsInstanced(unsigned int mode, int count, int instanceCount) = 0;
+  virtual void drawElementsIndirect(unsigned int mode, unsigned int indirectBuffer, size_t offset) = 0;
+  virtual void dispatchCompute(unsigned int x, unsigned int y, unsigned int z) = 0;
+};
+
+class GLRenderDevice : public RenderDevice {
+public:
+  void useProgram(unsigned int program) override;
+  void bindVertexArray(unsigned int vao) override;
+  void activeTexture(unsigned int unit) override;
+  void bindTexture(unsigned int target, unsigned int texture) override;
+  void bindFramebuffer(unsigned int target, unsigned int framebuffer) override;
+  void bindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer) override;
+  void bindBufferRange(unsigned int target, unsigned int binding, unsigned int buffer, size_t offset, size_t size) override;
+  void setViewport(int x, int y, int width, int height) override;
+  void setCapability(unsigned int cap, bool enabled) override;
+  bool isCapabilityEnabled(unsigned int cap) override;
+  void setDepthMask(bool enabled) override;
+  void setDepthFunc(unsigned int func) override;
+  void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor) override;
+  void setColorMask(bool enabled) override;
+  void setUniform(int location, UniformType type, unsigned int count, const void *data) override;
+  void bufferSubData(unsigned int buffer, size_t offset, size_t size, const void *data) override;
+  void copyBufferSubData(unsigned int srcBuffer, unsigned int dstBuffer, size_t srcOffset, size_t dstOffset, size_t size) override;
+  void clear(unsigned int mask) override;
+  void drawArrays(unsigned int mode, int first, int count) override;
+  void drawElements(unsigned int mode, int count, int baseVertex = 0) override;
+  void drawElementsInstanced(unsigned int mode, int count, int instanceCount) override;
+  void drawElementsIndirect(unsigned int mode, unsigned int indirectBuffer, size_t offset) override;
+  void dispatchCompute(unsigned int x, unsigned int y, unsigned int z) override;
+};
+
+class NullRenderDevice : public RenderDevice {
+public:
+  void useProgram(unsigned int /*program*/) override {}
+  void bindVertexArray(unsigned int /*vao*/) override {}
+  void activeTexture(unsigned int /*unit*/) override {}
+  void bindTexture(unsigned int /*target*/, unsigned int /*texture*/) override {}
+  void bindFramebuffer(unsigned int /*target*/, unsigned int /*framebuffer*/) override {}
+  void bindBufferBase(unsigned int /*target*/, unsigned int /*binding*/, unsigned int /*buffer*/) override {}
+  void bindBufferRange(unsigned int /*target*/, unsigned int /*binding*/, unsigned int /*buffer*/, size_t /*offset*/, size_t /*size*/) override {}
+  void setViewport(int /*x*/, int /*y*/, int /*width*/, int /*height*/) override {}
+  void setCapability(unsigned int /*cap*/, bool /*enabled*/) override {}
+  bool isCapabilityEnabled(unsigned int /*cap*/) override { return false; }
+  void setDepthMask(bool /*enabled*/) override {}
+  void setDepthFunc(unsigned int /*func*/) override {}
+  void setBlendFunc(unsigned int /*sourceFactor*/, unsigned int /*destinationFactor*/) override {}
+  void setColorMask(bool /*enabled*/) override {}
+  void setUniform(int /*location*/, UniformType /*type*/, unsigned int /*count*/, const void * /*data*/) override {}
+  void bufferSubData(unsigned int /*buffer*/, size_t /*offset*/, size_t /*size*/, const void * /*data*/) override {}
+  void copyBufferSubData(unsigned int /*srcBuffer*/, unsigned int /*dstBuffer*/, size_t /*srcOffset*/, size_t /*dstOffset*/, size_t /*size*/) override {}
+  void clear(unsigned int /*mask*/) override {}
+  void drawArrays(unsigned int /*mode*/, int /*first*/, int /*count*/) override {}
+  void drawElements(unsigned int /*mode*/, int /*count*/, int /*baseVertex*/ = 0) override {}
+  void drawElementsInstanced(unsigned int /*mode*/, int /*count*/, int /*instanceCount*/) override {}
+  void drawElementsIndirect(unsigned int /*mode*/, unsigned int /*indirectBuffer*/, size_t /*offset*/) override {}
+  void dispatchCompute(unsigned int /*x*/, unsigned int /*y*/, unsigned int /*z*/) override {}
+};
+
+/* The device every renderer call goes through, the GL device unless another one was set */
+RenderDevice &getRenderDevice();
+/*
+* Replaces the current device, nullptr restores the GL device. The GLStateCache is
+* invalidated since the new device does not have the state of the previous one.
+* The device must outlive its use.
+*/
+void setRenderDevice(RenderDevice *device);
+
+}
@@ -0,0 +1,88 @@
+#include "RenderQueue.h"
+
+#include <bit>
+#include <array>
+
+namespace Renderer {
+
+static constexpr unsigned int SHADER_ID_BITS = 12;
+static constexpr unsigned int RADIX_BITS = 8;
+static constexpr unsigned int RADIX_BUCKETS = 1 << RADIX_BITS;
+
+uint16_t RenderQueue::getObjectId(std::unordered_map<const void *, uint16_t> &ids, const void *object)
+{
+  // ids only order packets, two objects sharing an id after an overflow are still drawn correctly
+  auto [it, inserted] = ids.try_emplace(object, (uint16_t)ids.size());
+  return it->second;
+}
+
+uint64_t RenderQueue::makeSortKey(RenderPass pass, uint16_t shaderId, uint16_t materialId, uint16_t vaoId, float depth)
+{
+  // positive floats keep their order when compared as integers, the 16 upper bits are a coarse depth
+  uint64_t depthBits = std::bit_cast<uint32_t>(glm::max(depth, 0.f)) >> 16;
+  uint64_t passBits = (uint64_t)pass & 0xf;
+  uint64_t shaderBits = shaderId & ((1u << SHADER_ID_BITS) - 1);
+  if (pass == RenderPass::TRANSLUCENT) {
+    depthBits = ~depthBits & 0xffff; // back to front
+    return passBits << 60 | depthBits << 44 | shaderBits << 32 | (uint64_t)materialId << 16 | vaoId;
+  }
+  return passBits << 60 | shaderBits << 48 | (uint64_t)materialId << 32 | (uint64_t)vaoId << 16 | depthBits;
+}
+
+void RenderQueue::submitMesh(const Camera &camera, const Mesh &mesh, RenderPass pass)
+{
+  const Material &material = *mesh.getMaterial();
+  float depth = glm::distance(camera.getPosition(), mesh.getTransform().position);
+  m_keys.push_back(makeSortKey(pass,
+    getObjectId(m_shaderIds, material.shader.get()),
+    getObjectId(m_materialIds, &material),
+    getObjectId(m_vaoIds, &mesh.getVAO()),
+    depth));
+  m_packets.push_back({ &camera, &mesh });
+}
+
+void RenderQueue::clear()
+{
+  m_keys.clear();
+  m_packets.clear();
+  m_shaderIds.clear();
+  m_materialIds.clear();
+  m_vaoIds.clear();
+}
+
+void RenderQueue::sort()
+{
+  size_t count = m_packets.size();
+  m_sortedKeys = m_keys;
+  m_keysSwap.resize(count);
+  m_sortedIndices.resize(count);
+  m_indicesSwap.resize(count);
+  for (size_t i = 0; i < count; i++)
+    m_sortedIndices[i] = (uint32_t)i;
+
+  // LSD radix sort, 8 bits at a time, stable so equal keys keep their submission order
+  for (unsigned int shift = 0; shift < 64; shift += RADIX_BITS) {
+    std::array<uint32_t, RADIX_BUCKETS> offsets{};
+    for (uint64_t key : m_sortedKeys)
+      offsets[(key >> shift) & (RADIX_BUCKETS - 1)]++;
+    // all keys share this digit (unused id bits, same pass...), the pass would not move anything
+    if (count == 0 || offsets[(m_sortedKeys[0] >> shift) & (RADIX_BUCKETS - 1)] == count)
+      continue;
+
+    uint32_t total = 0;
+    for (uint32_t &offset : offsets) {
+      uint32_t bucketSize = offset;
+      offset = total;
+      total += bucketSize;
+    }
+    for (size_t i = 0; i < count; i++) {
+      uint32_t destination = offsets[(m_sortedKeys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+      m_keysSwap[destination] = m_sortedKeys[i];
+      m_indicesSwap[destination] = m_sortedIndices[i];
+    }
+    m_sortedKeys.swap(m_keysSwap);
+    m_sortedIndices.swap(m_indicesSwap);
+  }
+}
+
+}
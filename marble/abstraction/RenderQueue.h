@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Mesh.h"
+#include "Camera.h"
+
+namespace Renderer {
+
+enum class RenderPass : unsigned char {
+  SOLID,       // drawn first, sorted to minimize state changes then front to back
+  TRANSLUCENT, // drawn after solid objects, sorted back to front
+};
+
+/**
+* A render queue collects draw packets instead of drawing meshes immediately.
+* When drawn with Renderer#renderQueue the packets are sorted by a 64 bits key
+* and executed in that order, binds of shaders, materials, textures and VAOs
+* that are already bound are skipped.
+*
+* Keys are made of (from the most significant bits to the least significant):
+*   solid packets       : pass(4) | shader(12) | material(16) | vao(16) | depth(16)
+*   translucent packets : pass(4) | depth(16)  | shader(12) | material(16) | vao(16)
+* shader, material and vao are small ids given to objects in the order they are
+* first submitted, they only exist until the queue is cleared.
+*
+* Cameras and meshes are referenced, they must be kept alive until the queue is drawn.
+*
+* Example usage:
+*   for (const Mesh &mesh : meshes)
+*     queue.submitMesh(camera, mesh);
+*   Renderer::renderQueue(queue); // also clears the queue
+*/
+class RenderQueue {
+public:
+  struct DrawPacket {
+    const Camera *camera;
+    const Mesh   *mesh;
+  };
+
+  struct Statistics {
+    unsigned int drawCalls;
+    unsigned int shaderBinds;
+    unsigned int materialBinds;
+    unsigned int textureBinds;
+    unsigned int vaoBinds;
+  };
+
+private:
+  std::vector<uint64_t>   m_keys;
+  std::vector<DrawPacket> m_packets;
+  // sort buffers, kept between frames to avoid reallocations
+  std::vector<uint64_t>   m_sortedKeys, m_keysSwap;
+  std::vector<uint32_t>   m_sortedIndices, m_indicesSwap;
+  std::unordered_map<const void *, uint16_t> m_shaderIds;
+  std::unordered_map<const void *, uint16_t> m_materialIds;
+  std::unordered_map<const void *, uint16_t> m_vaoIds;
+  Statistics m_lastStatistics{};
+
+public:
+  void submitMesh(const Camera &camera, const Mesh &mesh, RenderPass pass = RenderPass::SOLID);
+  void clear();
+
+  size_t getPacketCount() const { return m_packets.size(); }
+  /* Sorts the packets by key, #getSortedPacket can be called after */
+  void sort();
+  const DrawPacket &getSortedPacket(size_t i) const { return m_packets[m_sortedIndices[i]]; }
+  uint64_t getSortedKey(size_t i) const { return m_sortedKeys[i]; }
+
+  const Statistics &getLastStatistics() const { return m_lastStatistics; }
+  void setLastStatistics(const Statistics &statistics) { m_lastStatistics = statistics; }
+
+  static uint64_t makeSortKey(RenderPass pass, uint16_t shaderId, uint16_t materialId, uint16_t vaoId, float depth);
+
+private:
+  static uint16_t getObjectId(std::unordered_map<const void *, uint16_t> &ids, const void *object);
+};
+
+}
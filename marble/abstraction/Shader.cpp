@@ -10,6 +10,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+
+#include "GLStateCache.h"
+#include "RenderDevice.h"
 #include "../vendor/imgui/imgui.h"
 
 #include "UnifiedRenderer.h"
@@ -17,6 +20,54 @@
 
 namespace Renderer {
 
+	// attaches the shared blocks declared by the program to their binding points
+	// and returns the mask of these blocks, see Shader#usesUniformBlock
+	static unsigned int bindSharedUniformBlocks(unsigned int programID)
+	{
+		unsigned int usedBlocks = 0;
+		for (const UniformBlockDescription &block : SHARED_UNIFORM_BLOCKS) {
+			GLuint blockIndex = glGetUniformBlockIndex(programID, block.name);
+			if (blockIndex == GL_INVALID_INDEX)
+				continue;
+			GLint blockSize;
+			glGetActiveUniformBlockiv(programID, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+			if ((size_t)blockSize != block.size) {
+				std::cerr << "Uniform block \"" << block.name << "\" is declared with a size of " << blockSize << " instead of " << block.size << std::endl;
+				MARBLE_DEBUGBREAK();
+			}
+			glUniformBlockBinding(programID, blockIndex, block.binding);
+			usedBlocks |= 1u << block.binding;
+		}
+		return usedBlocks;
+	}
+
+	// returns the mask of the vertex attribute locations read by the program, see Shader#readsAttribute
+	static unsigned int listActiveAttributes(unsigned int programID)
+	{
+		GLint attributeCount, maxNameLength;
+		glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+		glGetProgramiv(programID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+		std::string name(maxNameLength, '\0');
+		unsigned int activeAttributes = 0;
+		for (GLint i = 0; i < attributeCount; i++) {
+			GLint size;
+			GLenum type;
+			glGetActiveAttrib(programID, i, maxNameLength, nullptr, &size, &type, name.data());
+			GLint location = glGetAttribLocation(programID, name.c_str());
+			if (location >= 0 && location < 32) // built-in inputs (gl_VertexID...) have no location
+				activeAttributes |= 1u << location;
+		}
+		return activeAttributes;
+	}
+
+	// samplers of textures that the renderer binds to fixed units are set once, when the program is linked
+	static void bindSharedSamplers(unsigned int programID)
+	{
+		GLint location = glGetUniformLocation(programID, "u_TextureArray");
+		if (location != -1)
+			glProgramUniform1i(programID, location, Material::TEXTURE_ARRAY_SLOT);
+	}
+
 	//================== SHADER CLASS =============//
   
 	Shader::Shader(const std::string& str_vertexShader, const std::string& str_fragmentShader)
@@ -47,11 +98,29 @@ namespace Renderer {
 
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
+
+		m_uniformBlocks = bindSharedUniformBlocks(m_shaderID);
+		m_activeAttributes = listActiveAttributes(m_shaderID);
+		bindSharedSamplers(m_shaderID);
+		fillUniformTable();
+	}
+
+	Shader::Shader(int shaderID)
+		: m_shaderID(shaderID),
+		  m_uniformBlocks(bindSharedUniformBlocks(shaderID)),
+		  m_activeAttributes(listActiveAttributes(shaderID))
+	{
+		bindSharedSamplers(shaderID);
+		fillUniformTable();
 	}
 
 	Shader::Shader(Shader &&moved) noexcept
 	{
 	  m_shaderID = moved.m_shaderID;
+	  m_uniformBlocks = moved.m_uniformBlocks;
+	  m_activeAttributes = moved.m_activeAttributes;
+	  m_uniformTable = std::move(moved.m_uniformTable);
+	  m_uniformTableUsage = moved.m_uniformTableUsage;
 	  m_uniformLocationCache = std::move(moved.m_uniformLocationCache);
 	  moved.m_shaderID = 0;
 	}
@@ -64,61 +133,149 @@ namespace Renderer {
 	}
 
 	void Shader::bind() const {
-		glUseProgram(m_shaderID);
+		GLStateCache::useProgram(m_shaderID);
 	}
 
 	void Shader::unbind() {
-		glUseProgram(0);
+		GLStateCache::useProgram(0);
 	}
 
 	void Shader::destroy() {
+		GLStateCache::notifyProgramDeleted(m_shaderID);
 		glDeleteProgram(m_shaderID);
 	}
 
-	void Shader::setUniform1i(const std::string & name, int value) {
-		glUniform1i(getUniformLocation(name), value);
+	void Shader::setUniform1i(UniformID id, int value) {
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::INT, 1, &value);
 	}
 
-	void Shader::setUniform1f(const std::string & name, float value) {
-		glUniform1f(getUniformLocation(name), value);
+	void Shader::setUniform1f(UniformID id, float value) {
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::FLOAT, 1, &value);
 	}
 
-	void Shader::setUniform2f(const std::string & name, float v1, float v2)
+	void Shader::setUniform2f(UniformID id, float v1, float v2)
 	{
-	  glUniform2f(getUniformLocation(name), v1, v2);
+	  float values[2]{ v1, v2 };
+	  getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::VEC2, 1, values);
 	}
 
-	void Shader::setUniform3f(const std::string & name, float v1, float v2, float v3)
+	void Shader::setUniform3f(UniformID id, float v1, float v2, float v3)
 	{
-	  glUniform3f(getUniformLocation(name), v1, v2, v3);
+	  float values[3]{ v1, v2, v3 };
+	  getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::VEC3, 1, values);
 	}
 
-	void Shader::setUniform3fv(const std::string& name, unsigned int count, const float* data)
+	void Shader::setUniform3fv(UniformID id, unsigned int count, const float* data)
 	{
-		glUniform3fv(getUniformLocation(name), count, data);
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::VEC3, count, data);
 	}
 
-	void Shader::setUniform4f(const std::string & name, float v1, float v2, float v3, float v4) {
-		glUniform4f(getUniformLocation(name), v1, v2, v3, v4);
+	void Shader::setUniform4f(UniformID id, float v1, float v2, float v3, float v4) {
+		float values[4]{ v1, v2, v3, v4 };
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::VEC4, 1, values);
 	}
 	
-	void Shader::setUniformMat4f(const std::string & name, const glm::mat4& matrix) {
-		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+	void Shader::setUniformMat4f(UniformID id, const glm::mat4& matrix) {
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::MAT4, 1, glm::value_ptr(matrix));
 	}
 
-	void Shader::setUniformMat2f(const std::string & name, const glm::mat2& matrix) {
-		glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+	void Shader::setUniformMat2f(UniformID id, const glm::mat2& matrix) {
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::MAT2, 1, glm::value_ptr(matrix));
 	}
 	
-	void Shader::setUniformMat4x3f(const std::string & name, const glm::mat4x3 &matrix) {
-	  glUniformMatrix4x3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
+	void Shader::setUniformMat4x3f(UniformID id, const glm::mat4x3 &matrix) {
+	  getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::MAT4X3, 1, glm::value_ptr(matrix));
+	}
+
+	void Shader::setUniform1iv(UniformID id, unsigned int count, const int* data) {
+		getRenderDevice().setUniform(getUniformLocation(id), RenderDevice::UniformType::INT, count, data);
 	}
 
-	void Shader::setUniform1iv(const std::string & name, unsigned int count, const int* data) {
-		 glUniform1iv(getUniformLocation(name), count, data);
+	static constexpr int EMPTY_SLOT = -2;    // no uniform has this hash
+	static constexpr int COLLIDED_SLOT = -3; // two uniforms of the program share this hash, they are found by name
+
+	void Shader::fillUniformTable()
+	{
+		m_uniformTable.clear();
+		m_uniformTableUsage = 0;
+
+		GLint uniformCount, maxNameLength;
+		glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::string name(maxNameLength, '\0');
+		for (GLint i = 0; i < uniformCount; i++) {
+			GLsizei nameLength;
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(m_shaderID, i, maxNameLength, &nameLength, &size, &type, name.data());
+			int location = glGetUniformLocation(m_shaderID, name.c_str());
+			if (location == -1)
+				continue; // members of uniform blocks
+			std::string_view uniformName(name.data(), nameLength);
+			insertUniformSlot(hashUniformName(uniformName), location);
+			// arrays are listed as "u_array[0]", the first element can also be set with "u_array"
+			if (uniformName.ends_with("[0]"))
+				insertUniformSlot(hashUniformName(uniformName.substr(0, nameLength - 3)), location);
+		}
+	}
+
+	void Shader::insertUniformSlot(uint32_t hash, int location)
+	{
+		// the table is kept at most half full for probe sequences to stay short
+		if ((m_uniformTableUsage + 1) * 2 > m_uniformTable.size()) {
+			std::vector<UniformSlot> previousTable = std::move(m_uniformTable);
+			m_uniformTable.assign(std::max<size_t>(32, previousTable.size() * 2), UniformSlot{ 0, EMPTY_SLOT });
+			m_uniformTableUsage = 0;
+			for (const UniformSlot &slot : previousTable)
+				if (slot.location != EMPTY_SLOT)
+					insertUniformSlot(slot.hash, slot.location);
+		}
+
+		size_t mask = m_uniformTable.size() - 1;
+		for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+			UniformSlot &slot = m_uniformTable[i];
+			if (slot.location == EMPTY_SLOT) {
+				slot = { hash, location };
+				m_uniformTableUsage++;
+				return;
+			}
+			if (slot.hash == hash) {
+				if (slot.location != location)
+					slot.location = COLLIDED_SLOT;
+				return;
+			}
+		}
+	}
+
+	const Shader::UniformSlot *Shader::findUniformSlot(uint32_t hash) const
+	{
+		if (m_uniformTable.empty())
+			return nullptr;
+		size_t mask = m_uniformTable.size() - 1;
+		for (size_t i = hash & mask; m_uniformTable[i].location != EMPTY_SLOT; i = (i + 1) & mask) {
+			if (m_uniformTable[i].hash == hash)
+				return &m_uniformTable[i];
+		}
+		return nullptr;
+	}
+
+	bool Shader::hasUniform(UniformID id) const
+	{
+		const UniformSlot *slot = findUniformSlot(id.hash);
+		return slot && slot->location != -1;
+	}
+
+	int Shader::getUniformLocation(UniformID id) {
+		if (const UniformSlot *slot = findUniformSlot(id.hash))
+			return slot->location == COLLIDED_SLOT ? getUniformLocationSlowPath(id) : slot->location;
+		// not an active uniform of the program, or an array element that is not the first
+		int location = getUniformLocationSlowPath(id);
+		insertUniformSlot(id.hash, location);
+		return location;
 	}
 
-	int Shader::getUniformLocation(const std::string &name) {
+	int Shader::getUniformLocationSlowPath(UniformID id) {
+		std::string name{ id.name };
 		if (m_uniformLocationCache.find(name) != m_uniformLocationCache.end())
 			return m_uniformLocationCache[name];
 
@@ -235,7 +392,7 @@ namespace Renderer {
 		  m_textures[slot]->bind(slot);
 	  m_shader.bind();
 	  m_vao.bind();
-	  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	  getRenderDevice().drawElements(GL_TRIANGLES, 6);
 	  m_shader.unbind();
 	  VertexArray::unbind();
 	}
@@ -12,20 +12,39 @@
 
 #include "VertexArray.h"
 #include "Texture.h"
+#include "UniformBlocks.h"
+#include "UniformID.h"
 
 namespace Renderer {
 
 namespace fs = std::filesystem;
 
-/* Immediate wrapper of the GL concept */
+/**
+* Immediate wrapper of the GL concept.
+*
+* Uniforms can be set by name or by UniformID, in both cases the location is
+* found in a table filled with the active uniforms of the program when it is
+* linked. Ids are hashed at compile time, names are hashed on each call. Names
+* that are not in the table (array elements other than the first, inactive
+* uniforms...) go through glGetUniformLocation once and are added to the table.
+*/
 class Shader
 {
 private:
+	struct UniformSlot {
+		uint32_t hash;
+		int      location; // EMPTY_SLOT for unused slots
+	};
+
 	unsigned int m_shaderID;
-	std::unordered_map<std::string, int> m_uniformLocationCache;
+	unsigned int m_uniformBlocks; // bit i is set iff the program declares the shared block bound to point i
+	unsigned int m_activeAttributes; // bit i is set iff the program reads the vertex attribute at location i
+	std::vector<UniformSlot> m_uniformTable; // open addressing on the name hashes, the size is a power of 2
+	size_t m_uniformTableUsage;
+	std::unordered_map<std::string, int> m_uniformLocationCache; // slow path, for names whose hash collides with another uniform
 
 public:
-	Shader() : m_shaderID(0) {}
+	Shader() : m_shaderID(0), m_uniformBlocks(0), m_activeAttributes(0), m_uniformTableUsage(0) {}
 	Shader(const std::string& str_vertexShader, const std::string& str_fragmentShader);
 	Shader(Shader &&moved) noexcept;
 	Shader &operator=(Shader &&moved) noexcept;
@@ -36,26 +55,51 @@ public:
 	static void unbind();
 	void destroy();
 
-	void setUniform1i(const std::string & name, int value);
-	void setUniform1f(const std::string & name, float value);
-	void setUniform2f(const std::string & name, float v1, float v2);
-	void setUniform3f(const std::string & name, float v1, float v2, float v3);
-	void setUniform3fv(const std::string& name, unsigned int count, const float* data);
-	void setUniform4f(const std::string & name, float v1, float v2, float v3, float v4);
-	void setUniformMat2f(const std::string & name, const glm::mat2 &matrix);
-	void setUniformMat4f(const std::string & name, const glm::mat4 &matrix);
-	void setUniformMat4x3f(const std::string & name, const glm::mat4x3 &matrix);
-	void setUniform2f(const std::string & name, glm::vec2 v) { setUniform2f(name, v.x, v.y); }
-	void setUniform3f(const std::string & name, glm::vec3 v) { setUniform3f(name, v.x, v.y, v.z); }
-	void setUniform4f(const std::string & name, glm::vec4 v) { setUniform4f(name, v.x, v.y, v.z, v.w); }
-	void setUniform1iv(const std::string & name, unsigned int count, const int* data);
+	void setUniform1i(UniformID id, int value);
+	void setUniform1f(UniformID id, float value);
+	void setUniform2f(UniformID id, float v1, float v2);
+	void setUniform3f(UniformID id, float v1, float v2, float v3);
+	void setUniform3fv(UniformID id, unsigned int count, const float* data);
+	void setUniform4f(UniformID id, float v1, float v2, float v3, float v4);
+	void setUniformMat2f(UniformID id, const glm::mat2 &matrix);
+	void setUniformMat4f(UniformID id, const glm::mat4 &matrix);
+	void setUniformMat4x3f(UniformID id, const glm::mat4x3 &matrix);
+	void setUniform2f(UniformID id, glm::vec2 v) { setUniform2f(id, v.x, v.y); }
+	void setUniform3f(UniformID id, glm::vec3 v) { setUniform3f(id, v.x, v.y, v.z); }
+	void setUniform4f(UniformID id, glm::vec4 v) { setUniform4f(id, v.x, v.y, v.z, v.w); }
+	void setUniform1iv(UniformID id, unsigned int count, const int* data);
+
+	// by name, the name is hashed on each call
+	void setUniform1i(const std::string & name, int value) { setUniform1i(UniformID(name), value); }
+	void setUniform1f(const std::string & name, float value) { setUniform1f(UniformID(name), value); }
+	void setUniform2f(const std::string & name, float v1, float v2) { setUniform2f(UniformID(name), v1, v2); }
+	void setUniform3f(const std::string & name, float v1, float v2, float v3) { setUniform3f(UniformID(name), v1, v2, v3); }
+	void setUniform3fv(const std::string& name, unsigned int count, const float* data) { setUniform3fv(UniformID(name), count, data); }
+	void setUniform4f(const std::string & name, float v1, float v2, float v3, float v4) { setUniform4f(UniformID(name), v1, v2, v3, v4); }
+	void setUniformMat2f(const std::string & name, const glm::mat2 &matrix) { setUniformMat2f(UniformID(name), matrix); }
+	void setUniformMat4f(const std::string & name, const glm::mat4 &matrix) { setUniformMat4f(UniformID(name), matrix); }
+	void setUniformMat4x3f(const std::string & name, const glm::mat4x3 &matrix) { setUniformMat4x3f(UniformID(name), matrix); }
+	void setUniform2f(const std::string & name, glm::vec2 v) { setUniform2f(UniformID(name), v); }
+	void setUniform3f(const std::string & name, glm::vec3 v) { setUniform3f(UniformID(name), v); }
+	void setUniform4f(const std::string & name, glm::vec4 v) { setUniform4f(UniformID(name), v); }
+	void setUniform1iv(const std::string & name, unsigned int count, const int* data) { setUniform1iv(UniformID(name), count, data); }
+	/* Shared blocks are declared in UniformBlocks.h, their uniforms must not be set with setUniform* */
+	bool usesUniformBlock(UniformBlockBinding binding) const { return m_uniformBlocks & (1u << binding); }
+	/* Whether the program reads the vertex attribute at the given location, instanced draws need instance attributes to be read */
+	bool readsAttribute(unsigned int location) const { return location < 32 && (m_activeAttributes & (1u << location)); }
+	/* Whether the uniform was listed when the program was linked, does not fall back to glGetUniformLocation */
+	bool hasUniform(UniformID id) const;
 	// Unsafe
 	inline unsigned int getId() { return m_shaderID; }
 
 private:
-	int getUniformLocation(const std::string & name);
+	int getUniformLocation(UniformID id);
+	const UniformSlot *findUniformSlot(uint32_t hash) const;
+	int getUniformLocationSlowPath(UniformID id);
+	void fillUniformTable();
+	void insertUniformSlot(uint32_t hash, int location);
 
-	explicit Shader(int shaderID) : m_shaderID(shaderID) {}
+	explicit Shader(int shaderID);
 	friend class ShaderFactory;
 };
 
@@ -107,7 +151,11 @@ private:
   void sendUniformValue();
 };
 
-/* Factory with which to build shader programs, shader files can be added but not removed */
+/**
+* Factory with which to build shader programs, shader files can be added but not removed.
+* The shared uniform blocks (see UniformBlocks.h) declared by the built program are
+* attached to their binding points.
+*/
 class ShaderFactory {
 private:
   std::vector<int> m_parts;
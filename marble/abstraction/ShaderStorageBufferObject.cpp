@@ -0,0 +1,74 @@
+#include "ShaderStorageBufferObject.h"
+
+#include <cassert>
+#include <algorithm>
+#include <utility>
+#include <new>
+
+#include <glad/glad.h>
+
+#include "StreamBuffer.h"
+#include "RenderDevice.h"
+
+namespace Renderer {
+
+ShaderStorageBufferObject::ShaderStorageBufferObject(size_t capacity)
+  : m_renderID(0), m_capacity(capacity)
+{
+  glCreateBuffers(1, &m_renderID);
+  glNamedBufferData(m_renderID, capacity, nullptr, GL_DYNAMIC_DRAW);
+}
+
+ShaderStorageBufferObject::~ShaderStorageBufferObject()
+{
+  glDeleteBuffers(1, &m_renderID);
+  m_renderID = 0;
+}
+
+ShaderStorageBufferObject::ShaderStorageBufferObject(ShaderStorageBufferObject &&moved) noexcept
+{
+  m_capacity = moved.m_capacity;
+  m_renderID = moved.m_renderID;
+  moved.m_renderID = 0;
+}
+
+ShaderStorageBufferObject &ShaderStorageBufferObject::operator=(ShaderStorageBufferObject &&moved) noexcept
+{
+  this->~ShaderStorageBufferObject();
+  new (this)ShaderStorageBufferObject(std::move(moved));
+  return *this;
+}
+
+void ShaderStorageBufferObject::bindBase(unsigned int binding) const
+{
+  getRenderDevice().bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_renderID);
+}
+
+bool ShaderStorageBufferObject::setData(const void *data, size_t size)
+{
+  assert(m_renderID != 0);
+  if (size > m_capacity) {
+    // grows geometrically, the buffer id does not change so bindings stay valid
+    m_capacity = std::max(size, m_capacity * 2);
+    glNamedBufferData(m_renderID, m_capacity, nullptr, GL_DYNAMIC_DRAW);
+    updateData(data, size);
+    return true;
+  }
+  updateData(data, size);
+  return false;
+}
+
+void ShaderStorageBufferObject::updateData(const void *data, size_t size, size_t offset)
+{
+  assert(m_renderID != 0);
+  assert(offset + size <= m_capacity);
+  if (size == 0)
+    return;
+  // staged in the stream buffer so that the call does not wait for draws that read the buffer
+  if (StreamBuffer *stream = getFrameStreamBuffer())
+    stream->copyToBuffer(m_renderID, offset, data, size);
+  else
+    getRenderDevice().bufferSubData(m_renderID, offset, size, data);
+}
+
+}
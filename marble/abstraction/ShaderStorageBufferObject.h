@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Renderer {
+
+/**
+* Immediate wrapper of the GL concept, shader storage buffers are read by
+* #version 430 shaders through std430 blocks declared with a fixed binding,
+* see UniformBlocks.h for the bindings used by the renderer.
+*
+* The buffer grows (and is reallocated) when data larger than its capacity
+* is written, its content is not kept when it does.
+*/
+class ShaderStorageBufferObject {
+private:
+  unsigned int m_renderID;
+  size_t       m_capacity;
+public:
+  ShaderStorageBufferObject() : m_renderID(0), m_capacity(0) {} // does not create the buffer on the gpu
+  explicit ShaderStorageBufferObject(size_t capacity);
+  ShaderStorageBufferObject(ShaderStorageBufferObject &&moved) noexcept;
+  ShaderStorageBufferObject &operator=(ShaderStorageBufferObject &&moved) noexcept;
+  ShaderStorageBufferObject(const ShaderStorageBufferObject &) = delete;
+  ShaderStorageBufferObject &operator=(const ShaderStorageBufferObject &) = delete;
+  ~ShaderStorageBufferObject();
+
+  void bindBase(unsigned int binding) const;
+
+  size_t getCapacity() const { return m_capacity; }
+  // Unsafe
+  unsigned int getId() const { return m_renderID; }
+  /* Replaces the content of the buffer, it is reallocated if size exceeds its capacity. Returns true if it was */
+  bool setData(const void *data, size_t size);
+  /* Writes in the buffer, offset+size must not exceed its capacity */
+  void updateData(const void *data, size_t size, size_t offset=0);
+};
+
+}
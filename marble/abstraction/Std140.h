@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+/**
+* Compile time computation of the std140 layout of GLSL uniform blocks.
+*
+* A Layout is given the types of the block members, in declaration order, and
+* gives back the offset of each member and the size of the block. C++ structs
+* mirroring a block can be checked against it with static_asserts.
+*
+* Example usage:
+*   // layout(std140) uniform Block { mat4 u_VP; vec3 u_position; float u_time; };
+*   using BlockLayout = Std140::Layout<glm::mat4, glm::vec3, float>;
+*   static_assert(BlockLayout::offsetOf(2) == 76);
+*   static_assert(BlockLayout::SIZE == 80);
+*/
+namespace Renderer::Std140 {
+
+constexpr size_t alignUp(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+/* ALIGNMENT and SIZE of a type in a std140 block, only types that are used by blocks are defined */
+template<class T>
+struct TypeInfo;
+
+template<> struct TypeInfo<float>        { static constexpr size_t ALIGNMENT = 4,  SIZE = 4; };
+template<> struct TypeInfo<int>          { static constexpr size_t ALIGNMENT = 4,  SIZE = 4; };
+template<> struct TypeInfo<unsigned int> { static constexpr size_t ALIGNMENT = 4,  SIZE = 4; };
+template<> struct TypeInfo<glm::vec2>    { static constexpr size_t ALIGNMENT = 8,  SIZE = 8; };
+template<> struct TypeInfo<glm::vec3>    { static constexpr size_t ALIGNMENT = 16, SIZE = 12; };
+template<> struct TypeInfo<glm::vec4>    { static constexpr size_t ALIGNMENT = 16, SIZE = 16; };
+template<> struct TypeInfo<glm::ivec4>   { static constexpr size_t ALIGNMENT = 16, SIZE = 16; };
+template<> struct TypeInfo<glm::mat4>    { static constexpr size_t ALIGNMENT = 16, SIZE = 64; }; // 4 vec4 columns
+
+// array elements are padded to a vec4, glm::vec3 u[4] is 64 bytes long
+template<class T, size_t N>
+struct TypeInfo<T[N]> {
+  static constexpr size_t STRIDE = alignUp(TypeInfo<T>::SIZE, 16);
+  static constexpr size_t ALIGNMENT = alignUp(TypeInfo<T>::ALIGNMENT, 16);
+  static constexpr size_t SIZE = STRIDE * N;
+};
+
+template<class... Members>
+class Layout {
+public:
+  static constexpr size_t MEMBER_COUNT = sizeof...(Members);
+
+private:
+  struct Offsets {
+    std::array<size_t, MEMBER_COUNT> members{};
+    size_t end = 0;
+  };
+
+  static constexpr Offsets computeOffsets()
+  {
+    Offsets offsets;
+    size_t i = 0;
+    ((offsets.end = alignUp(offsets.end, TypeInfo<Members>::ALIGNMENT),
+      offsets.members[i++] = offsets.end,
+      offsets.end += TypeInfo<Members>::SIZE), ...);
+    return offsets;
+  }
+
+  static constexpr Offsets OFFSETS = computeOffsets();
+
+public:
+  /* The size of the block, blocks are padded to a multiple of a vec4 */
+  static constexpr size_t SIZE = alignUp(OFFSETS.end, 16);
+
+  static constexpr size_t offsetOf(size_t member) { return OFFSETS.members[member]; }
+};
+
+}
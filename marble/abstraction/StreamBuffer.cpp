@@ -0,0 +1,132 @@
+#include "StreamBuffer.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <new>
+
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+namespace Renderer {
+
+StreamBuffer::StreamBuffer(size_t regionSize)
+  : m_renderID(0), m_regionSize(regionSize), m_mappedMemory(nullptr), m_regionFences{}, m_currentRegion(0), m_regionHead(0), m_currentStatistics{}, m_lastFrameStatistics{}
+{
+  constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glCreateBuffers(1, &m_renderID);
+  glNamedBufferStorage(m_renderID, regionSize * FRAME_COUNT, nullptr, flags);
+  m_mappedMemory = (char *)glMapNamedBufferRange(m_renderID, 0, regionSize * FRAME_COUNT, flags);
+  if (m_mappedMemory == nullptr)
+    throw std::runtime_error("Could not map the stream buffer");
+}
+
+StreamBuffer::~StreamBuffer()
+{
+  for (void *&fence : m_regionFences) {
+    if (fence != nullptr)
+      glDeleteSync((GLsync)fence);
+    fence = nullptr;
+  }
+  if (m_renderID != 0) {
+    glUnmapNamedBuffer(m_renderID);
+    glDeleteBuffers(1, &m_renderID);
+  }
+  m_renderID = 0;
+  m_mappedMemory = nullptr;
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer &&moved) noexcept
+{
+  m_renderID = moved.m_renderID;
+  m_regionSize = moved.m_regionSize;
+  m_mappedMemory = moved.m_mappedMemory;
+  m_currentRegion = moved.m_currentRegion;
+  m_regionHead = moved.m_regionHead;
+  m_currentStatistics = moved.m_currentStatistics;
+  m_lastFrameStatistics = moved.m_lastFrameStatistics;
+  for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+    m_regionFences[i] = moved.m_regionFences[i];
+    moved.m_regionFences[i] = nullptr;
+  }
+  moved.m_renderID = 0;
+  moved.m_mappedMemory = nullptr;
+}
+
+StreamBuffer &StreamBuffer::operator=(StreamBuffer &&moved) noexcept
+{
+  this->~StreamBuffer();
+  new (this)StreamBuffer(std::move(moved));
+  return *this;
+}
+
+void StreamBuffer::advanceRegion()
+{
+  void *&currentFence = m_regionFences[m_currentRegion];
+  if (currentFence != nullptr)
+    glDeleteSync((GLsync)currentFence);
+  currentFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  m_currentRegion = (m_currentRegion + 1) % FRAME_COUNT;
+  m_regionHead = 0;
+
+  void *&nextFence = m_regionFences[m_currentRegion];
+  if (nextFence == nullptr)
+    return;
+  // the commands are flushed on the first wait only, there is no need to flush them again
+  GLenum status = glClientWaitSync((GLsync)nextFence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    m_currentStatistics.stalls++;
+    do {
+      status = glClientWaitSync((GLsync)nextFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+  }
+  glDeleteSync((GLsync)nextFence);
+  nextFence = nullptr;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment)
+{
+  if (size > m_regionSize)
+    throw std::runtime_error("Stream buffer allocations cannot be larger than a region");
+
+  size_t regionStart = m_currentRegion * m_regionSize;
+  size_t offset = regionStart + m_regionHead;
+  offset += (alignment - offset % alignment) % alignment;
+  if (offset + size > regionStart + m_regionSize) {
+    advanceRegion();
+    regionStart = m_currentRegion * m_regionSize;
+    offset = regionStart;
+    offset += (alignment - offset % alignment) % alignment;
+    if (offset + size > regionStart + m_regionSize)
+      throw std::runtime_error("Stream buffer allocations cannot be larger than a region");
+  }
+  m_regionHead = offset + size - regionStart;
+
+  m_currentStatistics.allocations++;
+  m_currentStatistics.allocatedBytes += size;
+  return Allocation{ m_mappedMemory + offset, m_renderID, offset, size };
+}
+
+void StreamBuffer::copyToBuffer(unsigned int dstBuffer, size_t dstOffset, const void *data, size_t size)
+{
+  if (size > m_regionSize) {
+    // too large to be staged, let the driver handle it
+    getRenderDevice().bufferSubData(dstBuffer, dstOffset, size, data);
+    return;
+  }
+  Allocation staging = allocate(size);
+  std::memcpy(staging.data, data, size);
+  getRenderDevice().copyBufferSubData(m_renderID, dstBuffer, staging.offset, dstOffset, size);
+  m_currentStatistics.copies++;
+}
+
+void StreamBuffer::endFrame()
+{
+  m_lastFrameStatistics = m_currentStatistics;
+  m_currentStatistics = {};
+  advanceRegion();
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Renderer {
+
+/**
+* Ring allocator for data that is written by the cpu each frame and read by the
+* gpu once, typically vertices of debug quads, instances and uploads to static
+* buffers.
+*
+* The buffer is mapped once with persistent and coherent storage, it is split
+* into FRAME_COUNT regions and allocations are taken from the current region.
+* When a region is full or when the frame ends, a fence is placed after the
+* commands that read it and the next region becomes the current one. The cpu
+* only waits if the gpu is still reading that region, that is if it is more
+* than FRAME_COUNT-1 frames behind.
+*
+* Allocations are transient, their memory must be written before the commands
+* that read it are issued and is not valid after the next #endFrame.
+*
+* Example usage:
+*   StreamBuffer::Allocation alloc = stream.allocate(sizeof(vertices), sizeof(BaseVertex));
+*   std::memcpy(alloc.data, vertices, sizeof(vertices));
+*   glDrawElementsBaseVertex(..., (int)(alloc.offset / sizeof(BaseVertex)));
+*   // or, to update a buffer that is not persistently mapped
+*   stream.copyToBuffer(vbo.getId(), 0, vertices, sizeof(vertices));
+*   ...
+*   stream.endFrame(); // once per frame, before swapping buffers
+*/
+class StreamBuffer {
+public:
+  static constexpr unsigned int FRAME_COUNT = 3;
+
+  struct Allocation {
+    void        *data;   // cpu pointer, write only
+    unsigned int buffer; // gl id of the stream buffer
+    size_t       offset; // in bytes, from the start of the buffer
+    size_t       size;
+  };
+
+  struct Statistics {
+    size_t       allocatedBytes; // since the last #endFrame
+    unsigned int allocations;
+    unsigned int copies;
+    unsigned int stalls;         // times the cpu had to wait for the gpu to release a region
+  };
+
+private:
+  unsigned int m_renderID;
+  size_t       m_regionSize;
+  char        *m_mappedMemory;
+  void        *m_regionFences[FRAME_COUNT];
+  unsigned int m_currentRegion;
+  size_t       m_regionHead; // offset of the next allocation in the current region
+  Statistics   m_currentStatistics;
+  Statistics   m_lastFrameStatistics;
+
+public:
+  StreamBuffer() : m_renderID(0), m_regionSize(0), m_mappedMemory(nullptr), m_regionFences{}, m_currentRegion(0), m_regionHead(0), m_currentStatistics{}, m_lastFrameStatistics{} {} // does not create the buffer on the gpu
+  explicit StreamBuffer(size_t regionSize);
+  StreamBuffer(StreamBuffer &&moved) noexcept;
+  StreamBuffer &operator=(StreamBuffer &&moved) noexcept;
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+  ~StreamBuffer();
+
+  /* Throws if size is larger than a region, alignment does not need to be a power of two */
+  Allocation allocate(size_t size, size_t alignment=16);
+  /* Writes data in the stream buffer and copies it to the destination buffer on the gpu, the destination does not need to be bound */
+  void copyToBuffer(unsigned int dstBuffer, size_t dstOffset, const void *data, size_t size);
+  /* Fences the current region and moves to the next one */
+  void endFrame();
+
+  size_t getRegionSize() const { return m_regionSize; }
+  const Statistics &getLastFrameStatistics() const { return m_lastFrameStatistics; }
+  // Unsafe
+  unsigned int getId() const { return m_renderID; }
+
+private:
+  void advanceRegion();
+};
+
+/* The stream buffer of the renderer, null until Renderer#init is called */
+StreamBuffer *getFrameStreamBuffer();
+
+}
@@ -1,10 +1,13 @@
 #include "Texture.h"
 
+#include <cassert>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
 
+#include "GLStateCache.h"
 #include "../Utils/Debug.h"
 
 namespace Renderer {
@@ -22,7 +25,7 @@ Texture::Texture(const std::string &path)
   unsigned char *localBuffer = stbi_load(path.c_str(), &m_width, &m_height, nullptr, 4);
 
   glGenTextures(1, &m_rendererID);
-  glBindTexture(GL_TEXTURE_2D, m_rendererID);
+  GLStateCache::bindTexture2D(m_rendererID);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -31,7 +34,7 @@ Texture::Texture(const std::string &path)
 
   if (localBuffer) {
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, localBuffer);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::bindTexture2D(0);
 	glGenerateMipmap(GL_TEXTURE_2D);
 	stbi_image_free(localBuffer);
   } else {
@@ -46,7 +49,7 @@ Texture::Texture(unsigned int width, unsigned int height)
   : m_width(width), m_height(height)
 {
   glGenTextures(1, &m_rendererID);
-  glBindTexture(GL_TEXTURE_2D, m_rendererID);
+  GLStateCache::bindTexture2D(m_rendererID);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -54,7 +57,7 @@ Texture::Texture(unsigned int width, unsigned int height)
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, nullptr);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLStateCache::bindTexture2D(0);
 }
 
 Texture::Texture(unsigned int rendererId, int width, int height)
@@ -86,27 +89,24 @@ Texture &Texture::operator=(Texture &&moved) noexcept
 
 void Texture::destroy()
 {
+  GLStateCache::notifyTextureDeleted(m_rendererID);
   glDeleteTextures(1, &m_rendererID);
   m_rendererID = 0;
 }
 
 void Texture::bind(unsigned int slot /* = 0*/) const
 {
-  glActiveTexture(GL_TEXTURE0 + slot);
-  glBindTexture(GL_TEXTURE_2D, m_rendererID);
-
+  GLStateCache::bindTexture2D(slot, m_rendererID);
 }
 
 
 void Texture::bindFromId(unsigned int texId, unsigned int slot/*=0*/) {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, texId);
-
+	GLStateCache::bindTexture2D(slot, texId);
 }
 
 void Texture::unbind(unsigned int slot /* = 0*/)
 {
-  glBindTexture(GL_TEXTURE_2D + slot, 0);
+  GLStateCache::bindTexture2D(slot, 0);
 } 
 
 void Texture::changeColor(uint32_t color)
@@ -118,7 +118,7 @@ Texture Texture::createTextureFromData(const float *data, int width, int height,
 {
   unsigned int rendererId;
   glGenTextures(1, &rendererId);
-  glBindTexture(GL_TEXTURE_2D, rendererId);
+  GLStateCache::bindTexture2D(rendererId);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -135,7 +135,24 @@ Texture Texture::createTextureFromData(const float *data, int width, int height,
   }
 
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, dataFormat, GL_FLOAT, data);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLStateCache::bindTexture2D(0);
+
+  return Texture(rendererId, width, height);
+}
+
+Texture Texture::createTargetTexture(int width, int height, unsigned int internalFormat)
+{
+  unsigned int rendererId;
+  glGenTextures(1, &rendererId);
+  GLStateCache::bindTexture2D(rendererId);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+  GLStateCache::bindTexture2D(0);
 
   return Texture(rendererId, width, height);
 }
@@ -144,7 +161,7 @@ Texture Texture::createDepthTexture(int width, int height)
 {
   unsigned int rendererId;
   glGenTextures(1, &rendererId);
-  glBindTexture(GL_TEXTURE_2D, rendererId);
+  GLStateCache::bindTexture2D(rendererId);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -152,16 +169,25 @@ Texture Texture::createDepthTexture(int width, int height)
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
   glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLStateCache::bindTexture2D(0);
 
   return Texture(rendererId, width, height);
 }
 
+void Texture::copyTextureContent(const Texture &source, Texture &destination)
+{
+  assert(source.m_width == destination.m_width && source.m_height == destination.m_height);
+  glCopyImageSubData(
+    source.m_rendererID, GL_TEXTURE_2D, 0, 0, 0, 0,
+    destination.m_rendererID, GL_TEXTURE_2D, 0, 0, 0, 0,
+    source.m_width, source.m_height, 1);
+}
+
 void Texture::writeToFile(const Texture &texture, const std::filesystem::path &path)
 {
   int w, h;
   int lod = 0;
-  glBindTexture(GL_TEXTURE_2D, texture.m_rendererID);
+  GLStateCache::bindTexture2D(texture.m_rendererID);
   glGetTexLevelParameteriv(GL_TEXTURE_2D, lod, GL_TEXTURE_WIDTH, &w);
   glGetTexLevelParameteriv(GL_TEXTURE_2D, lod, GL_TEXTURE_HEIGHT, &h);
   char *data = new char[(size_t)w * h * 4];
@@ -40,6 +40,11 @@ public:
 
   static Texture createTextureFromData(const float *data, int width, int height, int floatPerPixel = 4);
   static Texture createDepthTexture(int width, int height);
+  /* Render target with a specific internal format (GL_RGBA8, GL_RG16...), sampled with nearest filtering */
+  static Texture createTargetTexture(int width, int height, unsigned int internalFormat);
+
+  /* Copies the whole content of a texture to another of the same size and format, without going through the CPU */
+  static void copyTextureContent(const Texture &source, Texture &destination);
 
   /* Writes a texture to a .png file, depth textures aren't supported */
   static void writeToFile(const Texture &texture, const std::filesystem::path &path);
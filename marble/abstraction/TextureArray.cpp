@@ -0,0 +1,94 @@
+#include "TextureArray.h"
+
+#include <cassert>
+#include <utility>
+#include <new>
+
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+#include "../Utils/Mathf.h"
+
+namespace Renderer {
+
+static unsigned int createTextureArrayStorage(unsigned int size, unsigned int layerCount, unsigned int mipLevelCount)
+{
+  unsigned int rendererID;
+  glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &rendererID);
+  glTextureParameteri(rendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTextureParameteri(rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTextureStorage3D(rendererID, mipLevelCount, GL_RGBA8, size, size, layerCount);
+  return rendererID;
+}
+
+TextureArray::TextureArray(unsigned int size, unsigned int layerCount)
+  : m_size(size), m_layerCount(layerCount), m_mipLevelCount(0)
+{
+  assert(Mathf::isPowerOfTwo(size) && layerCount > 0);
+  for (unsigned int s = size; s > 0; s >>= 1)
+    m_mipLevelCount++;
+  m_rendererID = createTextureArrayStorage(m_size, m_layerCount, m_mipLevelCount);
+}
+
+TextureArray::~TextureArray()
+{
+  destroy();
+}
+
+TextureArray::TextureArray(TextureArray &&moved) noexcept
+{
+  m_rendererID = moved.m_rendererID;
+  m_size = moved.m_size;
+  m_layerCount = moved.m_layerCount;
+  m_mipLevelCount = moved.m_mipLevelCount;
+  moved.m_rendererID = 0;
+  moved.m_size = 0;
+  moved.m_layerCount = 0;
+  moved.m_mipLevelCount = 0;
+}
+
+TextureArray &TextureArray::operator=(TextureArray &&moved) noexcept
+{
+  destroy();
+  new (this) TextureArray(std::move(moved));
+  return *this;
+}
+
+void TextureArray::destroy()
+{
+  GLStateCache::notifyTextureDeleted(m_rendererID);
+  glDeleteTextures(1, &m_rendererID);
+  m_rendererID = 0;
+}
+
+void TextureArray::bind(unsigned int slot) const
+{
+  GLStateCache::bindTexture2DArray(slot, m_rendererID);
+}
+
+void TextureArray::setLayer(unsigned int layer, const unsigned char *pixels)
+{
+  assert(layer < m_layerCount);
+  glTextureSubImage3D(m_rendererID, 0, 0, 0, layer, m_size, m_size, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glGenerateTextureMipmap(m_rendererID);
+}
+
+void TextureArray::resize(unsigned int layerCount)
+{
+  assert(layerCount >= m_layerCount);
+  unsigned int resized = createTextureArrayStorage(m_size, layerCount, m_mipLevelCount);
+  for (unsigned int level = 0; level < m_mipLevelCount; level++) {
+    unsigned int levelSize = m_size >> level;
+    glCopyImageSubData(
+      m_rendererID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+      resized, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+      levelSize, levelSize, m_layerCount);
+  }
+  destroy();
+  m_rendererID = resized;
+  m_layerCount = layerCount;
+}
+
+}
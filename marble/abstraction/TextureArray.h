@@ -0,0 +1,43 @@
+#pragma once
+
+namespace Renderer {
+
+/**
+* Immediate wrapper of the GL concept, a 2D texture array of square RGBA8
+* layers with mipmaps. Layers are sampled in shaders with
+*   uniform sampler2DArray u_TextureArray;
+*   texture(u_TextureArray, vec3(uv, layer));
+*
+* Texture arrays are usually obtained from a TextureArrayManager, which packs
+* textures of any size into arrays and hands out (array, layer) handles.
+*/
+class TextureArray {
+private:
+  unsigned int m_rendererID;
+  unsigned int m_size;
+  unsigned int m_layerCount;
+  unsigned int m_mipLevelCount;
+public:
+  TextureArray() : m_rendererID(0), m_size(0), m_layerCount(0), m_mipLevelCount(0) {}
+  /* size must be a power of two, layers are uninitialized */
+  TextureArray(unsigned int size, unsigned int layerCount);
+  ~TextureArray();
+  TextureArray(TextureArray &&moved) noexcept;
+  TextureArray &operator=(TextureArray &&moved) noexcept;
+  TextureArray(const TextureArray &) = delete;
+  TextureArray &operator=(const TextureArray &) = delete;
+
+  void bind(unsigned int slot) const;
+  void destroy();
+
+  /* Fills a layer with size*size RGBA8 pixels and regenerates the mipmaps */
+  void setLayer(unsigned int layer, const unsigned char *pixels);
+  /* Reallocates the array with more layers, the content of the existing layers is kept (copied on the gpu) */
+  void resize(unsigned int layerCount);
+
+  unsigned int getSize() const { return m_size; }
+  unsigned int getLayerCount() const { return m_layerCount; }
+  unsigned int getId() const { return m_rendererID; } // unsafe
+};
+
+}
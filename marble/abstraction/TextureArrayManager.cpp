@@ -0,0 +1,99 @@
+#include "TextureArrayManager.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <stb/stb_image.h>
+
+namespace Renderer {
+
+// bilinear resampling of RGBA8 pixels, only used when textures are loaded
+static std::vector<unsigned char> resamplePixels(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int size)
+{
+  std::vector<unsigned char> resampled((size_t)size * size * 4);
+  for (unsigned int y = 0; y < size; y++) {
+    float sy = std::clamp((y + .5f) * height / size - .5f, 0.f, (float)(height - 1));
+    unsigned int y0 = (unsigned int)sy;
+    unsigned int y1 = std::min(y0 + 1, height - 1);
+    float ty = sy - y0;
+    for (unsigned int x = 0; x < size; x++) {
+      float sx = std::clamp((x + .5f) * width / size - .5f, 0.f, (float)(width - 1));
+      unsigned int x0 = (unsigned int)sx;
+      unsigned int x1 = std::min(x0 + 1, width - 1);
+      float tx = sx - x0;
+      for (unsigned int c = 0; c < 4; c++) {
+        float p00 = pixels[((size_t)y0 * width + x0) * 4 + c];
+        float p10 = pixels[((size_t)y0 * width + x1) * 4 + c];
+        float p01 = pixels[((size_t)y1 * width + x0) * 4 + c];
+        float p11 = pixels[((size_t)y1 * width + x1) * 4 + c];
+        float p = (p00 * (1 - tx) + p10 * tx) * (1 - ty) + (p01 * (1 - tx) + p11 * tx) * ty;
+        resampled[((size_t)y * size + x) * 4 + c] = (unsigned char)(p + .5f);
+      }
+    }
+  }
+  return resampled;
+}
+
+unsigned int TextureArrayManager::getNormalizedSize(unsigned int width, unsigned int height)
+{
+  unsigned int largestSide = std::max(width, height);
+  unsigned int size = MIN_TEXTURE_SIZE;
+  while (size < largestSide && size < MAX_TEXTURE_SIZE)
+    size <<= 1;
+  return size;
+}
+
+TextureHandle TextureArrayManager::loadTexture(const fs::path &path, unsigned int size)
+{
+  std::string key = path.string() + '@' + std::to_string(size);
+  if (auto loaded = m_loadedFiles.find(key); loaded != m_loadedFiles.end())
+    return loaded->second;
+
+  // same orientation as Texture
+  stbi_set_flip_vertically_on_load(1);
+  int width, height;
+  unsigned char *pixels = stbi_load(path.string().c_str(), &width, &height, nullptr, 4);
+  if (pixels == nullptr)
+    throw std::runtime_error("Failed to load texture '" + path.string() + "': " + stbi_failure_reason());
+  TextureHandle handle = addTexture(pixels, width, height, size);
+  stbi_image_free(pixels);
+
+  m_loadedFiles.emplace(std::move(key), handle);
+  return handle;
+}
+
+TextureHandle TextureArrayManager::addTexture(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int size)
+{
+  if (size == 0)
+    size = getNormalizedSize(width, height);
+  else if ((size & (size - 1)) != 0)
+    throw std::runtime_error("Texture array layers must have a power of two size, got " + std::to_string(size));
+  SizedArray &sizedArray = m_arrays[size];
+  if (sizedArray.array == nullptr)
+    sizedArray.array = std::make_shared<TextureArray>(size, INITIAL_LAYER_COUNT);
+  else if (sizedArray.usedLayers == sizedArray.array->getLayerCount())
+    sizedArray.array->resize(sizedArray.usedLayers * 2);
+
+  unsigned int layer = sizedArray.usedLayers++;
+  if (width == size && height == size) {
+    sizedArray.array->setLayer(layer, pixels);
+  } else {
+    std::vector<unsigned char> resampled = resamplePixels(pixels, width, height, size);
+    sizedArray.array->setLayer(layer, resampled.data());
+  }
+  return TextureHandle{ sizedArray.array, layer };
+}
+
+void TextureArrayManager::clear()
+{
+  m_arrays.clear();
+  m_loadedFiles.clear();
+}
+
+void TextureArrayManager::assignLayer(std::vector<BaseVertex> &vertices, const TextureHandle &texture)
+{
+  for (BaseVertex &vertex : vertices)
+    vertex.texId = (float)texture.layer;
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include "TextureArray.h"
+#include "Mesh.h"
+
+namespace Renderer {
+
+namespace fs = std::filesystem;
+
+/* A texture packed in a TextureArray, the layer is given to shaders through the texId vertex attribute */
+struct TextureHandle {
+  std::shared_ptr<TextureArray> array;
+  unsigned int                  layer;
+};
+
+/**
+* Packs textures into texture arrays so that meshes with different textures
+* can share a material (and be drawn without rebinding textures in between).
+*
+* Textures are resized to a square power of two size, the next power of two
+* of their largest side clamped to [MIN_TEXTURE_SIZE, MAX_TEXTURE_SIZE], or the
+* size given by the caller to gather textures of any size in one array. There
+* is one array per size, arrays grow geometrically when they are full, the
+* handles stay valid because the TextureArray object is kept and its storage
+* is replaced.
+*
+* The layer of a texture is written in the texId attribute of the vertices of
+* the models that use it, materials only reference the array (Material#textureArray)
+* and their shader samples it with the "color_texturearray.fs" mesh part. A
+* MaterialTable can be used instead to also give each mesh its own tint.
+*
+* Example usage:
+*   TextureHandle rock = manager.loadTexture("res/textures/rock.png");
+*   TextureArrayManager::assignLayer(rockVertices, rock);
+*   auto model = std::make_shared<Model>(rockVertices, rockIndices);
+*   sharedMaterial->textureArray = rock.array; // the same for every texture of that size
+*/
+class TextureArrayManager {
+public:
+  static constexpr unsigned int MIN_TEXTURE_SIZE = 16;
+  static constexpr unsigned int MAX_TEXTURE_SIZE = 2048;
+  static constexpr unsigned int INITIAL_LAYER_COUNT = 4;
+
+private:
+  struct SizedArray {
+    std::shared_ptr<TextureArray> array;
+    unsigned int                  usedLayers = 0;
+  };
+
+  std::map<unsigned int, SizedArray> m_arrays; // by layer size
+  std::unordered_map<std::string, TextureHandle> m_loadedFiles;
+
+public:
+  /*
+  * Loads an image file, loading the same file twice (at the same size) returns the same handle.
+  * size must be a power of two, 0 for the normalized size of the image (see #getNormalizedSize).
+  */
+  TextureHandle loadTexture(const fs::path &path, unsigned int size=0);
+  /* Adds width*height RGBA8 pixels, resized if needed */
+  TextureHandle addTexture(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int size=0);
+
+  /* Forgets the arrays and the loaded files, existing handles keep their array alive */
+  void clear();
+
+  size_t getArrayCount() const { return m_arrays.size(); }
+
+  static unsigned int getNormalizedSize(unsigned int width, unsigned int height);
+  /* Sets the texId attribute of the vertices to the layer of the texture */
+  static void assignLayer(std::vector<BaseVertex> &vertices, const TextureHandle &texture);
+};
+
+}
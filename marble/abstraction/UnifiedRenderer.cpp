@@ -14,17 +14,30 @@
 #include "Window.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "RenderDevice.h"
+#include "UniformBufferObject.h"
+#include "StreamBuffer.h"
+#include "LightBuffer.h"
+#include "ClusteredLights.h"
+#include "MaterialTable.h"
 #include "../Utils/Mathf.h"
+#include "../Utils/Profiler.h"
 
 #include "../World/Light/Light.h" // TODO move light.h to the abstraction package
                                   // abstraction should not depend on world, the inverse is possible
 
 namespace Renderer {
 
+// 3 regions of 8MB, large enough for the grass instance buffers to be refilled in a single frame
+static constexpr size_t STREAM_BUFFER_REGION_SIZE = 8 << 20;
+
 static struct KeepAliveResources {
   std::shared_ptr<Shader> standardMeshShader;
-  std::shared_ptr<Shader> standardLineShader;
-  std::shared_ptr<Shader> standardLightsShader;
+  std::shared_ptr<Shader> clusteredMeshShader; // the standard shader with the "lights_clustered.fs" part, of the FORWARD_PLUS state
+  std::shared_ptr<Shader> standardLineShader; // draws the batched debug lines
   std::shared_ptr<Shader> cubemapShader;
   std::shared_ptr<Shader> debugNormalsShader;
   std::shared_ptr<Shader> standardDepthPassShader;
@@ -37,17 +50,39 @@ static struct KeepAliveResources {
   VertexArray        cubemapVAO;
   VertexBufferObject cubemapVBO;
   IndexBufferObject  cubemapIBO;
-  VertexArray        lineVAO;
-  IndexBufferObject  lineIBO;
-  VertexBufferObject emptyVBO; // used by the line vao
-  VertexArray        debugUIQuadVAO;
-  VertexBufferObject debugUIQuadVBO;
+  VertexArray        lineVAO; // reads its vertices from the stream buffer
+  IndexBufferObject  emptyIBO; // used by the line vao
+  VertexArray        debugUIQuadVAO; // reads its vertices from the stream buffer
   IndexBufferObject  debugUIQuadIBO;
+  UniformBufferObject cameraBlockUBO;
+  StreamBuffer       streamBuffer;
+  LightBuffer        lightBuffer;
+  ClusteredLights    lightClusters; // used in the FORWARD_PLUS state
 } *s_keepAliveResources = nullptr;
 
+// one BaseInstance, the instance of VAOs drawn one mesh at a time. Created by the first
+// mesh instead of Renderer#init, meshes are built before it (the sky's, for example)
+static VertexBufferObject *s_identityInstanceBuffer = nullptr;
+
+struct DebugLineVertex {
+  glm::vec3 position;
+  glm::vec4 color;
+};
+
+/* Debug lines submitted from the same camera with the same depth test, drawn together by #flushDebugDraw */
+struct DebugLineBatch {
+  glm::mat4 VP;
+  bool      depthTested;
+  std::vector<DebugLineVertex> vertices;
+};
+
 static struct State {
   Shader *activeStandardShader;
   RenderingState renderingState;
+  std::vector<unsigned int> visibleIndices; // kept between frames to avoid reallocations
+  CameraBlock cameraBlock;     // last uploaded content of the camera block
+  bool isCameraBlockOutdated;  // time or fog changed since the last upload
+  std::vector<DebugLineBatch> debugLineBatches; // kept between frames, empty batches are reused
 } s_state;
 
 
@@ -58,11 +93,16 @@ void setRenderingState(RenderingState state)
         throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
 
     s_state.renderingState = state;
+    s_state.isCameraBlockOutdated = true; // FORWARD_PLUS assigns the clusters of the next uploaded camera
 
     switch (state) {
     case DEFERRED:
         s_state.activeStandardShader = s_keepAliveResources->deferredGeometryPass.get();
         break;
+    case FORWARD_PLUS:
+        // lights are assigned to the clusters of each camera and shaded per cluster
+        s_state.activeStandardShader = s_keepAliveResources->clusteredMeshShader.get();
+        break;
     default:
         s_state.activeStandardShader = s_keepAliveResources->standardMeshShader.get();
         break;
@@ -199,7 +239,7 @@ static void skipStreamText(std::istream &stream, const char *text)
 }
 
 // Move this somewhere else
-Mesh loadMeshFromFile(const fs::path& objPath)
+ObjFile readObjFile(const fs::path& objPath)
 {
     // TODO : read the MTL file, and try to find the correct filename for the materials
   std::ifstream modelFile{ objPath };
@@ -209,9 +249,7 @@ Mesh loadMeshFromFile(const fs::path& objPath)
   std::vector<glm::vec3> positions;
   std::vector<glm::vec3> normals;
   std::vector<glm::vec2> uvs;
-  std::unordered_map<int, std::shared_ptr<Texture>> slotsTextures = {
-      { 0, s_keepAliveResources->missingTextureTexture }
-  };
+  std::vector<std::string> texturePaths;
 
   std::unordered_map<std::string, std::string> cacheMatFile;
   std::vector<std::string> materials_slots;
@@ -333,39 +371,44 @@ Mesh loadMeshFromFile(const fs::path& objPath)
           }
       }
 
-      // Loop through the materials found in the obj file, and produce ptr to textures for each material
+      // Loop through the materials found in the obj file, and find the texture of each material
+      texturePaths.resize(materials_slots.size());
       for (int i = 0; i < materials_slots.size(); i++) {
 
           const std::string& material_name = materials_slots[i];
-            
-          std::shared_ptr<Texture> computed;
 
-          std::string texturePath;
           if (!material_texturefilepath_map.contains(material_name)) {
               std::cout << " === Warning : texture \" " << material_name << " \" has no texture in " + mtllib + " file !" << std::endl;
-              computed = std::make_shared<Texture>("res/textures/no_texture.png");
               continue;
           } 
           struct stat buffer;
-          texturePath = material_texturefilepath_map[material_name];;
+          std::string texturePath = material_texturefilepath_map[material_name];;
           if ((stat(texturePath.c_str(), &buffer) != 0)) {
               std::cout << " === Warning : Texture \" " << texturePath << " \" was not found ! " << std::endl;
-              computed = std::make_shared<Texture>("res/textures/no_texture.png");
+              texturePaths[i] = "res/textures/no_texture.png";
           } else {
-              computed = std::make_shared<Texture>(texturePath);
+              texturePaths[i] = texturePath;
           }
-
-          slotsTextures[i] = computed;
       }
 
   }
 
+  return ObjFile{ std::move(vertices), std::move(indices), std::move(texturePaths) };
+}
+
+Mesh loadMeshFromFile(const fs::path& objPath)
+{
+  ObjFile obj = readObjFile(objPath);
+
   auto material = std::make_shared<Material>();
-  auto model = std::make_shared<Model>(vertices, indices);
+  auto model = std::make_shared<Model>(obj.vertices, obj.indices);
 
   material->shader = getStandardMeshShader();
-  for (auto &[slot, texture] : slotsTextures)
-    material->textures[slot] = texture;
+  material->textures[0] = s_keepAliveResources->missingTextureTexture;
+  for (size_t slot = 0; slot < obj.texturePaths.size(); slot++) {
+    if (!obj.texturePaths[slot].empty())
+      material->textures[slot] = std::make_shared<Texture>(obj.texturePaths[slot]);
+  }
 
   return Mesh(model, material);
 }
@@ -375,18 +418,38 @@ const std::shared_ptr<Texture> &getMissingTexture()
   return s_keepAliveResources->missingTextureTexture;
 }
 
+void addIdentityInstance(VertexArray &vao)
+{
+  if (s_identityInstanceBuffer == nullptr) {
+    BaseInstance identityInstance;
+    s_identityInstanceBuffer = new VertexBufferObject(&identityInstance, sizeof(identityInstance));
+  }
+  // a non-instanced draw reads the first element of arrays with a divisor, like an instanced draw of one instance
+  vao.addInstanceBuffer(*s_identityInstanceBuffer, BaseInstance::getVertexBufferLayout(), BaseVertex::getVertexBufferLayout());
+}
+
 void clear()
 {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  getRenderDevice().clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void init()
 {
-  VertexBufferLayout emptyLayout;
   s_keepAliveResources = new KeepAliveResources;
 
   s_keepAliveResources->standardMeshShader = loadShaderFromFiles("res/shaders/standard.vs", "res/shaders/standard_color.fs"); // invalid shader
-  s_keepAliveResources->standardLineShader = loadShaderFromFiles("res/shaders/standard_line.vs", "res/shaders/standard_color.fs");
+  s_keepAliveResources->clusteredMeshShader = ShaderFactory()
+    .prefix("res/shaders/")
+    .addFileVertex("standard.vs")
+    .prefix("mesh_parts/")
+    .addFileFragment("base.fs")
+    .addFileFragment("color_terrain.fs")
+    .addFileFragment("lights_clustered.fs")
+    .addFileFragment("final_fog.fs")
+    .addFileFragment("shadows_normal.fs")
+    .addFileFragment("normal_none.fs")
+    .build();
+  s_keepAliveResources->standardLineShader = loadShaderFromFiles("res/shaders/standard_line.vs", "res/shaders/standard_line.fs");
   s_keepAliveResources->standardDepthPassShader = loadShaderFromFiles("res/shaders/depth_pass.vs", "res/shaders/depth_pass.fs");
   s_keepAliveResources->cubemapShader = loadShaderFromFiles("res/shaders/cubemap.vs", "res/shaders/cubemap.fs");
 
@@ -395,9 +458,6 @@ void init()
   
   s_keepAliveResources->missingTextureTexture = std::make_shared<Texture>("res/textures/no_texture.png");
 
-  s_keepAliveResources->lineIBO = IndexBufferObject({ 0, 1 });
-  s_keepAliveResources->lineVAO.addBuffer(s_keepAliveResources->emptyVBO, emptyLayout, s_keepAliveResources->lineIBO);
-
   s_keepAliveResources->debugCubeMesh = Mesh(createCubeModel(), std::make_shared<Material>());
   s_keepAliveResources->debugCubeMesh.getMaterial()->shader = loadShaderFromFiles("res/shaders/standard.vs", "res/shaders/standard_color.fs");
   s_keepAliveResources->debugNormalsShader = loadShaderFromFiles("res/shaders/standard.vs", "res/shaders/standard_color.fs");
@@ -437,26 +497,61 @@ void init()
     s_keepAliveResources->cubemapVAO.addBuffer(s_keepAliveResources->cubemapVBO, layout, s_keepAliveResources->cubemapIBO);
   }
 
+  s_keepAliveResources->streamBuffer = StreamBuffer(STREAM_BUFFER_REGION_SIZE);
+
   { // debugUIQuad setup
     std::array<unsigned int, 6> indices{ 3,2,0, 1,0,2 };
-    s_keepAliveResources->debugUIQuadVBO = VertexBufferObject(nullptr, sizeof(BaseVertex) * 12);
     s_keepAliveResources->debugUIQuadIBO = IndexBufferObject(indices.data(), indices.size());
-    s_keepAliveResources->debugUIQuadVAO.addBuffer(s_keepAliveResources->debugUIQuadVBO, BaseVertex::getVertexBufferLayout(), s_keepAliveResources->debugUIQuadIBO);
+    s_keepAliveResources->debugUIQuadVAO.addBuffer(s_keepAliveResources->streamBuffer.getId(), BaseVertex::getVertexBufferLayout(), s_keepAliveResources->debugUIQuadIBO);
   }
 
+  { // debug lines setup
+    VertexBufferLayout layout;
+    layout.push<float>(3); // position
+    layout.push<float>(4); // color
+    s_keepAliveResources->lineVAO.addBuffer(s_keepAliveResources->streamBuffer.getId(), layout, s_keepAliveResources->emptyIBO);
+  }
+
+  s_keepAliveResources->cameraBlockUBO = UniformBufferObject(sizeof(CameraBlock));
+  s_keepAliveResources->cameraBlockUBO.bindBase(CAMERA_BLOCK_BINDING);
+  s_state.cameraBlock = {};
+  s_state.isCameraBlockOutdated = true;
+  setFogParameters();
+
+  s_keepAliveResources->lightBuffer = LightBuffer(64);
+  s_keepAliveResources->lightBuffer.bind();
+  s_keepAliveResources->lightClusters.bind();
+
   s_state.renderingState = FORWARD;
   s_state.activeStandardShader = s_keepAliveResources->standardMeshShader.get();
 
   int samplers[8] = { 0,1,2,3,4,5,6,7 };
-  s_state.activeStandardShader->bind();
-  s_state.activeStandardShader->setUniform1iv("u_Textures2D", 8, samplers);
-  s_state.activeStandardShader->unbind();
+  for (Shader *shader : { s_keepAliveResources->standardMeshShader.get(), s_keepAliveResources->clusteredMeshShader.get() }) {
+    shader->bind();
+    shader->setUniform1iv("u_Textures2D"_uniform, 8, samplers);
+  }
+  Shader::unbind();
   VertexArray::unbind();
 }
 
 void shutdown()
 {
   delete s_keepAliveResources;
+  s_keepAliveResources = nullptr;
+  delete s_identityInstanceBuffer;
+  s_identityInstanceBuffer = nullptr;
+}
+
+StreamBuffer *getFrameStreamBuffer()
+{
+  return s_keepAliveResources == nullptr ? nullptr : &s_keepAliveResources->streamBuffer;
+}
+
+void endFrame()
+{
+  if (s_keepAliveResources == nullptr)
+    throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
+  s_keepAliveResources->streamBuffer.endFrame();
 }
 
 const std::shared_ptr<Shader> &rebuildStandardMeshShader(const ShaderFactory &builder)
@@ -470,29 +565,78 @@ const std::shared_ptr<Shader> &getStandardMeshShader()
 {
   if (s_keepAliveResources == nullptr)
     throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
+  if (s_state.renderingState == FORWARD_PLUS)
+    return s_keepAliveResources->clusteredMeshShader;
   return s_keepAliveResources->standardMeshShader;
 }
 
 void beginColorPass()
 {
-  glEnable(GL_MULTISAMPLE);
-  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-  s_state.activeStandardShader = s_keepAliveResources->standardMeshShader.get();
+  GLStateCache::setCapability(GL_MULTISAMPLE, true);
+  getRenderDevice().setColorMask(true);
+  s_state.activeStandardShader = getStandardMeshShader().get();
 }
 
 void beginDepthPass()
 {
-  glDisable(GL_MULTISAMPLE);
-  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);  // do not draw color during a depth pass
+  GLStateCache::setCapability(GL_MULTISAMPLE, false);
+  getRenderDevice().setColorMask(false);  // do not draw color during a depth pass
   s_state.activeStandardShader = s_keepAliveResources->standardDepthPassShader.get();
 }
 
+// meshes renderers leave their shader and VAO bound, binding the same ones again
+// for the next mesh is elided by the GLStateCache
 static inline void bindMaterial(const Material &material)
 {
   material.shader->bind();
   for (unsigned int i = 0; i < material.textures.size(); i++)
     if (material.textures[i])
       material.textures[i]->bind(i);
+  if (material.textureArray)
+    material.textureArray->bind(Material::TEXTURE_ARRAY_SLOT);
+  if (material.materialTable)
+    material.materialTable->bind();
+}
+
+void setFrameTime(float time)
+{
+  s_state.cameraBlock.time = time;
+  s_state.isCameraBlockOutdated = true;
+}
+
+void setFogParameters(const glm::vec3 &damping, const glm::vec3 &color)
+{
+  s_state.cameraBlock.fogDamping = damping;
+  s_state.cameraBlock.fogColor = color;
+  s_state.isCameraBlockOutdated = true;
+}
+
+// the camera block is uploaded once per view, drawing many meshes
+// with the same camera only compares the camera with the uploaded one
+static void uploadCameraBlock(const Camera &camera)
+{
+  CameraBlock &block = s_state.cameraBlock;
+  if (!s_state.isCameraBlockOutdated && block.VP == camera.getViewProjectionMatrix() && block.cameraPos == camera.getPosition())
+    return;
+  // lights are assigned to the clusters of a view once, not for each of its draws
+  if (s_state.renderingState == FORWARD_PLUS)
+    s_keepAliveResources->lightClusters.update(camera);
+  block.VP = camera.getViewProjectionMatrix();
+  block.V = camera.getViewMatrix();
+  block.P = camera.getProjectionMatrix();
+  block.cameraPos = camera.getPosition();
+  s_keepAliveResources->cameraBlockUBO.updateData(&block, sizeof(block));
+  s_state.isCameraBlockOutdated = false;
+}
+
+// shaders that do not declare the camera block still receive the camera as plain uniforms
+static inline void setCameraUniforms(Shader &shader, const Camera &camera)
+{
+  uploadCameraBlock(camera);
+  if (shader.usesUniformBlock(CAMERA_BLOCK_BINDING))
+    return;
+  shader.setUniform3f("u_cameraPos"_uniform, camera.getPosition());
+  shader.setUniformMat4f("u_VP"_uniform, camera.getViewProjectionMatrix());
 }
 
 static inline glm::mat4 transformToMMatrix(const Transform &transform)
@@ -516,14 +660,80 @@ void renderMesh(const Camera &camera, const Mesh &mesh)
   mesh.getVAO().bind();
   bindMaterial(material);
   // uniforms
-  shader.setUniform3f("u_cameraPos", camera.getPosition());
-  shader.setUniformMat4f("u_M", transformToMMatrix(mesh.getTransform()));
-  shader.setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
+  setCameraUniforms(shader, camera);
+  shader.setUniformMat4f("u_M"_uniform, transformToMMatrix(mesh.getTransform()));
   // draw call
-  glDrawElements(GL_TRIANGLES, mesh.getModel()->getVertexCount(), GL_UNSIGNED_INT, nullptr);
-  // unbind
-  VertexArray::unbind();
-  Shader::unbind();
+  getRenderDevice().drawElements(GL_TRIANGLES, mesh.getModel()->getVertexCount());
+}
+
+void renderQueue(RenderQueue &queue)
+{
+  MARBLE_PROFILE_SCOPE("Render queue");
+  queue.sort();
+
+  RenderQueue::Statistics stats{};
+  const Shader *boundShader = nullptr;
+  const Material *boundMaterial = nullptr;
+  const VertexArray *boundVAO = nullptr;
+  const Camera *boundCamera = nullptr;
+  unsigned int boundTextures[Material::TEXTURE_SLOT_COUNT];
+  std::fill_n(boundTextures, Material::TEXTURE_SLOT_COUNT, std::numeric_limits<unsigned int>::max()); // textures bound before the queue are unknown
+  unsigned int boundTextureArray = std::numeric_limits<unsigned int>::max();
+  unsigned int boundMaterialTable = std::numeric_limits<unsigned int>::max();
+
+  for (size_t i = 0; i < queue.getPacketCount(); i++) {
+    const RenderQueue::DrawPacket &packet = queue.getSortedPacket(i);
+    const Mesh &mesh = *packet.mesh;
+    const Material &material = *mesh.getMaterial();
+    Shader &shader = *material.shader;
+    s_debugData.meshCount++;
+    s_debugData.vertexCount += mesh.getModel()->getVertexCount();
+
+    // bindings, only the ones that changed since the previous packet
+    bool shaderChanged = &shader != boundShader;
+    if (shaderChanged) {
+      shader.bind();
+      boundShader = &shader;
+      stats.shaderBinds++;
+    }
+    if (&material != boundMaterial) {
+      for (unsigned int slot = 0; slot < Material::TEXTURE_SLOT_COUNT; slot++) {
+        if (material.textures[slot] && material.textures[slot]->getId() != boundTextures[slot]) {
+          material.textures[slot]->bind(slot);
+          boundTextures[slot] = material.textures[slot]->getId();
+          stats.textureBinds++;
+        }
+      }
+      if (material.textureArray && material.textureArray->getId() != boundTextureArray) {
+        material.textureArray->bind(Material::TEXTURE_ARRAY_SLOT);
+        boundTextureArray = material.textureArray->getId();
+        stats.textureBinds++;
+      }
+      if (material.materialTable && material.materialTable->getId() != boundMaterialTable) {
+        material.materialTable->bind();
+        boundMaterialTable = material.materialTable->getId();
+      }
+      boundMaterial = &material;
+      stats.materialBinds++;
+    }
+    if (&mesh.getVAO() != boundVAO) {
+      mesh.getVAO().bind();
+      boundVAO = &mesh.getVAO();
+      stats.vaoBinds++;
+    }
+    // uniforms, camera uniforms are kept by the shader (or the camera block) until the camera changes
+    if (shaderChanged || packet.camera != boundCamera) {
+      setCameraUniforms(shader, *packet.camera);
+      boundCamera = packet.camera;
+    }
+    shader.setUniformMat4f("u_M"_uniform, transformToMMatrix(mesh.getTransform()));
+    // draw call
+    getRenderDevice().drawElements(GL_TRIANGLES, mesh.getModel()->getVertexCount());
+    stats.drawCalls++;
+  }
+
+  queue.setLastStatistics(stats);
+  queue.clear();
 }
 
 void renderMeshInstanced(const Camera &camera, const InstancedMesh &mesh)
@@ -543,43 +753,49 @@ void renderMeshInstanced(const Camera &camera, const InstancedMesh &mesh, size_t
   // bindings
   mesh.getVAO().bind();
   bindMaterial(material);
-  // uniforms
-  shader.setUniform3f("u_cameraPos", camera.getPosition());
-  shader.setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
+  // uniforms, instances of shaders that have a model matrix are already in world space
+  setCameraUniforms(shader, camera);
+  if (shader.hasUniform("u_M"_uniform))
+    shader.setUniformMat4f("u_M"_uniform, glm::mat4(1.f));
   // draw call
-  glDrawElementsInstanced(GL_TRIANGLES, mesh.getModel()->getVertexCount(), GL_UNSIGNED_INT, nullptr, (GLsizei)instanceCount);
-  // unbind
-  VertexArray::unbind();
-  Shader::unbind();
-  
+  getRenderDevice().drawElementsInstanced(GL_TRIANGLES, mesh.getModel()->getVertexCount(), (int)instanceCount);
 }
 
-void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh)
+// draws the chunks listed in s_state.visibleIndices
+static void renderTerrainChunks(const Camera &camera, const TerrainMesh &mesh, const OcclusionBuffer *occlusion)
 {
+  MARBLE_PROFILE_SCOPE("Terrain");
   s_debugData.meshCount++;
   Material &material = *mesh.getMaterial();
   Shader &shader = *material.shader;
-  Frustum frustum = Frustum::createFrustumFromCamera(camera);
   
   // bindings
   bindMaterial(material);
   // uniforms
-  shader.setUniform3f("u_cameraPos", camera.getPosition());
-  shader.setUniformMat4f("u_M", transformToMMatrix(mesh.getTransform()));
-  shader.setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
+  setCameraUniforms(shader, camera);
+  shader.setUniformMat4f("u_M"_uniform, transformToMMatrix(mesh.getTransform()));
 
-  for (const TerrainMesh::Chunk &chunk : mesh.getChunks()) {
-    if (!frustum.isOnFrustum(chunk.worldBoundingBox))
+  for (unsigned int chunkIndex : s_state.visibleIndices) {
+    const TerrainMesh::Chunk &chunk = mesh.getChunks()[chunkIndex];
+    if (occlusion && !occlusion->isVisible(chunk.worldBoundingBox))
       continue;
     // draw call
     chunk.vao.bind();
-    glDrawElements(GL_TRIANGLES, (int)mesh.getIBO().getCount(), GL_UNSIGNED_INT, nullptr);
+    getRenderDevice().drawElements(GL_TRIANGLES, (int)mesh.getIBO().getCount());
     s_debugData.vertexCount += mesh.getIBO().getCount();
   }
+}
 
-  // unbind
-  VertexArray::unbind();
-  Shader::unbind();
+void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh, const OcclusionBuffer *occlusion)
+{
+  mesh.getChunksCulling().cull(Frustum::createFrustumFromCamera(camera), s_state.visibleIndices);
+  renderTerrainChunks(camera, mesh, occlusion);
+}
+
+void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh, const CullingSystem::VisibilityBitset &visibleChunks, const OcclusionBuffer *occlusion)
+{
+  CullingSystem::collectVisibleIndices(visibleChunks, s_state.visibleIndices);
+  renderTerrainChunks(camera, mesh, occlusion);
 }
 
 void renderNormalsMesh(const Camera &camera, const glm::vec3 &position, const glm::vec3 &size, const NormalsMesh &normalsMesh, const glm::vec4 &color)
@@ -591,9 +807,9 @@ void renderNormalsMesh(const Camera &camera, const glm::vec3 &position, const gl
   M = glm::translate(M, position);
   M = glm::scale(M, size);
   s_keepAliveResources->debugNormalsShader->bind();
-  s_keepAliveResources->debugNormalsShader->setUniform4f("u_color", color);
-  s_keepAliveResources->debugNormalsShader->setUniformMat4f("u_M", M);
-  s_keepAliveResources->debugNormalsShader->setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
+  s_keepAliveResources->debugNormalsShader->setUniform4f("u_color"_uniform, color);
+  s_keepAliveResources->debugNormalsShader->setUniformMat4f("u_M"_uniform, M);
+  setCameraUniforms(*s_keepAliveResources->debugNormalsShader, camera);
   normalsMesh.draw();
 }
 
@@ -603,8 +819,8 @@ void renderCubemap(const Camera &camera, const Cubemap &cubemap)
 {
   s_keepAliveResources->cubemapVAO.bind();
   s_keepAliveResources->cubemapShader->bind();
-  s_keepAliveResources->cubemapShader->setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
-  s_keepAliveResources->cubemapShader->setUniform3f("u_displacement", camera.getPosition());
+  s_keepAliveResources->cubemapShader->setUniformMat4f("u_VP"_uniform, camera.getViewProjectionMatrix());
+  s_keepAliveResources->cubemapShader->setUniform3f("u_displacement"_uniform, camera.getPosition());
   cubemap.bind();
 
   /*
@@ -617,40 +833,95 @@ void renderCubemap(const Camera &camera, const Cubemap &cubemap)
   the shader should not set the screen position to 1 but rather to gl_Position.w
   */
 
-  glDepthFunc(GL_LEQUAL);
-  glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
-  glDepthFunc(GL_LESS);
+  GLStateCache::setDepthFunc(GL_LEQUAL);
+  getRenderDevice().drawElements(GL_TRIANGLES, 36);
+  GLStateCache::setDepthFunc(GL_LESS);
 
   VertexArray::unbind();
   Shader::unbind();
 }
 
-void renderDebugLine(const Camera &camera, const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color)
+// returns the vertices of the batch of lines seen from the given camera with the current depth test
+static std::vector<DebugLineVertex> &getDebugLineBatch(const Camera &camera)
+{
+  const glm::mat4 &VP = camera.getViewProjectionMatrix();
+  bool depthTested = GLStateCache::isCapabilityEnabled(GL_DEPTH_TEST);
+  DebugLineBatch *unusedBatch = nullptr;
+  for (DebugLineBatch &batch : s_state.debugLineBatches) {
+    if (batch.vertices.empty()) {
+      if (unusedBatch == nullptr)
+        unusedBatch = &batch;
+    } else if (batch.depthTested == depthTested && batch.VP == VP) {
+      return batch.vertices;
+    }
+  }
+  if (unusedBatch == nullptr)
+    unusedBatch = &s_state.debugLineBatches.emplace_back();
+  unusedBatch->VP = VP;
+  unusedBatch->depthTested = depthTested;
+  return unusedBatch->vertices;
+}
+
+static inline void pushDebugLine(std::vector<DebugLineVertex> &vertices, const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color)
 {
+  vertices.push_back({ from, color });
+  vertices.push_back({ to, color });
   s_debugData.debugLines++;
   s_debugData.vertexCount += 2;
+}
+
+void renderDebugLine(const Camera &camera, const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color)
+{
+  pushDebugLine(getDebugLineBatch(camera), from, to, color);
+}
+
+void flushDebugDraw()
+{
+  if (s_keepAliveResources == nullptr)
+    return;
+  if (std::all_of(s_state.debugLineBatches.begin(), s_state.debugLineBatches.end(), [](const DebugLineBatch &batch) { return batch.vertices.empty(); }))
+    return;
+
+  StreamBuffer &stream = s_keepAliveResources->streamBuffer;
+  Shader &shader = *s_keepAliveResources->standardLineShader;
+  // a batch larger than a stream buffer region is drawn in several parts, each of an even number of vertices
+  size_t maxVerticesPerDraw = (stream.getRegionSize() / 2 / sizeof(DebugLineVertex)) & ~(size_t)1;
+  bool wasDepthTested = GLStateCache::isCapabilityEnabled(GL_DEPTH_TEST);
+
+  shader.bind();
   s_keepAliveResources->lineVAO.bind();
-  s_keepAliveResources->standardLineShader->bind();
-  s_keepAliveResources->standardLineShader->setUniform3f("u_from", from);
-  s_keepAliveResources->standardLineShader->setUniform3f("u_to", to);
-  s_keepAliveResources->standardLineShader->setUniform4f("u_color", color);
-  s_keepAliveResources->standardLineShader->setUniformMat4f("u_VP", camera.getViewProjectionMatrix());
-  glDrawElements(GL_LINES, 2, GL_UNSIGNED_INT, nullptr);
+  for (DebugLineBatch &batch : s_state.debugLineBatches) {
+    if (batch.vertices.empty())
+      continue;
+    GLStateCache::setCapability(GL_DEPTH_TEST, batch.depthTested);
+    shader.setUniformMat4f("u_VP"_uniform, batch.VP);
+    for (size_t first = 0; first < batch.vertices.size(); first += maxVerticesPerDraw) {
+      size_t count = std::min(maxVerticesPerDraw, batch.vertices.size() - first);
+      // the vertices are aligned on their size so that they can be addressed by the first vertex index
+      StreamBuffer::Allocation allocation = stream.allocate(count * sizeof(DebugLineVertex), sizeof(DebugLineVertex));
+      std::memcpy(allocation.data, batch.vertices.data() + first, count * sizeof(DebugLineVertex));
+      getRenderDevice().drawArrays(GL_LINES, (int)(allocation.offset / sizeof(DebugLineVertex)), (int)count);
+      s_debugData.debugDrawCalls++;
+    }
+    batch.vertices.clear();
+  }
+  GLStateCache::setCapability(GL_DEPTH_TEST, wasDepthTested);
 }
 
 void renderDebugCube(const Camera &camera, const glm::vec3 &position, const glm::vec3 &size, const glm::vec4 &color)
 {
   s_keepAliveResources->debugCubeMesh.setTransform({ position, size });
   s_keepAliveResources->debugCubeMesh.getMaterial()->shader->bind();
-  s_keepAliveResources->debugCubeMesh.getMaterial()->shader->setUniform4f("u_color", color);
+  s_keepAliveResources->debugCubeMesh.getMaterial()->shader->setUniform4f("u_color"_uniform, color);
   renderMesh(camera, s_keepAliveResources->debugCubeMesh);
 }
 
 void renderDebugAxis(const Camera &camera)
 {
-  renderDebugLine(camera, { 0, 0, 0 }, { 10, 0, 0 }, { 1.f, 0.f, 0.f, 1.f }); // x red
-  renderDebugLine(camera, { 0, 0, 0 }, { 0, 10, 0 }, { 0.f, 1.f, 0.f, 1.f }); // y green
-  renderDebugLine(camera, { 0, 0, 0 }, { 0, 0, 10 }, { 0.f, 0.f, 1.f, 1.f }); // z blue
+  std::vector<DebugLineVertex> &vertices = getDebugLineBatch(camera);
+  pushDebugLine(vertices, { 0, 0, 0 }, { 10, 0, 0 }, { 1.f, 0.f, 0.f, 1.f }); // x red
+  pushDebugLine(vertices, { 0, 0, 0 }, { 0, 10, 0 }, { 0.f, 1.f, 0.f, 1.f }); // y green
+  pushDebugLine(vertices, { 0, 0, 0 }, { 0, 0, 10 }, { 0.f, 0.f, 1.f, 1.f }); // z blue
 }
 
 
@@ -660,18 +931,19 @@ void renderAABBDebugOutline(const Camera &camera, const AABB &aabb, const glm::v
   glm::vec3 x = { aabb.getSize().x, 0, 0 };
   glm::vec3 y = { 0, aabb.getSize().y, 0 };
   glm::vec3 z = { 0, 0, aabb.getSize().z };
-  renderDebugLine(camera, o, o + x, color);
-  renderDebugLine(camera, o + y, o + x + y, color);
-  renderDebugLine(camera, o + z, o + x + z, color);
-  renderDebugLine(camera, o + y + z, o + x + y + z, color);
-  renderDebugLine(camera, o, o + y, color);
-  renderDebugLine(camera, o + x, o + y + x, color);
-  renderDebugLine(camera, o + z, o + y + z, color);
-  renderDebugLine(camera, o + x + z, o + y + x + z, color);
-  renderDebugLine(camera, o, o + z, color);
-  renderDebugLine(camera, o + x, o + z + x, color);
-  renderDebugLine(camera, o + y, o + z + y, color);
-  renderDebugLine(camera, o + x + y, o + z + x + y, color);
+  std::vector<DebugLineVertex> &vertices = getDebugLineBatch(camera);
+  pushDebugLine(vertices, o, o + x, color);
+  pushDebugLine(vertices, o + y, o + x + y, color);
+  pushDebugLine(vertices, o + z, o + x + z, color);
+  pushDebugLine(vertices, o + y + z, o + x + y + z, color);
+  pushDebugLine(vertices, o, o + y, color);
+  pushDebugLine(vertices, o + x, o + y + x, color);
+  pushDebugLine(vertices, o + z, o + y + z, color);
+  pushDebugLine(vertices, o + x + z, o + y + x + z, color);
+  pushDebugLine(vertices, o, o + z, color);
+  pushDebugLine(vertices, o + x, o + z + x, color);
+  pushDebugLine(vertices, o + y, o + z + y, color);
+  pushDebugLine(vertices, o + x + y, o + z + x + y, color);
 }
 
 static void renderDebugOrthographicCameraOutline(const Camera &viewCamera, const Camera &outlinedCamera)
@@ -683,24 +955,25 @@ static void renderDebugOrthographicCameraOutline(const Camera &viewCamera, const
   glm::vec3 F = outlinedCamera.getForward();
   float zNear = proj.zNear;
   float zFar = proj.zFar;
+  std::vector<DebugLineVertex> &vertices = getDebugLineBatch(viewCamera);
   glm::vec3 p1 = pos + I * proj.right + J * proj.top;
   glm::vec3 p2 = pos + I * proj.right - J * proj.top;
   glm::vec3 p3 = pos - I * proj.right - J * proj.top;
   glm::vec3 p4 = pos - I * proj.right + J * proj.top;
 
-  renderDebugLine(viewCamera, pos, pos + F * zFar, { 1.f, 0.f, .0f, 1.f }); // dir
-  renderDebugLine(viewCamera, pos, pos + Camera::UP, { 1.f, 1.f, .3f, 1.f }); // world up
-  renderDebugLine(viewCamera, pos, pos + I, { .5f, 1.f, .5f, 1.f }); // right
-  renderDebugLine(viewCamera, pos, pos + J, { 1.f, .5f, .5f, 1.f }); // up
-  renderDebugLine(viewCamera, p1, p1 + F * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, p2, p2 + F * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, p3, p3 + F * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, p4, p4 + F * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos, pos + F * zFar, { 1.f, 0.f, .0f, 1.f }); // dir
+  pushDebugLine(vertices, pos, pos + Camera::UP, { 1.f, 1.f, .3f, 1.f }); // world up
+  pushDebugLine(vertices, pos, pos + I, { .5f, 1.f, .5f, 1.f }); // right
+  pushDebugLine(vertices, pos, pos + J, { 1.f, .5f, .5f, 1.f }); // up
+  pushDebugLine(vertices, p1, p1 + F * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, p2, p2 + F * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, p3, p3 + F * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, p4, p4 + F * zFar, { .5f, .5f, .5f, 1.f });
   for (float z = zNear; z < zFar; z += 5) {
-    renderDebugLine(viewCamera, p1 + z * F, p2 + z * F, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, p2 + z * F, p3 + z * F, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, p3 + z * F, p4 + z * F, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, p4 + z * F, p1 + z * F, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, p1 + z * F, p2 + z * F, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, p2 + z * F, p3 + z * F, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, p3 + z * F, p4 + z * F, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, p4 + z * F, p1 + z * F, { .5f, .5f, .5f, 1.f });
   }
   renderDebugCube(viewCamera, pos, { .1f, .1f, .1f });
 }
@@ -721,24 +994,25 @@ static void renderDebugPerspectiveCameraOutline(const Camera &viewCamera, const
   glm::vec3 U4 = F + dh * J - dw * I;
   float zNear = proj.zNear;
   float zFar = proj.zFar;
-
-  renderDebugLine(viewCamera, pos, pos + F * zFar, { 1.f, 0.f, .0f, 1.f }); // dir
-  renderDebugLine(viewCamera, pos, pos + Camera::UP, { 1.f, 1.f, .3f, 1.f }); // world up
-  renderDebugLine(viewCamera, pos, pos + I, { .5f, 1.f, .5f, 1.f }); // right
-  renderDebugLine(viewCamera, pos, pos + J, { 1.f, .5f, .5f, 1.f }); // up
-  renderDebugLine(viewCamera, pos, pos + U1 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos, pos + U2 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos, pos + U3 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos, pos + U4 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos + U1 * zFar, pos + U2 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos + U2 * zFar, pos + U3 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos + U3 * zFar, pos + U4 * zFar, { .5f, .5f, .5f, 1.f });
-  renderDebugLine(viewCamera, pos + U4 * zFar, pos + U1 * zFar, { .5f, .5f, .5f, 1.f });
+  std::vector<DebugLineVertex> &vertices = getDebugLineBatch(viewCamera);
+
+  pushDebugLine(vertices, pos, pos + F * zFar, { 1.f, 0.f, .0f, 1.f }); // dir
+  pushDebugLine(vertices, pos, pos + Camera::UP, { 1.f, 1.f, .3f, 1.f }); // world up
+  pushDebugLine(vertices, pos, pos + I, { .5f, 1.f, .5f, 1.f }); // right
+  pushDebugLine(vertices, pos, pos + J, { 1.f, .5f, .5f, 1.f }); // up
+  pushDebugLine(vertices, pos, pos + U1 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos, pos + U2 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos, pos + U3 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos, pos + U4 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos + U1 * zFar, pos + U2 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos + U2 * zFar, pos + U3 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos + U3 * zFar, pos + U4 * zFar, { .5f, .5f, .5f, 1.f });
+  pushDebugLine(vertices, pos + U4 * zFar, pos + U1 * zFar, { .5f, .5f, .5f, 1.f });
   for (float z = zNear; z < zFar; z += 5) {
-    renderDebugLine(viewCamera, pos + U1 * z, pos + U2 * z, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, pos + U2 * z, pos + U3 * z, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, pos + U3 * z, pos + U4 * z, { .5f, .5f, .5f, 1.f });
-    renderDebugLine(viewCamera, pos + U4 * z, pos + U1 * z, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, pos + U1 * z, pos + U2 * z, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, pos + U2 * z, pos + U3 * z, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, pos + U3 * z, pos + U4 * z, { .5f, .5f, .5f, 1.f });
+    pushDebugLine(vertices, pos + U4 * z, pos + U1 * z, { .5f, .5f, .5f, 1.f });
   }
   renderDebugCube(viewCamera, pos, { .1f, .1f, .1f });
 }
@@ -766,38 +1040,43 @@ void renderDebugGUIQuadWithTexture(const Texture& texture, glm::vec2 positionOnS
     BaseVertex{ { positionOnScreen.x + size.x, positionOnScreen.y,          0.f }, { 0.f, 1.f }, { 0, 1.f, 0 }, {1.0f, 1.0f, 0.0f}, },
   };
 
-  s_keepAliveResources->debugUIQuadVAO.bind();
-  s_keepAliveResources->debugUIQuadVBO.updateData(vertices.data(), sizeof(vertices));
+  // the vertices are aligned on their size so that they can be addressed by the base vertex
+  StreamBuffer::Allocation allocation = s_keepAliveResources->streamBuffer.allocate(sizeof(vertices), sizeof(BaseVertex));
+  std::memcpy(allocation.data, vertices.data(), sizeof(vertices));
 
+  s_keepAliveResources->debugUIQuadVAO.bind();
   texture.bind(0);
   s_keepAliveResources->debugFlatScreenShader->bind();
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+  getRenderDevice().drawElements(GL_TRIANGLES, 6, (int)(allocation.offset / sizeof(BaseVertex)));
 }
 
-// This method should be somewhere else / WIP
 void setUniformPointLights(const std::vector<Light>& pointLights)
 {
-    s_keepAliveResources->standardLightsShader->bind();
-    s_keepAliveResources->standardLightsShader->setUniform1i("u_numberOfLights", (int)pointLights.size());
-
-    for (int i = 0; i < pointLights.size(); i++) {
-        const Light& light = pointLights.at(i);
-
-        std::stringstream ss{ std::string() };
-        ss << "u_lights[";
-        ss << i;
-        ss << "].";
-        std::string lightInShader = ss.str();
-        s_keepAliveResources->standardLightsShader->setUniform1i(lightInShader + "on", light.isOn());
-        s_keepAliveResources->standardLightsShader->setUniform3f(lightInShader + "position", light.getPosition());
-        s_keepAliveResources->standardLightsShader->setUniform1f(lightInShader + "constant", light.getCoefs().constant);
-        s_keepAliveResources->standardLightsShader->setUniform1f(lightInShader + "linear", light.getCoefs().linear);
-        s_keepAliveResources->standardLightsShader->setUniform1f(lightInShader + "quadratic", light.getCoefs().quadratic);
-        s_keepAliveResources->standardLightsShader->setUniform3f(lightInShader + "ambient", light.getParams().ambiant);
-        s_keepAliveResources->standardLightsShader->setUniform3f(lightInShader + "diffuse", light.getParams().diffuse);
-        s_keepAliveResources->standardLightsShader->setUniform3f(lightInShader + "specular", light.getParams().specular);
+    if (s_keepAliveResources == nullptr)
+        throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
+
+    // kept between calls to avoid reallocations
+    static std::vector<PackedPointLight> s_packedLights;
+    s_packedLights.clear();
+    for (const Light &light : pointLights) {
+        auto coefs = light.getCoefs();
+        s_packedLights.push_back({
+          glm::vec4(light.getPosition(), light.getDistance()),
+          glm::vec4(light.getParams().ambiant, 0),
+          glm::vec4(light.getParams().diffuse, 0),
+          glm::vec4(light.getParams().specular, 0),
+          glm::vec4(coefs.constant, coefs.linear, coefs.quadratic, light.isOn() ? 1.f : 0.f),
+        });
     }
-    Shader::unbind();
+    s_keepAliveResources->lightBuffer.setLights(s_packedLights);
+    s_keepAliveResources->lightClusters.setLights(s_packedLights);
+    s_state.isCameraBlockOutdated = true; // the clusters are re-assigned with the next camera upload
+}
+
+const LightBuffer &getLightBuffer() {
+    if (s_keepAliveResources == nullptr)
+        throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
+    return s_keepAliveResources->lightBuffer;
 }
 
 //=========================================================================================================================//
@@ -809,12 +1088,19 @@ void clearDebugData() {
   s_debugData.meshCount = 0;
   s_debugData.vertexCount = 0;
   s_debugData.debugLines = 0;
+  s_debugData.debugDrawCalls = 0;
 }
 
 const DebugData& getRendererDebugData() {
   return s_debugData;
 }
 
+const ClusteredLights &getLightClusters() {
+    if (s_keepAliveResources == nullptr)
+        throw std::runtime_error("Cannot fetch resources until the renderer is initialized");
+    return s_keepAliveResources->lightClusters;
+}
+
 RenderingState getCurrentRenderingState() {
     return s_state.renderingState;
 }
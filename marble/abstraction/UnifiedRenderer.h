@@ -8,6 +8,8 @@
 #include "Texture.h"
 #include "Camera.h"
 #include "Cubemap.h"
+#include "LightBuffer.h"
+#include "ClusteredLights.h"
 #include "../Utils/AABB.h"
 #include "../World/Light/Light.h"
 
@@ -38,10 +40,14 @@ namespace Renderer {
     
 namespace fs = std::filesystem;
 
+class OcclusionBuffer;
+class RenderQueue;
+
 static struct DebugData {
   size_t vertexCount;
   size_t meshCount;
   size_t debugLines;
+  size_t debugDrawCalls;
 } s_debugData;
 
 
@@ -60,6 +66,14 @@ std::shared_ptr<Shader> loadShaderFromFiles(const fs::path &vertexPath, const fs
 std::shared_ptr<Model> createCubeModel();
 std::shared_ptr<Model> createPlaneModel(bool facingDown=false);
 std::shared_ptr<Model> createSphereModel(int resolution=10);
+/* The content of an obj file, the texId of each vertex is the index of its material (usemtl) in the file */
+struct ObjFile {
+  std::vector<BaseVertex>   vertices;
+  std::vector<unsigned int> indices;
+  std::vector<std::string>  texturePaths; // by material, empty if the material has no texture
+};
+ObjFile readObjFile(const fs::path &objPath);
+/* Reads an obj file, the textures of its materials are bound to the slot of the material */
 Mesh loadMeshFromFile(const fs::path &objPath);
 const std::shared_ptr<Texture> &getMissingTexture();
 
@@ -67,29 +81,51 @@ void clear();
 
 void init();
 void shutdown();
+/* Must be called once per frame, after the last draw call, releases the transient allocations of the stream buffer */
+void endFrame();
 void clearDebugData();
 const DebugData& getRendererDebugData();
 
 const std::shared_ptr<Shader> &rebuildStandardMeshShader(const ShaderFactory &builder);
+/* The standard shader of the current rendering state, in the FORWARD_PLUS state it shades the lights of its cluster */
 const std::shared_ptr<Shader> &getStandardMeshShader();
 /* Disables color drawing and switches the standard Model shader to an empty one */
 void beginColorPass();
 /* Enables color drawing and restores the standard Model shader */
 void beginDepthPass();
 
+/* Time and fog are given to shaders through the camera block (see UniformBlocks.h) */
+void setFrameTime(float time);
+void setFogParameters(const glm::vec3 &damping={ .001f, .001f, .001f }, const glm::vec3 &color={ .71f, .86f, 1.f });
+
 void renderMesh(const Camera &camera, const Mesh &mesh);
+/* Sorts the packets of the queue to minimize state changes, draws them and clears the queue */
+void renderQueue(RenderQueue &queue);
 void renderMeshInstanced(const Camera &camera, const InstancedMesh &mesh);
 void renderMeshInstanced(const Camera &camera, const InstancedMesh &mesh, size_t instanceCount);
-void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh);
+/* Chunks hidden by the occluders of the given occlusion buffer are not drawn, it must be rasterized from the same camera */
+void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh, const OcclusionBuffer *occlusion = nullptr);
+/* Same as above but chunks were already culled, typically by a MultiViewCulling, bit i is set iff chunk i is visible */
+void renderMeshTerrain(const Camera &camera, const TerrainMesh &mesh, const CullingSystem::VisibilityBitset &visibleChunks, const OcclusionBuffer *occlusion = nullptr);
 void renderNormalsMesh(const Camera &camera, const glm::vec3 &position, const glm::vec3 &size, const NormalsMesh &normalsModel, const glm::vec4 &color={ 1,0,0,1 });
 void renderCubemap(const Camera &camera, const Cubemap &cubemap);
+/*
+ * Debug lines (and outlines) are not drawn immediately, they are batched by camera and depth test state (enabled when
+ * they are submitted) and drawn by #flushDebugDraw with one draw call per batch. Binding a framebuffer flushes them.
+ */
 void renderDebugLine(const Camera &camera, const glm::vec3 &from, const glm::vec3 &to, const glm::vec4 &color={1.f, 1.f, 1.f, 1.f});
 void renderDebugCube(const Camera &camera, const glm::vec3 &position, const glm::vec3 &size={1.f, 1.f, 1.f}, const glm::vec4 &color={1.f, 1.f, 1.f, 1.f});
 void renderDebugAxis(const Camera &camera);
 void renderAABBDebugOutline(const Camera &camera, const AABB &aabb, const glm::vec4 &color = { 1.f, 1.f, 0.f, 1.f });
 void renderDebugCameraOutline(const Camera &viewCamera, const Camera &outlinedCamera);
 void renderDebugGUIQuadWithTexture(const Texture& texture, glm::vec2 positionOnScreen, glm::vec2 size);
+/* Draws the debug lines submitted since the last flush in the currently bound framebuffer */
+void flushDebugDraw();
 
+/* Writes the lights in the light buffer shared by all lighting shaders, only the lights that changed since the last call are uploaded */
 void setUniformPointLights(const std::vector<Light>& pointLights);
+const LightBuffer &getLightBuffer();
+/* Clusters of the last camera used in the FORWARD_PLUS state */
+const ClusteredLights &getLightClusters();
 
 }
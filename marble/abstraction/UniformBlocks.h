@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Std140.h"
+
+/**
+* Uniform blocks shared by many shaders. Each block has a fixed binding point,
+* when a shader program is built the blocks it declares are attached to their
+* binding point (see ShaderFactory#build) and the renderer keeps one uniform
+* buffer bound to each point.
+*
+* A shader that declares a block must declare it exactly as written in the
+* comment of its C++ struct, the layout is always std140.
+*
+* Shader storage buffers (std430, #version 430 shaders only) are declared with
+* their binding in GLSL, the bindings are listed in ShaderStorageBinding.
+*/
+namespace Renderer {
+
+enum UniformBlockBinding : unsigned int {
+  CAMERA_BLOCK_BINDING = 0,
+  CLUSTER_BLOCK_BINDING = 1,
+};
+
+// bindings 0 to 3 are used temporarily by the grass compute shaders
+enum ShaderStorageBinding : unsigned int {
+  POINT_LIGHTS_STORAGE_BINDING = 4,          // see LightBuffer
+  LIGHT_CLUSTERS_STORAGE_BINDING = 5,        // see ClusteredLights
+  LIGHT_CLUSTER_INDICES_STORAGE_BINDING = 6,
+  VISIBLE_LIGHTS_STORAGE_BINDING = 7,        // see LightVolumes
+  MATERIALS_STORAGE_BINDING = 8,             // see MaterialTable
+};
+
+/**
+* Per-view data, uploaded once each time the renderer draws from a different
+* camera (or when time/fog change), per draw uniforms are then only u_M.
+*
+* GLSL declaration:
+*   layout(std140) uniform CameraBlock {
+*     mat4  u_VP;
+*     mat4  u_V;
+*     mat4  u_P;
+*     vec3  u_cameraPos;
+*     float u_time;
+*     vec3  u_fogDamping;
+*     vec3  u_fogColor;
+*   };
+*/
+struct CameraBlock {
+  glm::mat4 VP;
+  glm::mat4 V;
+  glm::mat4 P;
+  glm::vec3 cameraPos;
+  float     time;
+  alignas(16) glm::vec3 fogDamping;
+  alignas(16) glm::vec3 fogColor;
+
+  using Layout = Std140::Layout<glm::mat4, glm::mat4, glm::mat4, glm::vec3, float, glm::vec3, glm::vec3>;
+};
+
+static_assert(offsetof(CameraBlock, VP)         == CameraBlock::Layout::offsetOf(0));
+static_assert(offsetof(CameraBlock, V)          == CameraBlock::Layout::offsetOf(1));
+static_assert(offsetof(CameraBlock, P)          == CameraBlock::Layout::offsetOf(2));
+static_assert(offsetof(CameraBlock, cameraPos)  == CameraBlock::Layout::offsetOf(3));
+static_assert(offsetof(CameraBlock, time)       == CameraBlock::Layout::offsetOf(4));
+static_assert(offsetof(CameraBlock, fogDamping) == CameraBlock::Layout::offsetOf(5));
+static_assert(offsetof(CameraBlock, fogColor)   == CameraBlock::Layout::offsetOf(6));
+static_assert(sizeof(CameraBlock)               == CameraBlock::Layout::SIZE);
+
+/**
+* Froxel grid of the clustered lights (see ClusteredLights), the cluster of a
+* fragment is found from its normalized device coordinates and view depth:
+*   tile  = ndc.xy*.5+.5 * u_clusterCount.xy
+*   slice = log(viewDepth) * u_clusterDepthScale + u_clusterDepthBias
+*
+* GLSL declaration:
+*   layout(std140) uniform ClusterBlock {
+*     ivec4 u_clusterCount;
+*     float u_clusterDepthScale;
+*     float u_clusterDepthBias;
+*   };
+*/
+struct alignas(16) ClusterBlock {
+  glm::ivec4 clusterCount; // x, y, z, unused
+  float      depthScale;
+  float      depthBias;
+
+  using Layout = Std140::Layout<glm::ivec4, float, float>;
+};
+
+static_assert(offsetof(ClusterBlock, clusterCount) == ClusterBlock::Layout::offsetOf(0));
+static_assert(offsetof(ClusterBlock, depthScale)   == ClusterBlock::Layout::offsetOf(1));
+static_assert(offsetof(ClusterBlock, depthBias)    == ClusterBlock::Layout::offsetOf(2));
+static_assert(sizeof(ClusterBlock)                 == ClusterBlock::Layout::SIZE);
+
+struct UniformBlockDescription {
+  const char          *name;
+  UniformBlockBinding  binding;
+  size_t               size;
+};
+
+inline constexpr UniformBlockDescription SHARED_UNIFORM_BLOCKS[] = {
+  { "CameraBlock", CAMERA_BLOCK_BINDING, sizeof(CameraBlock) },
+  { "ClusterBlock", CLUSTER_BLOCK_BINDING, sizeof(ClusterBlock) },
+};
+
+}
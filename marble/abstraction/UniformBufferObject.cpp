@@ -0,0 +1,52 @@
+#include "UniformBufferObject.h"
+
+#include <cassert>
+#include <utility>
+#include <new>
+
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+namespace Renderer {
+
+UniformBufferObject::UniformBufferObject(size_t size)
+  : m_renderID(0), m_size(size)
+{
+  glCreateBuffers(1, &m_renderID);
+  glNamedBufferData(m_renderID, size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+UniformBufferObject::~UniformBufferObject()
+{
+  glDeleteBuffers(1, &m_renderID);
+  m_renderID = 0;
+}
+
+UniformBufferObject::UniformBufferObject(UniformBufferObject &&moved) noexcept
+{
+  m_size = moved.m_size;
+  m_renderID = moved.m_renderID;
+  moved.m_renderID = 0;
+}
+
+UniformBufferObject &UniformBufferObject::operator=(UniformBufferObject &&moved) noexcept
+{
+  this->~UniformBufferObject();
+  new (this)UniformBufferObject(std::move(moved));
+  return *this;
+}
+
+void UniformBufferObject::bindBase(unsigned int binding) const
+{
+  getRenderDevice().bindBufferBase(GL_UNIFORM_BUFFER, binding, m_renderID);
+}
+
+void UniformBufferObject::updateData(const void *data, size_t size, size_t offset)
+{
+  assert(m_renderID != 0);
+  assert(offset + size <= m_size);
+  getRenderDevice().bufferSubData(m_renderID, offset, size, data);
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Renderer {
+
+/* Immediate wrapper of the GL concept, see UniformBlocks.h for the blocks shared by shaders */
+class UniformBufferObject {
+private:
+  unsigned int m_renderID;
+  size_t       m_size;
+public:
+  UniformBufferObject() : m_renderID(0), m_size(0) {} // does not create the buffer on the gpu
+  explicit UniformBufferObject(size_t size);
+  UniformBufferObject(UniformBufferObject &&moved) noexcept;
+  UniformBufferObject &operator=(UniformBufferObject &&moved) noexcept;
+  UniformBufferObject(const UniformBufferObject &) = delete;
+  UniformBufferObject &operator=(const UniformBufferObject &) = delete;
+  ~UniformBufferObject();
+
+  /* Attaches the whole buffer to an indexed binding point, shaders read their blocks from there */
+  void bindBase(unsigned int binding) const;
+
+  size_t getSize() const { return m_size; }
+  // Unsafe
+  unsigned int getId() const { return m_renderID; }
+  // the buffer does not need to be bound
+  void updateData(const void *data, size_t size, size_t offset=0);
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace Renderer {
+
+/* 32 bits FNV-1a, constexpr so that uniform names written in the code are hashed at compile time */
+constexpr uint32_t hashUniformName(std::string_view name)
+{
+  uint32_t hash = 2166136261u;
+  for (char c : name) {
+    hash ^= (unsigned char)c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+* Identifies a uniform by the hash of its name. Shaders keep a table from
+* hashes to locations that is filled when the program is linked, setting a
+* uniform with an id does not allocate nor compare strings.
+*
+* The name is kept (it must outlive the id) to look up uniforms that were not
+* listed at link time and to report missing uniforms.
+*
+* Example usage:
+*   shader.setUniformMat4f("u_M"_uniform, M); // hashed at compile time
+*   static constexpr UniformID u_color{ "u_color" };
+*   shader.setUniform4f(u_color, color);
+*/
+struct UniformID {
+  uint32_t         hash;
+  std::string_view name;
+
+  explicit constexpr UniformID(std::string_view name) : hash(hashUniformName(name)), name(name) {}
+};
+
+consteval UniformID operator""_uniform(const char *name, size_t length)
+{
+  return UniformID{ std::string_view(name, length) };
+}
+
+}
@@ -2,11 +2,13 @@
 
 #include <glad/glad.h>
 
+#include "GLStateCache.h"
+
 namespace Renderer {
 
 VertexArray::VertexArray() {
   glGenVertexArrays(1, &m_RendererID);
-  glBindVertexArray(m_RendererID);
+  GLStateCache::bindVertexArray(m_RendererID);
 }
 
 VertexArray::~VertexArray() {
@@ -26,22 +28,27 @@ VertexArray &VertexArray::operator=(VertexArray &&moved) noexcept
 }
 
 void VertexArray::bind() const {
-  glBindVertexArray(m_RendererID);
+  GLStateCache::bindVertexArray(m_RendererID);
 }
 
 void VertexArray::unbind() {
-  glBindVertexArray(0);
+  GLStateCache::bindVertexArray(0);
 }
 
 void VertexArray::destroy()
 {
+  GLStateCache::notifyVertexArrayDeleted(m_RendererID);
   glDeleteVertexArrays(1, &m_RendererID);
   m_RendererID = 0;
 }
 
 void VertexArray::addBuffer(const VertexBufferObject& vb, const VertexBufferLayout& layout, const IndexBufferObject &ib) {
+  addBuffer(vb.getId(), layout, ib);
+}
+
+void VertexArray::addBuffer(unsigned int vertexBufferID, const VertexBufferLayout& layout, const IndexBufferObject &ib) {
   bind();
-  vb.bind();
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
   ib.bind();
 
   const auto& elements = layout.getElements();
@@ -24,6 +24,8 @@ public:
   void destroy();
 
   void addBuffer(const VertexBufferObject &vb, const VertexBufferLayout &layout, const IndexBufferObject &ib);
+  /* Same as above for buffers that are not owned by a VertexBufferObject, see StreamBuffer */
+  void addBuffer(unsigned int vertexBufferID, const VertexBufferLayout &layout, const IndexBufferObject &ib);
   void addInstanceBuffer(const VertexBufferObject &ivb, const VertexBufferLayout &instanceLayout, const VertexBufferLayout &modelLayout);
 };
 
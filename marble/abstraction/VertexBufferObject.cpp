@@ -4,6 +4,8 @@
 
 #include <glad/glad.h>
 
+#include "StreamBuffer.h"
+
 namespace Renderer {
 
 VertexBufferObject::VertexBufferObject(const void *vertices, size_t size)
@@ -57,7 +59,11 @@ void VertexBufferObject::updateData(const void *data, size_t size, size_t offset
 {
     assert(m_renderID != 0);
     assert(offset + size <= m_size);
-    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+    // staged in the stream buffer so that the call does not wait for draws that read the buffer
+    if (StreamBuffer *stream = getFrameStreamBuffer())
+        stream->copyToBuffer(m_renderID, offset, data, size);
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 }
 
 unsigned int VertexBufferElement::getSizeOfType(unsigned int glType)
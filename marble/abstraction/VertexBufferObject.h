@@ -28,6 +28,7 @@ public:
   unsigned int getId() const { return m_renderID; }
   // buffer must be bound
   void replaceData(const void *data, size_t size);
+  // buffer must be bound if the renderer is not initialized, see StreamBuffer
   void updateData(const void *data, size_t size, size_t offset=0);
 };
 
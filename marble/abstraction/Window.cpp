@@ -7,6 +7,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLStateCache.h"
 #include "../Utils/Debug.h"
 
 using namespace Window::Inputs;
@@ -15,6 +16,8 @@ namespace Window {
 
 static GLFWwindow *window = nullptr;
 static unsigned int winWidth, winHeight;
+static bool headless = false;
+static bool framerateCapped = false;
 static std::vector<InputHandler*> inputHandlers;
 
 void GLAPIENTRY openglMessageCallback(GLenum source, GLenum type, GLuint id,
@@ -70,22 +73,19 @@ void GLAPIENTRY openglMessageCallback(GLenum source, GLenum type, GLuint id,
   }
 }
 
-void createWindow(unsigned int width, unsigned int height, const char *title)
+static void setContextHints()
 {
-  glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
   glfwWindowHint(GLFW_VISIBLE, 0);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_SAMPLES, 4); // Enable mutisampling (MSAA), must be done to framebuffers too
+}
 
-  window = glfwCreateWindow(width, height, title, NULL, NULL);
+static void initContext(unsigned int width, unsigned int height)
+{
   winWidth = width;
   winHeight = height;
 
-  if (window == NULL)
-    throw std::runtime_error("Failed to create GLFW window");
-
   glfwMakeContextCurrent(window);
 
   glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int scancode, int action, int mods) {
@@ -109,7 +109,7 @@ void createWindow(unsigned int width, unsigned int height, const char *title)
       handler->triggerChar(codepoint);
   });
   glfwSetFramebufferSizeCallback(window, [](GLFWwindow *window, int width, int height) {
-    glViewport(0, 0, width, height);
+    Renderer::GLStateCache::setViewport(0, 0, width, height);
     winWidth = width;
     winHeight = height;
   });
@@ -120,15 +120,57 @@ void createWindow(unsigned int width, unsigned int height, const char *title)
   glEnable(GL_DEBUG_OUTPUT);
   glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
   glDebugMessageCallback(openglMessageCallback, 0);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glEnable(GL_CULL_FACE);
-  glEnable(GL_DEPTH_TEST);
+  Renderer::GLStateCache::setCapability(GL_BLEND, true);
+  Renderer::GLStateCache::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  Renderer::GLStateCache::setCapability(GL_CULL_FACE, true);
+  Renderer::GLStateCache::setCapability(GL_DEPTH_TEST, true);
   glLineWidth(5.f);
-  glViewport(0, 0, width, height);
+  Renderer::GLStateCache::setViewport(0, 0, width, height);
   glClearColor(0.f, 0.f, 0.0f, 1.0f);
 }
 
+void createWindow(unsigned int width, unsigned int height, const char *title)
+{
+  glfwInit();
+  setContextHints();
+  glfwWindowHint(GLFW_SAMPLES, 4); // Enable mutisampling (MSAA), must be done to framebuffers too
+
+  window = glfwCreateWindow(width, height, title, NULL, NULL);
+
+  if (window == NULL)
+    throw std::runtime_error("Failed to create GLFW window");
+
+  initContext(width, height);
+}
+
+void createHeadlessWindow(unsigned int width, unsigned int height)
+{
+  if (!glfwInit())
+    throw std::runtime_error("Failed to initialize GLFW");
+
+  // OSMesa and EGL do not need a display server, the native api is tried
+  // last so that a virtual display (Xvfb) also works
+  static constexpr int contextApis[] = { GLFW_OSMESA_CONTEXT_API, GLFW_EGL_CONTEXT_API, GLFW_NATIVE_CONTEXT_API };
+  for (int api : contextApis) {
+    setContextHints();
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+    window = glfwCreateWindow(width, height, "headless", NULL, NULL);
+    if (window != NULL)
+      break;
+  }
+
+  if (window == NULL)
+    throw std::runtime_error("Failed to create an offscreen GL context");
+
+  headless = true;
+  initContext(width, height);
+}
+
+bool isHeadless()
+{
+  return headless;
+}
+
 void setVisible(bool visible)
 {
   if (visible)
@@ -205,9 +247,15 @@ void setPosition(int x, int y)
   glfwSetWindowPos(window, x, y);
 }
 
-void capFramerate()
+void capFramerate(bool enabled)
+{
+  glfwSwapInterval(enabled ? 1 : 0);
+  framerateCapped = enabled;
+}
+
+bool isFramerateCapped()
 {
-  glfwSwapInterval(1);
+  return framerateCapped;
 }
 
 void captureMouse(bool enabled)
@@ -32,6 +32,13 @@ public:
 }
 
 void createWindow(unsigned int width, unsigned int height, const char *title);
+/*
+* Creates a hidden window with an offscreen (OSMesa, EGL) context when the
+* platform allows it, for runs without a display. Frames should be drawn to a
+* framebuffer of the requested size, the window's own may not be backed.
+*/
+void createHeadlessWindow(unsigned int width, unsigned int height);
+bool isHeadless();
 void setVisible(bool visible = true);
 bool shouldClose();
 void sendFrame();
@@ -48,7 +55,8 @@ void setSize(unsigned int w, unsigned int h);
 void setPosition(int x, int y);
 void renameWindow(const char *title);
 void setFullScreen(bool fullScreen);
-void capFramerate();
+void capFramerate(bool enabled=true); // vsync
+bool isFramerateCapped();
 void captureMouse(bool enable=true);
 
 void registerInputHandler(Inputs::InputHandler *handler);
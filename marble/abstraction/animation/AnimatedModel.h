@@ -58,7 +58,7 @@ public:
 	}
 
 	void step(float delta) {
-		m_animator.step(delta);
+		m_animator.step(delta, m_rootJoint);
 	}
 
 	
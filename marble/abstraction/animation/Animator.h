@@ -1,9 +1,11 @@
 #pragma once
 
 
-#include "AnimatedModel.h"
 #include "Animation.h"
+#include "Joint.h"
 
+#include <cmath>
+#include <string>
 #include <unordered_map>
 #include <glm/glm.hpp>
 
@@ -11,7 +13,6 @@ class Animator {
 
 private:
 
-	AnimatedModel m_entity;
 	Animation* m_currentAnimation;
 
 	float m_animationTime;
@@ -19,8 +20,7 @@ private:
 
 public:
 
-	Animator(AnimatedModel&& entity) : m_entity(std::move(entity)), m_animationTime(0), m_currentAnimation(nullptr) {}
-	Animator(): m_animationTime(0), m_currentAnimation(nullptr) {}
+	Animator(): m_currentAnimation(nullptr), m_animationTime(0) {}
 
 	void doAnimation(Animation* animation) {
 
@@ -28,13 +28,14 @@ public:
 		m_currentAnimation = animation;
 	}
 
-	void step(float delta) {
+	/* The animator does not own the skeleton, the animated model passes its root joint */
+	void step(float delta, Joint& rootJoint) {
 
 		if (!m_currentAnimation) return;
 
 		increaseAnimationTime(delta);
 		std::unordered_map<std::string, glm::mat4> currentPose = calculateCurrentAnimationPose();
-		applyPoseToJoints(currentPose, m_entity.getRootJoint(), glm::mat4(1.0f));
+		applyPoseToJoints(currentPose, rootJoint, glm::mat4(1.0f));
 
 
 
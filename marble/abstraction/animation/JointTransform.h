@@ -16,7 +16,7 @@ public:
 	JointTransform(const glm::vec3& position, const glm::quat& rotation) : m_position(position), m_rotation(rotation) {}
 
 
-	glm::mat4 getLocalTransform() {
+	glm::mat4 getLocalTransform() const {
 
 		glm::mat4 matrix(1.0F);
 		matrix = glm::translate(matrix, m_position);
@@ -2,6 +2,7 @@
 
 
 #include "JointTransform.h"
+#include <string>
 #include <unordered_map>
 
 class KeyFrame {
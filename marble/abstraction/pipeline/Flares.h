@@ -8,6 +8,8 @@
 
 #include "../Texture.h"
 #include "../UnifiedRenderer.h"
+#include "../GLStateCache.h"
+#include "../RenderDevice.h"
 
 // TODO move Flares implementation in a .cpp file
 // TODO figure out how glad got included here!!
@@ -138,13 +140,13 @@ public:
 
 		m_VAO.bind();
 
-		glDisable(GL_DEPTH_TEST);
-		glDepthMask(GL_FALSE);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-		glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr);
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(GL_TRUE);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		Renderer::GLStateCache::setCapability(GL_DEPTH_TEST, false);
+		Renderer::GLStateCache::setDepthMask(false);
+		Renderer::GLStateCache::setBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		Renderer::getRenderDevice().drawElements(GL_TRIANGLES, (int)m_indexCount);
+		Renderer::GLStateCache::setCapability(GL_DEPTH_TEST, true);
+		Renderer::GLStateCache::setDepthMask(true);
+		Renderer::GLStateCache::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		m_indexCount = 0;
 		m_textureSlotIndex = 1;
@@ -3,6 +3,7 @@
 
 #include "VFX.h"
 #include "../Texture.h"
+#include "../GLStateCache.h"
 #include <random>
 
 // This SSAO implementation should really be used in a deferrend rendering engine
@@ -66,7 +67,7 @@ namespace visualEffects {
 				ssaoNoise.push_back(noise);
 			}
 			glGenTextures(1, &m_noiseTexture);
-			glBindTexture(GL_TEXTURE_2D, m_noiseTexture);
+			Renderer::GLStateCache::bindTexture2D(m_noiseTexture);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -79,7 +80,7 @@ namespace visualEffects {
 			// Set-up the shader
 			m_ssaoPass.setShader("res/shaders/SSAO.fs");
 			m_ssaoPass.getShader().bind();
-			m_ssaoPass.getShader().setUniform1i("gPosition", 0);
+			m_ssaoPass.getShader().setUniform1i("gDepth", 0);
 			m_ssaoPass.getShader().setUniform1i("gNormal", 1);
 			m_ssaoPass.getShader().setUniform1i("texNoise", 2);
 			m_ssaoPass.getShader().setUniform3fv("samples", 64, (const float*)&ssaoKernel[0]);
@@ -100,18 +101,19 @@ namespace visualEffects {
 		}
 
 		Renderer::Texture* computeSSAOTexture(
-			Renderer::Texture* gPos,
+			Renderer::Texture* gDepth,
 			Renderer::Texture* gNormal,
 			Renderer::Camera& camera		
 		)
 		{
 			
-			gPos->bind(0);
+			gDepth->bind(0);
 			gNormal->bind(1);
 			Renderer::Texture::bindFromId(m_noiseTexture, 2);
 
 			m_ssaoPass.getShader().bind();
 			m_ssaoPass.getShader().setUniformMat4f("projection", camera.getViewProjectionMatrix());
+			m_ssaoPass.getShader().setUniformMat4f("u_inverseVP", glm::inverse(camera.getViewProjectionMatrix()));
 			m_ssaoPass.getShader().unbind();
 		
 			// Create the ssao texture
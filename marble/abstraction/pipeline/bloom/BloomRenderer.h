@@ -2,6 +2,7 @@
 
 #include "../../Shader.h"
 #include "../../UnifiedRenderer.h"
+#include "../../GLStateCache.h"
 
 
 class BloomRenderer {
@@ -115,8 +116,8 @@ private:
         m_blitUp.getShader().setUniform1f("u_filterRadius", filterRadius);
         m_blitUp.getShader().setUniform1i("u_texture", 0);
         
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_ONE, GL_ONE);
+        Renderer::GLStateCache::setCapability(GL_BLEND, true);
+        Renderer::GLStateCache::setBlendFunc(GL_ONE, GL_ONE);
         glBlendEquation(GL_FUNC_ADD); // TODO FIX pin down the inclusing of glad.h that allows this call
    
                                       // glad.h should not be included in any .h file
@@ -145,6 +146,6 @@ private:
             }
         }
 
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        Renderer::GLStateCache::setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     }
 };
\ No newline at end of file
@@ -3,7 +3,7 @@ out vec4 FragColor;
 
 in vec2 o_uv;
 
-uniform sampler2D gPosition;
+uniform sampler2D gDepth;  // see GBufferEncoding.h
 uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
@@ -18,13 +18,27 @@ uniform float bias = 0.25;
 const vec2 noiseScale = vec2(16*70.0/4.0, 9*70.F/4.0); 
 
 uniform mat4 projection;
+uniform mat4 u_inverseVP;
+
+vec3 decodeNormal(vec2 f) {
+    f = f * 2.0 - 1.0;
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 uv, float depth) {
+    vec4 p = u_inverseVP * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return p.xyz / p.w;
+}
 
 void main()
 {
     // get input for SSAO algorithm
     vec2 TexCoords = o_uv;
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+    vec3 fragPos = reconstructPosition(TexCoords, texture(gDepth, TexCoords).r);
+    vec3 normal = decodeNormal(texture(gNormal, TexCoords).rg);
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
     // create TBN change-of-basis matrix: from tangent-space to view-space
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -45,7 +59,7 @@ void main()
         offset.xyz = offset.xyz * 0.5 + 0.5; // transform to range 0.0 - 1.0
         
         // get sample depth
-        float sampleDepth = texture(gPosition, offset.xy).z; // get depth value of kernel sample
+        float sampleDepth = reconstructPosition(offset.xy, texture(gDepth, offset.xy).r).z; // get depth value of kernel sample
         
         // range check & accumulate
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
@@ -1,39 +1,48 @@
-#version 330 core
+#version 430 core
 
 layout (location=0) out vec4 color;
 
 in vec2 o_uv;
 
-uniform sampler2D[16] u_gBufferTextures;
+uniform sampler2D[16] u_gBufferTextures; // albedo, normal, depth (see GBufferEncoding.h)
 uniform sampler2D u_ssaoTexture;
 uniform vec3 u_cameraPos;
+uniform mat4 u_inverseVP;
 
 // Somehow make a factory out of this
 
 uniform vec3 u_SunPos = vec3(1000,1000,1000);
+// false when the point lights are shaded by light volumes (see LightVolumes.h)
+uniform bool u_shadePointLights = true;
 
 
 
-// Lights structure
+// Lights, see LightBuffer.h
 struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;   // constant, linear, quadratic, on
+};
 
-    int on; // does this work ? yes it does
-
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-   
+layout(std430, binding = 4) readonly buffer PointLights {
+    uint       u_pointLightCount;
+    PointLight u_pointLights[];
 };
 
-const int NR_LIGHTS = 32;
-uniform PointLight u_lights[NR_LIGHTS];
-uniform int u_numberOfLights = 0;
+vec3 decodeNormal(vec2 f) {
+    f = f * 2.0 - 1.0;
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 uv, float depth) {
+    vec4 p = u_inverseVP * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return p.xyz / p.w;
+}
 
 float computeSunlight(vec3 normal) {
     return max(0, dot(normalize(normal), normalize(u_SunPos)));
@@ -42,31 +51,32 @@ float computeSunlight(vec3 normal) {
 void main() 
 {
     
-    vec3 diffuse = texture(u_gBufferTextures[0], o_uv).rgb;
-    vec3 normal = texture(u_gBufferTextures[1], o_uv).rgb;
-    vec3 fragPos = texture(u_gBufferTextures[2], o_uv).rgb;
+    vec3 diffuse = texture(u_gBufferTextures[0], o_uv).rgb * 3.0;
+    vec3 normal = decodeNormal(texture(u_gBufferTextures[1], o_uv).rg);
+    vec3 fragPos = reconstructPosition(o_uv, texture(u_gBufferTextures[2], o_uv).r);
     float occlusion = texture(u_ssaoTexture, o_uv).r;
     
     vec3 lighting  = vec3(0.3 * diffuse * occlusion);
 
 
     vec3 viewDir  = normalize(u_cameraPos - fragPos);
-    for(int i = 0; i < u_numberOfLights; ++i)
+    for(uint i = 0; u_shadePointLights && i < u_pointLightCount; ++i)
     {
-        if (u_lights[i].on == 0) continue;
+        PointLight light = u_pointLights[i];
+        if (light.attenuation.w == 0) continue;
 
         // diffuse
-        vec3 lightDir = normalize(u_lights[i].position - fragPos);
-        vec3 lightDiffuse = max(dot(normal, lightDir), 0.0) * (u_lights[i].ambient);
+        vec3 lightDir = normalize(light.positionRange.xyz - fragPos);
+        vec3 lightDiffuse = max(dot(normal, lightDir), 0.0) * (light.ambient.rgb);
         
         // specular
         vec3 halfwayDir = normalize(lightDir + viewDir);  
         float spec = pow(max(dot(normal, halfwayDir), 0.0), 16.0);
-        vec3 specular = u_lights[i].specular;
+        vec3 specular = light.specular.rgb;
         
         // attenuation
-        float distance = length(u_lights[i].position - fragPos);
-        float attenuation = 1.0 / (1.0 + u_lights[i].linear * distance + u_lights[i].quadratic * distance * distance);
+        float distance = length(light.positionRange.xyz - fragPos);
+        float attenuation = 1.0 / (1.0 + light.attenuation.y * distance + light.attenuation.z * distance * distance);
         lightDiffuse *= attenuation;
         specular *= attenuation;
         lighting += lightDiffuse + specular;        
@@ -0,0 +1,77 @@
+#version 430 core
+
+layout (location=0) out vec4 color;
+
+flat in uint o_lightIndex;
+
+uniform sampler2D[16] u_gBufferTextures; // albedo, normal, depth (see GBufferEncoding.h)
+uniform vec2 u_screenSize;
+uniform mat4 u_inverseVP;
+
+// see LightBuffer.h
+struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;   // constant, linear, quadratic, on
+};
+
+layout(std430, binding = 4) readonly buffer PointLights {
+    uint       u_pointLightCount;
+    PointLight u_pointLights[];
+};
+
+layout(std140) uniform CameraBlock {
+    mat4  u_VP;
+    mat4  u_V;
+    mat4  u_P;
+    vec3  u_cameraPos;
+    float u_time;
+    vec3  u_fogDamping;
+    vec3  u_fogColor;
+};
+
+vec3 decodeNormal(vec2 f) {
+    f = f * 2.0 - 1.0;
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 uv, float depth) {
+    vec4 p = u_inverseVP * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return p.xyz / p.w;
+}
+
+// Shades one light for the pixels of its volume, the results of all lights are added
+// same lighting as the loop of deferredPass.fs
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / u_screenSize;
+    vec3 normal = decodeNormal(texture(u_gBufferTextures[1], uv).rg);
+    vec3 fragPos = reconstructPosition(uv, texture(u_gBufferTextures[2], uv).r);
+    PointLight light = u_pointLights[o_lightIndex];
+
+    // the stencil only tells that the pixel is in some light volume
+    float distance = length(light.positionRange.xyz - fragPos);
+    if (distance > light.positionRange.w)
+        discard;
+
+    vec3 viewDir  = normalize(u_cameraPos - fragPos);
+
+    // diffuse
+    vec3 lightDir = normalize(light.positionRange.xyz - fragPos);
+    vec3 lightDiffuse = max(dot(normal, lightDir), 0.0) * (light.ambient.rgb);
+
+    // specular
+    vec3 specular = light.specular.rgb;
+
+    // attenuation
+    float attenuation = 1.0 / (1.0 + light.attenuation.y * distance + light.attenuation.z * distance * distance);
+    lightDiffuse *= attenuation;
+    specular *= attenuation;
+
+    color = vec4(lightDiffuse + specular, 0);
+}
@@ -0,0 +1,44 @@
+#version 430 core
+
+layout(location = 0) in vec3 i_position;
+
+// see LightBuffer.h and LightVolumes.h, the bindings are listed in UniformBlocks.h
+struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;   // constant, linear, quadratic, on
+};
+
+layout(std430, binding = 4) readonly buffer PointLights {
+    uint       u_pointLightCount;
+    PointLight u_pointLights[];
+};
+
+layout(std430, binding = 7) readonly buffer VisibleLights {
+    uint u_visibleLights[]; // one per instance
+};
+
+layout(std140) uniform CameraBlock {
+    mat4  u_VP;
+    mat4  u_V;
+    mat4  u_P;
+    vec3  u_cameraPos;
+    float u_time;
+    vec3  u_fogDamping;
+    vec3  u_fogColor;
+};
+
+// the sphere model is tessellated, it is scaled up to contain the actual sphere
+uniform float u_volumeScale = 1;
+
+flat out uint o_lightIndex;
+
+void main()
+{
+    o_lightIndex = u_visibleLights[gl_InstanceID];
+    vec4 positionRange = u_pointLights[o_lightIndex].positionRange;
+    vec3 worldPos = positionRange.xyz + i_position * positionRange.w * u_volumeScale;
+    gl_Position = u_VP * vec4(worldPos, 1);
+}
@@ -3,7 +3,16 @@
 layout(location=0) in vec3 i_position;
 
 uniform mat4 u_M;
-uniform mat4 u_VP;
+
+layout(std140) uniform CameraBlock {
+  mat4  u_VP;
+  mat4  u_V;
+  mat4  u_P;
+  vec3  u_cameraPos;
+  float u_time;
+  vec3  u_fogDamping;
+  vec3  u_fogColor;
+};
 
 void main()
 {
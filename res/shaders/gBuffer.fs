@@ -1,9 +1,8 @@
 #version 330 core
 
-// Vec4 to render
-layout (location=0) out vec4 gAlbedo;
-layout (location=1) out vec4 gNormal;
-layout (location=2) out vec4 gPosition;
+// Packed g-buffer, see GBufferEncoding.h, positions are reconstructed from the depth buffer
+layout (location=0) out vec4 gAlbedo; // RGBA8
+layout (location=1) out vec2 gNormal; // RG16, octahedral
 
 in vec2 o_uv;
 in vec3 o_normal;
@@ -13,11 +12,16 @@ flat in int o_texId;
 
 // Make a factory out of this for insane over-engineering
 
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e * 0.5 + 0.5;
+}
+
 void main() 
 {
 
-    gPosition = vec4(o_pos,1);
-    gNormal = vec4(o_normal,1);
-    gAlbedo = vec4((o_color)*3.F,1);
+    gNormal = encodeNormal(normalize(o_normal));
+    gAlbedo = vec4(o_color,1); // RGBA8 is clamped, the lighting pass scales the albedo
 
-}
\ No newline at end of file
+}
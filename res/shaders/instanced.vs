@@ -8,7 +8,7 @@ layout(location = 4) in float i_texId;
 // instance members
 layout(location = 5) in vec3 i_iposition;
 layout(location = 6) in vec3 i_iscale;
-layout(location = 7) in float i_irotation; // fake rotation, acceptable values are 0 (no rotation) and 1 (90deg rotation)
+layout(location = 7) in vec4 i_irotation; // quaternion, xyz then w
 
 out vec2 o_uv;
 out vec3 o_normal;
@@ -23,26 +23,36 @@ out vec4 o_clipspace;
 out vec3 o_toCameraVector;
 out vec3 o_fromLightVector;
 
-uniform mat4 u_VP;
+layout(std140) uniform CameraBlock {
+  mat4  u_VP;
+  mat4  u_V;
+  mat4  u_P;
+  vec3  u_cameraPos;
+  float u_time;
+  vec3  u_fogDamping;
+  vec3  u_fogColor;
+};
+
 uniform vec3 u_SunPos = vec3(1000.f);
 
 uniform vec3 u_camPos = vec3(0.f,0.f,0.f);
 uniform vec4 u_plane = vec4(0, -1, 0, 10000);
 
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+  return v + 2. * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 void main()
 {
-  vec4 worldPos = vec4(i_position, 0);
-  worldPos.xz += i_irotation * (-worldPos.xz -worldPos.zw +worldPos.wx); // if an actual rotation is required, replace with rotation matrices
-  worldPos.xyz *= i_iscale;
-  worldPos.xyz += i_iposition;
-  worldPos.w = 1;
+  vec4 worldPos = vec4(i_iposition + i_iscale * rotateByQuaternion(i_irotation, i_position), 1);
   gl_ClipDistance[0] = dot(worldPos, u_plane);
   gl_ClipDistance[0] = 100000;
   vec4 screenSpacePos = u_VP * worldPos;
 
   o_pos = worldPos.xyz;
   o_uv = i_uv;
-  o_normal = i_normal;
+  o_normal = rotateByQuaternion(i_irotation, i_normal);
   o_color = i_color;
   o_texId = int(i_texId);
 
@@ -0,0 +1,24 @@
+#version 430 core
+
+in vec2 o_uv;
+in vec3 o_normal;
+in vec3 o_pos;
+in vec3 o_color;
+flat in int o_texId;
+
+// see MaterialTable.h, materials are selected by the texId vertex attribute
+struct PackedMaterial {
+    vec4 tint;
+    uint layer;
+};
+
+layout(std430, binding = 8) readonly buffer Materials {
+    PackedMaterial u_materials[];
+};
+
+uniform sampler2DArray u_TextureArray;
+
+vec4 computeBaseColor(vec3 normal) {
+    PackedMaterial material = u_materials[o_texId];
+    return texture(u_TextureArray, vec3(o_uv, material.layer)) * material.tint;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 o_uv;
+in vec3 o_normal;
+in vec3 o_pos;
+in vec3 o_color;
+flat in int o_texId;
+
+// layers are selected by the texId vertex attribute, see TextureArrayManager
+uniform sampler2DArray u_TextureArray;
+
+vec4 computeBaseColor(vec3 normal) {
+    return texture(u_TextureArray, vec3(o_uv, o_texId));
+}
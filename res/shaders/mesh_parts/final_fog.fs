@@ -5,9 +5,16 @@ in vec3 o_normal;
 in vec3 o_pos;
 in vec3 o_color;
 
-uniform vec3 u_fogColor = vec3(.71, .86, 1.);
-uniform vec3 u_fogDamping = vec3(.001, .001, .001);
-uniform vec3 u_cameraPos;
+// fog parameters are set with Renderer::setFogParameters
+layout(std140) uniform CameraBlock {
+    mat4  u_VP;
+    mat4  u_V;
+    mat4  u_P;
+    vec3  u_cameraPos;
+    float u_time;
+    vec3  u_fogDamping;
+    vec3  u_fogColor;
+};
 
 void applyFinalPass(vec3 normal, inout vec4 color) {
     color.rgb = mix(u_fogColor, color.rgb, exp(-length(o_pos - u_cameraPos)*u_fogDamping));
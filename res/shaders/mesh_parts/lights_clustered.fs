@@ -0,0 +1,90 @@
+#version 430 core
+
+in vec2 o_uv;
+in vec3 o_normal;
+in vec3 o_pos;
+in vec3 o_color;
+
+// see LightBuffer.h and ClusteredLights.h, the bindings are listed in UniformBlocks.h
+struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;   // constant, linear, quadratic, on
+};
+
+layout(std430, binding = 4) readonly buffer PointLights {
+    uint       u_pointLightCount;
+    PointLight u_pointLights[];
+};
+
+layout(std430, binding = 5) readonly buffer LightClusters {
+    uvec2 u_lightClusters[]; // first index, count
+};
+
+layout(std430, binding = 6) readonly buffer LightClusterIndices {
+    uint u_lightClusterIndices[];
+};
+
+layout(std140) uniform CameraBlock {
+    mat4  u_VP;
+    mat4  u_V;
+    mat4  u_P;
+    vec3  u_cameraPos;
+    float u_time;
+    vec3  u_fogDamping;
+    vec3  u_fogColor;
+};
+
+layout(std140) uniform ClusterBlock {
+    ivec4 u_clusterCount;
+    float u_clusterDepthScale;
+    float u_clusterDepthBias;
+};
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightPos = light.positionRange.xyz;
+    vec3 lightDir = normalize(lightPos - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = max(dot(viewDir, reflectDir), 0.0);
+    // attenuation
+    float distance    = length(lightPos - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+  			     light.attenuation.z * (distance * distance));
+    // combine results, same as lights_pointlights.fs
+    vec3 ambient  = light.ambient.rgb;
+    vec3 diffuse  = light.diffuse.rgb;
+    vec3 specular = light.specular.rgb;
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
+
+uint getClusterIndex() {
+    vec4 clip = u_VP * vec4(o_pos, 1);
+    ivec2 tile = ivec2((clip.xy / clip.w * .5 + .5) * vec2(u_clusterCount.xy));
+    tile = clamp(tile, ivec2(0), u_clusterCount.xy - 1);
+    float depth = -(u_V * vec4(o_pos, 1)).z;
+    int slice = int(log(max(depth, 1e-4)) * u_clusterDepthScale + u_clusterDepthBias);
+    slice = clamp(slice, 0, u_clusterCount.z - 1);
+    return uint((slice * u_clusterCount.y + tile.y) * u_clusterCount.x + tile.x);
+}
+
+vec4 computeExtraLights(vec3 normal) {
+    vec3 viewDir = normalize(u_cameraPos - o_pos);
+    vec4 extra = vec4(0);
+
+    uvec2 cluster = u_lightClusters[getClusterIndex()];
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++) {
+        PointLight light = u_pointLights[u_lightClusterIndices[i]];
+        extra.rgb += CalcPointLight(light, normal, o_pos, viewDir);
+    }
+
+    return extra;
+}
@@ -1,48 +1,51 @@
-#version 330 core
-
-#define MAX_NB_POINT_LIGHTS 12
+#version 430 core
 
 in vec2 o_uv;
 in vec3 o_normal;
 in vec3 o_pos;
 in vec3 o_color;
 
+// see LightBuffer.h, the binding is listed in UniformBlocks.h
 struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;   // constant, linear, quadratic, on
+};
 
-    int on; // does this work ? yes it does
-
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-   
+layout(std430, binding = 4) readonly buffer PointLights {
+    uint       u_pointLightCount;
+    PointLight u_pointLights[];
 };
 
-uniform PointLight u_lights[MAX_NB_POINT_LIGHTS];
-uniform int        u_numberOfLights = 0;
-uniform vec3       u_cameraPos;
+layout(std140) uniform CameraBlock {
+    mat4  u_VP;
+    mat4  u_V;
+    mat4  u_P;
+    vec3  u_cameraPos;
+    float u_time;
+    vec3  u_fogDamping;
+    vec3  u_fogColor;
+};
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 lightPos = light.positionRange.xyz;
+    vec3 lightDir = normalize(lightPos - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = max(dot(viewDir, reflectDir), 0.0);
     // attenuation
-    float distance    = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + 
-  			     light.quadratic * (distance * distance));    
+    float distance    = length(lightPos - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+  			     light.attenuation.z * (distance * distance));
     // combine results
-    vec3 ambient  = light.ambient;
-    vec3 diffuse  = light.diffuse; 
-    vec3 specular = light.specular;
+    vec3 ambient  = light.ambient.rgb;
+    vec3 diffuse  = light.diffuse.rgb;
+    vec3 specular = light.specular.rgb;
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
@@ -53,9 +56,9 @@ vec4 computeExtraLights(vec3 normal) {
     vec3 viewDir = normalize(u_cameraPos - o_pos);
     vec4 extra = vec4(0);
 
-    for (int i = 0; i < u_numberOfLights; i++) {
-        PointLight light = u_lights[i];
-        if (light.on == 0) continue;
+    for (uint i = 0; i < u_pointLightCount; i++) {
+        PointLight light = u_pointLights[i];
+        if (light.attenuation.w == 0) continue;
         extra.rgb += CalcPointLight(light, normal, o_pos, viewDir);
     }
 
@@ -0,0 +1,44 @@
+#version 330 core
+
+in vec2 o_uv;
+in vec3 o_normal;
+in vec3 o_pos;
+in vec3 o_color;
+
+#define MAX_CASCADES 4
+
+// This tells what texture slot is the normal texture of the index-Texture
+uniform int       u_NormalsTextureSlot[8];
+uniform sampler2D u_Textures2D[8];
+uniform vec3      u_SunPos;
+uniform int       u_shadowCascadeCount;
+uniform sampler2D u_shadowMaps[MAX_CASCADES];            // the depth maps of the cascades, from the nearest to the farthest
+uniform vec2      u_shadowMapOrthoZRanges[MAX_CASCADES]; // = (zNear, zFar) in the orthographic projection that generated each shadow map
+uniform mat4x3    u_shadowMapProjs[MAX_CASCADES];        // projections from world coordinates to shadow map coordinates (xy are UVs and z is the distance to the sun)
+
+float computeSunlight(vec3 normal) {
+    if (u_NormalsTextureSlot[0] != -1) {
+        vec4 sn = texture(u_Textures2D[0],o_uv); // TODO see note in normal_normalmap.fs
+        normal = normal * sn.rgb;
+    }
+
+    float sunlight = max(0, dot(normalize(normal), normalize(u_SunPos)));
+
+    // cascades are nested, the first one that contains the fragment is the most detailed
+    for (int i = 0; i < u_shadowCascadeCount; i++) {
+        vec3 shadowMapPos = u_shadowMapProjs[i] * vec4(o_pos, 1);
+        vec2 zRange = u_shadowMapOrthoZRanges[i];
+        if(abs(shadowMapPos.x-.5) > .5 || abs(shadowMapPos.y-.5) > .5 || shadowMapPos.z > zRange.y)
+            continue;
+        // sampler arrays can only be indexed by constant expressions in glsl 330
+        float depth;
+        if (i == 0) depth = texture(u_shadowMaps[0], shadowMapPos.xy).x;
+        else if (i == 1) depth = texture(u_shadowMaps[1], shadowMapPos.xy).x;
+        else if (i == 2) depth = texture(u_shadowMaps[2], shadowMapPos.xy).x;
+        else depth = texture(u_shadowMaps[3], shadowMapPos.xy).x;
+        float closestDistanceToSun = depth*(zRange.y-zRange.x) + zRange.x;
+        return sunlight * smoothstep(-0.1, 0., closestDistanceToSun - shadowMapPos.z);
+    }
+
+    return .5; // outside of every cascade
+}
@@ -7,6 +7,7 @@ layout(location=2) in vec3 m_normal;
 // instance
 layout(location=5) in vec3 i_position;
 layout(location=6) in vec3 i_scale;
+layout(location=7) in vec4 i_rotation; // quaternion, xyz then w
 
 out vec3 v_normal;
 out vec3 v_vertex;
@@ -17,16 +18,30 @@ out vec3 o_color;
 out vec3 o_normal; // FIX normalize standard VS and standard instanced VS outputs (o_xx vs v_xx)
                    // and also rename this file to standard_instanced.vs
 
-uniform mat4 u_VP;
+layout(std140) uniform CameraBlock {
+  mat4  u_VP;
+  mat4  u_V;
+  mat4  u_P;
+  vec3  u_cameraPos;
+  float u_time;
+  vec3  u_fogDamping;
+  vec3  u_fogColor;
+};
+
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+  return v + 2. * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
 
 void main()
 {
-  vec4 position = vec4(m_position * i_scale + i_position, 1);
+  vec3 normal = rotateByQuaternion(i_rotation, m_normal);
+  vec4 position = vec4(i_scale * rotateByQuaternion(i_rotation, m_position) + i_position, 1);
   v_vertex = m_position;
-  v_normal = m_normal;
+  v_normal = normal;
   v_position = position.xyz;
   o_uv = m_uv;
   o_color = vec3(1);
-  o_normal = m_normal;
+  o_normal = normal;
   gl_Position = u_VP * position;
 }
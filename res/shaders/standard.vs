@@ -5,6 +5,11 @@ layout(location = 1) in vec2 i_uv;
 layout(location = 2) in vec3 i_normal;
 layout(location = 3) in vec3 i_color;
 layout(location = 4) in float i_texId;
+// instance members, meshes that are not drawn instanced have a single identity
+// instance (see Renderer::addIdentityInstance)
+layout(location = 5) in vec3 i_iposition;
+layout(location = 6) in vec3 i_iscale;
+layout(location = 7) in vec4 i_irotation; // quaternion, xyz then w
 
 out vec2 o_uv;
 out vec3 o_normal;
@@ -19,22 +24,38 @@ out vec4 o_clipspace;
 out vec3 o_toCameraVector;
 out vec3 o_fromLightVector;
 
-uniform mat4 u_VP;
 uniform mat4 u_M;
+
+layout(std140) uniform CameraBlock {
+  mat4  u_VP;
+  mat4  u_V;
+  mat4  u_P;
+  vec3  u_cameraPos;
+  float u_time;
+  vec3  u_fogDamping;
+  vec3  u_fogColor;
+};
 uniform vec3 u_SunPos = vec3(1000.f);
 
 uniform vec3 u_camPos = vec3(0.f,0.f,0.f);
 uniform vec4 u_plane = vec4(0, -1, 0, 10000);
 
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+  return v + 2. * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 void main()
 {
-  vec4 worldPos = u_M * vec4(i_position, +1.0);
+  // same order as the model matrices of the renderer: translation, scale then rotation
+  vec3 instancePos = i_iposition + i_iscale * rotateByQuaternion(i_irotation, i_position);
+  vec4 worldPos = u_M * vec4(instancePos, +1.0);
   gl_ClipDistance[0] = dot(worldPos, u_plane);
   vec4 screenSpacePos = u_VP * worldPos;
 
   o_pos = worldPos.xyz;
   o_uv = i_uv;
-  o_normal = mat3(u_M) *  i_normal;
+  o_normal = mat3(u_M) * (i_iscale * rotateByQuaternion(i_irotation, i_normal));
   o_color = i_color;
   o_texId = int(i_texId);
 
@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec4 o_color;
+
+out vec4 color;
+
+void main()
+{
+    color = o_color;
+}
@@ -1,10 +1,15 @@
 #version 330 core
 
+layout(location = 0) in vec3 i_position;
+layout(location = 1) in vec4 i_color;
+
+out vec4 o_color;
+
+// the camera of the batch, debug lines may be drawn from cameras other than the view's
 uniform mat4 u_VP;
-uniform vec3 u_from, u_to;
 
 void main()
 {
-  vec3 position = gl_VertexID == 0 ? u_from : u_to;
-  gl_Position = u_VP * vec4(position, +1.0);
+  o_color = i_color;
+  gl_Position = u_VP * vec4(i_position, +1.0);
 }